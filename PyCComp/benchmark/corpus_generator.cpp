@@ -0,0 +1,375 @@
+#include "corpus_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::array<std::string_view, CorpusGenerator::SHAPE_COUNT> c_ShapeNames{ "mixed", "deep_indent", "long_strings", "numbers" };
+
+    constexpr std::array<std::string_view, 24> c_Words{
+        "value", "count", "index", "total", "buffer", "result", "item", "node", "offset", "length", "scale", "limit",
+        "weight", "cursor", "state", "token", "queue", "table", "entry", "width", "height", "level", "score", "delta"
+    };
+
+    constexpr std::array<std::string_view, 12> c_BinaryOperators{ "+", "-", "*", "/", "//", "%", "**", "&", "|", "^", "<<", ">>" };
+    constexpr std::array<std::string_view, 6> c_Comparisons{ "==", "!=", "<", "<=", ">", ">=" };
+    constexpr std::array<std::string_view, 6> c_Assignments{ "=", "+=", "-=", "*=", "//=", "|=" };
+    // The tokenizer has no escape sequences, so strings get their variety from punctuation instead
+    constexpr std::array<std::string_view, 8> c_Punctuation{ ",", ".", ":", ";", "!", "?", " -", " (see above)" };
+
+    void appendLine(std::string& p_Out, const uint32_t p_Indent, const std::string_view p_Text)
+    {
+        p_Out.append(static_cast<size_t>(p_Indent) * 4, ' ');
+        p_Out += p_Text;
+        p_Out += '\n';
+    }
+}
+
+CorpusGenerator::CorpusGenerator(const uint64_t p_Seed)
+    : m_Random(p_Seed)
+{
+}
+
+std::string CorpusGenerator::generateModule(const Shape p_Shape, const size_t p_Size)
+{
+    std::string l_Source;
+    l_Source.reserve(p_Size + 8192);
+    while (l_Source.size() < p_Size)
+    {
+        switch (p_Shape)
+        {
+        case MIXED:
+            appendMixed(l_Source);
+            break;
+        case DEEP_INDENT:
+            appendDeepIndent(l_Source);
+            break;
+        case LONG_STRINGS:
+            appendLongStrings(l_Source);
+            break;
+        case NUMBERS:
+            appendNumbers(l_Source);
+            break;
+        default:
+            throw std::invalid_argument("Unknown corpus shape");
+        }
+    }
+    return l_Source;
+}
+
+std::filesystem::path CorpusGenerator::generateImportGraph(const std::filesystem::path& p_Directory, const uint32_t p_ModuleCount, const uint32_t p_Fanout, const size_t p_ModuleSize)
+{
+    std::filesystem::create_directories(p_Directory);
+    for (uint32_t l_Module = 0; l_Module < p_ModuleCount; ++l_Module)
+    {
+        std::string l_Source;
+        const uint32_t l_Later = p_ModuleCount - l_Module - 1;
+        if (l_Later > 0)
+        {
+            appendLine(l_Source, 0, "import module_" + std::to_string(l_Module + 1));
+        }
+        for (uint32_t l_Import = 1; l_Import < p_Fanout && l_Later > 1; ++l_Import)
+        {
+            appendLine(l_Source, 0, "import module_" + std::to_string(l_Module + 2 + below(l_Later - 1)));
+        }
+        l_Source += '\n';
+        l_Source += generateModule(MIXED, p_ModuleSize);
+
+        const std::filesystem::path l_Path = p_Directory / ("module_" + std::to_string(l_Module) + ".py");
+        std::ofstream l_File(l_Path, std::ios::binary | std::ios::trunc);
+        if (!l_File.write(l_Source.data(), static_cast<std::streamsize>(l_Source.size())))
+        {
+            throw std::runtime_error("Could not write " + l_Path.string());
+        }
+    }
+    return p_Directory / "module_0.py";
+}
+
+std::string_view CorpusGenerator::getShapeName(const Shape p_Shape)
+{
+    return c_ShapeNames[p_Shape];
+}
+
+std::optional<CorpusGenerator::Shape> CorpusGenerator::findShape(const std::string_view p_Name)
+{
+    for (uint8_t l_Shape = 0; l_Shape < SHAPE_COUNT; ++l_Shape)
+    {
+        if (c_ShapeNames[l_Shape] == p_Name)
+        {
+            return static_cast<Shape>(l_Shape);
+        }
+    }
+    return std::nullopt;
+}
+
+uint32_t CorpusGenerator::below(const uint32_t p_Bound)
+{
+    // The slight modulo bias does not matter here, reproducibility does
+    return static_cast<uint32_t>(m_Random() % p_Bound);
+}
+
+std::string_view CorpusGenerator::pickWord()
+{
+    return c_Words[below(static_cast<uint32_t>(c_Words.size()))];
+}
+
+std::string CorpusGenerator::makeName()
+{
+    // Mostly names seen before, so the symbol table sees realistic reuse
+    const uint32_t l_Id = m_NextName > 0 && chance(80) ? below(m_NextName) : m_NextName++;
+    return std::string(pickWord()) + "_" + std::to_string(l_Id % 4096);
+}
+
+std::string CorpusGenerator::makeNumber()
+{
+    switch (below(9))
+    {
+    case 0:
+        return std::to_string(below(1000000));
+    case 1:
+        {
+            static constexpr char c_Hex[] = "0123456789ABCDEF";
+            std::string l_Number = "0x";
+            for (uint32_t l_Digit = 0, l_Count = 1 + below(8); l_Digit < l_Count; ++l_Digit)
+            {
+                l_Number += c_Hex[below(16)];
+            }
+            return l_Number;
+        }
+    case 2:
+        return "0o" + std::to_string(below(8)) + std::to_string(below(8)) + std::to_string(below(8));
+    case 3:
+        {
+            std::string l_Number = "0b1";
+            for (uint32_t l_Digit = 0, l_Count = below(16); l_Digit < l_Count; ++l_Digit)
+            {
+                l_Number += below(2) == 0 ? '0' : '1';
+            }
+            return l_Number;
+        }
+    case 4:
+        return std::to_string(below(10000)) + "." + std::to_string(below(1000));
+    case 5:
+        return std::to_string(1 + below(9)) + "." + std::to_string(below(100)) + (chance(50) ? "e-" : "e") + std::to_string(below(300));
+    case 6:
+        return std::to_string(1 + below(999)) + "_" + std::to_string(100 + below(900)) + "_" + std::to_string(100 + below(900));
+    case 7:
+        return std::to_string(below(100)) + "." + std::to_string(below(10)) + "j";
+    default:
+        return "." + std::to_string(below(1000));
+    }
+}
+
+std::string CorpusGenerator::makeExpression(const uint32_t p_Depth)
+{
+    if (p_Depth == 0 || chance(30))
+    {
+        switch (below(10))
+        {
+        case 0:
+        case 1:
+        case 2:
+            return makeNumber();
+        case 3:
+            return "\"" + std::string(pickWord()) + " " + std::string(pickWord()) + "\"";
+        case 4:
+            return chance(50) ? "True" : chance(50) ? "False" : "None";
+        case 5:
+            return makeName() + "." + std::string(pickWord());
+        case 6:
+            return makeName() + "[" + std::to_string(below(64)) + "]";
+        default:
+            return makeName();
+        }
+    }
+    switch (below(8))
+    {
+    case 0:
+        return "(" + makeExpression(p_Depth - 1) + ")";
+    case 1:
+        return makeName() + "(" + makeExpression(p_Depth - 1) + ", " + makeExpression(p_Depth - 1) + ")";
+    case 2:
+        return "[" + makeExpression(p_Depth - 1) + ", " + makeExpression(p_Depth - 1) + "]";
+    case 3:
+        // Parenthesized, since the result can end up as the operand of a binary operator
+        return "(not " + makeExpression(p_Depth - 1) + ")";
+    default:
+        return makeExpression(p_Depth - 1) + " " + std::string(c_BinaryOperators[below(static_cast<uint32_t>(c_BinaryOperators.size()))]) + " " + makeExpression(p_Depth - 1);
+    }
+}
+
+void CorpusGenerator::appendMixed(std::string& p_Out)
+{
+    const auto l_Condition = [this]
+    {
+        std::string l_Condition = makeExpression(1) + " " + std::string(c_Comparisons[below(static_cast<uint32_t>(c_Comparisons.size()))]) + " " + makeExpression(1);
+        if (chance(30))
+        {
+            l_Condition += (chance(50) ? " and " : " or ") + makeName();
+        }
+        return l_Condition;
+    };
+    const auto l_Statement = [this](std::string& p_Lines, const uint32_t p_Indent)
+    {
+        appendLine(p_Lines, p_Indent, makeName() + " " + std::string(c_Assignments[below(static_cast<uint32_t>(c_Assignments.size()))]) + " " + makeExpression(3));
+    };
+
+    if (chance(70))
+    {
+        appendLine(p_Out, 0, "def " + makeName() + "(" + makeName() + ", " + makeName() + ", " + makeName() + "):");
+        appendLine(p_Out, 1, "# " + std::string(pickWord()) + " the " + std::string(pickWord()) + " before the " + std::string(pickWord()) + " is updated");
+        for (uint32_t l_Line = 0, l_Count = 1 + below(4); l_Line < l_Count; ++l_Line)
+        {
+            l_Statement(p_Out, 1);
+        }
+        appendLine(p_Out, 1, "if " + l_Condition() + ":");
+        l_Statement(p_Out, 2);
+        if (chance(50))
+        {
+            appendLine(p_Out, 1, "elif " + l_Condition() + ":");
+            l_Statement(p_Out, 2);
+        }
+        appendLine(p_Out, 1, "else:");
+        appendLine(p_Out, 2, chance(50) ? "pass" : makeName() + " = " + makeNumber());
+        if (chance(50))
+        {
+            appendLine(p_Out, 1, "while " + l_Condition() + ":");
+            l_Statement(p_Out, 2);
+            appendLine(p_Out, 2, "if " + l_Condition() + ":");
+            appendLine(p_Out, 3, chance(50) ? "break" : "continue");
+        }
+        appendLine(p_Out, 1, "return " + makeExpression(2));
+    }
+    else
+    {
+        appendLine(p_Out, 0, "class " + makeName() + ":");
+        for (uint32_t l_Method = 0, l_Count = 1 + below(3); l_Method < l_Count; ++l_Method)
+        {
+            const bool l_Static = chance(25);
+            if (l_Static)
+            {
+                appendLine(p_Out, 1, "@staticmethod");
+            }
+            appendLine(p_Out, 1, "def " + makeName() + (l_Static ? "(" : "(self, ") + makeName() + "):");
+            appendLine(p_Out, 2, (l_Static ? makeName() : "self." + std::string(pickWord())) + " = " + makeExpression(2));
+            appendLine(p_Out, 2, "return " + makeExpression(1));
+        }
+    }
+    p_Out += '\n';
+}
+
+void CorpusGenerator::appendDeepIndent(std::string& p_Out)
+{
+    const uint32_t l_Depth = 10 + below(40);
+    appendLine(p_Out, 0, "def " + makeName() + "(" + makeName() + "):");
+    for (uint32_t l_Level = 1; l_Level <= l_Depth; ++l_Level)
+    {
+        switch (below(3))
+        {
+        case 0:
+            appendLine(p_Out, l_Level, "if " + makeName() + " > " + makeNumber() + ":");
+            break;
+        case 1:
+            appendLine(p_Out, l_Level, "while " + makeName() + ":");
+            break;
+        default:
+            appendLine(p_Out, l_Level, "if not " + makeName() + ":");
+            break;
+        }
+        if (chance(40))
+        {
+            appendLine(p_Out, l_Level + 1, makeName() + " = " + makeExpression(1));
+        }
+    }
+    // Back out a few levels at a time, so that single lines close several blocks at once
+    for (uint32_t l_Level = l_Depth + 1; l_Level > 1;)
+    {
+        appendLine(p_Out, l_Level, makeName() + " += " + makeNumber());
+        l_Level -= std::min(l_Level - 1, 1 + below(4));
+    }
+    appendLine(p_Out, 1, "return " + makeName());
+    p_Out += '\n';
+}
+
+void CorpusGenerator::appendLongStrings(std::string& p_Out)
+{
+    const auto l_Text = [this](const uint32_t p_Words, const bool p_Punctuation)
+    {
+        std::string l_Text;
+        for (uint32_t l_Word = 0; l_Word < p_Words; ++l_Word)
+        {
+            if (l_Word != 0)
+            {
+                l_Text += ' ';
+            }
+            l_Text += pickWord();
+            if (p_Punctuation && chance(10))
+            {
+                l_Text += c_Punctuation[below(static_cast<uint32_t>(c_Punctuation.size()))];
+            }
+        }
+        return l_Text;
+    };
+
+    switch (below(3))
+    {
+    case 0:
+        {
+            const char l_Quote = chance(50) ? '"' : '\'';
+            appendLine(p_Out, 0, makeName() + " = " + l_Quote + l_Text(30 + below(600), true) + l_Quote);
+            break;
+        }
+    case 1:
+        {
+            // Triple quoted strings span lines, which the tokenizer has to carry across line starts
+            const std::string_view l_Quotes = chance(50) ? "\"\"\"" : "'''";
+            std::string l_Lines = makeName() + " = " + std::string(l_Quotes);
+            for (uint32_t l_Line = 0, l_Count = 2 + below(30); l_Line < l_Count; ++l_Line)
+            {
+                l_Lines += l_Text(4 + below(12), false);
+                l_Lines += '\n';
+            }
+            l_Lines += l_Quotes;
+            appendLine(p_Out, 0, l_Lines);
+            break;
+        }
+    default:
+        appendLine(p_Out, 0, "def " + makeName() + "():");
+        appendLine(p_Out, 1, "\"\"\"" + l_Text(8 + below(40), false) + "\"\"\"");
+        appendLine(p_Out, 1, "return \"" + l_Text(10 + below(200), true) + "\" + '" + l_Text(5 + below(50), false) + "'");
+        break;
+    }
+}
+
+void CorpusGenerator::appendNumbers(std::string& p_Out)
+{
+    if (chance(60))
+    {
+        // Tables are sometimes split over lines, which stay one logical line inside the brackets
+        const bool l_Split = chance(40);
+        std::string l_Table = makeName() + " = [";
+        for (uint32_t l_Entry = 0, l_Count = 8 + below(32); l_Entry < l_Count; ++l_Entry)
+        {
+            if (l_Entry != 0)
+            {
+                l_Table += l_Split && l_Entry % 8 == 0 ? ",\n    " : ", ";
+            }
+            l_Table += makeNumber();
+        }
+        l_Table += ']';
+        appendLine(p_Out, 0, l_Table);
+        return;
+    }
+    std::string l_Expression = makeNumber();
+    for (uint32_t l_Term = 0, l_Count = 2 + below(10); l_Term < l_Count; ++l_Term)
+    {
+        l_Expression += ' ';
+        l_Expression += c_BinaryOperators[below(6)];
+        l_Expression += ' ';
+        l_Expression += makeNumber();
+    }
+    appendLine(p_Out, 0, makeName() + " = " + l_Expression);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Synthetic Python sources for the benchmarks, restricted to the subset the tokenizer and the parser accept so that a
+// run measures lexing and parsing rather than error reporting. Output depends on the seed only: mt19937_64 is fully
+// specified by the standard, and its raw output is all that is used, never the library's distributions
+class CorpusGenerator
+{
+public:
+    enum Shape: uint8_t
+    {
+        // Functions and classes with a bit of everything, the closest to real code
+        MIXED,
+        // Blocks nested dozens of levels deep, heavy on INDENT and DEDENT
+        DEEP_INDENT,
+        // Long single line and triple quoted strings
+        LONG_STRINGS,
+        // Number literals of every form, in tables and expressions
+        NUMBERS,
+        SHAPE_COUNT
+    };
+
+    explicit CorpusGenerator(uint64_t p_Seed);
+
+    // At least p_Size bytes of the given shape, made of whole top level statements
+    [[nodiscard]] std::string generateModule(Shape p_Shape, size_t p_Size);
+    // Writes p_ModuleCount MIXED modules of about p_ModuleSize bytes to p_Directory. Module i imports module i + 1 and
+    // up to p_Fanout - 1 random later ones, so the graph is acyclic and everything is reachable from the entry
+    // module, whose path is returned
+    std::filesystem::path generateImportGraph(const std::filesystem::path& p_Directory, uint32_t p_ModuleCount, uint32_t p_Fanout, size_t p_ModuleSize);
+
+    [[nodiscard]] static std::string_view getShapeName(Shape p_Shape);
+    [[nodiscard]] static std::optional<Shape> findShape(std::string_view p_Name);
+
+private:
+    [[nodiscard]] uint32_t below(uint32_t p_Bound);
+    [[nodiscard]] bool chance(uint32_t p_Percent) { return below(100) < p_Percent; }
+    [[nodiscard]] std::string_view pickWord();
+    [[nodiscard]] std::string makeName();
+    [[nodiscard]] std::string makeNumber();
+    [[nodiscard]] std::string makeExpression(uint32_t p_Depth);
+
+    void appendMixed(std::string& p_Out);
+    void appendDeepIndent(std::string& p_Out);
+    void appendLongStrings(std::string& p_Out);
+    void appendNumbers(std::string& p_Out);
+
+    std::mt19937_64 m_Random;
+    uint32_t m_NextName = 0;
+};
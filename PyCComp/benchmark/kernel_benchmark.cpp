@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Numeric kernels compiled with pyccomp and run against CPython. Each kernel in PYCCOMP_KERNEL_DIR is compiled to C++,
+// built with the host compiler, and both programs are timed as whole processes and must print the same thing
+namespace
+{
+    struct Options
+    {
+        uint32_t repeat = 3;
+        std::string compiler = "c++";
+        std::string python = "python3";
+        std::vector<std::string> kernels;
+        std::filesystem::path workDir;
+        std::filesystem::path output = "kernel_benchmark.json";
+    };
+
+    struct Result
+    {
+        std::string name;
+        // Every measured run, sorted
+        std::vector<double> nativeSeconds = {};
+        std::vector<double> pythonSeconds = {};
+        bool matches = false;
+
+        [[nodiscard]] double getNativeMedian() const { return nativeSeconds[nativeSeconds.size() / 2]; }
+        [[nodiscard]] double getPythonMedian() const { return pythonSeconds[pythonSeconds.size() / 2]; }
+        [[nodiscard]] double getSpeedup() const { return getPythonMedian() / getNativeMedian(); }
+    };
+
+    // Single quoted for /bin/sh
+    std::string quote(const std::string_view p_Text)
+    {
+        std::string l_Quoted = "'";
+        for (const char l_Char : p_Text)
+        {
+            l_Quoted += l_Char == '\'' ? std::string("'\\''") : std::string(1, l_Char);
+        }
+        return l_Quoted + "'";
+    }
+
+    bool run(const std::string& p_Command)
+    {
+        return std::system(p_Command.c_str()) == 0;
+    }
+
+    std::string readFile(const std::filesystem::path& p_Path)
+    {
+        std::ifstream l_File(p_Path, std::ios::binary);
+        std::ostringstream l_Contents;
+        l_Contents << l_File.rdbuf();
+        return l_Contents.str();
+    }
+
+    bool writeFile(const std::filesystem::path& p_Path, const std::string_view p_Contents)
+    {
+        std::ofstream l_File(p_Path, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(l_File.write(p_Contents.data(), static_cast<std::streamsize>(p_Contents.size())));
+    }
+
+    // One unmeasured run to warm caches, then p_Repeat measured ones. The output of the first run is left in p_Output
+    bool measure(const std::string& p_Command, const std::filesystem::path& p_Output, const uint32_t p_Repeat, std::vector<double>& p_Seconds)
+    {
+        if (!run(p_Command + " > " + quote(p_Output.string())))
+        {
+            return false;
+        }
+        for (uint32_t l_Run = 0; l_Run < p_Repeat; ++l_Run)
+        {
+            const std::chrono::steady_clock::time_point l_Start = std::chrono::steady_clock::now();
+            if (!run(p_Command + " > /dev/null"))
+            {
+                return false;
+            }
+            p_Seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - l_Start).count());
+        }
+        std::ranges::sort(p_Seconds);
+        return true;
+    }
+
+    void appendNumber(std::string& p_Out, const double p_Value)
+    {
+        char l_Buffer[32];
+        p_Out.append(l_Buffer, std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), p_Value).ptr);
+    }
+
+    void appendField(std::string& p_Out, const std::string_view p_Name, const double p_Value, const bool p_Last = false)
+    {
+        p_Out += "      \"";
+        p_Out += p_Name;
+        p_Out += "\": ";
+        appendNumber(p_Out, p_Value);
+        p_Out += p_Last ? "\n" : ",\n";
+    }
+
+    std::string writeJson(const Options& p_Options, const std::vector<Result>& p_Results)
+    {
+        std::string l_Json = "{\n  \"benchmark\": \"pyccomp-kernels\",\n  \"format\": 1,\n";
+        l_Json += "  \"compiler\": \"" + p_Options.compiler + "\",\n";
+        l_Json += "  \"python\": \"" + p_Options.python + "\",\n";
+        l_Json += "  \"repeat\": " + std::to_string(p_Options.repeat) + ",\n";
+        l_Json += "  \"results\": [\n";
+        for (size_t l_Index = 0; l_Index < p_Results.size(); ++l_Index)
+        {
+            const Result& l_Result = p_Results[l_Index];
+            l_Json += "    {\n      \"name\": \"" + l_Result.name + "\",\n";
+            l_Json += std::string("      \"output_matches\": ") + (l_Result.matches ? "true" : "false") + ",\n";
+            appendField(l_Json, "runs", static_cast<double>(l_Result.nativeSeconds.size()));
+            appendField(l_Json, "native_best_seconds", l_Result.nativeSeconds.front());
+            appendField(l_Json, "native_median_seconds", l_Result.getNativeMedian());
+            appendField(l_Json, "python_best_seconds", l_Result.pythonSeconds.front());
+            appendField(l_Json, "python_median_seconds", l_Result.getPythonMedian());
+            appendField(l_Json, "speedup", l_Result.getSpeedup(), true);
+            l_Json += l_Index + 1 < p_Results.size() ? "    },\n" : "    }\n";
+        }
+        l_Json += "  ]\n}\n";
+        return l_Json;
+    }
+
+    void printTable(const std::vector<Result>& p_Results)
+    {
+        std::cout << std::left << std::setw(16) << "Kernel" << std::right << std::setw(12) << "Native s" << std::setw(12) << "CPython s"
+                  << std::setw(12) << "Speedup" << std::setw(10) << "Output" << '\n';
+        std::cout << std::fixed;
+        for (const Result& l_Result : p_Results)
+        {
+            std::cout << std::left << std::setw(16) << l_Result.name << std::right << std::setprecision(3)
+                      << std::setw(12) << l_Result.getNativeMedian()
+                      << std::setw(12) << l_Result.getPythonMedian()
+                      << std::setw(11) << std::setprecision(1) << l_Result.getSpeedup() << 'x'
+                      << std::setw(10) << (l_Result.matches ? "same" : "DIFFERS") << '\n';
+        }
+    }
+
+    bool parseCount(const std::string_view p_Text, uint64_t& p_Value)
+    {
+        const std::from_chars_result l_Parse = std::from_chars(p_Text.data(), p_Text.data() + p_Text.size(), p_Value);
+        return !p_Text.empty() && l_Parse.ec == std::errc{} && l_Parse.ptr == p_Text.data() + p_Text.size();
+    }
+
+    constexpr std::string_view c_Usage =
+        "Arguments: [--repeat <n>] [--cxx <compiler>] [--python <interpreter>] [--kernel <name>]... [--work-dir <dir>]\n"
+        "           [--out <file.json>]\n";
+}
+
+int main(const int argc, char* argv[])
+{
+    Options l_Options;
+    for (int l_Arg = 1; l_Arg < argc; ++l_Arg)
+    {
+        const std::string_view l_Name = argv[l_Arg];
+        if (l_Arg + 1 >= argc)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        const std::string_view l_Value = argv[++l_Arg];
+        if (l_Name == "--cxx" || l_Name == "--python")
+        {
+            (l_Name == "--cxx" ? l_Options.compiler : l_Options.python) = l_Value;
+            continue;
+        }
+        if (l_Name == "--kernel")
+        {
+            l_Options.kernels.emplace_back(l_Value);
+            continue;
+        }
+        if (l_Name == "--work-dir" || l_Name == "--out")
+        {
+            (l_Name == "--out" ? l_Options.output : l_Options.workDir) = l_Value;
+            continue;
+        }
+        uint64_t l_Count = 0;
+        if (l_Name != "--repeat" || !parseCount(l_Value, l_Count) || l_Count == 0 || l_Count > UINT32_MAX)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        l_Options.repeat = static_cast<uint32_t>(l_Count);
+    }
+    const std::filesystem::path l_KernelDir = PYCCOMP_KERNEL_DIR;
+    if (l_Options.kernels.empty())
+    {
+        for (const std::filesystem::directory_entry& l_Entry : std::filesystem::directory_iterator(l_KernelDir))
+        {
+            if (l_Entry.path().extension() == ".py")
+            {
+                l_Options.kernels.push_back(l_Entry.path().stem().string());
+            }
+        }
+        std::ranges::sort(l_Options.kernels);
+    }
+    if (l_Options.workDir.empty())
+    {
+        l_Options.workDir = std::filesystem::temp_directory_path() / "pyccomp-kernels";
+    }
+
+    std::vector<Result> l_Results;
+    try
+    {
+        std::filesystem::create_directories(l_Options.workDir);
+        for (const std::string& l_Kernel : l_Options.kernels)
+        {
+            const std::filesystem::path l_Source = l_KernelDir / (l_Kernel + ".py");
+            const std::filesystem::path l_Base = l_Options.workDir / l_Kernel;
+            const std::string l_Cpp = l_Base.string() + ".cpp";
+            if (!std::filesystem::exists(l_Source))
+            {
+                std::cerr << "Unknown kernel: " << l_Kernel << "\n";
+                return 1;
+            }
+            // Compiled and built once, outside the measured runs
+            if (!run(quote(PYCCOMP_COMPILER) + " --no-cache --emit=cpp " + quote(l_Cpp) + " " + quote(l_Source.string()))
+                || !run(quote(l_Options.compiler) + " -std=c++23 -O2 -I " + quote(PYCCOMP_RUNTIME_DIR) + " " + quote(l_Cpp) + " -o " + quote(l_Base.string())))
+            {
+                std::cerr << "Could not build " << l_Kernel << "\n";
+                return 1;
+            }
+            Result l_Result{ .name = l_Kernel };
+            const std::filesystem::path l_NativeOutput = l_Base.string() + ".native.txt";
+            const std::filesystem::path l_PythonOutput = l_Base.string() + ".python.txt";
+            if (!measure(quote(l_Base.string()), l_NativeOutput, l_Options.repeat, l_Result.nativeSeconds)
+                || !measure(quote(l_Options.python) + " " + quote(l_Source.string()), l_PythonOutput, l_Options.repeat, l_Result.pythonSeconds))
+            {
+                std::cerr << "Could not run " << l_Kernel << "\n";
+                return 1;
+            }
+            l_Result.matches = readFile(l_NativeOutput) == readFile(l_PythonOutput);
+            l_Results.push_back(std::move(l_Result));
+        }
+    }
+    catch (const std::exception& l_Error)
+    {
+        std::cerr << l_Error.what() << "\n";
+        return 1;
+    }
+
+    printTable(l_Results);
+    if (!writeFile(l_Options.output, writeJson(l_Options, l_Results)))
+    {
+        std::cerr << "Could not write " << l_Options.output.string() << "\n";
+        return 1;
+    }
+    std::cout << "Results written to " << l_Options.output.string() << "\n";
+    return std::ranges::all_of(l_Results, &Result::matches) ? 0 : 1;
+}
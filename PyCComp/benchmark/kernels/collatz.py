@@ -0,0 +1,23 @@
+# Longest Collatz chain below a bound, a while loop inside a counted one
+N = 300000
+
+
+def longest(n):
+    best = 0
+    start = 0
+    for i in range(1, n):
+        x = i
+        steps = 0
+        while x != 1:
+            if x % 2 == 0:
+                x = x // 2
+            else:
+                x = 3 * x + 1
+            steps += 1
+        if steps > best:
+            best = steps
+            start = i
+    return start
+
+
+print(longest(N))
@@ -0,0 +1,21 @@
+# Dot product of two float lists, indexed by range(len(...))
+N = 1000000
+ROUNDS = 20
+
+
+def dot(xs, ys):
+    total = 0.0
+    for i in range(len(xs)):
+        total += xs[i] * ys[i]
+    return total
+
+
+xs = []
+ys = []
+for i in range(N):
+    xs.append(i * 0.5)
+    ys.append(1.0 / (i + 1))
+result = 0.0
+for r in range(ROUNDS):
+    result += dot(xs, ys)
+print(result)
@@ -0,0 +1,23 @@
+# Mean and variance of a float list, iterated directly
+N = 2000000
+ROUNDS = 10
+
+
+def variance(values):
+    total = 0.0
+    for v in values:
+        total += v
+    mean = total / len(values)
+    spread = 0.0
+    for v in values:
+        spread += (v - mean) * (v - mean)
+    return spread / len(values)
+
+
+values = []
+for i in range(N):
+    values.append((i * 7919) % 1000 * 0.001)
+result = 0.0
+for r in range(ROUNDS):
+    result += variance(values)
+print(result)
@@ -0,0 +1,24 @@
+# Naive product of two square matrices stored row major in flat lists
+N = 160
+
+
+def matmul(a, b, c, n):
+    for i in range(n):
+        for k in range(n):
+            aik = a[i * n + k]
+            for j in range(n):
+                c[i * n + j] += aik * b[k * n + j]
+
+
+a = []
+b = []
+c = []
+for i in range(N * N):
+    a.append((i % 13) * 0.5)
+    b.append((i % 7) * 0.25)
+    c.append(0.0)
+matmul(a, b, c, N)
+total = 0.0
+for v in c:
+    total += v
+print(total)
@@ -0,0 +1,23 @@
+# Sum of squares over a counted range, and stepped ranges whose last step would pass the ends of a 64-bit int
+N = 20000000
+
+
+def sum_squares(n):
+    total = 0
+    for i in range(n):
+        total += i * i % 7
+    return total
+
+
+def edge_steps(top):
+    n = 0
+    for i in range(0, top, 2 ** 62):
+        n += 1
+    for i in range(-top, -top - 1, -3):
+        n += 1
+    for i in range(top - 5, top, 2):
+        n += i - top
+    return n
+
+
+print(sum_squares(N), edge_steps(2 ** 63 - 1))
@@ -0,0 +1,18 @@
+# Sieve of Eratosthenes with a stepped range
+N = 10000000
+
+
+def count_primes(n):
+    composite = []
+    for i in range(n + 1):
+        composite.append(False)
+    count = 0
+    for p in range(2, n + 1):
+        if not composite[p]:
+            count += 1
+            for m in range(p * p, n + 1, p):
+                composite[m] = True
+    return count
+
+
+print(count_primes(N))
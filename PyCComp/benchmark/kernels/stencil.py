@@ -0,0 +1,24 @@
+# Three point smoothing written back into the list, and a prefix sum
+N = 1000000
+ROUNDS = 10
+
+
+def smooth(xs, out):
+    for i in range(1, len(xs) - 1):
+        out[i] = (xs[i - 1] + xs[i] + xs[i + 1]) / 3.0
+
+
+def prefix(xs):
+    for i in range(1, len(xs)):
+        xs[i] += xs[i - 1]
+
+
+xs = []
+out = []
+for i in range(N):
+    xs.append(float(i % 100))
+    out.append(0.0)
+for r in range(ROUNDS):
+    smooth(xs, out)
+prefix(out)
+print(out[N - 1])
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "corpus_generator.hpp"
+#include "../src/driver/compilation_context.hpp"
+#include "../src/driver/pipeline.hpp"
+#include "../src/instrumentation/instrumentation.hpp"
+#include "../src/parser/parser.hpp"
+#include "../src/scheduler/task_scheduler.hpp"
+#include "../src/source_file/source_reader.hpp"
+#include "../src/tokenizer/tokenizer.hpp"
+
+namespace
+{
+    struct Options
+    {
+        uint64_t seed = 1;
+        // Per shape, in KiB
+        uint32_t size = 8192;
+        uint32_t modules = 200;
+        uint32_t fanout = 8;
+        // Per module of the import graph, in KiB
+        uint32_t moduleSize = 16;
+        uint32_t repeat = 5;
+        uint32_t jobs = 1;
+        std::vector<CorpusGenerator::Shape> shapes;
+        std::filesystem::path corpusDir;
+        std::filesystem::path output = "tokenizer_benchmark.json";
+        bool generateOnly = false;
+    };
+
+    // What one run of a scenario went through
+    struct Sample
+    {
+        uint64_t bytes = 0;
+        uint64_t tokens = 0;
+        // Zero for scenarios that stop before parsing
+        uint64_t nodes = 0;
+        uint64_t errors = 0;
+        uint32_t modules = 0;
+    };
+
+    struct Result
+    {
+        std::string name;
+        Sample sample = {};
+        // Every measured run, sorted
+        std::vector<double> seconds = {};
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t peakMemoryKb = 0;
+
+        [[nodiscard]] double getMedian() const { return seconds[seconds.size() / 2]; }
+        [[nodiscard]] double getAllocationsPerRun() const { return static_cast<double>(allocations) / static_cast<double>(seconds.size()); }
+    };
+
+    // Peak RSS is per process, so it is reset before each scenario. Needs Linux 4.0 or later, elsewhere the peak
+    // covers the whole run so far
+    void resetPeakMemory()
+    {
+        std::ofstream l_ClearRefs("/proc/self/clear_refs");
+        l_ClearRefs << "5";
+    }
+
+    uint64_t readPeakMemoryKb()
+    {
+        std::ifstream l_Status("/proc/self/status");
+        std::string l_Line;
+        while (std::getline(l_Status, l_Line))
+        {
+            if (l_Line.starts_with("VmHWM:"))
+            {
+                return std::strtoull(l_Line.c_str() + 6, nullptr, 10);
+            }
+        }
+        return 0;
+    }
+
+    // One unmeasured run to warm caches, then p_Repeat measured ones
+    template<typename Run>
+    Result measure(std::string p_Name, const uint32_t p_Repeat, Run&& p_Run)
+    {
+        Result l_Result{ .name = std::move(p_Name) };
+        resetPeakMemory();
+        l_Result.sample = p_Run();
+        const uint64_t l_Allocations = Instrumentation::getCount(Instrumentation::ALLOCATIONS);
+        const uint64_t l_AllocatedBytes = Instrumentation::getCount(Instrumentation::ALLOCATED_BYTES);
+        for (uint32_t l_Run = 0; l_Run < p_Repeat; ++l_Run)
+        {
+            const std::chrono::steady_clock::time_point l_Start = std::chrono::steady_clock::now();
+            p_Run();
+            l_Result.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - l_Start).count());
+        }
+        // The pushes above are part of the count, a handful against the thousands a run makes
+        l_Result.allocations = Instrumentation::getCount(Instrumentation::ALLOCATIONS) - l_Allocations;
+        l_Result.allocatedBytes = Instrumentation::getCount(Instrumentation::ALLOCATED_BYTES) - l_AllocatedBytes;
+        l_Result.peakMemoryKb = readPeakMemoryKb();
+        std::ranges::sort(l_Result.seconds);
+        return l_Result;
+    }
+
+    void appendNumber(std::string& p_Out, const double p_Value)
+    {
+        char l_Buffer[32];
+        p_Out.append(l_Buffer, std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), p_Value).ptr);
+    }
+
+    void appendField(std::string& p_Out, const std::string_view p_Name, const double p_Value, const bool p_Last = false)
+    {
+        p_Out += "      \"";
+        p_Out += p_Name;
+        p_Out += "\": ";
+        appendNumber(p_Out, p_Value);
+        p_Out += p_Last ? "\n" : ",\n";
+    }
+
+    // Throughputs use the median run. MB are 10^6 bytes
+    std::string writeJson(const Options& p_Options, const std::vector<Result>& p_Results)
+    {
+        std::string l_Json = "{\n  \"benchmark\": \"pyccomp-tokenizer\",\n  \"format\": 2,\n";
+        l_Json += "  \"seed\": " + std::to_string(p_Options.seed) + ",\n";
+        l_Json += "  \"jobs\": " + std::to_string(p_Options.jobs) + ",\n";
+        l_Json += "  \"repeat\": " + std::to_string(p_Options.repeat) + ",\n";
+        l_Json += "  \"results\": [\n";
+        for (size_t l_Index = 0; l_Index < p_Results.size(); ++l_Index)
+        {
+            const Result& l_Result = p_Results[l_Index];
+            const double l_Median = l_Result.getMedian();
+            const double l_Tokens = static_cast<double>(l_Result.sample.tokens);
+            l_Json += "    {\n      \"name\": \"" + l_Result.name + "\",\n";
+            appendField(l_Json, "modules", l_Result.sample.modules);
+            appendField(l_Json, "bytes", static_cast<double>(l_Result.sample.bytes));
+            appendField(l_Json, "tokens", l_Tokens);
+            appendField(l_Json, "nodes", static_cast<double>(l_Result.sample.nodes));
+            appendField(l_Json, "errors", static_cast<double>(l_Result.sample.errors));
+            appendField(l_Json, "runs", static_cast<double>(l_Result.seconds.size()));
+            appendField(l_Json, "best_seconds", l_Result.seconds.front());
+            appendField(l_Json, "median_seconds", l_Median);
+            appendField(l_Json, "mb_per_second", static_cast<double>(l_Result.sample.bytes) / 1e6 / l_Median);
+            appendField(l_Json, "tokens_per_second", l_Tokens / l_Median);
+            appendField(l_Json, "allocations_per_run", l_Result.getAllocationsPerRun());
+            appendField(l_Json, "allocations_per_token", l_Tokens > 0 ? l_Result.getAllocationsPerRun() / l_Tokens : 0.0);
+            appendField(l_Json, "allocated_bytes_per_run", static_cast<double>(l_Result.allocatedBytes) / static_cast<double>(l_Result.seconds.size()));
+            appendField(l_Json, "peak_rss_kb", static_cast<double>(l_Result.peakMemoryKb), true);
+            l_Json += l_Index + 1 < p_Results.size() ? "    },\n" : "    }\n";
+        }
+        l_Json += "  ]\n}\n";
+        return l_Json;
+    }
+
+    void printTable(const std::vector<Result>& p_Results)
+    {
+        std::cout << std::left << std::setw(26) << "Scenario" << std::right << std::setw(12) << "MB/s" << std::setw(14) << "Mtokens/s"
+                  << std::setw(12) << "Allocs/tok" << std::setw(12) << "Knodes" << std::setw(14) << "Peak RSS MB" << std::setw(8) << "Errors" << '\n';
+        std::cout << std::fixed;
+        for (const Result& l_Result : p_Results)
+        {
+            const double l_Median = l_Result.getMedian();
+            const double l_Tokens = static_cast<double>(l_Result.sample.tokens);
+            std::cout << std::left << std::setw(26) << l_Result.name << std::right << std::setprecision(1)
+                      << std::setw(12) << static_cast<double>(l_Result.sample.bytes) / 1e6 / l_Median
+                      << std::setw(14) << std::setprecision(2) << l_Tokens / 1e6 / l_Median
+                      << std::setw(12) << std::setprecision(4) << (l_Tokens > 0 ? l_Result.getAllocationsPerRun() / l_Tokens : 0.0)
+                      << std::setw(12) << std::setprecision(1) << static_cast<double>(l_Result.sample.nodes) / 1e3
+                      << std::setw(14) << static_cast<double>(l_Result.peakMemoryKb) / 1024.0
+                      << std::setw(8) << l_Result.sample.errors << '\n';
+        }
+    }
+
+    bool parseCount(const std::string_view p_Text, uint64_t& p_Value)
+    {
+        const std::from_chars_result l_Parse = std::from_chars(p_Text.data(), p_Text.data() + p_Text.size(), p_Value);
+        return !p_Text.empty() && l_Parse.ec == std::errc{} && l_Parse.ptr == p_Text.data() + p_Text.size();
+    }
+
+    bool writeFile(const std::filesystem::path& p_Path, const std::string_view p_Contents)
+    {
+        std::ofstream l_File(p_Path, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(l_File.write(p_Contents.data(), static_cast<std::streamsize>(p_Contents.size())));
+    }
+
+    constexpr std::string_view c_Usage =
+        "Arguments: [--seed <n>] [--size <KiB per shape>] [--modules <n>] [--fanout <n>] [--module-size <KiB>] [--repeat <n>]\n"
+        "           [-j <jobs>] [--shape mixed|deep_indent|long_strings|numbers]... [--corpus-dir <dir>] [--out <file.json>]\n"
+        "           [--generate-only]\n";
+}
+
+int main(const int argc, char* argv[])
+{
+    Options l_Options;
+    for (int l_Arg = 1; l_Arg < argc; ++l_Arg)
+    {
+        const std::string_view l_Name = argv[l_Arg];
+        if (l_Name == "--generate-only")
+        {
+            l_Options.generateOnly = true;
+            continue;
+        }
+        if (l_Arg + 1 >= argc)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        const std::string_view l_Value = argv[++l_Arg];
+        if (l_Name == "--shape")
+        {
+            const std::optional<CorpusGenerator::Shape> l_Shape = CorpusGenerator::findShape(l_Value);
+            if (!l_Shape)
+            {
+                std::cerr << "Unknown shape: " << l_Value << "\n";
+                return 1;
+            }
+            l_Options.shapes.push_back(*l_Shape);
+            continue;
+        }
+        if (l_Name == "--corpus-dir" || l_Name == "--out")
+        {
+            (l_Name == "--out" ? l_Options.output : l_Options.corpusDir) = l_Value;
+            continue;
+        }
+        uint64_t l_Count = 0;
+        if (!parseCount(l_Value, l_Count))
+        {
+            std::cerr << "Invalid value for " << l_Name << ": " << l_Value << "\n";
+            return 1;
+        }
+        if (l_Name == "--seed")
+        {
+            l_Options.seed = l_Count;
+            continue;
+        }
+        uint32_t* const l_Target = l_Name == "--size" ? &l_Options.size
+            : l_Name == "--modules" ? &l_Options.modules
+            : l_Name == "--fanout" ? &l_Options.fanout
+            : l_Name == "--module-size" ? &l_Options.moduleSize
+            : l_Name == "--repeat" ? &l_Options.repeat
+            : l_Name == "-j" ? &l_Options.jobs
+            : nullptr;
+        if (l_Target == nullptr || l_Count == 0 || l_Count > UINT32_MAX)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        *l_Target = static_cast<uint32_t>(l_Count);
+    }
+    if (l_Options.shapes.empty())
+    {
+        for (uint8_t l_Shape = 0; l_Shape < CorpusGenerator::SHAPE_COUNT; ++l_Shape)
+        {
+            l_Options.shapes.push_back(static_cast<CorpusGenerator::Shape>(l_Shape));
+        }
+    }
+    if (l_Options.corpusDir.empty())
+    {
+        l_Options.corpusDir = std::filesystem::temp_directory_path() / ("pyccomp-bench-" + std::to_string(l_Options.seed));
+    }
+
+    // Every shape and the import graph get their own generator, so that selecting shapes does not change the others
+    std::vector<std::string> l_Sources;
+    std::filesystem::path l_Entry;
+    try
+    {
+        std::filesystem::create_directories(l_Options.corpusDir);
+        for (const CorpusGenerator::Shape l_Shape : l_Options.shapes)
+        {
+            CorpusGenerator l_Generator{ l_Options.seed + l_Shape };
+            l_Sources.push_back(l_Generator.generateModule(l_Shape, static_cast<size_t>(l_Options.size) * 1024));
+            const std::filesystem::path l_Path = l_Options.corpusDir / (std::string(CorpusGenerator::getShapeName(l_Shape)) + ".py");
+            if (!writeFile(l_Path, l_Sources.back()))
+            {
+                std::cerr << "Could not write " << l_Path.string() << "\n";
+                return 1;
+            }
+        }
+        CorpusGenerator l_Generator{ l_Options.seed + CorpusGenerator::SHAPE_COUNT };
+        l_Entry = l_Generator.generateImportGraph(l_Options.corpusDir / "graph", l_Options.modules, l_Options.fanout, static_cast<size_t>(l_Options.moduleSize) * 1024);
+    }
+    catch (const std::exception& l_Error)
+    {
+        std::cerr << l_Error.what() << "\n";
+        return 1;
+    }
+    std::cout << "Corpus written to " << l_Options.corpusDir.string() << "\n";
+    if (l_Options.generateOnly)
+    {
+        return 0;
+    }
+
+    // Counters only, and before the scheduler starts its workers
+    Instrumentation::enable(false);
+    std::optional<TaskScheduler> l_Scheduler;
+    if (l_Options.jobs > 1)
+    {
+        l_Scheduler.emplace(l_Options.jobs);
+    }
+    TaskScheduler* const l_Jobs = l_Scheduler ? &*l_Scheduler : nullptr;
+    const std::string l_Suffix = l_Options.jobs > 1 ? "/j" + std::to_string(l_Options.jobs) : "";
+
+    std::vector<Result> l_Results;
+    // The cursor goes first, as memory the heap has touched stays in the RSS the later scenarios start from. Its peak
+    // is the sources plus the window, where tokenize/ holds every token
+    for (size_t l_Index = 0; l_Index < l_Options.shapes.size(); ++l_Index)
+    {
+        const std::string_view l_Source = l_Sources[l_Index];
+        l_Results.push_back(measure("cursor/" + std::string(CorpusGenerator::getShapeName(l_Options.shapes[l_Index])), l_Options.repeat, [&]
+        {
+            SymbolTable l_Symbols;
+            TokenCursor l_Cursor{ l_Source, 1, &l_Symbols };
+            Sample l_Sample{ .bytes = l_Source.size(), .modules = 1 };
+            // Every token pulled, as a parser would
+            while (l_Cursor.next().type != Tokenizer::Token::Type::END)
+            {
+                l_Sample.tokens++;
+            }
+            l_Sample.errors = l_Cursor.getErrors().size();
+            return l_Sample;
+        }));
+    }
+    for (size_t l_Index = 0; l_Index < l_Options.shapes.size(); ++l_Index)
+    {
+        const std::string_view l_Source = l_Sources[l_Index];
+        l_Results.push_back(measure("tokenize/" + std::string(CorpusGenerator::getShapeName(l_Options.shapes[l_Index])) + l_Suffix, l_Options.repeat, [&]
+        {
+            // A fresh context and table each run, as every compilation starts with them
+            CompilationContext l_Context;
+            SymbolTable l_Symbols;
+            const Tokenizer l_Tokenizer{ l_Source, 1, l_Jobs, &l_Symbols, l_Context.getResource() };
+            return Sample{ .bytes = l_Source.size(), .tokens = l_Tokenizer.getTokens().size(), .errors = l_Tokenizer.getErrors().size(), .modules = 1 };
+        }));
+    }
+    for (size_t l_Index = 0; l_Index < l_Options.shapes.size(); ++l_Index)
+    {
+        // Tokenized once up front so that only the parser is measured. Throughputs are still per source byte and token
+        const std::string_view l_Source = l_Sources[l_Index];
+        CompilationContext l_TokenContext;
+        SymbolTable l_Symbols;
+        const Tokenizer l_Tokenizer{ l_Source, 1, l_Jobs, &l_Symbols, l_TokenContext.getResource() };
+        l_Results.push_back(measure("parse/" + std::string(CorpusGenerator::getShapeName(l_Options.shapes[l_Index])), l_Options.repeat, [&]
+        {
+            CompilationContext l_Context;
+            const Ast l_Ast = Parser::parse(l_Tokenizer, l_Context.getResource());
+            return Sample{ .bytes = l_Source.size(), .tokens = l_Tokenizer.getTokens().size(), .nodes = l_Ast.getNodeCount(), .errors = l_Ast.getErrors().size(), .modules = 1 };
+        }));
+    }
+
+    try
+    {
+        // Loading and import scanning alone, then with every module tokenized the way the compiler does it
+        l_Results.push_back(measure("source_reader/graph" + l_Suffix, l_Options.repeat, [&]
+        {
+            CompilationContext l_Context;
+            const SourceReader l_Reader{ l_Entry.filename(), l_Entry.parent_path(), l_Jobs, nullptr, l_Context.getResource() };
+            Sample l_Sample{ .modules = l_Reader.getModuleCount() };
+            for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+            {
+                l_Sample.bytes += l_Reader.getModule(l_Module)->source.getContents().size();
+            }
+            return l_Sample;
+        }));
+        l_Results.push_back(measure("pipeline/graph" + l_Suffix, l_Options.repeat, [&]
+        {
+            CompilationContext l_Context;
+            const SourceReader l_Reader{ l_Entry.filename(), l_Entry.parent_path(), l_Jobs, nullptr, l_Context.getResource() };
+            SymbolTable l_Symbols;
+            std::vector<std::optional<Tokenizer>> l_Tokenizers(l_Reader.getModuleCount());
+            for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+            {
+                const auto l_Tokenize = [&, l_Module] { l_Tokenizers[l_Module] = tokenizeModule(*l_Reader.getModule(l_Module), l_Jobs, nullptr, l_Symbols, l_Context.getResource()); };
+                if (l_Jobs != nullptr)
+                {
+                    l_Jobs->submit(l_Tokenize);
+                }
+                else
+                {
+                    l_Tokenize();
+                }
+            }
+            if (l_Jobs != nullptr)
+            {
+                l_Jobs->wait();
+            }
+            Sample l_Sample{ .modules = l_Reader.getModuleCount() };
+            for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+            {
+                l_Sample.bytes += l_Reader.getModule(l_Module)->source.getContents().size();
+                l_Sample.tokens += l_Tokenizers[l_Module]->getTokens().size();
+                l_Sample.errors += l_Tokenizers[l_Module]->getErrors().size();
+            }
+            return l_Sample;
+        }));
+
+        // Every module of the graph parsed, loaded and tokenized once up front like the shapes above
+        CompilationContext l_TokenContext;
+        const SourceReader l_Reader{ l_Entry.filename(), l_Entry.parent_path(), l_Jobs, nullptr, l_TokenContext.getResource() };
+        SymbolTable l_Symbols;
+        std::vector<std::optional<Tokenizer>> l_Tokenizers(l_Reader.getModuleCount());
+        for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+        {
+            l_Tokenizers[l_Module] = tokenizeModule(*l_Reader.getModule(l_Module), l_Jobs, nullptr, l_Symbols, l_TokenContext.getResource());
+        }
+        l_Results.push_back(measure("parse/graph" + l_Suffix, l_Options.repeat, [&]
+        {
+            CompilationContext l_Context;
+            std::vector<std::optional<Ast>> l_Trees(l_Reader.getModuleCount());
+            for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+            {
+                const auto l_Parse = [&, l_Module] { l_Trees[l_Module] = Parser::parse(*l_Tokenizers[l_Module], l_Context.getResource()); };
+                if (l_Jobs != nullptr)
+                {
+                    l_Jobs->submit(l_Parse);
+                }
+                else
+                {
+                    l_Parse();
+                }
+            }
+            if (l_Jobs != nullptr)
+            {
+                l_Jobs->wait();
+            }
+            Sample l_Sample{ .modules = l_Reader.getModuleCount() };
+            for (uint32_t l_Module = 0; l_Module < l_Reader.getModuleCount(); ++l_Module)
+            {
+                l_Sample.bytes += l_Reader.getModule(l_Module)->source.getContents().size();
+                l_Sample.tokens += l_Tokenizers[l_Module]->getTokens().size();
+                l_Sample.nodes += l_Trees[l_Module]->getNodeCount();
+                l_Sample.errors += l_Trees[l_Module]->getErrors().size();
+            }
+            return l_Sample;
+        }));
+    }
+    catch (const std::exception& l_Error)
+    {
+        std::cerr << l_Error.what() << "\n";
+        return 1;
+    }
+
+    printTable(l_Results);
+    if (!writeFile(l_Options.output, writeJson(l_Options, l_Results)))
+    {
+        std::cerr << "Could not write " << l_Options.output.string() << "\n";
+        return 1;
+    }
+    std::cout << "Results written to " << l_Options.output.string() << "\n";
+    return 0;
+}
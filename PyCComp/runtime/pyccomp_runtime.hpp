@@ -0,0 +1,1573 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Support library of the C++ that --emit=cpp writes, header only. Values the compiler could type are plain C++ ones:
+// int64_t, double, bool, std::string, and List<T> for lists. Value holds any of them, for what it could not type.
+// Where the two differ, Python's behavior is kept, with these exceptions:
+//  - int is 64 bits, arithmetic that leaves that range overflows instead of growing
+//  - str is a string of bytes, indexing and len() count bytes rather than code points
+//  - math functions outside their domain give NaN instead of raising ValueError
+//  - a list keeps the element type it was made with, storing anything else in it raises TypeError
+namespace pyc
+{
+    // A Python exception, reported with its type when it ends the program
+    class Error : public std::runtime_error
+    {
+    public:
+        Error(std::string p_Type, const std::string& p_Message) : std::runtime_error(p_Message), m_Type(std::move(p_Type)) {}
+
+        [[nodiscard]] const std::string& getType() const { return m_Type; }
+
+    private:
+        std::string m_Type;
+    };
+
+    struct NoneType
+    {
+        constexpr bool operator==(const NoneType&) const = default;
+    };
+    inline constexpr NoneType None{};
+
+    class ListObject;
+    template<typename T>
+    class ListStorage;
+    template<typename T>
+    class List;
+
+    // A value of any type, boxed. Lists are held by reference, so a boxed list is the same list as the one it was
+    // made from
+    class Value
+    {
+    public:
+        using Storage = std::variant<NoneType, bool, int64_t, double, std::string, std::shared_ptr<ListObject>>;
+
+        Value() = default;
+        Value(NoneType) {}
+        Value(const bool p_Value) : m_Storage(p_Value) {}
+        Value(const int p_Value) : m_Storage(static_cast<int64_t>(p_Value)) {}
+        Value(const int64_t p_Value) : m_Storage(p_Value) {}
+        Value(const double p_Value) : m_Storage(p_Value) {}
+        Value(const char* p_Value) : m_Storage(std::string(p_Value)) {}
+        Value(std::string p_Value) : m_Storage(std::move(p_Value)) {}
+        Value(std::shared_ptr<ListObject> p_List) : m_Storage(std::move(p_List)) {}
+        template<typename T>
+        Value(const List<T>& p_List);
+
+        [[nodiscard]] bool isNone() const { return std::holds_alternative<NoneType>(m_Storage); }
+        [[nodiscard]] bool isBool() const { return std::holds_alternative<bool>(m_Storage); }
+        [[nodiscard]] bool isInt() const { return std::holds_alternative<int64_t>(m_Storage); }
+        [[nodiscard]] bool isFloat() const { return std::holds_alternative<double>(m_Storage); }
+        [[nodiscard]] bool isString() const { return std::holds_alternative<std::string>(m_Storage); }
+        [[nodiscard]] bool isList() const { return std::holds_alternative<std::shared_ptr<ListObject>>(m_Storage); }
+        // bool included, as Python does arithmetic on it
+        [[nodiscard]] bool isNumber() const { return isBool() || isInt() || isFloat(); }
+
+        [[nodiscard]] bool getBool() const { return std::get<bool>(m_Storage); }
+        [[nodiscard]] int64_t getInt() const { return std::get<int64_t>(m_Storage); }
+        [[nodiscard]] double getFloat() const { return std::get<double>(m_Storage); }
+        [[nodiscard]] const std::string& getString() const { return std::get<std::string>(m_Storage); }
+        [[nodiscard]] ListObject& getList() const { return *std::get<std::shared_ptr<ListObject>>(m_Storage); }
+        [[nodiscard]] const std::shared_ptr<ListObject>& getListPointer() const { return std::get<std::shared_ptr<ListObject>>(m_Storage); }
+        // Only for isNumber() values
+        [[nodiscard]] int64_t toInteger() const { return isBool() ? static_cast<int64_t>(getBool()) : getInt(); }
+        [[nodiscard]] double toDouble() const { return isFloat() ? getFloat() : static_cast<double>(toInteger()); }
+
+        // Python's type(), as named in error messages
+        [[nodiscard]] const char* getTypeName() const
+        {
+            constexpr const char* c_Names[] = { "NoneType", "bool", "int", "float", "str", "list" };
+            return c_Names[m_Storage.index()];
+        }
+
+    private:
+        Storage m_Storage;
+    };
+
+    // Index p_Index from the end if negative, as Python does. Raises IndexError outside the sequence
+    inline int64_t normalizeIndex(int64_t p_Index, const int64_t p_Size, const char* p_What)
+    {
+        if (p_Index < 0)
+        {
+            p_Index += p_Size;
+        }
+        if (p_Index < 0 || p_Index >= p_Size)
+        {
+            throw Error("IndexError", std::string(p_What) + " index out of range");
+        }
+        return p_Index;
+    }
+
+    // A list of any element type, for what holds lists without knowing which
+    class ListObject
+    {
+    public:
+        virtual ~ListObject() = default;
+
+        [[nodiscard]] virtual int64_t size() const = 0;
+        [[nodiscard]] virtual Value get(int64_t p_Index) const = 0;
+        virtual void set(int64_t p_Index, const Value& p_Value) = 0;
+        virtual void append(const Value& p_Value) = 0;
+        virtual Value pop(int64_t p_Index) = 0;
+        virtual void insert(int64_t p_Index, const Value& p_Value) = 0;
+        // A new list of the same element type, empty
+        [[nodiscard]] virtual std::shared_ptr<ListObject> makeEmpty() const = 0;
+    };
+
+    template<typename T>
+    T unbox(const Value& p_Value);
+
+    template<typename T>
+    class ListStorage final : public ListObject
+    {
+    public:
+        ListStorage() = default;
+        explicit ListStorage(std::vector<T> p_Items) : items(std::move(p_Items)) {}
+
+        [[nodiscard]] int64_t size() const override { return static_cast<int64_t>(items.size()); }
+        [[nodiscard]] Value get(const int64_t p_Index) const override { return Value(static_cast<T>(items[normalizeIndex(p_Index, size(), "list")])); }
+        void set(const int64_t p_Index, const Value& p_Value) override { items[normalizeIndex(p_Index, size(), "list assignment")] = unbox<T>(p_Value); }
+        void append(const Value& p_Value) override { items.push_back(unbox<T>(p_Value)); }
+        Value pop(const int64_t p_Index) override { return Value(popItem(p_Index)); }
+        void insert(const int64_t p_Index, const Value& p_Value) override { insertItem(p_Index, unbox<T>(p_Value)); }
+        T popItem(const int64_t p_Index)
+        {
+            if (items.empty())
+            {
+                throw Error("IndexError", "pop from empty list");
+            }
+            const int64_t l_Index = normalizeIndex(p_Index, size(), "pop");
+            T l_Item = items[l_Index];
+            items.erase(items.begin() + l_Index);
+            return l_Item;
+        }
+        void insertItem(const int64_t p_Index, T p_Value)
+        {
+            // Python clamps the position instead of raising
+            const int64_t l_Index = std::clamp<int64_t>(p_Index < 0 ? p_Index + size() : p_Index, 0, size());
+            items.insert(items.begin() + l_Index, std::move(p_Value));
+        }
+        [[nodiscard]] std::shared_ptr<ListObject> makeEmpty() const override { return std::make_shared<ListStorage<T>>(); }
+
+        std::vector<T> items;
+    };
+
+    // A list of T. Copies refer to the same list, like Python names do
+    template<typename T>
+    class List
+    {
+    public:
+        using Element = T;
+
+        List() : m_Storage(std::make_shared<ListStorage<T>>()) {}
+        List(std::initializer_list<T> p_Items) : m_Storage(std::make_shared<ListStorage<T>>(std::vector<T>(p_Items))) {}
+        explicit List(std::vector<T> p_Items) : m_Storage(std::make_shared<ListStorage<T>>(std::move(p_Items))) {}
+        explicit List(std::shared_ptr<ListStorage<T>> p_Storage) : m_Storage(std::move(p_Storage)) {}
+
+        [[nodiscard]] int64_t size() const { return static_cast<int64_t>(m_Storage->items.size()); }
+        // Python indexing, from the end if negative, with IndexError outside the list
+        [[nodiscard]] typename std::vector<T>::const_reference at(const int64_t p_Index) const { return m_Storage->items[normalizeIndex(p_Index, size(), "list")]; }
+        // Unchecked, for indices known to be in the list
+        [[nodiscard]] typename std::vector<T>::const_reference operator[](const int64_t p_Index) const { return m_Storage->items[p_Index]; }
+        void set(const int64_t p_Index, T p_Value) const { m_Storage->items[normalizeIndex(p_Index, size(), "list assignment")] = std::move(p_Value); }
+        void setUnchecked(const int64_t p_Index, T p_Value) const { m_Storage->items[p_Index] = std::move(p_Value); }
+        void append(T p_Value) const { m_Storage->items.push_back(std::move(p_Value)); }
+        T pop(const int64_t p_Index = -1) const { return m_Storage->popItem(p_Index); }
+        void insert(const int64_t p_Index, T p_Value) const { m_Storage->insertItem(p_Index, std::move(p_Value)); }
+        void extend(const List& p_Other) const
+        {
+            // Copied first, the list may be extended with itself
+            const std::vector<T> l_Items = p_Other.m_Storage->items;
+            m_Storage->items.insert(m_Storage->items.end(), l_Items.begin(), l_Items.end());
+        }
+
+        [[nodiscard]] std::vector<T>& getItems() const { return m_Storage->items; }
+        [[nodiscard]] const std::shared_ptr<ListStorage<T>>& getStorage() const { return m_Storage; }
+
+    private:
+        std::shared_ptr<ListStorage<T>> m_Storage;
+    };
+
+    template<typename T>
+    Value::Value(const List<T>& p_List) : m_Storage(std::shared_ptr<ListObject>(p_List.getStorage())) {}
+
+    template<typename T>
+    struct IsList : std::false_type {};
+    template<typename T>
+    struct IsList<List<T>> : std::true_type {};
+
+    // Name of the type a statically typed value has, for error messages
+    template<typename T>
+    const char* getTypeName()
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return "bool";
+        }
+        else if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return "int";
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return "float";
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            return "str";
+        }
+        else if constexpr (std::is_same_v<T, NoneType>)
+        {
+            return "NoneType";
+        }
+        else
+        {
+            return "list";
+        }
+    }
+
+    // The value p_Value holds as a T, which it has to be, or an int or bool where a float or an int is asked for.
+    // Raises TypeError otherwise
+    template<typename T>
+    T unbox(const Value& p_Value)
+    {
+        if constexpr (std::is_same_v<T, Value>)
+        {
+            return p_Value;
+        }
+        else
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                if (p_Value.isBool())
+                {
+                    return p_Value.getBool();
+                }
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                if (p_Value.isInt() || p_Value.isBool())
+                {
+                    return p_Value.toInteger();
+                }
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                if (p_Value.isNumber())
+                {
+                    return p_Value.toDouble();
+                }
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                if (p_Value.isString())
+                {
+                    return p_Value.getString();
+                }
+            }
+            else if constexpr (std::is_same_v<T, NoneType>)
+            {
+                if (p_Value.isNone())
+                {
+                    return None;
+                }
+            }
+            else
+            {
+                static_assert(IsList<T>::value, "Values only hold the types of the compiled subset");
+                if (p_Value.isList())
+                {
+                    if (auto l_Storage = std::dynamic_pointer_cast<ListStorage<typename T::Element>>(p_Value.getListPointer()))
+                    {
+                        return T(std::move(l_Storage));
+                    }
+                }
+            }
+            throw Error("TypeError", std::string("expected ") + getTypeName<T>() + ", got " + p_Value.getTypeName());
+        }
+    }
+
+    // Text
+
+    inline std::string str(const Value& p_Value);
+    inline std::string repr(const Value& p_Value);
+
+    // Shortest text that reads back as the same double, laid out like Python's float repr: positional for exponents
+    // from -4 to 15, scientific otherwise, and always with a '.' or an exponent
+    inline std::string str(const double p_Value)
+    {
+        if (std::isnan(p_Value))
+        {
+            return "nan";
+        }
+        if (std::isinf(p_Value))
+        {
+            return p_Value > 0 ? "inf" : "-inf";
+        }
+        char l_Buffer[64];
+        const char* const l_End = std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), p_Value, std::chars_format::scientific).ptr;
+        const std::string_view l_Text(l_Buffer, static_cast<size_t>(l_End - l_Buffer));
+        const bool l_Negative = l_Text.front() == '-';
+        const size_t l_ExponentAt = l_Text.find('e');
+        std::string l_Digits;
+        for (const char l_Char : l_Text.substr(l_Negative ? 1 : 0, l_ExponentAt - (l_Negative ? 1 : 0)))
+        {
+            if (l_Char != '.')
+            {
+                l_Digits += l_Char;
+            }
+        }
+        const std::string_view l_ExponentText = l_Text.substr(l_ExponentAt + 2);
+        int l_Exponent = 0;
+        std::from_chars(l_ExponentText.data(), l_ExponentText.data() + l_ExponentText.size(), l_Exponent);
+        if (l_Text[l_ExponentAt + 1] == '-')
+        {
+            l_Exponent = -l_Exponent;
+        }
+
+        std::string l_Result = l_Negative ? "-" : "";
+        if (l_Exponent >= 16 || l_Exponent < -4)
+        {
+            l_Result += l_Digits.front();
+            if (l_Digits.size() > 1)
+            {
+                l_Result += '.';
+                l_Result += l_Digits.substr(1);
+            }
+            const std::string l_Magnitude = std::to_string(l_Exponent < 0 ? -l_Exponent : l_Exponent);
+            return l_Result + (l_Exponent < 0 ? "e-" : "e+") + (l_Magnitude.size() < 2 ? "0" : "") + l_Magnitude;
+        }
+        if (l_Exponent < 0)
+        {
+            return l_Result + "0." + std::string(static_cast<size_t>(-l_Exponent - 1), '0') + l_Digits;
+        }
+        const size_t l_IntegerDigits = static_cast<size_t>(l_Exponent) + 1;
+        if (l_Digits.size() <= l_IntegerDigits)
+        {
+            return l_Result + l_Digits + std::string(l_IntegerDigits - l_Digits.size(), '0') + ".0";
+        }
+        return l_Result + l_Digits.substr(0, l_IntegerDigits) + "." + l_Digits.substr(l_IntegerDigits);
+    }
+
+    inline std::string str(const int64_t p_Value) { return std::to_string(p_Value); }
+    inline std::string str(const bool p_Value) { return p_Value ? "True" : "False"; }
+    inline std::string str(const std::string& p_Value) { return p_Value; }
+    inline std::string str(const char* p_Value) { return p_Value; }
+    inline std::string str(NoneType) { return "None"; }
+
+    // Quoted like Python does, with single quotes unless the text has some and no double ones
+    inline std::string repr(const std::string& p_Value)
+    {
+        const char l_Quote = p_Value.find('\'') != std::string::npos && p_Value.find('"') == std::string::npos ? '"' : '\'';
+        std::string l_Result(1, l_Quote);
+        for (const char l_Char : p_Value)
+        {
+            switch (l_Char)
+            {
+            case '\\':
+                l_Result += "\\\\";
+                break;
+            case '\n':
+                l_Result += "\\n";
+                break;
+            case '\r':
+                l_Result += "\\r";
+                break;
+            case '\t':
+                l_Result += "\\t";
+                break;
+            default:
+                if (l_Char == l_Quote)
+                {
+                    l_Result += '\\';
+                    l_Result += l_Char;
+                }
+                else if (static_cast<unsigned char>(l_Char) < 0x20 || l_Char == 0x7f)
+                {
+                    constexpr const char* c_Hex = "0123456789abcdef";
+                    l_Result += "\\x";
+                    l_Result += c_Hex[static_cast<unsigned char>(l_Char) >> 4];
+                    l_Result += c_Hex[static_cast<unsigned char>(l_Char) & 0xf];
+                }
+                else
+                {
+                    l_Result += l_Char;
+                }
+                break;
+            }
+        }
+        return l_Result + l_Quote;
+    }
+
+    template<typename T>
+    std::string repr(const T& p_Value)
+    {
+        if constexpr (IsList<T>::value)
+        {
+            std::string l_Result = "[";
+            for (int64_t l_Index = 0; l_Index < p_Value.size(); ++l_Index)
+            {
+                l_Result += l_Index == 0 ? "" : ", ";
+                l_Result += repr(static_cast<typename T::Element>(p_Value[l_Index]));
+            }
+            return l_Result + "]";
+        }
+        else
+        {
+            return str(p_Value);
+        }
+    }
+
+    template<typename T>
+    std::string str(const List<T>& p_Value)
+    {
+        return repr(p_Value);
+    }
+
+    inline std::string repr(const ListObject& p_List)
+    {
+        std::string l_Result = "[";
+        for (int64_t l_Index = 0; l_Index < p_List.size(); ++l_Index)
+        {
+            l_Result += l_Index == 0 ? "" : ", ";
+            l_Result += repr(p_List.get(l_Index));
+        }
+        return l_Result + "]";
+    }
+
+    inline std::string str(const Value& p_Value)
+    {
+        if (p_Value.isString())
+        {
+            return p_Value.getString();
+        }
+        return repr(p_Value);
+    }
+
+    inline std::string repr(const Value& p_Value)
+    {
+        if (p_Value.isNone())
+        {
+            return "None";
+        }
+        if (p_Value.isBool())
+        {
+            return str(p_Value.getBool());
+        }
+        if (p_Value.isInt())
+        {
+            return str(p_Value.getInt());
+        }
+        if (p_Value.isFloat())
+        {
+            return str(p_Value.getFloat());
+        }
+        if (p_Value.isString())
+        {
+            return repr(p_Value.getString());
+        }
+        return repr(p_Value.getList());
+    }
+
+    // print() with the given sep and end
+    template<typename... Args>
+    void printWith([[maybe_unused]] const std::string_view p_Separator, const std::string_view p_End, const Args&... p_Values)
+    {
+        std::string l_Line;
+        bool l_First = true;
+        ((l_Line += l_First ? std::string_view{} : p_Separator, l_Line += str(p_Values), l_First = false), ...);
+        l_Line += p_End;
+        std::cout.write(l_Line.data(), static_cast<std::streamsize>(l_Line.size()));
+    }
+
+    template<typename... Args>
+    void print(const Args&... p_Values)
+    {
+        printWith(" ", "\n", p_Values...);
+    }
+
+    // Truth
+
+    inline bool truthy(const bool p_Value) { return p_Value; }
+    inline bool truthy(const int64_t p_Value) { return p_Value != 0; }
+    inline bool truthy(const double p_Value) { return p_Value != 0.0; }
+    inline bool truthy(const std::string& p_Value) { return !p_Value.empty(); }
+    inline bool truthy(NoneType) { return false; }
+    template<typename T>
+    bool truthy(const List<T>& p_Value) { return p_Value.size() != 0; }
+    inline bool truthy(const Value& p_Value)
+    {
+        if (p_Value.isNumber())
+        {
+            return p_Value.toDouble() != 0.0;
+        }
+        if (p_Value.isString())
+        {
+            return !p_Value.getString().empty();
+        }
+        return p_Value.isList() && p_Value.getList().size() != 0;
+    }
+
+    // Arithmetic, with Python's rounding and errors. The operators C++ already gets right are emitted as they are
+
+    inline Error unsupported(const char* p_Operator, const Value& p_Left, const Value& p_Right)
+    {
+        return Error("TypeError", std::string("unsupported operand type(s) for ") + p_Operator + ": '" + p_Left.getTypeName() + "' and '" + p_Right.getTypeName() + "'");
+    }
+
+    // Wrapping, where C++ leaves signed overflow undefined
+    inline int64_t wrap(const uint64_t p_Value) { return static_cast<int64_t>(p_Value); }
+    inline int64_t add(const int64_t p_Left, const int64_t p_Right) { return wrap(static_cast<uint64_t>(p_Left) + static_cast<uint64_t>(p_Right)); }
+    inline int64_t subtract(const int64_t p_Left, const int64_t p_Right) { return wrap(static_cast<uint64_t>(p_Left) - static_cast<uint64_t>(p_Right)); }
+    inline int64_t multiply(const int64_t p_Left, const int64_t p_Right) { return wrap(static_cast<uint64_t>(p_Left) * static_cast<uint64_t>(p_Right)); }
+    inline int64_t negate(const int64_t p_Value) { return wrap(0 - static_cast<uint64_t>(p_Value)); }
+
+    inline double divide(const double p_Left, const double p_Right)
+    {
+        if (p_Right == 0.0)
+        {
+            throw Error("ZeroDivisionError", "division by zero");
+        }
+        return p_Left / p_Right;
+    }
+
+    inline int64_t floorDivide(const int64_t p_Left, const int64_t p_Right)
+    {
+        if (p_Right == 0)
+        {
+            throw Error("ZeroDivisionError", "integer division or modulo by zero");
+        }
+        if (p_Right == -1)
+        {
+            return negate(p_Left);
+        }
+        const int64_t l_Quotient = p_Left / p_Right;
+        return (p_Left % p_Right != 0 && (p_Left < 0) != (p_Right < 0)) ? l_Quotient - 1 : l_Quotient;
+    }
+
+    inline double floorDivide(const double p_Left, const double p_Right)
+    {
+        if (p_Right == 0.0)
+        {
+            throw Error("ZeroDivisionError", "float floor division by zero");
+        }
+        return std::floor(p_Left / p_Right);
+    }
+
+    inline int64_t modulo(const int64_t p_Left, const int64_t p_Right)
+    {
+        if (p_Right == 0)
+        {
+            throw Error("ZeroDivisionError", "integer division or modulo by zero");
+        }
+        if (p_Right == -1)
+        {
+            return 0;
+        }
+        const int64_t l_Remainder = p_Left % p_Right;
+        return l_Remainder != 0 && (l_Remainder < 0) != (p_Right < 0) ? l_Remainder + p_Right : l_Remainder;
+    }
+
+    inline double modulo(const double p_Left, const double p_Right)
+    {
+        if (p_Right == 0.0)
+        {
+            throw Error("ZeroDivisionError", "float modulo");
+        }
+        double l_Remainder = std::fmod(p_Left, p_Right);
+        if (l_Remainder != 0.0 && (l_Remainder < 0.0) != (p_Right < 0.0))
+        {
+            l_Remainder += p_Right;
+        }
+        return l_Remainder;
+    }
+
+    // Only for exponents known not to be negative, which give an int
+    inline int64_t power(const int64_t p_Base, int64_t p_Exponent)
+    {
+        uint64_t l_Result = 1;
+        uint64_t l_Base = static_cast<uint64_t>(p_Base);
+        while (p_Exponent > 0)
+        {
+            if (p_Exponent & 1)
+            {
+                l_Result *= l_Base;
+            }
+            l_Base *= l_Base;
+            p_Exponent >>= 1;
+        }
+        return wrap(l_Result);
+    }
+
+    inline double power(const double p_Base, const double p_Exponent)
+    {
+        if (p_Base == 0.0 && p_Exponent < 0.0)
+        {
+            throw Error("ZeroDivisionError", "0.0 cannot be raised to a negative power");
+        }
+        return std::pow(p_Base, p_Exponent);
+    }
+
+    inline int64_t shiftLeft(const int64_t p_Value, const int64_t p_Count)
+    {
+        if (p_Count < 0)
+        {
+            throw Error("ValueError", "negative shift count");
+        }
+        return p_Count >= 64 ? 0 : wrap(static_cast<uint64_t>(p_Value) << p_Count);
+    }
+
+    inline int64_t shiftRight(const int64_t p_Value, const int64_t p_Count)
+    {
+        if (p_Count < 0)
+        {
+            throw Error("ValueError", "negative shift count");
+        }
+        return p_Count >= 64 ? (p_Value < 0 ? -1 : 0) : p_Value >> p_Count;
+    }
+
+    inline std::string repeat(const std::string& p_Value, const int64_t p_Count)
+    {
+        std::string l_Result;
+        for (int64_t l_Index = 0; l_Index < p_Count; ++l_Index)
+        {
+            l_Result += p_Value;
+        }
+        return l_Result;
+    }
+
+    template<typename T>
+    List<T> repeat(const List<T>& p_Value, const int64_t p_Count)
+    {
+        std::vector<T> l_Items;
+        for (int64_t l_Index = 0; l_Index < p_Count; ++l_Index)
+        {
+            l_Items.insert(l_Items.end(), p_Value.getItems().begin(), p_Value.getItems().end());
+        }
+        return List<T>(std::move(l_Items));
+    }
+
+    template<typename T>
+    List<T> concat(const List<T>& p_Left, const List<T>& p_Right)
+    {
+        std::vector<T> l_Items = p_Left.getItems();
+        l_Items.insert(l_Items.end(), p_Right.getItems().begin(), p_Right.getItems().end());
+        return List<T>(std::move(l_Items));
+    }
+
+    // Numbers of a boxed operation: a float if either is one, an int otherwise
+    template<typename IntOperation, typename FloatOperation>
+    Value numeric(const Value& p_Left, const Value& p_Right, const IntOperation& p_Int, const FloatOperation& p_Float)
+    {
+        if (p_Left.isFloat() || p_Right.isFloat())
+        {
+            return Value(p_Float(p_Left.toDouble(), p_Right.toDouble()));
+        }
+        return Value(p_Int(p_Left.toInteger(), p_Right.toInteger()));
+    }
+
+    // A new list with the items of p_Left p_Times times, then those of p_Right. It keeps the element type of p_Left,
+    // which the items of p_Right have to be
+    inline std::shared_ptr<ListObject> concatLists(const ListObject& p_Left, const ListObject* p_Right, const int64_t p_Times = 1)
+    {
+        std::shared_ptr<ListObject> l_Result = p_Left.makeEmpty();
+        const int64_t l_Size = p_Left.size();
+        for (int64_t l_Time = 0; l_Time < p_Times; ++l_Time)
+        {
+            for (int64_t l_Index = 0; l_Index < l_Size; ++l_Index)
+            {
+                l_Result->append(p_Left.get(l_Index));
+            }
+        }
+        for (int64_t l_Index = 0; p_Right != nullptr && l_Index < p_Right->size(); ++l_Index)
+        {
+            l_Result->append(p_Right->get(l_Index));
+        }
+        return l_Result;
+    }
+
+    inline Value add(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return numeric(p_Left, p_Right, [](const int64_t a, const int64_t b) { return add(a, b); }, [](const double a, const double b) { return a + b; });
+        }
+        if (p_Left.isString() && p_Right.isString())
+        {
+            return Value(p_Left.getString() + p_Right.getString());
+        }
+        if (p_Left.isList() && p_Right.isList())
+        {
+            return Value(concatLists(p_Left.getList(), &p_Right.getList()));
+        }
+        throw unsupported("+", p_Left, p_Right);
+    }
+
+    inline Value subtract(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return numeric(p_Left, p_Right, [](const int64_t a, const int64_t b) { return subtract(a, b); }, [](const double a, const double b) { return a - b; });
+        }
+        throw unsupported("-", p_Left, p_Right);
+    }
+
+    inline Value multiply(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return numeric(p_Left, p_Right, [](const int64_t a, const int64_t b) { return multiply(a, b); }, [](const double a, const double b) { return a * b; });
+        }
+        const bool l_LeftCount = p_Left.isInt() || p_Left.isBool();
+        const bool l_RightCount = p_Right.isInt() || p_Right.isBool();
+        if ((p_Left.isString() || p_Left.isList()) && l_RightCount)
+        {
+            return p_Left.isString() ? Value(repeat(p_Left.getString(), p_Right.toInteger())) : Value(concatLists(p_Left.getList(), nullptr, p_Right.toInteger()));
+        }
+        if ((p_Right.isString() || p_Right.isList()) && l_LeftCount)
+        {
+            return multiply(p_Right, p_Left);
+        }
+        throw unsupported("*", p_Left, p_Right);
+    }
+
+    inline Value divide(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return Value(divide(p_Left.toDouble(), p_Right.toDouble()));
+        }
+        throw unsupported("/", p_Left, p_Right);
+    }
+
+    inline Value floorDivide(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return numeric(p_Left, p_Right, [](const int64_t a, const int64_t b) { return floorDivide(a, b); }, [](const double a, const double b) { return floorDivide(a, b); });
+        }
+        throw unsupported("//", p_Left, p_Right);
+    }
+
+    inline Value modulo(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return numeric(p_Left, p_Right, [](const int64_t a, const int64_t b) { return modulo(a, b); }, [](const double a, const double b) { return modulo(a, b); });
+        }
+        throw unsupported("%", p_Left, p_Right);
+    }
+
+    inline Value power(const Value& p_Left, const Value& p_Right)
+    {
+        if (!p_Left.isNumber() || !p_Right.isNumber())
+        {
+            throw unsupported("** or pow()", p_Left, p_Right);
+        }
+        // A negative int exponent makes a float
+        if (!p_Left.isFloat() && !p_Right.isFloat() && p_Right.toInteger() >= 0)
+        {
+            return Value(power(p_Left.toInteger(), p_Right.toInteger()));
+        }
+        return Value(power(p_Left.toDouble(), p_Right.toDouble()));
+    }
+
+    template<typename Operation>
+    Value bitwise(const char* p_Operator, const Value& p_Left, const Value& p_Right, const Operation& p_Operation)
+    {
+        if (p_Left.isBool() && p_Right.isBool())
+        {
+            return Value(static_cast<bool>(p_Operation(p_Left.toInteger(), p_Right.toInteger())));
+        }
+        if ((p_Left.isInt() || p_Left.isBool()) && (p_Right.isInt() || p_Right.isBool()))
+        {
+            return Value(p_Operation(p_Left.toInteger(), p_Right.toInteger()));
+        }
+        throw unsupported(p_Operator, p_Left, p_Right);
+    }
+
+    inline Value bitAnd(const Value& p_Left, const Value& p_Right) { return bitwise("&", p_Left, p_Right, [](const int64_t a, const int64_t b) { return a & b; }); }
+    inline Value bitOr(const Value& p_Left, const Value& p_Right) { return bitwise("|", p_Left, p_Right, [](const int64_t a, const int64_t b) { return a | b; }); }
+    inline Value bitXor(const Value& p_Left, const Value& p_Right) { return bitwise("^", p_Left, p_Right, [](const int64_t a, const int64_t b) { return a ^ b; }); }
+
+    inline Value shiftLeft(const Value& p_Left, const Value& p_Right)
+    {
+        if ((p_Left.isInt() || p_Left.isBool()) && (p_Right.isInt() || p_Right.isBool()))
+        {
+            return Value(shiftLeft(p_Left.toInteger(), p_Right.toInteger()));
+        }
+        throw unsupported("<<", p_Left, p_Right);
+    }
+
+    inline Value shiftRight(const Value& p_Left, const Value& p_Right)
+    {
+        if ((p_Left.isInt() || p_Left.isBool()) && (p_Right.isInt() || p_Right.isBool()))
+        {
+            return Value(shiftRight(p_Left.toInteger(), p_Right.toInteger()));
+        }
+        throw unsupported(">>", p_Left, p_Right);
+    }
+
+    inline Value negate(const Value& p_Value)
+    {
+        if (p_Value.isFloat())
+        {
+            return Value(-p_Value.getFloat());
+        }
+        if (p_Value.isNumber())
+        {
+            return Value(negate(p_Value.toInteger()));
+        }
+        throw Error("TypeError", std::string("bad operand type for unary -: '") + p_Value.getTypeName() + "'");
+    }
+
+    inline Value positive(const Value& p_Value)
+    {
+        if (p_Value.isFloat())
+        {
+            return p_Value;
+        }
+        if (p_Value.isNumber())
+        {
+            return Value(p_Value.toInteger());
+        }
+        throw Error("TypeError", std::string("bad operand type for unary +: '") + p_Value.getTypeName() + "'");
+    }
+
+    inline Value invert(const Value& p_Value)
+    {
+        if (p_Value.isInt() || p_Value.isBool())
+        {
+            return Value(~p_Value.toInteger());
+        }
+        throw Error("TypeError", std::string("bad operand type for unary ~: '") + p_Value.getTypeName() + "'");
+    }
+
+    // Comparisons
+
+    inline bool equal(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return p_Left.isFloat() || p_Right.isFloat() ? p_Left.toDouble() == p_Right.toDouble() : p_Left.toInteger() == p_Right.toInteger();
+        }
+        if (p_Left.isString() && p_Right.isString())
+        {
+            return p_Left.getString() == p_Right.getString();
+        }
+        if (p_Left.isList() && p_Right.isList())
+        {
+            const ListObject& l_Left = p_Left.getList();
+            const ListObject& l_Right = p_Right.getList();
+            if (l_Left.size() != l_Right.size())
+            {
+                return false;
+            }
+            for (int64_t l_Index = 0; l_Index < l_Left.size(); ++l_Index)
+            {
+                if (!equal(l_Left.get(l_Index), l_Right.get(l_Index)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return p_Left.isNone() && p_Right.isNone();
+    }
+
+    // Python's <, which raises TypeError between values that have no order
+    inline bool less(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isNumber() && p_Right.isNumber())
+        {
+            return p_Left.isFloat() || p_Right.isFloat() ? p_Left.toDouble() < p_Right.toDouble() : p_Left.toInteger() < p_Right.toInteger();
+        }
+        if (p_Left.isString() && p_Right.isString())
+        {
+            return p_Left.getString() < p_Right.getString();
+        }
+        if (p_Left.isList() && p_Right.isList())
+        {
+            const ListObject& l_Left = p_Left.getList();
+            const ListObject& l_Right = p_Right.getList();
+            for (int64_t l_Index = 0; l_Index < l_Left.size() && l_Index < l_Right.size(); ++l_Index)
+            {
+                const Value l_A = l_Left.get(l_Index);
+                const Value l_B = l_Right.get(l_Index);
+                if (!equal(l_A, l_B))
+                {
+                    return less(l_A, l_B);
+                }
+            }
+            return l_Left.size() < l_Right.size();
+        }
+        throw Error("TypeError", std::string("'<' not supported between instances of '") + p_Left.getTypeName() + "' and '" + p_Right.getTypeName() + "'");
+    }
+
+    inline bool operator==(const Value& p_Left, const Value& p_Right) { return equal(p_Left, p_Right); }
+    inline bool operator<(const Value& p_Left, const Value& p_Right) { return less(p_Left, p_Right); }
+    inline bool operator>(const Value& p_Left, const Value& p_Right) { return less(p_Right, p_Left); }
+    inline bool operator<=(const Value& p_Left, const Value& p_Right) { return !less(p_Right, p_Left); }
+    inline bool operator>=(const Value& p_Left, const Value& p_Right) { return !less(p_Left, p_Right); }
+
+    template<typename T>
+    bool operator==(const List<T>& p_Left, const List<T>& p_Right)
+    {
+        return p_Left.getItems() == p_Right.getItems();
+    }
+
+    template<typename T>
+    bool operator<(const List<T>& p_Left, const List<T>& p_Right)
+    {
+        const std::vector<T>& l_Left = p_Left.getItems();
+        const std::vector<T>& l_Right = p_Right.getItems();
+        return std::lexicographical_compare(l_Left.begin(), l_Left.end(), l_Right.begin(), l_Right.end(), [](const T& a, const T& b) { return a < b; });
+    }
+    template<typename T>
+    bool operator>(const List<T>& p_Left, const List<T>& p_Right) { return p_Right < p_Left; }
+    template<typename T>
+    bool operator<=(const List<T>& p_Left, const List<T>& p_Right) { return !(p_Right < p_Left); }
+    template<typename T>
+    bool operator>=(const List<T>& p_Left, const List<T>& p_Right) { return !(p_Left < p_Right); }
+
+    // in
+
+    template<typename T>
+    bool contains(const List<T>& p_List, const T& p_Item)
+    {
+        return std::find(p_List.getItems().begin(), p_List.getItems().end(), p_Item) != p_List.getItems().end();
+    }
+
+    inline bool contains(const std::string& p_Text, const std::string& p_Part)
+    {
+        return p_Text.find(p_Part) != std::string::npos;
+    }
+
+    inline bool contains(const Value& p_Container, const Value& p_Item)
+    {
+        if (p_Container.isList())
+        {
+            const ListObject& l_List = p_Container.getList();
+            for (int64_t l_Index = 0; l_Index < l_List.size(); ++l_Index)
+            {
+                if (equal(l_List.get(l_Index), p_Item))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (p_Container.isString() && p_Item.isString())
+        {
+            return contains(p_Container.getString(), p_Item.getString());
+        }
+        throw Error("TypeError", std::string("argument of type '") + p_Container.getTypeName() + "' is not iterable");
+    }
+
+    // Items
+
+    inline std::string charAt(const std::string& p_Text, const int64_t p_Index)
+    {
+        return std::string(1, p_Text[normalizeIndex(p_Index, static_cast<int64_t>(p_Text.size()), "string")]);
+    }
+
+    inline Value getItem(const Value& p_Object, const Value& p_Index)
+    {
+        if (!p_Object.isList() && !p_Object.isString())
+        {
+            throw Error("TypeError", std::string("'") + p_Object.getTypeName() + "' object is not subscriptable");
+        }
+        const int64_t l_Index = unbox<int64_t>(p_Index);
+        return p_Object.isList() ? p_Object.getList().get(l_Index) : Value(charAt(p_Object.getString(), l_Index));
+    }
+
+    inline void setItem(const Value& p_Object, const Value& p_Index, const Value& p_Value)
+    {
+        if (!p_Object.isList())
+        {
+            throw Error("TypeError", std::string("'") + p_Object.getTypeName() + "' object does not support item assignment");
+        }
+        p_Object.getList().set(unbox<int64_t>(p_Index), p_Value);
+    }
+
+    // List methods on a boxed list
+
+    inline ListObject& asList(const Value& p_Value, const char* p_Method)
+    {
+        if (!p_Value.isList())
+        {
+            throw Error("AttributeError", std::string("'") + p_Value.getTypeName() + "' object has no attribute '" + p_Method + "'");
+        }
+        return p_Value.getList();
+    }
+
+    inline void append(const Value& p_List, const Value& p_Item) { asList(p_List, "append").append(p_Item); }
+    inline Value pop(const Value& p_List, const int64_t p_Index = -1) { return asList(p_List, "pop").pop(p_Index); }
+    inline void insert(const Value& p_List, const int64_t p_Index, const Value& p_Item) { asList(p_List, "insert").insert(p_Index, p_Item); }
+    inline void extend(const Value& p_List, const Value& p_Items)
+    {
+        ListObject& l_List = asList(p_List, "extend");
+        if (!p_Items.isList())
+        {
+            throw Error("TypeError", std::string("'") + p_Items.getTypeName() + "' object is not iterable");
+        }
+        const ListObject& l_Items = p_Items.getList();
+        const int64_t l_Size = l_Items.size();
+        for (int64_t l_Index = 0; l_Index < l_Size; ++l_Index)
+        {
+            l_List.append(l_Items.get(l_Index));
+        }
+    }
+
+    // x += y, which extends a list in place where x + y would make a new one
+    inline Value addInPlace(const Value& p_Left, const Value& p_Right)
+    {
+        if (p_Left.isList() && p_Right.isList())
+        {
+            extend(p_Left, p_Right);
+            return p_Left;
+        }
+        return add(p_Left, p_Right);
+    }
+
+    // Builtins
+
+    inline int64_t len(const std::string& p_Value) { return static_cast<int64_t>(p_Value.size()); }
+    template<typename T>
+    int64_t len(const List<T>& p_Value) { return p_Value.size(); }
+    inline int64_t len(const Value& p_Value)
+    {
+        if (p_Value.isString())
+        {
+            return len(p_Value.getString());
+        }
+        if (p_Value.isList())
+        {
+            return p_Value.getList().size();
+        }
+        throw Error("TypeError", std::string("object of type '") + p_Value.getTypeName() + "' has no len()");
+    }
+
+    // How many values range(p_Start, p_Stop, p_Step) yields, for a step other than zero. Unsigned, since the distance
+    // between two int64_t may not fit in one
+    inline uint64_t rangeLength(const int64_t p_Start, const int64_t p_Stop, const int64_t p_Step)
+    {
+        if (p_Step > 0)
+        {
+            return p_Start < p_Stop ? (static_cast<uint64_t>(p_Stop) - static_cast<uint64_t>(p_Start) - 1) / static_cast<uint64_t>(p_Step) + 1 : 0;
+        }
+        return p_Start > p_Stop ? (static_cast<uint64_t>(p_Start) - static_cast<uint64_t>(p_Stop) - 1) / (0 - static_cast<uint64_t>(p_Step)) + 1 : 0;
+    }
+
+    class Range
+    {
+    public:
+        // Counts the values left rather than comparing against the stop, which a step past the last value may overflow
+        class Iterator
+        {
+        public:
+            Iterator(const int64_t p_Value, const int64_t p_Step, const uint64_t p_Left) : m_Value(p_Value), m_Step(p_Step), m_Left(p_Left) {}
+            int64_t operator*() const { return m_Value; }
+            Iterator& operator++()
+            {
+                m_Value = add(m_Value, m_Step);
+                --m_Left;
+                return *this;
+            }
+            bool operator!=(const Iterator& p_End) const { return m_Left != p_End.m_Left; }
+
+        private:
+            int64_t m_Value;
+            int64_t m_Step;
+            uint64_t m_Left;
+        };
+
+        Range(const int64_t p_Start, const int64_t p_Stop, const int64_t p_Step) : m_Start(p_Start), m_Stop(p_Stop), m_Step(p_Step)
+        {
+            if (p_Step == 0)
+            {
+                throw Error("ValueError", "range() arg 3 must not be zero");
+            }
+        }
+
+        [[nodiscard]] Iterator begin() const { return { m_Start, m_Step, rangeLength(m_Start, m_Stop, m_Step) }; }
+        [[nodiscard]] Iterator end() const { return { m_Stop, m_Step, 0 }; }
+
+    private:
+        int64_t m_Start;
+        int64_t m_Stop;
+        int64_t m_Step;
+    };
+
+    inline Range range(const int64_t p_Stop) { return { 0, p_Stop, 1 }; }
+    inline Range range(const int64_t p_Start, const int64_t p_Stop, const int64_t p_Step = 1) { return { p_Start, p_Stop, p_Step }; }
+
+    // Iteration over a list by index, as Python's list iterator does: items appended during the loop are reached,
+    // and each item is read when it is reached
+    template<typename Sequence, typename Item, typename Read>
+    class Iteration
+    {
+    public:
+        class Iterator
+        {
+        public:
+            Iterator(const Iteration& p_Iteration, const int64_t p_Index) : m_Iteration(p_Iteration), m_Index(p_Index) {}
+            Item operator*() const { return Read{}(m_Iteration.m_Sequence, m_Index); }
+            Iterator& operator++()
+            {
+                ++m_Index;
+                return *this;
+            }
+            bool operator!=(const Iterator&) const { return m_Index < Read::size(m_Iteration.m_Sequence); }
+
+        private:
+            const Iteration& m_Iteration;
+            int64_t m_Index;
+        };
+
+        explicit Iteration(Sequence p_Sequence) : m_Sequence(std::move(p_Sequence)) {}
+
+        [[nodiscard]] Iterator begin() const { return { *this, 0 }; }
+        [[nodiscard]] Iterator end() const { return { *this, 0 }; }
+
+    private:
+        Sequence m_Sequence;
+    };
+
+    template<typename T>
+    struct ReadListItem
+    {
+        T operator()(const List<T>& p_List, const int64_t p_Index) const { return p_List[p_Index]; }
+        static int64_t size(const List<T>& p_List) { return p_List.size(); }
+    };
+
+    struct ReadChar
+    {
+        std::string operator()(const std::string& p_Text, const int64_t p_Index) const { return std::string(1, p_Text[p_Index]); }
+        static int64_t size(const std::string& p_Text) { return static_cast<int64_t>(p_Text.size()); }
+    };
+
+    struct ReadValueItem
+    {
+        Value operator()(const Value& p_Value, const int64_t p_Index) const { return p_Value.isList() ? p_Value.getList().get(p_Index) : Value(std::string(1, p_Value.getString()[p_Index])); }
+        static int64_t size(const Value& p_Value) { return len(p_Value); }
+    };
+
+    template<typename T>
+    Iteration<List<T>, T, ReadListItem<T>> iterate(const List<T>& p_List) { return Iteration<List<T>, T, ReadListItem<T>>(p_List); }
+    // By character, the string copied once so the loop may reassign it
+    inline Iteration<std::string, std::string, ReadChar> iterate(const std::string& p_Text) { return Iteration<std::string, std::string, ReadChar>(p_Text); }
+    inline Iteration<Value, Value, ReadValueItem> iterate(const Value& p_Value)
+    {
+        if (!p_Value.isList() && !p_Value.isString())
+        {
+            throw Error("TypeError", std::string("'") + p_Value.getTypeName() + "' object is not iterable");
+        }
+        return Iteration<Value, Value, ReadValueItem>(p_Value);
+    }
+
+    inline std::string_view stripView(std::string_view p_Text)
+    {
+        constexpr std::string_view c_Whitespace = " \t\n\r\v\f";
+        const size_t l_First = p_Text.find_first_not_of(c_Whitespace);
+        if (l_First == std::string_view::npos)
+        {
+            return {};
+        }
+        return p_Text.substr(l_First, p_Text.find_last_not_of(c_Whitespace) - l_First + 1);
+    }
+
+    inline int64_t toInt(const int64_t p_Value) { return p_Value; }
+    inline int64_t toInt(const bool p_Value) { return p_Value; }
+    inline int64_t toInt(const double p_Value)
+    {
+        if (std::isnan(p_Value))
+        {
+            throw Error("ValueError", "cannot convert float NaN to integer");
+        }
+        if (std::isinf(p_Value))
+        {
+            throw Error("OverflowError", "cannot convert float infinity to integer");
+        }
+        return static_cast<int64_t>(std::trunc(p_Value));
+    }
+    inline int64_t toInt(const std::string& p_Text)
+    {
+        const std::string_view l_Text = stripView(p_Text);
+        std::string l_Digits;
+        bool l_Valid = !l_Text.empty();
+        for (size_t l_Index = 0; l_Index < l_Text.size() && l_Valid; ++l_Index)
+        {
+            const char l_Char = l_Text[l_Index];
+            if ((l_Char == '+' || l_Char == '-') && l_Index == 0)
+            {
+                l_Digits += l_Char == '-' ? "-" : "";
+            }
+            // Underscores only between digits
+            else if (l_Char == '_' && !l_Digits.empty() && l_Digits.back() != '-' && l_Index + 1 < l_Text.size())
+            {
+                continue;
+            }
+            else if (l_Char >= '0' && l_Char <= '9')
+            {
+                l_Digits += l_Char;
+            }
+            else
+            {
+                l_Valid = false;
+            }
+        }
+        int64_t l_Value = 0;
+        const std::from_chars_result l_Result = std::from_chars(l_Digits.data(), l_Digits.data() + l_Digits.size(), l_Value);
+        if (!l_Valid || l_Result.ec != std::errc{} || l_Result.ptr != l_Digits.data() + l_Digits.size())
+        {
+            throw Error("ValueError", "invalid literal for int() with base 10: " + repr(p_Text));
+        }
+        return l_Value;
+    }
+    inline int64_t toInt(const Value& p_Value)
+    {
+        if (p_Value.isFloat())
+        {
+            return toInt(p_Value.getFloat());
+        }
+        if (p_Value.isString())
+        {
+            return toInt(p_Value.getString());
+        }
+        if (p_Value.isNumber())
+        {
+            return p_Value.toInteger();
+        }
+        throw Error("TypeError", std::string("int() argument must be a string or a number, not '") + p_Value.getTypeName() + "'");
+    }
+
+    inline double toFloat(const double p_Value) { return p_Value; }
+    inline double toFloat(const int64_t p_Value) { return static_cast<double>(p_Value); }
+    inline double toFloat(const bool p_Value) { return p_Value; }
+    inline double toFloat(const std::string& p_Text)
+    {
+        std::string l_Text(stripView(p_Text));
+        std::string l_Lower;
+        for (const char l_Char : l_Text)
+        {
+            l_Lower += static_cast<char>(std::tolower(static_cast<unsigned char>(l_Char)));
+        }
+        const bool l_Negative = !l_Lower.empty() && l_Lower.front() == '-';
+        const std::string_view l_Word = std::string_view(l_Lower).substr(!l_Lower.empty() && (l_Lower.front() == '-' || l_Lower.front() == '+') ? 1 : 0);
+        if (l_Word == "inf" || l_Word == "infinity")
+        {
+            return l_Negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        }
+        if (l_Word == "nan")
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        // from_chars takes no '+', and no digits that could be read as inf or nan got this far
+        std::erase(l_Text, '_');
+        const char* const l_Begin = l_Text.data() + (!l_Text.empty() && l_Text.front() == '+' ? 1 : 0);
+        double l_Value = 0.0;
+        const std::from_chars_result l_Result = std::from_chars(l_Begin, l_Text.data() + l_Text.size(), l_Value);
+        if (l_Text.empty() || l_Result.ec == std::errc::invalid_argument || l_Result.ptr != l_Text.data() + l_Text.size())
+        {
+            throw Error("ValueError", "could not convert string to float: " + repr(p_Text));
+        }
+        return l_Value;
+    }
+    inline double toFloat(const Value& p_Value)
+    {
+        if (p_Value.isString())
+        {
+            return toFloat(p_Value.getString());
+        }
+        if (p_Value.isNumber())
+        {
+            return p_Value.toDouble();
+        }
+        throw Error("TypeError", std::string("float() argument must be a string or a number, not '") + p_Value.getTypeName() + "'");
+    }
+
+    inline int64_t abs(const int64_t p_Value) { return p_Value < 0 ? negate(p_Value) : p_Value; }
+    inline int64_t abs(const bool p_Value) { return p_Value; }
+    inline double abs(const double p_Value) { return std::fabs(p_Value); }
+    inline Value abs(const Value& p_Value)
+    {
+        if (p_Value.isFloat())
+        {
+            return Value(abs(p_Value.getFloat()));
+        }
+        if (p_Value.isNumber())
+        {
+            return Value(abs(p_Value.toInteger()));
+        }
+        throw Error("TypeError", std::string("bad operand type for abs(): '") + p_Value.getTypeName() + "'");
+    }
+
+    // min() and max() of several arguments, converted to T by the caller, and of a list. The first of equal values
+    // wins, like in Python
+    template<typename T>
+    T min(std::initializer_list<T> p_Values)
+    {
+        T l_Result = *p_Values.begin();
+        for (const T& l_Value : p_Values)
+        {
+            if (l_Value < l_Result)
+            {
+                l_Result = l_Value;
+            }
+        }
+        return l_Result;
+    }
+
+    template<typename T>
+    T max(std::initializer_list<T> p_Values)
+    {
+        T l_Result = *p_Values.begin();
+        for (const T& l_Value : p_Values)
+        {
+            if (l_Result < l_Value)
+            {
+                l_Result = l_Value;
+            }
+        }
+        return l_Result;
+    }
+
+    template<typename Sequence, bool c_Max>
+    auto extreme(const Sequence& p_Values, const char* p_Name)
+    {
+        bool l_First = true;
+        std::remove_cvref_t<decltype(*iterate(p_Values).begin())> l_Result{};
+        for (const auto& l_Value : iterate(p_Values))
+        {
+            if (l_First || (c_Max ? l_Result < l_Value : l_Value < l_Result))
+            {
+                l_Result = l_Value;
+            }
+            l_First = false;
+        }
+        if (l_First)
+        {
+            throw Error("ValueError", std::string(p_Name) + "() iterable argument is empty");
+        }
+        return l_Result;
+    }
+
+    template<typename T>
+    T min(const List<T>& p_Values) { return extreme<List<T>, false>(p_Values, "min"); }
+    template<typename T>
+    T max(const List<T>& p_Values) { return extreme<List<T>, true>(p_Values, "max"); }
+    inline Value min(const Value& p_Values) { return extreme<Value, false>(p_Values, "min"); }
+    inline Value max(const Value& p_Values) { return extreme<Value, true>(p_Values, "max"); }
+
+    template<typename T>
+    auto sum(const List<T>& p_Values)
+    {
+        if constexpr (std::is_same_v<T, Value>)
+        {
+            Value l_Total(int64_t{ 0 });
+            for (const Value& l_Value : p_Values.getItems())
+            {
+                l_Total = add(l_Total, l_Value);
+            }
+            return l_Total;
+        }
+        else
+        {
+            std::conditional_t<std::is_same_v<T, double>, double, int64_t> l_Total{};
+            for (const T l_Value : p_Values.getItems())
+            {
+                if constexpr (std::is_same_v<T, double>)
+                {
+                    l_Total += l_Value;
+                }
+                else
+                {
+                    l_Total = add(l_Total, static_cast<int64_t>(l_Value));
+                }
+            }
+            return l_Total;
+        }
+    }
+
+    inline Value sum(const Value& p_Values)
+    {
+        Value l_Total(int64_t{ 0 });
+        for (const Value& l_Value : iterate(p_Values))
+        {
+            l_Total = add(l_Total, l_Value);
+        }
+        return l_Total;
+    }
+
+    // str methods
+
+    inline std::string upper(std::string p_Text)
+    {
+        for (char& l_Char : p_Text)
+        {
+            l_Char = static_cast<char>(std::toupper(static_cast<unsigned char>(l_Char)));
+        }
+        return p_Text;
+    }
+
+    inline std::string lower(std::string p_Text)
+    {
+        for (char& l_Char : p_Text)
+        {
+            l_Char = static_cast<char>(std::tolower(static_cast<unsigned char>(l_Char)));
+        }
+        return p_Text;
+    }
+
+    inline std::string strip(const std::string& p_Text) { return std::string(stripView(p_Text)); }
+
+    // Split on runs of whitespace, leading and trailing ones ignored
+    inline List<std::string> split(const std::string& p_Text)
+    {
+        std::vector<std::string> l_Parts;
+        std::string_view l_Rest = stripView(p_Text);
+        while (!l_Rest.empty())
+        {
+            const size_t l_End = l_Rest.find_first_of(" \t\n\r\v\f");
+            l_Parts.emplace_back(l_Rest.substr(0, l_End));
+            l_Rest = l_End == std::string_view::npos ? std::string_view{} : stripView(l_Rest.substr(l_End));
+        }
+        return List<std::string>(std::move(l_Parts));
+    }
+
+    inline List<std::string> split(const std::string& p_Text, const std::string& p_Separator)
+    {
+        if (p_Separator.empty())
+        {
+            throw Error("ValueError", "empty separator");
+        }
+        std::vector<std::string> l_Parts;
+        size_t l_Start = 0;
+        for (size_t l_Found = p_Text.find(p_Separator); l_Found != std::string::npos; l_Found = p_Text.find(p_Separator, l_Start))
+        {
+            l_Parts.push_back(p_Text.substr(l_Start, l_Found - l_Start));
+            l_Start = l_Found + p_Separator.size();
+        }
+        l_Parts.push_back(p_Text.substr(l_Start));
+        return List<std::string>(std::move(l_Parts));
+    }
+
+    inline std::string join(const std::string& p_Separator, const List<std::string>& p_Parts)
+    {
+        std::string l_Result;
+        for (size_t l_Index = 0; l_Index < p_Parts.getItems().size(); ++l_Index)
+        {
+            l_Result += l_Index == 0 ? "" : p_Separator;
+            l_Result += p_Parts.getItems()[l_Index];
+        }
+        return l_Result;
+    }
+
+    inline std::string join(const std::string& p_Separator, const Value& p_Parts)
+    {
+        std::string l_Result;
+        bool l_First = true;
+        for (const Value& l_Part : iterate(p_Parts))
+        {
+            l_Result += l_First ? "" : p_Separator;
+            l_Result += unbox<std::string>(l_Part);
+            l_First = false;
+        }
+        return l_Result;
+    }
+
+    inline bool startswith(const std::string& p_Text, const std::string& p_Prefix) { return p_Text.starts_with(p_Prefix); }
+    inline bool endswith(const std::string& p_Text, const std::string& p_Suffix) { return p_Text.ends_with(p_Suffix); }
+
+    inline std::string replace(const std::string& p_Text, const std::string& p_Old, const std::string& p_New)
+    {
+        std::string l_Result;
+        if (p_Old.empty())
+        {
+            // Python puts the replacement around every character
+            for (const char l_Char : p_Text)
+            {
+                l_Result += p_New;
+                l_Result += l_Char;
+            }
+            return l_Result + p_New;
+        }
+        size_t l_Start = 0;
+        for (size_t l_Found = p_Text.find(p_Old); l_Found != std::string::npos; l_Found = p_Text.find(p_Old, l_Start))
+        {
+            l_Result.append(p_Text, l_Start, l_Found - l_Start);
+            l_Result += p_New;
+            l_Start = l_Found + p_Old.size();
+        }
+        l_Result.append(p_Text, l_Start);
+        return l_Result;
+    }
+
+    inline int64_t find(const std::string& p_Text, const std::string& p_Part)
+    {
+        const size_t l_Found = p_Text.find(p_Part);
+        return l_Found == std::string::npos ? -1 : static_cast<int64_t>(l_Found);
+    }
+
+    // math functions that differ from their <cmath> counterparts
+
+    inline int64_t roundedToInt(const double p_Value)
+    {
+        if (std::isnan(p_Value))
+        {
+            throw Error("ValueError", "cannot convert float NaN to integer");
+        }
+        if (std::isinf(p_Value))
+        {
+            throw Error("OverflowError", "cannot convert float infinity to integer");
+        }
+        return static_cast<int64_t>(p_Value);
+    }
+
+    inline int64_t floor(const double p_Value) { return roundedToInt(std::floor(p_Value)); }
+    inline int64_t ceil(const double p_Value) { return roundedToInt(std::ceil(p_Value)); }
+    inline int64_t trunc(const double p_Value) { return roundedToInt(std::trunc(p_Value)); }
+    inline double log(const double p_Value) { return std::log(p_Value); }
+    inline double log(const double p_Value, const double p_Base) { return divide(std::log(p_Value), std::log(p_Base)); }
+    inline double degrees(const double p_Radians) { return p_Radians * (180.0 / std::numbers::pi); }
+    inline double radians(const double p_Degrees) { return p_Degrees * (std::numbers::pi / 180.0); }
+    inline int64_t gcd(const int64_t p_Left, const int64_t p_Right) { return std::gcd(p_Left, p_Right); }
+
+    // Runs a program's module initializers, reporting an exception that escapes them like Python does. Returns the
+    // exit code
+    template<typename Program>
+    int run(const Program& p_Program)
+    {
+        std::ios::sync_with_stdio(false);
+        try
+        {
+            p_Program();
+        }
+        catch (const Error& p_Error)
+        {
+            std::cout.flush();
+            std::cerr << "Traceback (most recent call last):\n" << p_Error.getType() << ": " << p_Error.what() << "\n";
+            return 1;
+        }
+        std::cout.flush();
+        return 0;
+    }
+}
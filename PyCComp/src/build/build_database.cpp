@@ -0,0 +1,211 @@
+#include "build_database.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string_view>
+
+#include "../source_file/source_reader.hpp"
+
+namespace
+{
+    constexpr char c_Magic[4] = { 'P', 'Y', 'C', 'B' };
+
+    // Layout: magic, version and record count, then per record the content hash, output time, key and dependency
+    // keys, each string prefixed with its uint32_t length
+    class Reader
+    {
+    public:
+        explicit Reader(const std::string_view p_Data) : m_Data(p_Data) {}
+
+        template<typename T>
+        bool read(T& p_Value)
+        {
+            if (m_Data.size() - m_Position < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&p_Value, m_Data.data() + m_Position, sizeof(T));
+            m_Position += sizeof(T);
+            return true;
+        }
+
+        bool read(std::string& p_Value)
+        {
+            uint32_t l_Length;
+            if (!read(l_Length) || m_Data.size() - m_Position < l_Length)
+            {
+                return false;
+            }
+            p_Value.assign(m_Data.substr(m_Position, l_Length));
+            m_Position += l_Length;
+            return true;
+        }
+
+        [[nodiscard]] bool isAtEnd() const { return m_Position == m_Data.size(); }
+
+    private:
+        std::string_view m_Data;
+        size_t m_Position = 0;
+    };
+
+    template<typename T>
+    void write(std::string& p_Data, const T& p_Value)
+    {
+        p_Data.append(reinterpret_cast<const char*>(&p_Value), sizeof(T));
+    }
+
+    void write(std::string& p_Data, const std::string& p_Value)
+    {
+        write(p_Data, static_cast<uint32_t>(p_Value.size()));
+        p_Data += p_Value;
+    }
+
+    // Ticks of the clock the file system uses, only ever compared for equality
+    bool getWriteTime(const std::filesystem::path& p_Path, int64_t& p_Time)
+    {
+        std::error_code l_Error;
+        const std::filesystem::file_time_type l_Time = std::filesystem::last_write_time(p_Path, l_Error);
+        p_Time = static_cast<int64_t>(l_Time.time_since_epoch().count());
+        return !l_Error;
+    }
+}
+
+BuildDatabase::BuildDatabase(std::filesystem::path p_File)
+    : m_File(std::move(p_File))
+{
+    std::ifstream l_Stream(m_File, std::ios::binary);
+    if (!l_Stream.is_open())
+    {
+        return;
+    }
+    const std::string l_Data{ std::istreambuf_iterator<char>(l_Stream), std::istreambuf_iterator<char>() };
+    Reader l_Reader{ l_Data };
+
+    char l_Magic[4];
+    uint32_t l_Version;
+    uint32_t l_Count;
+    if (!l_Reader.read(l_Magic) || std::memcmp(l_Magic, c_Magic, sizeof(c_Magic)) != 0 || !l_Reader.read(l_Version) || l_Version != c_Version || !l_Reader.read(l_Count))
+    {
+        return;
+    }
+    std::unordered_map<std::string, Record> l_Records;
+    for (uint32_t l_Index = 0; l_Index < l_Count; ++l_Index)
+    {
+        Record l_Record;
+        std::string l_Key;
+        uint32_t l_Dependencies;
+        if (!l_Reader.read(l_Record.contentHash) || !l_Reader.read(l_Record.outputTime) || !l_Reader.read(l_Key) || !l_Reader.read(l_Dependencies))
+        {
+            return;
+        }
+        for (uint32_t l_Dependency = 0; l_Dependency < l_Dependencies; ++l_Dependency)
+        {
+            if (!l_Reader.read(l_Record.dependencies.emplace_back()))
+            {
+                return;
+            }
+        }
+        l_Records.emplace(std::move(l_Key), std::move(l_Record));
+    }
+    // A truncated or padded file is as untrustworthy as a corrupt one
+    if (l_Reader.isAtEnd())
+    {
+        m_Records = std::move(l_Records);
+    }
+}
+
+std::vector<std::string> BuildDatabase::getDependencyKeys(const SourceReader& p_Reader, const uint32_t p_Index)
+{
+    std::vector<std::string> l_Keys;
+    for (const uint32_t l_Dependency : p_Reader.getModule(p_Index)->dependencies)
+    {
+        l_Keys.push_back(p_Reader.getModuleKey(p_Reader.getModule(l_Dependency)->fileName));
+    }
+    return l_Keys;
+}
+
+std::vector<bool> BuildDatabase::findStaleModules(const SourceReader& p_Reader, const std::span<const std::filesystem::path> p_Outputs) const
+{
+    // Modules are numbered after everything they import, so one pass in order sees every dependency's state first.
+    // Source changes reach the dependents, a missing or modified output only makes its own module stale
+    std::vector<bool> l_Changed(p_Reader.getModuleCount(), true);
+    std::vector<bool> l_Stale(p_Reader.getModuleCount(), true);
+    for (uint32_t l_Index = 0; l_Index < p_Reader.getModuleCount(); ++l_Index)
+    {
+        const SourceReader::ModuleFile* l_Module = p_Reader.getModule(l_Index);
+        const auto l_Record = m_Records.find(p_Reader.getModuleKey(l_Module->fileName));
+        if (l_Record == m_Records.end() || l_Record->second.contentHash != l_Module->contentHash || l_Record->second.dependencies != getDependencyKeys(p_Reader, l_Index))
+        {
+            continue;
+        }
+        l_Changed[l_Index] = false;
+        for (const uint32_t l_Dependency : l_Module->dependencies)
+        {
+            if (l_Changed[l_Dependency])
+            {
+                l_Changed[l_Index] = true;
+                break;
+            }
+        }
+        int64_t l_OutputTime;
+        l_Stale[l_Index] = l_Changed[l_Index] || !getWriteTime(p_Outputs[l_Index], l_OutputTime) || l_OutputTime != l_Record->second.outputTime;
+    }
+    return l_Stale;
+}
+
+void BuildDatabase::update(const SourceReader& p_Reader, const std::span<const std::filesystem::path> p_Outputs, const std::vector<bool>& p_UpToDate)
+{
+    m_Records.clear();
+    for (uint32_t l_Index = 0; l_Index < p_Reader.getModuleCount(); ++l_Index)
+    {
+        Record l_Record{ .contentHash = p_Reader.getModule(l_Index)->contentHash, .outputTime = 0, .dependencies = getDependencyKeys(p_Reader, l_Index) };
+        if (p_UpToDate[l_Index] && getWriteTime(p_Outputs[l_Index], l_Record.outputTime))
+        {
+            m_Records.emplace(p_Reader.getModuleKey(p_Reader.getModule(l_Index)->fileName), std::move(l_Record));
+        }
+    }
+}
+
+bool BuildDatabase::save() const
+{
+    std::string l_Data;
+    l_Data.append(c_Magic, sizeof(c_Magic));
+    write(l_Data, c_Version);
+    write(l_Data, static_cast<uint32_t>(m_Records.size()));
+    for (const auto& [l_Key, l_Record] : m_Records)
+    {
+        write(l_Data, l_Record.contentHash);
+        write(l_Data, l_Record.outputTime);
+        write(l_Data, l_Key);
+        write(l_Data, static_cast<uint32_t>(l_Record.dependencies.size()));
+        for (const std::string& l_Dependency : l_Record.dependencies)
+        {
+            write(l_Data, l_Dependency);
+        }
+    }
+
+    std::error_code l_Error;
+    std::filesystem::create_directories(m_File.parent_path(), l_Error);
+    std::filesystem::path l_Temporary = m_File;
+    l_Temporary += '.';
+    l_Temporary += std::to_string(std::random_device{}());
+    l_Temporary += ".tmp";
+    {
+        std::ofstream l_Stream(l_Temporary, std::ios::binary | std::ios::trunc);
+        if (!l_Stream.write(l_Data.data(), static_cast<std::streamsize>(l_Data.size())))
+        {
+            l_Stream.close();
+            std::filesystem::remove(l_Temporary, l_Error);
+            return false;
+        }
+    }
+    std::filesystem::rename(l_Temporary, m_File, l_Error);
+    if (l_Error)
+    {
+        std::filesystem::remove(l_Temporary, l_Error);
+        return false;
+    }
+    return true;
+}
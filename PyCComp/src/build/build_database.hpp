@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SourceReader;
+
+// What the last build into an output directory produced: for every module, the hash of its file, the modules it
+// imports and the write time of its output. Used to only rebuild the modules whose output is out of date
+class BuildDatabase
+{
+public:
+    // Bumped whenever the file layout changes or the compiler produces different outputs for the same sources
+    static constexpr uint32_t c_Version = 1;
+
+    // A missing, unreadable or outdated file is an empty database, after which every module is stale
+    explicit BuildDatabase(std::filesystem::path p_File);
+
+    // p_Outputs holds the output path of every module, by index. A module is stale if it was not recorded, its file
+    // or imports changed, its output is missing or was written by someone else, or any module it imports is stale
+    [[nodiscard]] std::vector<bool> findStaleModules(const SourceReader& p_Reader, std::span<const std::filesystem::path> p_Outputs) const;
+    // Replaces every record with the modules of p_Reader whose output is up to date. The others are left out so that
+    // the next build retries them
+    void update(const SourceReader& p_Reader, std::span<const std::filesystem::path> p_Outputs, const std::vector<bool>& p_UpToDate);
+    // Written to a temporary file and renamed, false if that failed
+    bool save() const;
+
+private:
+    struct Record
+    {
+        uint64_t contentHash;
+        int64_t outputTime;
+        std::vector<std::string> dependencies;
+    };
+
+    [[nodiscard]] static std::vector<std::string> getDependencyKeys(const SourceReader& p_Reader, uint32_t p_Index);
+
+    std::filesystem::path m_File;
+    // By module key
+    std::unordered_map<std::string, Record> m_Records;
+};
@@ -0,0 +1,471 @@
+#include "token_cache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <type_traits>
+
+namespace
+{
+    constexpr uint64_t c_Prime1 = 11400714785074694791ull;
+    constexpr uint64_t c_Prime2 = 14029467366897019727ull;
+    constexpr uint64_t c_Prime3 = 1609587929392839161ull;
+    constexpr uint64_t c_Prime4 = 9650029242287828579ull;
+    constexpr uint64_t c_Prime5 = 2870177450012600261ull;
+
+    template<typename T>
+    T readRaw(const char* p_Data)
+    {
+        T l_Value;
+        std::memcpy(&l_Value, p_Data, sizeof(T));
+        return l_Value;
+    }
+
+    uint64_t xxhRound(uint64_t p_Accumulator, const uint64_t p_Input)
+    {
+        p_Accumulator += p_Input * c_Prime2;
+        return std::rotl(p_Accumulator, 31) * c_Prime1;
+    }
+
+    uint64_t xxhMerge(const uint64_t p_Accumulator, const uint64_t p_Value)
+    {
+        return (p_Accumulator ^ xxhRound(0, p_Value)) * c_Prime1 + c_Prime4;
+    }
+
+    // Every entry starts with this. All the sections after it are arrays of fixed-size records, in the order of the
+    // counts, followed by the pool and then the import names and error messages back to back
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t hash;
+        uint64_t contentSize;
+        // Of everything after the header
+        uint64_t checksum;
+        uint32_t bodyOffset;
+        uint32_t firstLine;
+        uint32_t numberCount;
+        uint32_t tokenCount;
+        uint32_t lineStartCount;
+        uint32_t errorCount;
+        uint32_t importCount;
+        uint32_t poolSize;
+        uint32_t textSize;
+    };
+    static_assert(sizeof(Header) == 72);
+
+    // Tokenizer::Number without the padding NumberLiteral has, so that entries are byte-for-byte reproducible
+    struct NumberRecord
+    {
+        uint32_t offset;
+        uint32_t length;
+        int64_t integer;
+        double real;
+        uint8_t kind;
+        uint8_t reserved[7];
+    };
+    static_assert(sizeof(NumberRecord) == 32);
+
+    struct ErrorRecord
+    {
+        uint32_t line;
+        uint32_t column;
+        uint32_t messageLength;
+    };
+
+    // Tokens are stored as they are, with their symbol cleared since ids only mean something within one run
+    static_assert(sizeof(Tokenizer::Token) == 16 && std::is_trivially_copyable_v<Tokenizer::Token>);
+
+    constexpr char c_Magic[4] = { 'P', 'Y', 'C', 'T' };
+    constexpr std::string_view c_Extension = ".tok";
+
+    // Offsets of every section of an entry, from the counts in its header
+    struct Layout
+    {
+        size_t numbers;
+        size_t tokens;
+        size_t lineStarts;
+        size_t errors;
+        size_t importLengths;
+        size_t pool;
+        size_t text;
+        size_t end;
+
+        explicit Layout(const Header& p_Header)
+        {
+            numbers = sizeof(Header);
+            tokens = numbers + size_t{ p_Header.numberCount } * sizeof(NumberRecord);
+            lineStarts = tokens + size_t{ p_Header.tokenCount } * sizeof(Tokenizer::Token);
+            errors = lineStarts + size_t{ p_Header.lineStartCount } * sizeof(uint32_t);
+            importLengths = errors + size_t{ p_Header.errorCount } * sizeof(ErrorRecord);
+            pool = importLengths + size_t{ p_Header.importCount } * sizeof(uint32_t);
+            text = pool + p_Header.poolSize;
+            end = text + p_Header.textSize;
+        }
+    };
+}
+
+TokenCache::TokenCache(std::filesystem::path p_Directory)
+    : m_Directory(std::move(p_Directory))
+{
+}
+
+uint64_t TokenCache::hashContents(const std::string_view p_Contents)
+{
+    const char* l_Data = p_Contents.data();
+    const char* const l_End = l_Data + p_Contents.size();
+    constexpr uint64_t l_Seed = c_Version;
+
+    uint64_t l_Hash;
+    if (p_Contents.size() >= 32)
+    {
+        uint64_t l_Lanes[4] = { l_Seed + c_Prime1 + c_Prime2, l_Seed + c_Prime2, l_Seed, l_Seed - c_Prime1 };
+        for (; l_End - l_Data >= 32; l_Data += 32)
+        {
+            for (uint32_t l_Lane = 0; l_Lane < 4; ++l_Lane)
+            {
+                l_Lanes[l_Lane] = xxhRound(l_Lanes[l_Lane], readRaw<uint64_t>(l_Data + l_Lane * 8));
+            }
+        }
+        l_Hash = std::rotl(l_Lanes[0], 1) + std::rotl(l_Lanes[1], 7) + std::rotl(l_Lanes[2], 12) + std::rotl(l_Lanes[3], 18);
+        for (const uint64_t l_Lane : l_Lanes)
+        {
+            l_Hash = xxhMerge(l_Hash, l_Lane);
+        }
+    }
+    else
+    {
+        l_Hash = l_Seed + c_Prime5;
+    }
+    l_Hash += p_Contents.size();
+
+    for (; l_End - l_Data >= 8; l_Data += 8)
+    {
+        l_Hash = std::rotl(l_Hash ^ xxhRound(0, readRaw<uint64_t>(l_Data)), 27) * c_Prime1 + c_Prime4;
+    }
+    if (l_End - l_Data >= 4)
+    {
+        l_Hash = std::rotl(l_Hash ^ (readRaw<uint32_t>(l_Data) * c_Prime1), 23) * c_Prime2 + c_Prime3;
+        l_Data += 4;
+    }
+    for (; l_Data < l_End; ++l_Data)
+    {
+        l_Hash = std::rotl(l_Hash ^ (static_cast<uint8_t>(*l_Data) * c_Prime5), 11) * c_Prime1;
+    }
+
+    l_Hash ^= l_Hash >> 33;
+    l_Hash *= c_Prime2;
+    l_Hash ^= l_Hash >> 29;
+    l_Hash *= c_Prime3;
+    l_Hash ^= l_Hash >> 32;
+    return l_Hash;
+}
+
+std::filesystem::path TokenCache::getEntryPath(const uint64_t p_Hash) const
+{
+    char l_Name[17];
+    for (uint32_t l_Digit = 0; l_Digit < 16; ++l_Digit)
+    {
+        l_Name[l_Digit] = "0123456789abcdef"[(p_Hash >> (60 - l_Digit * 4)) & 0xF];
+    }
+    l_Name[16] = '\0';
+    return m_Directory / (std::string(l_Name) + std::string(c_Extension));
+}
+
+std::optional<TokenCache::Entry> TokenCache::find(const uint64_t p_Hash, const size_t p_ContentSize) const
+{
+    const std::filesystem::path l_Path = getEntryPath(p_Hash);
+    std::error_code l_Error;
+    if (!std::filesystem::is_regular_file(l_Path, l_Error))
+    {
+        return std::nullopt;
+    }
+
+    Entry l_Entry;
+    try
+    {
+        l_Entry.file = MappedFile{ l_Path };
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+    const std::string_view l_Data = l_Entry.file.getContents();
+    if (l_Data.size() < sizeof(Header))
+    {
+        return std::nullopt;
+    }
+    const Header l_Header = readRaw<Header>(l_Data.data());
+    const Layout l_Layout{ l_Header };
+    if (std::memcmp(l_Header.magic, c_Magic, sizeof(c_Magic)) != 0 || l_Header.version != c_Version || l_Header.hash != p_Hash ||
+        l_Header.contentSize != p_ContentSize || l_Header.bodyOffset > p_ContentSize || l_Layout.end != l_Data.size() ||
+        l_Header.checksum != hashContents(l_Data.substr(sizeof(Header))))
+    {
+        return std::nullopt;
+    }
+
+    l_Entry.bodyOffset = l_Header.bodyOffset;
+    l_Entry.firstLine = l_Header.firstLine;
+    size_t l_Text = l_Layout.text;
+    for (uint32_t l_Import = 0; l_Import < l_Header.importCount; ++l_Import)
+    {
+        const uint32_t l_Length = readRaw<uint32_t>(l_Data.data() + l_Layout.importLengths + l_Import * sizeof(uint32_t));
+        if (l_Length > l_Layout.end - l_Text)
+        {
+            return std::nullopt;
+        }
+        l_Entry.imports.emplace_back(l_Data.substr(l_Text, l_Length));
+        l_Text += l_Length;
+    }
+    std::filesystem::last_write_time(l_Path, std::filesystem::file_time_type::clock::now(), l_Error);
+    return l_Entry;
+}
+
+std::optional<Tokenizer> TokenCache::restore(const Entry& p_Entry, const std::string_view p_Body, SymbolTable* p_Symbols, std::pmr::memory_resource* p_Memory)
+{
+    const std::string_view l_Data = p_Entry.file.getContents();
+    const Header l_Header = readRaw<Header>(l_Data.data());
+    const Layout l_Layout{ l_Header };
+
+    Tokenizer l_Tokenizer{ p_Memory };
+    l_Tokenizer.m_Source = p_Body;
+    l_Tokenizer.m_FirstLine = l_Header.firstLine;
+
+    l_Tokenizer.m_Numbers.reserve(l_Header.numberCount);
+    for (uint32_t l_Index = 0; l_Index < l_Header.numberCount; ++l_Index)
+    {
+        const NumberRecord l_Record = readRaw<NumberRecord>(l_Data.data() + l_Layout.numbers + l_Index * sizeof(NumberRecord));
+        if (l_Record.offset > p_Body.size() || l_Record.length > p_Body.size() - l_Record.offset || l_Record.kind > NumberLiteral::IMAGINARY)
+        {
+            return std::nullopt;
+        }
+        l_Tokenizer.m_Numbers.push_back({ .offset = l_Record.offset, .length = l_Record.length, .literal = {
+            .kind = static_cast<NumberLiteral::Kind>(l_Record.kind), .integer = l_Record.integer, .real = l_Record.real } });
+    }
+
+    l_Tokenizer.m_Pool.assign(l_Data.substr(l_Layout.pool, l_Header.poolSize));
+    l_Tokenizer.m_Tokens.reserve(l_Header.tokenCount);
+    // Token text is handed out without bounds checks, so every reference is checked once here
+    for (uint32_t l_Index = 0; l_Index < l_Header.tokenCount; ++l_Index)
+    {
+        const Tokenizer::Token l_Token = readRaw<Tokenizer::Token>(l_Data.data() + l_Layout.tokens + l_Index * sizeof(Tokenizer::Token));
+        const bool l_Valid = l_Token.type <= Tokenizer::Token::END && (
+            (l_Token.storage == Tokenizer::Token::SOURCE && l_Token.offset <= p_Body.size() && l_Token.length <= p_Body.size() - l_Token.offset) ||
+            (l_Token.storage == Tokenizer::Token::NUMBER_TABLE && l_Token.offset < l_Header.numberCount) ||
+            (l_Token.storage == Tokenizer::Token::POOL && l_Token.offset <= l_Header.poolSize && l_Header.poolSize - l_Token.offset >= sizeof(uint32_t) &&
+                readRaw<uint32_t>(l_Tokenizer.m_Pool.data() + l_Token.offset) <= l_Header.poolSize - l_Token.offset - sizeof(uint32_t)));
+        if (!l_Valid)
+        {
+            return std::nullopt;
+        }
+        l_Tokenizer.m_Tokens.push_back(l_Token);
+    }
+
+    l_Tokenizer.m_LineStarts.resize(l_Header.lineStartCount);
+    std::memcpy(l_Tokenizer.m_LineStarts.data(), l_Data.data() + l_Layout.lineStarts, size_t{ l_Header.lineStartCount } * sizeof(uint32_t));
+    if (l_Tokenizer.m_LineStarts.empty() || l_Tokenizer.m_LineStarts.front() != 0)
+    {
+        return std::nullopt;
+    }
+
+    size_t l_Text = l_Layout.text;
+    for (uint32_t l_Import = 0; l_Import < l_Header.importCount; ++l_Import)
+    {
+        l_Text += readRaw<uint32_t>(l_Data.data() + l_Layout.importLengths + l_Import * sizeof(uint32_t));
+    }
+    for (uint32_t l_Index = 0; l_Index < l_Header.errorCount; ++l_Index)
+    {
+        const ErrorRecord l_Record = readRaw<ErrorRecord>(l_Data.data() + l_Layout.errors + l_Index * sizeof(ErrorRecord));
+        if (l_Record.messageLength > l_Layout.end - l_Text)
+        {
+            return std::nullopt;
+        }
+        l_Tokenizer.m_Errors.push_back({ .message = std::string(l_Data.substr(l_Text, l_Record.messageLength)), .line = l_Record.line, .column = l_Record.column });
+        l_Text += l_Record.messageLength;
+    }
+
+    if (p_Symbols != nullptr)
+    {
+        l_Tokenizer.internSymbols(*p_Symbols, nullptr);
+    }
+    return l_Tokenizer;
+}
+
+void TokenCache::store(const uint64_t p_Hash, const std::string_view p_Contents, const std::string_view p_Body, const uint32_t p_FirstLine, const std::span<const std::string> p_Imports, const Tokenizer& p_Tokenizer) const
+{
+    Header l_Header{};
+    std::memcpy(l_Header.magic, c_Magic, sizeof(c_Magic));
+    l_Header.version = c_Version;
+    l_Header.hash = p_Hash;
+    l_Header.contentSize = p_Contents.size();
+    l_Header.bodyOffset = static_cast<uint32_t>(p_Body.data() - p_Contents.data());
+    l_Header.firstLine = p_FirstLine;
+    l_Header.numberCount = static_cast<uint32_t>(p_Tokenizer.m_Numbers.size());
+    l_Header.tokenCount = static_cast<uint32_t>(p_Tokenizer.m_Tokens.size());
+    l_Header.lineStartCount = static_cast<uint32_t>(p_Tokenizer.m_LineStarts.size());
+    l_Header.errorCount = static_cast<uint32_t>(p_Tokenizer.m_Errors.size());
+    l_Header.importCount = static_cast<uint32_t>(p_Imports.size());
+    l_Header.poolSize = static_cast<uint32_t>(p_Tokenizer.m_Pool.size());
+    for (const std::string& l_Import : p_Imports)
+    {
+        l_Header.textSize += static_cast<uint32_t>(l_Import.size());
+    }
+    for (const Tokenizer::Error& l_Error : p_Tokenizer.m_Errors)
+    {
+        l_Header.textSize += static_cast<uint32_t>(l_Error.message.size());
+    }
+
+    // Built in memory and written with a single call
+    const Layout l_Layout{ l_Header };
+    std::string l_Data(l_Layout.end, '\0');
+    std::memcpy(l_Data.data(), &l_Header, sizeof(Header));
+    for (uint32_t l_Index = 0; l_Index < l_Header.numberCount; ++l_Index)
+    {
+        const Tokenizer::Number& l_Number = p_Tokenizer.m_Numbers[l_Index];
+        const NumberRecord l_Record{ .offset = l_Number.offset, .length = l_Number.length, .integer = l_Number.literal.integer,
+            .real = l_Number.literal.real, .kind = l_Number.literal.kind, .reserved = {} };
+        std::memcpy(l_Data.data() + l_Layout.numbers + l_Index * sizeof(NumberRecord), &l_Record, sizeof(NumberRecord));
+    }
+    for (uint32_t l_Index = 0; l_Index < l_Header.tokenCount; ++l_Index)
+    {
+        Tokenizer::Token l_Token = p_Tokenizer.m_Tokens[l_Index];
+        l_Token.symbol = SymbolTable::c_NoSymbol;
+        std::memcpy(l_Data.data() + l_Layout.tokens + l_Index * sizeof(Tokenizer::Token), &l_Token, sizeof(Tokenizer::Token));
+    }
+    std::memcpy(l_Data.data() + l_Layout.lineStarts, p_Tokenizer.m_LineStarts.data(), p_Tokenizer.m_LineStarts.size() * sizeof(uint32_t));
+    std::memcpy(l_Data.data() + l_Layout.pool, p_Tokenizer.m_Pool.data(), p_Tokenizer.m_Pool.size());
+    size_t l_Text = l_Layout.text;
+    for (uint32_t l_Index = 0; l_Index < l_Header.importCount; ++l_Index)
+    {
+        const uint32_t l_Length = static_cast<uint32_t>(p_Imports[l_Index].size());
+        std::memcpy(l_Data.data() + l_Layout.importLengths + l_Index * sizeof(uint32_t), &l_Length, sizeof(uint32_t));
+        std::memcpy(l_Data.data() + l_Text, p_Imports[l_Index].data(), l_Length);
+        l_Text += l_Length;
+    }
+    for (uint32_t l_Index = 0; l_Index < l_Header.errorCount; ++l_Index)
+    {
+        const Tokenizer::Error& l_Error = p_Tokenizer.m_Errors[l_Index];
+        const ErrorRecord l_Record{ .line = l_Error.line, .column = l_Error.column, .messageLength = static_cast<uint32_t>(l_Error.message.size()) };
+        std::memcpy(l_Data.data() + l_Layout.errors + l_Index * sizeof(ErrorRecord), &l_Record, sizeof(ErrorRecord));
+        std::memcpy(l_Data.data() + l_Text, l_Error.message.data(), l_Error.message.size());
+        l_Text += l_Error.message.size();
+    }
+    l_Header.checksum = hashContents(std::string_view(l_Data).substr(sizeof(Header)));
+    std::memcpy(l_Data.data(), &l_Header, sizeof(Header));
+
+    std::error_code l_Error;
+    std::filesystem::create_directories(m_Directory, l_Error);
+    const std::filesystem::path l_Path = getEntryPath(p_Hash);
+    thread_local std::mt19937_64 s_Random{ std::random_device{}() };
+    std::filesystem::path l_Temporary = l_Path;
+    l_Temporary += '.';
+    l_Temporary += std::to_string(s_Random());
+    l_Temporary += ".tmp";
+    {
+        std::ofstream l_Stream(l_Temporary, std::ios::binary | std::ios::trunc);
+        if (!l_Stream.write(l_Data.data(), static_cast<std::streamsize>(l_Data.size())))
+        {
+            l_Stream.close();
+            std::filesystem::remove(l_Temporary, l_Error);
+            return;
+        }
+    }
+    std::filesystem::rename(l_Temporary, l_Path, l_Error);
+    if (l_Error)
+    {
+        std::filesystem::remove(l_Temporary, l_Error);
+        return;
+    }
+    trim();
+}
+
+void TokenCache::trim() const
+{
+    struct Stored
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        uint64_t size;
+    };
+
+    std::error_code l_Error;
+    std::vector<Stored> l_Entries;
+    uint64_t l_Total = 0;
+    for (std::filesystem::directory_iterator l_Entry{ m_Directory, l_Error }; !l_Error && l_Entry != std::filesystem::directory_iterator{}; l_Entry.increment(l_Error))
+    {
+        std::error_code l_StatError;
+        if (l_Entry->path().extension() != c_Extension || !l_Entry->is_regular_file(l_StatError))
+        {
+            continue;
+        }
+        const uint64_t l_Size = l_Entry->file_size(l_StatError);
+        const std::filesystem::file_time_type l_Used = l_Entry->last_write_time(l_StatError);
+        if (!l_StatError)
+        {
+            l_Entries.push_back({ .path = l_Entry->path(), .used = l_Used, .size = l_Size });
+            l_Total += l_Size;
+        }
+    }
+    if (l_Total <= c_MaxSize)
+    {
+        return;
+    }
+
+    // Another run may be trimming too, an entry it already removed just fails to be removed here
+    std::ranges::sort(l_Entries, {}, &Stored::used);
+    for (const Stored& l_Entry : l_Entries)
+    {
+        if (l_Total <= c_TrimmedSize)
+        {
+            break;
+        }
+        std::filesystem::remove(l_Entry.path, l_Error);
+        l_Total -= l_Entry.size;
+    }
+}
+
+std::filesystem::path TokenCache::getDefaultDirectory()
+{
+#ifdef _WIN32
+    const char* const l_LocalAppData = std::getenv("LOCALAPPDATA");
+    return l_LocalAppData != nullptr && *l_LocalAppData != '\0' ? std::filesystem::path(l_LocalAppData) / "pyccomp" : std::filesystem::path{};
+#else
+    const char* const l_CacheHome = std::getenv("XDG_CACHE_HOME");
+    if (l_CacheHome != nullptr && *l_CacheHome != '\0')
+    {
+        return std::filesystem::path(l_CacheHome) / "pyccomp";
+    }
+    const char* const l_Home = std::getenv("HOME");
+    return l_Home != nullptr && *l_Home != '\0' ? std::filesystem::path(l_Home) / ".cache" / "pyccomp" : std::filesystem::path{};
+#endif
+}
+
+uint32_t TokenCache::purge() const
+{
+    uint32_t l_Removed = 0;
+    std::error_code l_Error;
+    std::vector<std::filesystem::path> l_Files;
+    for (std::filesystem::directory_iterator l_Entry{ m_Directory, l_Error }; !l_Error && l_Entry != std::filesystem::directory_iterator{}; l_Entry.increment(l_Error))
+    {
+        l_Files.push_back(l_Entry->path());
+    }
+    for (const std::filesystem::path& l_File : l_Files)
+    {
+        // Only entries and the temporary files they are written through, anything else in the directory is kept
+        const bool l_IsEntry = l_File.extension() == c_Extension;
+        if (!l_IsEntry && !(l_File.extension() == ".tmp" && l_File.stem().stem().extension() == c_Extension))
+        {
+            continue;
+        }
+        if (std::filesystem::remove(l_File, l_Error) && l_IsEntry)
+        {
+            l_Removed++;
+        }
+    }
+    // Only removed if nothing else is left in it
+    std::filesystem::remove(m_Directory, l_Error);
+    return l_Removed;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../source_file/mapped_file.hpp"
+#include "../tokenizer/tokenizer.hpp"
+
+// Directory of token streams from earlier runs, one file per distinct module contents. Entries are keyed by a hash
+// of the whole file seeded with c_Version, so an edited file or a different compiler version never reads a stale
+// one. The cache is best effort: unreadable, corrupt or unwritable entries behave as if they were missing. It is
+// bounded: once its entries pass c_MaxSize the least recently used ones are removed until they fit in c_TrimmedSize
+class TokenCache
+{
+public:
+    // Bumped whenever the entry layout or the tokens the lexer emits change
+    static constexpr uint32_t c_Version = 4;
+    static constexpr uint64_t c_MaxSize = 256ull << 20;
+    // Well below c_MaxSize so that a full cache is not scanned again on every store
+    static constexpr uint64_t c_TrimmedSize = 192ull << 20;
+
+    // A stored module, mapped. Its import header is decoded when it is found, the tokens only when restored
+    struct Entry
+    {
+        MappedFile file;
+        // Offset of the module body after the import header
+        uint32_t bodyOffset;
+        uint32_t firstLine;
+        std::vector<std::string> imports;
+    };
+
+    explicit TokenCache(std::filesystem::path p_Directory);
+
+    // pyccomp under the user's cache directory: $XDG_CACHE_HOME, else ~/.cache, or %LOCALAPPDATA% on Windows. Empty
+    // if the environment names none
+    [[nodiscard]] static std::filesystem::path getDefaultDirectory();
+
+    [[nodiscard]] const std::filesystem::path& getDirectory() const { return m_Directory; }
+
+    // XXH64 of the contents, seeded with c_Version
+    [[nodiscard]] static uint64_t hashContents(std::string_view p_Contents);
+
+    // A hit marks the entry as used, which is what trimming orders entries by
+    [[nodiscard]] std::optional<Entry> find(uint64_t p_Hash, size_t p_ContentSize) const;
+    // The tokenizer the entry was stored from, over p_Body and allocated from p_Memory, or nothing if the entry is corrupt
+    [[nodiscard]] static std::optional<Tokenizer> restore(const Entry& p_Entry, std::string_view p_Body, SymbolTable* p_Symbols = nullptr, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+    // p_Body is the part of p_Contents that p_Tokenizer lexed, p_Imports the module names in the header before it.
+    // Written to a temporary file and renamed, so concurrent runs never see half an entry. Trims the cache afterwards
+    void store(uint64_t p_Hash, std::string_view p_Contents, std::string_view p_Body, uint32_t p_FirstLine, std::span<const std::string> p_Imports, const Tokenizer& p_Tokenizer) const;
+    // Removes every entry and returns how many there were
+    uint32_t purge() const;
+
+private:
+    [[nodiscard]] std::filesystem::path getEntryPath(uint64_t p_Hash) const;
+    // Removes the least recently used entries if they add up to more than c_MaxSize
+    void trim() const;
+
+    std::filesystem::path m_Directory;
+};
@@ -0,0 +1,6 @@
+#include "compilation_context.hpp"
+
+CompilationContext::CompilationContext(const size_t p_InitialSize)
+    : m_Arena(p_InitialSize), m_Pools(std::pmr::pool_options{ .max_blocks_per_chunk = 0, .largest_required_pool_block = c_LargestPooledBlock }, &m_Arena)
+{
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+// Memory of one compilation. The source reader, the tokenizers and later stages allocate from getResource(), and all
+// of it is released in one step when the context is destroyed, so the context has to outlive everything that used it.
+// Not meant for long-lived processes like the daemon, since nothing but small blocks is reused before then
+class CompilationContext
+{
+public:
+    explicit CompilationContext(size_t p_InitialSize = c_DefaultInitialSize);
+    CompilationContext(const CompilationContext&) = delete;
+    CompilationContext& operator=(const CompilationContext&) = delete;
+
+    // Safe to use from several threads at once
+    [[nodiscard]] std::pmr::memory_resource* getResource() { return &m_Pools; }
+
+private:
+    static constexpr size_t c_DefaultInitialSize = 1 << 20;
+    // Blocks up to this size are pooled, larger ones come straight from the arena
+    static constexpr size_t c_LargestPooledBlock = 1 << 16;
+
+    // Takes memory from the global heap in geometrically growing chunks and frees it all at once
+    std::pmr::monotonic_buffer_resource m_Arena;
+    // Thread safe front of the arena. Small blocks given back, like the storage a vector leaves when it grows, are
+    // reused instead of being lost in the arena
+    std::pmr::synchronized_pool_resource m_Pools;
+};
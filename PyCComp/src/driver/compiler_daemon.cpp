@@ -0,0 +1,497 @@
+#include "compiler_daemon.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include "pipeline.hpp"
+#include "../scheduler/task_scheduler.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+namespace
+{
+    // A client gets this long to send its command line, and for each send of the answer to go through, so that one
+    // that connects and goes quiet cannot hold up the requests behind it
+    constexpr std::chrono::milliseconds c_ClientTimeout{ 2000 };
+    // Longer command lines are cut off here, and answered as unknown commands
+    constexpr size_t c_MaxCommandSize = 64;
+
+    bool sendAll(const int p_Socket, const char* p_Data, size_t p_Size)
+    {
+        while (p_Size > 0)
+        {
+            const ssize_t l_Sent = send(p_Socket, p_Data, p_Size, MSG_NOSIGNAL);
+            if (l_Sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (l_Sent <= 0)
+            {
+                return false;
+            }
+            p_Data += l_Sent;
+            p_Size -= static_cast<size_t>(l_Sent);
+        }
+        return true;
+    }
+
+    bool receiveAll(const int p_Socket, char* p_Data, size_t p_Size)
+    {
+        while (p_Size > 0)
+        {
+            const ssize_t l_Received = recv(p_Socket, p_Data, p_Size, 0);
+            if (l_Received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (l_Received <= 0)
+            {
+                return false;
+            }
+            p_Data += l_Received;
+            p_Size -= static_cast<size_t>(l_Received);
+        }
+        return true;
+    }
+
+    // Reads up to the first newline, in chunks, or false if the client went quiet or the connection failed before one
+    // arrived. A client that closes the connection early has sent what it read so far
+    bool receiveCommand(const int p_Socket, std::string& p_Command)
+    {
+        const std::chrono::steady_clock::time_point l_Deadline = std::chrono::steady_clock::now() + c_ClientTimeout;
+        char l_Buffer[c_MaxCommandSize];
+        size_t l_Size = 0;
+        while (l_Size < sizeof(l_Buffer))
+        {
+            const int64_t l_Left = std::chrono::duration_cast<std::chrono::milliseconds>(l_Deadline - std::chrono::steady_clock::now()).count();
+            pollfd l_Polled{ .fd = p_Socket, .events = POLLIN, .revents = 0 };
+            const int l_Ready = l_Left > 0 ? poll(&l_Polled, 1, static_cast<int>(l_Left)) : 0;
+            if (l_Ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (l_Ready <= 0)
+            {
+                return false;
+            }
+            const ssize_t l_Received = recv(p_Socket, l_Buffer + l_Size, sizeof(l_Buffer) - l_Size, 0);
+            if (l_Received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (l_Received < 0)
+            {
+                return false;
+            }
+            if (l_Received == 0)
+            {
+                break;
+            }
+            const char* const l_Newline = static_cast<const char*>(std::memchr(l_Buffer + l_Size, '\n', static_cast<size_t>(l_Received)));
+            if (l_Newline != nullptr)
+            {
+                l_Size = static_cast<size_t>(l_Newline - l_Buffer);
+                break;
+            }
+            l_Size += static_cast<size_t>(l_Received);
+        }
+        p_Command.assign(l_Buffer, l_Size);
+        return true;
+    }
+
+    bool sendFrame(const int p_Socket, const char p_Kind, const std::string_view p_Data)
+    {
+        char l_Header[5];
+        l_Header[0] = p_Kind;
+        const uint32_t l_Length = static_cast<uint32_t>(p_Data.size());
+        std::memcpy(l_Header + 1, &l_Length, sizeof(l_Length));
+        return sendAll(p_Socket, l_Header, sizeof(l_Header)) && sendAll(p_Socket, p_Data.data(), p_Data.size());
+    }
+
+    // False if the path does not fit in sun_path
+    bool makeAddress(const std::filesystem::path& p_Path, sockaddr_un& p_Address)
+    {
+        const std::string l_Path = p_Path.string();
+        p_Address = {};
+        p_Address.sun_family = AF_UNIX;
+        if (l_Path.size() >= sizeof(p_Address.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(p_Address.sun_path, l_Path.c_str(), l_Path.size() + 1);
+        return true;
+    }
+}
+#endif
+
+CompilerDaemon::CompilerDaemon(std::filesystem::path p_InputFile, std::filesystem::path p_WorkingDir, TaskScheduler* p_Scheduler, const TokenCache* p_Cache)
+    : m_InputFile(std::move(p_InputFile)), m_WorkingDir(std::move(p_WorkingDir)), m_Scheduler(p_Scheduler), m_Cache(p_Cache)
+{
+}
+
+CompilerDaemon::~CompilerDaemon()
+{
+#ifdef __linux__
+    if (m_Inotify >= 0)
+    {
+        close(m_Inotify);
+    }
+#endif
+}
+
+#ifdef __linux__
+
+int CompilerDaemon::run(const std::filesystem::path& p_SocketPath)
+{
+    sockaddr_un l_Address;
+    if (!makeAddress(p_SocketPath, l_Address))
+    {
+        std::cerr << "Socket path is too long: " << p_SocketPath.string() << "\n";
+        return 1;
+    }
+    // A socket file nobody answers on is left over from a daemon that did not shut down, anything else is a live one
+    const int l_Probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const bool l_Running = connect(l_Probe, reinterpret_cast<const sockaddr*>(&l_Address), sizeof(l_Address)) == 0;
+    close(l_Probe);
+    if (l_Running)
+    {
+        std::cerr << "A daemon is already listening on " << p_SocketPath.string() << "\n";
+        return 1;
+    }
+    unlink(l_Address.sun_path);
+
+    const int l_Listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (l_Listener < 0 || bind(l_Listener, reinterpret_cast<const sockaddr*>(&l_Address), sizeof(l_Address)) != 0 || listen(l_Listener, 16) != 0)
+    {
+        std::cerr << "Could not listen on " << p_SocketPath.string() << ": " << std::strerror(errno) << "\n";
+        if (l_Listener >= 0)
+        {
+            close(l_Listener);
+        }
+        return 1;
+    }
+    m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Inotify < 0)
+    {
+        std::cerr << "Could not watch files: " << std::strerror(errno) << "\n";
+        close(l_Listener);
+        unlink(l_Address.sun_path);
+        return 1;
+    }
+
+    refresh();
+    std::cout << "Listening on " << p_SocketPath.string() << std::endl;
+
+    bool l_Stopping = false;
+    while (!l_Stopping)
+    {
+        pollfd l_Polled[2] = { { .fd = m_Inotify, .events = POLLIN, .revents = 0 }, { .fd = l_Listener, .events = POLLIN, .revents = 0 } };
+        if (poll(l_Polled, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        // Changes are applied as soon as they are seen, so that a request usually finds everything lexed already
+        if (l_Polled[0].revents & POLLIN)
+        {
+            readEvents();
+            refresh();
+        }
+        if (!(l_Polled[1].revents & POLLIN))
+        {
+            continue;
+        }
+        const int l_Connection = accept4(l_Listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (l_Connection < 0)
+        {
+            continue;
+        }
+        const timeval l_Timeout{ .tv_sec = c_ClientTimeout.count() / 1000, .tv_usec = c_ClientTimeout.count() % 1000 * 1000 };
+        setsockopt(l_Connection, SOL_SOCKET, SO_SNDTIMEO, &l_Timeout, sizeof(l_Timeout));
+        std::string l_Command;
+        if (receiveCommand(l_Connection, l_Command))
+        {
+            l_Stopping = l_Command == "stop";
+            answer(l_Connection, l_Command);
+        }
+        close(l_Connection);
+    }
+
+    close(l_Listener);
+    unlink(l_Address.sun_path);
+    return 0;
+}
+
+int CompilerDaemon::runClient(const std::filesystem::path& p_SocketPath, const std::string_view p_Command)
+{
+    sockaddr_un l_Address;
+    const int l_Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (!makeAddress(p_SocketPath, l_Address) || connect(l_Socket, reinterpret_cast<const sockaddr*>(&l_Address), sizeof(l_Address)) != 0)
+    {
+        std::cerr << "No daemon is listening on " << p_SocketPath.string() << "\n";
+        close(l_Socket);
+        return 1;
+    }
+    const std::string l_Request = std::string(p_Command) + "\n";
+    sendAll(l_Socket, l_Request.data(), l_Request.size());
+
+    std::string l_Data;
+    while (true)
+    {
+        char l_Header[5];
+        uint32_t l_Length;
+        if (!receiveAll(l_Socket, l_Header, sizeof(l_Header)))
+        {
+            break;
+        }
+        std::memcpy(&l_Length, l_Header + 1, sizeof(l_Length));
+        l_Data.resize(l_Length);
+        if (!receiveAll(l_Socket, l_Data.data(), l_Length))
+        {
+            break;
+        }
+        if (l_Header[0] == 'x' && l_Length == sizeof(int32_t))
+        {
+            int32_t l_Code;
+            std::memcpy(&l_Code, l_Data.data(), sizeof(l_Code));
+            close(l_Socket);
+            return l_Code;
+        }
+        (l_Header[0] == 'e' ? std::cerr : std::cout).write(l_Data.data(), static_cast<std::streamsize>(l_Data.size()));
+    }
+    close(l_Socket);
+    std::cerr << "The daemon closed the connection without an answer\n";
+    return 1;
+}
+
+void CompilerDaemon::readEvents()
+{
+    alignas(inotify_event) char l_Buffer[64 * 1024];
+    while (true)
+    {
+        const ssize_t l_Size = read(m_Inotify, l_Buffer, sizeof(l_Buffer));
+        if (l_Size <= 0)
+        {
+            return;
+        }
+        for (ssize_t l_Offset = 0; l_Offset < l_Size;)
+        {
+            inotify_event l_Event;
+            std::memcpy(&l_Event, l_Buffer + l_Offset, sizeof(l_Event));
+            const std::string_view l_Name = l_Event.len > 0 ? std::string_view(l_Buffer + l_Offset + sizeof(inotify_event)) : std::string_view{};
+            l_Offset += static_cast<ssize_t>(sizeof(inotify_event) + l_Event.len);
+
+            // Lost events could be anything
+            if (l_Event.mask & IN_Q_OVERFLOW)
+            {
+                m_NeedsRebuild = true;
+                continue;
+            }
+            const auto l_Watch = m_Watches.find(l_Event.wd);
+            if (l_Watch == m_Watches.end() || !l_Name.ends_with(".py"))
+            {
+                continue;
+            }
+            const uint32_t l_Module = m_Reader ? m_Reader->getModuleIndex(l_Watch->second / l_Name) : UINT32_MAX;
+            if (l_Module != UINT32_MAX)
+            {
+                m_ChangedModules.insert(l_Module);
+            }
+            else if (!m_Reader || (l_Event.mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)))
+            {
+                // A new file can change where an existing import resolves to, and any file can be the one that was
+                // missing when the last rebuild failed
+                m_NeedsRebuild = true;
+            }
+        }
+    }
+}
+
+void CompilerDaemon::watchModuleDirectories()
+{
+    std::vector<std::filesystem::path> l_Directories{ m_WorkingDir };
+    for (uint32_t l_Index = 0; m_Reader && l_Index < m_Reader->getModuleCount(); ++l_Index)
+    {
+        l_Directories.push_back(std::filesystem::path(m_Reader->getModuleKey(m_Reader->getModule(l_Index)->fileName)).parent_path());
+    }
+    for (const std::filesystem::path& l_Directory : l_Directories)
+    {
+        if (m_WatchedDirectories.contains(l_Directory.string()))
+        {
+            continue;
+        }
+        const int l_Watch = inotify_add_watch(m_Inotify, l_Directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+        if (l_Watch >= 0)
+        {
+            m_Watches[l_Watch] = l_Directory;
+            m_WatchedDirectories.insert(l_Directory.string());
+        }
+    }
+}
+
+void CompilerDaemon::answer(const int p_Connection, const std::string_view p_Command)
+{
+    int32_t l_Code = 0;
+    if (p_Command == "compile")
+    {
+        // Saves that happened just before the request are already queued
+        readEvents();
+        refresh();
+        if (!m_Failure.empty())
+        {
+            sendFrame(p_Connection, 'e', m_Failure);
+            l_Code = 1;
+        }
+        else
+        {
+            for (uint32_t l_Index = 0; l_Index < m_Reader->getModuleCount(); ++l_Index)
+            {
+                const std::string l_Header = "Module: " + m_Reader->getModule(l_Index)->fileName.string() + "\n***********************************************\n\n";
+                if ((!m_Errors[l_Index].empty() && !sendFrame(p_Connection, 'e', m_Errors[l_Index])) || !sendFrame(p_Connection, 'o', l_Header) ||
+                    !sendFrame(p_Connection, 'o', m_Dumps[l_Index]))
+                {
+                    return;
+                }
+            }
+        }
+    }
+    else if (p_Command != "stop")
+    {
+        sendFrame(p_Connection, 'e', "Unknown daemon command: " + std::string(p_Command) + "\n");
+        l_Code = 1;
+    }
+    sendFrame(p_Connection, 'x', std::string_view(reinterpret_cast<const char*>(&l_Code), sizeof(l_Code)));
+}
+
+#else
+
+int CompilerDaemon::run(const std::filesystem::path&)
+{
+    std::cerr << "The daemon is only supported on Linux\n";
+    return 1;
+}
+
+int CompilerDaemon::runClient(const std::filesystem::path&, std::string_view)
+{
+    std::cerr << "The daemon is only supported on Linux\n";
+    return 1;
+}
+
+void CompilerDaemon::readEvents()
+{
+}
+
+void CompilerDaemon::watchModuleDirectories()
+{
+}
+
+void CompilerDaemon::answer(int, std::string_view)
+{
+}
+
+#endif
+
+void CompilerDaemon::refresh()
+{
+    if (!m_NeedsRebuild && !m_ChangedModules.empty())
+    {
+        std::vector<uint32_t> l_Relex;
+        for (const uint32_t l_Index : m_ChangedModules)
+        {
+            try
+            {
+                if (!m_Reader->reloadModule(l_Index))
+                {
+                    m_NeedsRebuild = true;
+                    break;
+                }
+            }
+            catch (const std::exception&)
+            {
+                // Deleted or unreadable now, the rebuild reports it
+                m_NeedsRebuild = true;
+                break;
+            }
+            // The tokens view the old contents, which the reload released, so the module is lexed again even if
+            // a save left it unchanged
+            l_Relex.push_back(l_Index);
+        }
+        if (!m_NeedsRebuild)
+        {
+            lexModules(l_Relex);
+        }
+    }
+    m_ChangedModules.clear();
+    if (m_NeedsRebuild)
+    {
+        rebuild();
+    }
+}
+
+void CompilerDaemon::rebuild()
+{
+    m_NeedsRebuild = false;
+    // The tokens view the reader's files, so they go first
+    m_Tokenizers.clear();
+    m_Reader.reset();
+    try
+    {
+        m_Reader.emplace(m_InputFile, m_WorkingDir, m_Scheduler, m_Cache);
+        m_Failure.clear();
+    }
+    catch (const std::exception& l_Error)
+    {
+        m_Reader.reset();
+        m_Failure = std::string(l_Error.what()) + "\n";
+        watchModuleDirectories();
+        return;
+    }
+    m_Tokenizers.resize(m_Reader->getModuleCount());
+    m_Errors.assign(m_Reader->getModuleCount(), {});
+    m_Dumps.assign(m_Reader->getModuleCount(), {});
+    std::vector<uint32_t> l_All(m_Reader->getModuleCount());
+    for (uint32_t l_Index = 0; l_Index < l_All.size(); ++l_Index)
+    {
+        l_All[l_Index] = l_Index;
+    }
+    lexModules(l_All);
+    watchModuleDirectories();
+}
+
+void CompilerDaemon::lexModules(const std::vector<uint32_t>& p_Indices)
+{
+    const auto l_Lex = [this, &p_Indices](const uint32_t p_Index)
+    {
+        const uint32_t l_Module = p_Indices[p_Index];
+        m_Tokenizers[l_Module] = tokenizeModule(*m_Reader->getModule(l_Module), m_Scheduler, m_Cache, m_Symbols);
+        std::ostringstream l_Errors;
+        m_Tokenizers[l_Module]->printErrors(l_Errors);
+        m_Errors[l_Module] = l_Errors.str();
+        m_Dumps[l_Module] = dumpTokens(*m_Tokenizers[l_Module]);
+    };
+    if (m_Scheduler != nullptr && p_Indices.size() > 1)
+    {
+        m_Scheduler->parallelFor(static_cast<uint32_t>(p_Indices.size()), l_Lex);
+    }
+    else
+    {
+        for (uint32_t l_Index = 0; l_Index < p_Indices.size(); ++l_Index)
+        {
+            l_Lex(l_Index);
+        }
+    }
+}
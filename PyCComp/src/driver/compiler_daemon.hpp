@@ -0,0 +1,68 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../source_file/source_reader.hpp"
+#include "../tokenizer/tokenizer.hpp"
+
+class TaskScheduler;
+class TokenCache;
+
+// Keeps a program's module graph and tokens in memory and watches the directories of its modules, re-reading and
+// re-lexing only the modules that change. Compile requests from runClient are answered over a UNIX socket with the
+// output a normal run would print. Linux only, elsewhere both ends report that they are unsupported
+//
+// A request is one command line: "compile" or "stop". A client that does not send it within two seconds is dropped
+// unanswered. The answer is a sequence of frames, each a kind byte ('o' for stdout, 'e' for stderr, 'x' for the exit
+// code), a uint32_t length and that many bytes
+class CompilerDaemon
+{
+public:
+    CompilerDaemon(std::filesystem::path p_InputFile, std::filesystem::path p_WorkingDir, TaskScheduler* p_Scheduler, const TokenCache* p_Cache);
+    ~CompilerDaemon();
+    CompilerDaemon(const CompilerDaemon&) = delete;
+    CompilerDaemon& operator=(const CompilerDaemon&) = delete;
+
+    // Serves requests until a stop request, returns the process exit code
+    int run(const std::filesystem::path& p_SocketPath);
+
+    // Sends p_Command and copies the answer to stdout and stderr, returns the exit code it carries
+    static int runClient(const std::filesystem::path& p_SocketPath, std::string_view p_Command);
+
+private:
+    // Discovers the module graph again and lexes every module
+    void rebuild();
+    // Applies the file changes seen since the last refresh
+    void refresh();
+    void readEvents();
+    void watchModuleDirectories();
+    void lexModules(const std::vector<uint32_t>& p_Indices);
+    void answer(int p_Connection, std::string_view p_Command);
+
+    std::filesystem::path m_InputFile;
+    std::filesystem::path m_WorkingDir;
+    TaskScheduler* m_Scheduler;
+    const TokenCache* m_Cache;
+
+    // Kept across rebuilds, so that symbol ids stay stable while the daemon runs
+    SymbolTable m_Symbols;
+    std::optional<SourceReader> m_Reader;
+    std::vector<std::optional<Tokenizer>> m_Tokenizers;
+    // What a normal run prints for every module, to stderr and to stdout
+    std::vector<std::string> m_Errors;
+    std::vector<std::string> m_Dumps;
+    // Why the last rebuild failed, reported instead of an output until the next one succeeds
+    std::string m_Failure;
+
+    bool m_NeedsRebuild = true;
+    std::unordered_set<uint32_t> m_ChangedModules;
+    int m_Inotify = -1;
+    // Watched directories by watch descriptor
+    std::unordered_map<int, std::filesystem::path> m_Watches;
+    std::unordered_set<std::string> m_WatchedDirectories;
+};
@@ -0,0 +1,102 @@
+#include "pipeline.hpp"
+
+#include "../cache/token_cache.hpp"
+#include "../emit/ast_writer.hpp"
+#include "../emit/cpp_writer.hpp"
+#include "../emit/token_writer.hpp"
+#include "../emit/type_report.hpp"
+#include "../instrumentation/instrumentation.hpp"
+#include "../parser/parser.hpp"
+
+Tokenizer tokenizeModule(const SourceReader::ModuleFile& p_Module, TaskScheduler* p_Scheduler, const TokenCache* p_Cache, SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory)
+{
+    if (p_Module.cacheEntry)
+    {
+        std::optional<Tokenizer> l_Restored;
+        {
+            const Instrumentation::ScopedTimer l_Timer{ Instrumentation::CACHE, p_Module.fileName };
+            l_Restored = TokenCache::restore(*p_Module.cacheEntry, p_Module.fileContent, &p_Symbols, p_Memory);
+        }
+        if (l_Restored)
+        {
+            Instrumentation::count(Instrumentation::CACHE_HITS);
+            Instrumentation::countTokens(*l_Restored);
+            Instrumentation::count(Instrumentation::ERRORS, l_Restored->getErrors().size());
+            return std::move(*l_Restored);
+        }
+    }
+    if (p_Cache != nullptr)
+    {
+        Instrumentation::count(Instrumentation::CACHE_MISSES);
+    }
+    std::optional<Tokenizer> l_Tokenizer;
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::TOKENIZE, p_Module.fileName };
+        l_Tokenizer.emplace(p_Module.fileContent, p_Module.firstLine, p_Scheduler, &p_Symbols, p_Memory);
+    }
+    Instrumentation::countTokens(*l_Tokenizer);
+    Instrumentation::count(Instrumentation::ERRORS, l_Tokenizer->getErrors().size());
+    if (p_Cache != nullptr)
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::CACHE, p_Module.fileName };
+        p_Cache->store(p_Module.contentHash, p_Module.source.getContents(), p_Module.fileContent, p_Module.firstLine, p_Module.importNames, *l_Tokenizer);
+    }
+    return std::move(*l_Tokenizer);
+}
+
+Ast parseModule(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory)
+{
+    std::optional<Ast> l_Ast;
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::PARSE };
+        l_Ast.emplace(Parser::parse(p_Tokenizer, p_Memory));
+    }
+    Instrumentation::count(Instrumentation::NODES, l_Ast->getNodeCount());
+    Instrumentation::count(Instrumentation::ERRORS, l_Ast->getErrors().size());
+    return std::move(*l_Ast);
+}
+
+TypeInference inferTypes(const SourceReader& p_Reader, const std::span<const Ast* const> p_Trees, const SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory)
+{
+    std::optional<TypeInference> l_Inference;
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::INFER };
+        l_Inference.emplace(p_Reader, p_Trees, p_Symbols, p_Memory);
+    }
+    for (uint32_t l_Module = 0; l_Module < l_Inference->getModuleCount(); ++l_Module)
+    {
+        Instrumentation::count(Instrumentation::ERRORS, l_Inference->getModule(l_Module).errors.size());
+    }
+    return std::move(*l_Inference);
+}
+
+std::string dumpTokens(const Tokenizer& p_Tokenizer)
+{
+    const Instrumentation::ScopedTimer l_Timer{ Instrumentation::DUMP };
+    std::string l_Dump;
+    TokenWriter::appendText(p_Tokenizer, l_Dump);
+    return l_Dump;
+}
+
+std::string dumpAst(const Ast& p_Ast)
+{
+    const Instrumentation::ScopedTimer l_Timer{ Instrumentation::DUMP };
+    std::string l_Dump;
+    AstWriter::appendText(p_Ast, l_Dump);
+    return l_Dump;
+}
+
+std::string dumpCpp(const TypeInference& p_Inference, std::vector<std::vector<Tokenizer::Error>>& p_Errors)
+{
+    const Instrumentation::ScopedTimer l_Timer{ Instrumentation::DUMP };
+    std::string l_Dump;
+    CppWriter::appendProgram(p_Inference, l_Dump, p_Errors);
+    return l_Dump;
+}
+
+std::string dumpTypeReport(const TypeInference& p_Inference)
+{
+    std::string l_Dump;
+    TypeReport::appendText(p_Inference, l_Dump);
+    return l_Dump;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../parser/ast.hpp"
+#include "../source_file/source_reader.hpp"
+#include "../tokenizer/tokenizer.hpp"
+#include "../types/type_inference.hpp"
+
+class TaskScheduler;
+class TokenCache;
+
+// Steps every module goes through, shared by a normal run and the daemon
+
+// Restored from the cache when it has an entry for the module, otherwise tokenized and stored in it. Allocates from
+// p_Memory, usually a CompilationContext's
+Tokenizer tokenizeModule(const SourceReader::ModuleFile& p_Module, TaskScheduler* p_Scheduler, const TokenCache* p_Cache, SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+// The tree refers to p_Tokenizer, which has to outlive it
+Ast parseModule(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+// Over the whole program, p_Trees in module order. The inference refers to the trees and p_Symbols, which have to
+// outlive it
+TypeInference inferTypes(const SourceReader& p_Reader, std::span<const Ast* const> p_Trees, const SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+// One line per token: l<line> | c<column> | type[(value)]
+std::string dumpTokens(const Tokenizer& p_Tokenizer);
+// One line per node, indented by depth
+std::string dumpAst(const Ast& p_Ast);
+// The program as one C++ translation unit, for an inference without errors. p_Errors gets what could not be
+// translated, per module
+std::string dumpCpp(const TypeInference& p_Inference, std::vector<std::vector<Tokenizer::Error>>& p_Errors);
+// The values inference left dynamic, and why
+std::string dumpTypeReport(const TypeInference& p_Inference);
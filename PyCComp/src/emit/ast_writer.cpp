@@ -0,0 +1,220 @@
+#include "ast_writer.hpp"
+
+#include <charconv>
+
+namespace
+{
+    class TextWriter
+    {
+    public:
+        TextWriter(const Ast& p_Ast, std::string& p_Buffer) : m_Ast(p_Ast), m_Buffer(p_Buffer) {}
+
+        void write(const Ast::NodeIndex p_Node, const uint32_t p_Depth, const std::string_view p_Role = {})
+        {
+            if (p_Node == Ast::c_NoNode)
+            {
+                return;
+            }
+            const Ast::Node& l_Node = m_Ast.getNode(p_Node);
+            writeLine(p_Node, p_Depth, p_Role);
+            const uint32_t l_Depth = p_Depth + 1;
+            switch (l_Node.kind)
+            {
+            case Ast::MODULE:
+                writeList(l_Node.first, l_Depth);
+                break;
+            case Ast::FUNCTION:
+                {
+                    const Ast::FunctionData l_Function = m_Ast.getFunction(p_Node);
+                    writeList(l_Function.parameters, l_Depth);
+                    write(l_Function.returns, l_Depth, "returns");
+                    writeList(l_Function.body, l_Depth, "body");
+                    break;
+                }
+            case Ast::PARAMETER:
+                write(l_Node.first, l_Depth, "annotation");
+                write(l_Node.second, l_Depth, "default");
+                break;
+            case Ast::CLASS:
+                writeList(l_Node.first, l_Depth, "base");
+                writeList(l_Node.second, l_Depth, "body");
+                break;
+            case Ast::IF:
+                {
+                    // An elif chain is written flat, each elif at the depth of the if it continues
+                    Ast::NodeIndex l_If = p_Node;
+                    while (true)
+                    {
+                        const Ast::IfData l_Branches = m_Ast.getIf(l_If);
+                        write(m_Ast.getNode(l_If).first, l_Depth, "condition");
+                        writeList(l_Branches.body, l_Depth, "body");
+                        const std::span<const Ast::NodeIndex> l_Else = m_Ast.getList(l_Branches.orElse);
+                        if (l_Else.size() != 1 || !(m_Ast.getNode(l_Else[0]).flags & Ast::ELIF))
+                        {
+                            writeList(l_Branches.orElse, l_Depth, "else");
+                            break;
+                        }
+                        l_If = l_Else[0];
+                        writeLine(l_If, p_Depth, {});
+                    }
+                    break;
+                }
+            case Ast::WHILE:
+                write(l_Node.first, l_Depth, "condition");
+                writeList(l_Node.second, l_Depth, "body");
+                break;
+            case Ast::FOR:
+                {
+                    const Ast::ForData l_For = m_Ast.getFor(p_Node);
+                    write(l_Node.first, l_Depth, "target");
+                    write(l_For.iterable, l_Depth, "iterable");
+                    writeList(l_For.body, l_Depth, "body");
+                    break;
+                }
+            case Ast::ASSIGN:
+                write(l_Node.first, l_Depth, "target");
+                write(l_Node.second, l_Depth, "value");
+                break;
+            case Ast::CONDITIONAL:
+                {
+                    const std::span<const Ast::NodeIndex, 2> l_Branches = m_Ast.getBranches(p_Node);
+                    write(l_Node.first, l_Depth, "condition");
+                    write(l_Branches[0], l_Depth, "then");
+                    write(l_Branches[1], l_Depth, "else");
+                    break;
+                }
+            case Ast::CALL:
+                write(l_Node.first, l_Depth, "callee");
+                writeList(l_Node.second, l_Depth);
+                break;
+            case Ast::SUBSCRIPT:
+                write(l_Node.first, l_Depth);
+                write(l_Node.second, l_Depth, "index");
+                break;
+            case Ast::LIST:
+            case Ast::TUPLE:
+            case Ast::DICT:
+                writeList(l_Node.first, l_Depth);
+                break;
+            case Ast::ANNOTATED:
+                write(l_Node.first, l_Depth);
+                write(l_Node.second, l_Depth, "annotation");
+                break;
+            case Ast::RETURN:
+            case Ast::EXPRESSION:
+            case Ast::UNARY:
+            case Ast::KEYWORD_ARGUMENT:
+            case Ast::ATTRIBUTE:
+                write(l_Node.first, l_Depth);
+                break;
+            case Ast::BINARY:
+                write(l_Node.first, l_Depth);
+                write(l_Node.second, l_Depth);
+                break;
+            default:
+                break;
+            }
+        }
+
+    private:
+        void writeList(const uint32_t p_List, const uint32_t p_Depth, const std::string_view p_Role = {})
+        {
+            for (const Ast::NodeIndex l_Child : m_Ast.getList(p_List))
+            {
+                write(l_Child, p_Depth, p_Role);
+            }
+        }
+
+        void writeLine(const Ast::NodeIndex p_Node, const uint32_t p_Depth, const std::string_view p_Role)
+        {
+            const Ast::Node& l_Node = m_Ast.getNode(p_Node);
+            const Tokenizer::Location l_Location = m_Ast.getLocation(p_Node);
+            m_Buffer += 'l';
+            writePadded(l_Location.line);
+            m_Buffer += " | c";
+            writePadded(l_Location.column);
+            m_Buffer += " | ";
+            m_Buffer.append(static_cast<size_t>(p_Depth) * 2, ' ');
+            if (!p_Role.empty())
+            {
+                m_Buffer += p_Role;
+                m_Buffer += ": ";
+            }
+            m_Buffer += l_Node.flags & Ast::ELIF ? "elif" : Ast::getKindName(l_Node.kind);
+            switch (l_Node.kind)
+            {
+            case Ast::FUNCTION:
+            case Ast::PARAMETER:
+            case Ast::CLASS:
+            case Ast::NAME:
+            case Ast::IMAGINARY:
+            case Ast::STRING:
+            case Ast::KEYWORD_ARGUMENT:
+            case Ast::ATTRIBUTE:
+                writeValue(m_Ast.getName(p_Node));
+                break;
+            case Ast::INTEGER:
+                {
+                    char l_Digits[24];
+                    writeValue({ l_Digits, std::to_chars(l_Digits, l_Digits + sizeof(l_Digits), m_Ast.getInteger(p_Node)).ptr });
+                    break;
+                }
+            case Ast::FLOAT:
+                {
+                    char l_Digits[32];
+                    std::string l_Value{ l_Digits, std::to_chars(l_Digits, l_Digits + sizeof(l_Digits), m_Ast.getFloat(p_Node)).ptr };
+                    // Shortest round trip text, which leaves whole numbers without anything saying they are floats
+                    if (l_Value.find_first_of(".en") == std::string::npos)
+                    {
+                        l_Value += ".0";
+                    }
+                    writeValue(l_Value);
+                    break;
+                }
+            case Ast::BOOLEAN:
+                writeValue(l_Node.first != 0 ? "True" : "False");
+                break;
+            case Ast::UNARY:
+            case Ast::BINARY:
+                writeValue(Ast::getOperatorName(l_Node.op));
+                break;
+            case Ast::ASSIGN:
+                if (l_Node.op != Ast::NO_OPERATOR)
+                {
+                    writeValue(std::string(Ast::getOperatorName(l_Node.op)) + "=");
+                }
+                break;
+            default:
+                break;
+            }
+            if (l_Node.flags & Ast::STATIC_METHOD)
+            {
+                m_Buffer += " static";
+            }
+            m_Buffer += '\n';
+        }
+
+        void writeValue(const std::string_view p_Value)
+        {
+            m_Buffer += '(';
+            m_Buffer += p_Value;
+            m_Buffer += ')';
+        }
+
+        void writePadded(const uint32_t p_Value)
+        {
+            char l_Digits[10];
+            const size_t l_Length = static_cast<size_t>(std::to_chars(l_Digits, l_Digits + sizeof(l_Digits), p_Value).ptr - l_Digits);
+            m_Buffer.append(l_Length < 4 ? 4 - l_Length : 0, ' ');
+            m_Buffer.append(l_Digits, l_Length);
+        }
+
+        const Ast& m_Ast;
+        std::string& m_Buffer;
+    };
+}
+
+void AstWriter::appendText(const Ast& p_Ast, std::string& p_Buffer)
+{
+    TextWriter{ p_Ast, p_Buffer }.write(p_Ast.getRoot(), 0);
+}
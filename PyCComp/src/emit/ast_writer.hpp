@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+
+#include "../parser/ast.hpp"
+
+// Text dump of a syntax tree, written by --emit=ast
+class AstWriter
+{
+public:
+    // Appends one line per node: l<line> | c<column> | [role: ]kind[(value)], indented by depth, where the role
+    // says which part of its parent a node is when the kind alone does not
+    static void appendText(const Ast& p_Ast, std::string& p_Buffer);
+};
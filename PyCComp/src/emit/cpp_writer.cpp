@@ -0,0 +1,1483 @@
+#include "cpp_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace
+{
+    using Reference = TypeInference::Reference;
+
+    // Python names that cannot be C++ ones: keywords, and names the runtime or its headers take
+    constexpr std::array<std::string_view, 110> c_Reserved{
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+        "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr", "constinit",
+        "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+        "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+        "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+        "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "requires", "return", "short",
+        "signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+        "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual",
+        "void", "volatile", "wchar_t", "while", "xor", "xor_eq", "final", "override", "import", "module",
+        "std", "pyc", "int64_t", "INT64_C", "assert", "errno", "EOF", "NULL", "stdin", "stdout", "stderr", "INFINITY",
+        "NAN", "M_PI"
+    };
+
+    // Runtime functions of the boxed and checked operations, by Ast::Operator
+    constexpr std::array<std::string_view, Ast::SHIFT_RIGHT + 1> c_OperationNames{
+        "", "add", "subtract", "multiply", "divide", "floorDivide", "modulo", "power", "bitAnd", "bitOr", "bitXor", "shiftLeft", "shiftRight"
+    };
+
+    constexpr std::array<std::string_view, Builtins::METHOD_COUNT> c_MethodNames{
+        "append", "pop", "insert", "extend", "upper", "lower", "strip", "split", "join", "startswith", "endswith", "replace", "find"
+    };
+
+    std::string formatDouble(const double p_Value)
+    {
+        if (std::isinf(p_Value))
+        {
+            return p_Value > 0 ? "::std::numeric_limits<double>::infinity()" : "-::std::numeric_limits<double>::infinity()";
+        }
+        if (std::isnan(p_Value))
+        {
+            return "::std::numeric_limits<double>::quiet_NaN()";
+        }
+        char l_Buffer[64];
+        char* const l_End = std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), p_Value).ptr;
+        std::string l_Text(l_Buffer, l_End);
+        if (l_Text.find_first_of(".e") == std::string::npos)
+        {
+            l_Text += ".0";
+        }
+        return l_Text;
+    }
+
+    // A C++ string literal holding p_Value
+    std::string formatString(const std::string_view p_Value)
+    {
+        std::string l_Literal = "\"";
+        for (const char l_Char : p_Value)
+        {
+            const unsigned char l_Byte = static_cast<unsigned char>(l_Char);
+            if (l_Char == '"' || l_Char == '\\')
+            {
+                l_Literal += '\\';
+                l_Literal += l_Char;
+            }
+            else if (l_Char == '\n')
+            {
+                l_Literal += "\\n";
+            }
+            else if (l_Char == '\t')
+            {
+                l_Literal += "\\t";
+            }
+            else if (l_Byte < 0x20 || l_Byte >= 0x7f)
+            {
+                // Octal escapes stop after three digits, unlike hexadecimal ones
+                l_Literal += '\\';
+                l_Literal += static_cast<char>('0' + (l_Byte >> 6));
+                l_Literal += static_cast<char>('0' + ((l_Byte >> 3) & 7));
+                l_Literal += static_cast<char>('0' + (l_Byte & 7));
+            }
+            else
+            {
+                l_Literal += l_Char;
+            }
+        }
+        l_Literal += '"';
+        if (p_Value.find('\0') != std::string_view::npos)
+        {
+            return "::std::string(" + l_Literal + ", " + std::to_string(p_Value.size()) + ")";
+        }
+        return "::std::string(" + l_Literal + ")";
+    }
+
+    class ProgramWriter
+    {
+    public:
+        ProgramWriter(const TypeInference& p_Inference, std::string& p_Buffer, std::vector<std::vector<Tokenizer::Error>>& p_Errors)
+            : m_Inference(p_Inference), m_Symbols(p_Inference.getSymbols()), m_Out(p_Buffer), m_Errors(p_Errors)
+        {
+            m_Errors.assign(p_Inference.getModuleCount(), {});
+        }
+
+        void write()
+        {
+            const SourceReader& l_Reader = m_Inference.getReader();
+            m_Out += "// Generated by PyCComp from " + l_Reader.getModule(m_Inference.getModuleCount() - 1)->fileName.filename().string() + "\n";
+            m_Out += "#include \"pyccomp_runtime.hpp\"\n";
+            std::set<std::string> l_Headers;
+            for (uint32_t l_Module = 0; l_Module < m_Inference.getModuleCount(); ++l_Module)
+            {
+                l_Headers.insert(l_Reader.getModule(l_Module)->stdDependencies.begin(), l_Reader.getModule(l_Module)->stdDependencies.end());
+            }
+            for (const std::string& l_Header : l_Headers)
+            {
+                m_Out += "#include <" + l_Header + ">\n";
+            }
+
+            // Namespaces after the module's file, told apart by index if two files share a name
+            std::set<std::string> l_Taken;
+            for (uint32_t l_Module = 0; l_Module < m_Inference.getModuleCount(); ++l_Module)
+            {
+                std::string l_Name = "py_";
+                for (const char l_Char : l_Reader.getModule(l_Module)->fileName.stem().string())
+                {
+                    l_Name += std::isalnum(static_cast<unsigned char>(l_Char)) ? l_Char : '_';
+                }
+                if (!l_Taken.insert(l_Name).second)
+                {
+                    l_Name += "_" + std::to_string(l_Module);
+                    l_Taken.insert(l_Name);
+                }
+                m_Namespaces.push_back(std::move(l_Name));
+            }
+
+            // Instances of a function are overloads of its name, unless two would take the same C++ types, which
+            // happens when parameters are boxed. Only the instances the program runs are written
+            m_InstanceNames.resize(m_Inference.getModuleCount());
+            for (uint32_t l_Module = 0; l_Module < m_Inference.getModuleCount(); ++l_Module)
+            {
+                for (const TypeInference::Function& l_Function : m_Inference.getModule(l_Module).functions)
+                {
+                    std::vector<std::string>& l_Names = m_InstanceNames[l_Module].emplace_back(l_Function.instances.size());
+                    std::set<std::string> l_Parameters;
+                    for (uint32_t l_Index = 0; l_Index < l_Function.instances.size(); ++l_Index)
+                    {
+                        const TypeInference::Instance& l_Instance = l_Function.instances[l_Index];
+                        if (!l_Instance.used)
+                        {
+                            continue;
+                        }
+                        std::string l_Key;
+                        for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+                        {
+                            l_Key += getTypeName(l_Instance.variables[l_Parameter].type) + ",";
+                        }
+                        l_Names[l_Index] = l_Parameters.insert(l_Key).second ? mangle(l_Function.result.name) : "pyc_" + std::to_string(l_Index) + "_" + std::string(m_Symbols.getName(l_Function.result.name));
+                    }
+                }
+            }
+
+            // Every declaration first, a module may call functions of the modules it imports
+            for (m_Module = 0; m_Module < m_Inference.getModuleCount(); ++m_Module)
+            {
+                const TypeInference::Module& l_Module = getModule();
+                m_Out += "\nnamespace " + m_Namespaces[m_Module] + "\n{\n";
+                for (const TypeInference::Variable& l_Global : l_Module.globals)
+                {
+                    // Globals nothing reads are left out, along with what is stored in them
+                    if (!l_Global.read)
+                    {
+                        continue;
+                    }
+                    if (l_Global.constant)
+                    {
+                        const std::string l_Value = emitConstant(*m_Inference.getConstant(m_Module, l_Global.node), l_Global.type, l_Global.node);
+                        line((l_Global.type == Type::STRING ? "const " : "constexpr ") + getTypeName(l_Global.type) + " " + mangle(l_Global.name) + " = " + l_Value + ";", 1);
+                        continue;
+                    }
+                    line(getTypeName(l_Global.type) + " " + mangle(l_Global.name) + "{};", 1);
+                }
+                for (uint32_t l_Function = 0; l_Function < l_Module.functions.size(); ++l_Function)
+                {
+                    for (uint32_t l_Instance = 0; l_Instance < l_Module.functions[l_Function].instances.size(); ++l_Instance)
+                    {
+                        if (l_Module.functions[l_Function].instances[l_Instance].used)
+                        {
+                            line(getSignature(l_Function, l_Instance) + ";", 1);
+                        }
+                    }
+                }
+                line("void pyc_init();", 1);
+                m_Out += "}\n";
+            }
+            for (m_Module = 0; m_Module < m_Inference.getModuleCount(); ++m_Module)
+            {
+                const TypeInference::Module& l_Module = getModule();
+                m_Out += "\nnamespace " + m_Namespaces[m_Module] + "\n{\n";
+                for (uint32_t l_Function = 0; l_Function < l_Module.functions.size(); ++l_Function)
+                {
+                    for (uint32_t l_Instance = 0; l_Instance < l_Module.functions[l_Function].instances.size(); ++l_Instance)
+                    {
+                        if (l_Module.functions[l_Function].instances[l_Instance].used)
+                        {
+                            writeFunction(l_Function, l_Instance);
+                            m_Out += "\n";
+                        }
+                    }
+                }
+                m_Function = nullptr;
+                m_Instance = nullptr;
+                m_Temporaries = 0;
+                line("void pyc_init()", 1);
+                line("{", 1);
+                m_Indent = 2;
+                writeBlock(l_Module.ast->getNode(l_Module.ast->getRoot()).first);
+                line("}", 1);
+                m_Out += "}\n";
+            }
+
+            m_Out += "\nint main()\n{\n    return ::pyc::run([]\n    {\n";
+            for (uint32_t l_Module = 0; l_Module < m_Inference.getModuleCount(); ++l_Module)
+            {
+                m_Out += "        ::" + m_Namespaces[l_Module] + "::pyc_init();\n";
+            }
+            m_Out += "    });\n}\n";
+        }
+
+    private:
+        [[nodiscard]] const TypeInference::Module& getModule() const { return m_Inference.getModule(m_Module); }
+        [[nodiscard]] const Ast& getAst() const { return *getModule().ast; }
+        [[nodiscard]] const Ast::Node& getNode(const Ast::NodeIndex p_Node) const { return getAst().getNode(p_Node); }
+        // What inference found, with UNKNOWN left in unreached code and list literals nothing was put in taken as
+        // DYNAMIC
+        [[nodiscard]] Type getType(const Ast::NodeIndex p_Node) const
+        {
+            return (m_Instance != nullptr ? m_Instance->types[p_Node - m_Function->firstNode] : getModule().types[p_Node]).resolve();
+        }
+        [[nodiscard]] bool isReached(const Ast::NodeIndex p_Node) const
+        {
+            return m_Instance != nullptr ? m_Instance->reached[p_Node - m_Function->firstNode] != 0 : getModule().reached[p_Node] != 0;
+        }
+        [[nodiscard]] const Reference& getReference(const Ast::NodeIndex p_Node) const { return getModule().references[p_Node]; }
+        [[nodiscard]] const ConstantFolder::Constant* getConstant(const Ast::NodeIndex p_Node) const { return m_Inference.getConstant(m_Module, p_Node); }
+
+        void line(const std::string_view p_Text, const uint32_t p_Indent)
+        {
+            m_Out.append(static_cast<size_t>(p_Indent) * 4, ' ');
+            m_Out += p_Text;
+            m_Out += '\n';
+        }
+        void line(const std::string_view p_Text) { line(p_Text, m_Indent); }
+
+        std::string temporary() { return "pyc_" + std::to_string(++m_Temporaries); }
+
+        void error(const Ast::NodeIndex p_At, std::string p_Message)
+        {
+            const Tokenizer::Location l_Location = getAst().getLocation(p_At);
+            m_Errors[m_Module].push_back({ .message = std::move(p_Message), .line = l_Location.line, .column = l_Location.column });
+        }
+
+        static std::string getTypeName(const Type p_Type)
+        {
+            std::string l_Name;
+            switch (p_Type.getKind())
+            {
+            case Type::NONE:
+                l_Name = "::pyc::NoneType";
+                break;
+            case Type::BOOL:
+                l_Name = "bool";
+                break;
+            case Type::INT:
+                l_Name = "int64_t";
+                break;
+            case Type::FLOAT:
+                l_Name = "double";
+                break;
+            case Type::STRING:
+                l_Name = "::std::string";
+                break;
+            default:
+                l_Name = "::pyc::Value";
+                break;
+            }
+            for (uint8_t l_Depth = 0; l_Depth < p_Type.getListDepth(); ++l_Depth)
+            {
+                l_Name = "::pyc::List<" + l_Name + ">";
+            }
+            return l_Name;
+        }
+
+        std::string mangle(const SymbolTable::Symbol p_Name) const
+        {
+            const std::string_view l_Name = m_Symbols.getName(p_Name);
+            if (std::ranges::find(c_Reserved, l_Name) != c_Reserved.end() || l_Name.starts_with("pyc_"))
+            {
+                return std::string(l_Name) + "_";
+            }
+            return std::string(l_Name);
+        }
+
+        std::string qualify(const uint32_t p_Module, std::string p_Name) const
+        {
+            return p_Module == m_Module ? p_Name : "::" + m_Namespaces[p_Module] + "::" + p_Name;
+        }
+
+        std::string getSignature(const uint32_t p_Function, const uint32_t p_Instance) const
+        {
+            const TypeInference::Function& l_Function = getModule().functions[p_Function];
+            const TypeInference::Instance& l_Instance = l_Function.instances[p_Instance];
+            const Type l_Result = l_Instance.result.type;
+            std::string l_Signature = (l_Result == Type::NONE ? "void" : getTypeName(l_Result)) + " " + m_InstanceNames[m_Module][p_Function][p_Instance] + "(";
+            for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+            {
+                const TypeInference::Variable& l_Variable = l_Instance.variables[l_Parameter];
+                l_Signature += (l_Parameter == 0 ? "" : ", ") + getTypeName(l_Variable.type) + " " + mangle(l_Variable.name);
+            }
+            return l_Signature + ")";
+        }
+
+        // Statements
+
+        void writeFunction(const uint32_t p_Function, const uint32_t p_Instance)
+        {
+            m_Function = &getModule().functions[p_Function];
+            m_Instance = &m_Function->instances[p_Instance];
+            m_Temporaries = 0;
+            line("// " + m_Inference.getInstanceName(*m_Function, *m_Instance), 1);
+            line(getSignature(p_Function, p_Instance), 1);
+            line("{", 1);
+            m_Indent = 2;
+            for (uint32_t l_Local = m_Function->parameterCount; l_Local < m_Instance->variables.size(); ++l_Local)
+            {
+                line(getTypeName(m_Instance->variables[l_Local].type) + " " + mangle(m_Instance->variables[l_Local].name) + "{};");
+            }
+            writeBlock(getAst().getFunction(m_Function->node).body);
+            if (m_Instance->fallsThrough && m_Instance->result.type.isDynamic())
+            {
+                line("return ::pyc::Value();");
+            }
+            line("}", 1);
+        }
+
+        void writeBlock(const uint32_t p_List)
+        {
+            for (const Ast::NodeIndex l_Statement : getAst().getList(p_List))
+            {
+                if (isReached(l_Statement))
+                {
+                    writeStatement(l_Statement);
+                }
+            }
+        }
+
+        void writeNested(const uint32_t p_List)
+        {
+            ++m_Indent;
+            writeBlock(p_List);
+            --m_Indent;
+        }
+
+        void writeStatement(const Ast::NodeIndex p_Node)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            switch (l_Node.kind)
+            {
+            case Ast::RETURN:
+                {
+                    const Type l_Result = m_Instance->result.type;
+                    if (l_Node.first == Ast::c_NoNode)
+                    {
+                        line(l_Result == Type::NONE ? "return;" : "return " + convert("::pyc::None", Type::NONE, l_Result, p_Node) + ";");
+                    }
+                    else if (l_Result == Type::NONE)
+                    {
+                        if (!isConstant(l_Node.first))
+                        {
+                            line(emitDiscarded(l_Node.first) + ";");
+                        }
+                        line("return;");
+                    }
+                    else
+                    {
+                        line("return " + emitAs(l_Node.first, l_Result) + ";");
+                    }
+                    break;
+                }
+            case Ast::IF:
+                writeIf(p_Node);
+                break;
+            case Ast::WHILE:
+                // A loop whose condition folds to false never runs
+                if (const ConstantFolder::Constant* const l_Condition = getConstant(l_Node.first); l_Condition != nullptr && !ConstantFolder::isTruthy(*l_Condition))
+                {
+                    break;
+                }
+                line("while (" + emitCondition(l_Node.first) + ")");
+                line("{");
+                writeNested(l_Node.second);
+                line("}");
+                break;
+            case Ast::FOR:
+                writeFor(p_Node);
+                break;
+            case Ast::ASSIGN:
+                writeAssign(p_Node);
+                break;
+            case Ast::EXPRESSION:
+                // Docstrings and other lone names and constants do nothing
+                if (getNode(l_Node.first).kind != Ast::NAME && !isConstant(l_Node.first))
+                {
+                    line(emitDiscarded(l_Node.first) + ";");
+                }
+                break;
+            case Ast::BREAK:
+                line("break;");
+                break;
+            case Ast::CONTINUE:
+                line("continue;");
+                break;
+            default:
+                // Functions are written on their own, pass does nothing, and inference rejects the rest
+                break;
+            }
+        }
+
+        // Branches whose condition folds to false are left out. One that folds to true is the else of the branches
+        // before it, or is written on its own, and the ones after it are left out
+        void writeIf(const Ast::NodeIndex p_Node)
+        {
+            Ast::NodeIndex l_If = p_Node;
+            // Whether an if was written that the next branch continues
+            bool l_Open = false;
+            while (true)
+            {
+                const Ast::IfData l_Data = getAst().getIf(l_If);
+                const Ast::NodeIndex l_Condition = getNode(l_If).first;
+                const ConstantFolder::Constant* const l_Constant = getConstant(l_Condition);
+                if (l_Constant != nullptr && ConstantFolder::isTruthy(*l_Constant))
+                {
+                    writeElse(l_Data.body, l_Open);
+                    return;
+                }
+                if (l_Constant == nullptr)
+                {
+                    line((l_Open ? "else if (" : "if (") + emitCondition(l_Condition) + ")");
+                    line("{");
+                    writeNested(l_Data.body);
+                    line("}");
+                    l_Open = true;
+                }
+                const std::span<const Ast::NodeIndex> l_Else = getAst().getList(l_Data.orElse);
+                if (l_Else.size() == 1 && (getNode(l_Else[0]).flags & Ast::ELIF))
+                {
+                    l_If = l_Else[0];
+                    continue;
+                }
+                if (!l_Else.empty())
+                {
+                    writeElse(l_Data.orElse, l_Open);
+                }
+                return;
+            }
+        }
+
+        // The branch taken when the ones written before it are not, all of them C++ would have to try
+        void writeElse(const uint32_t p_List, const bool p_Open)
+        {
+            if (!p_Open)
+            {
+                writeBlock(p_List);
+                return;
+            }
+            line("else");
+            line("{");
+            writeNested(p_List);
+            line("}");
+        }
+
+        // Loops over range() with a constant step count in a plain int64_t, and loops over a list by index. Where the
+        // body cannot resize a list, the length is read once, and a range(len(items)) loop reads items[i] unchecked
+        void writeFor(const Ast::NodeIndex p_Node)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Ast::ForData l_For = getAst().getFor(p_Node);
+            const Ast::Node& l_Iterable = getNode(l_For.iterable);
+            const Type l_Type = getType(l_For.iterable);
+            // The parser adds the body's nodes between the iterable and the loop
+            const bool l_Resizes = mayResize(l_For.iterable + 1, p_Node);
+            const std::string l_Item = temporary();
+            std::string l_Read = l_Item;
+            Type l_Element = l_Type.isList() ? l_Type.getElement() : l_Type;
+            const bool l_Range = l_Iterable.kind == Ast::CALL && getNode(l_Iterable.first).kind == Ast::NAME && getReference(l_Iterable.first).kind == Reference::BUILTIN && getReference(l_Iterable.first).index == Builtins::RANGE;
+            const std::span<const Ast::NodeIndex> l_Arguments = l_Range ? getAst().getList(l_Iterable.second) : std::span<const Ast::NodeIndex>{};
+            const std::optional<int64_t> l_Step = !l_Range ? std::nullopt : l_Arguments.size() < 3 ? 1 : getInteger(l_Arguments[2]);
+            const size_t l_Indexed = m_Indexed.size();
+            if (l_Step && *l_Step != 0)
+            {
+                const Ast::NodeIndex l_Stop = l_Arguments[l_Arguments.size() == 1 ? 0 : 1];
+                const std::string l_End = temporary();
+                const std::string l_Start = l_Arguments.size() == 1 ? "INT64_C(0)" : emitAs(l_Arguments[0], Type::INT);
+                if (*l_Step == 1 || *l_Step == -1)
+                {
+                    // Compared before every step, so the counter never passes the stop
+                    line("for (int64_t " + l_Item + " = " + l_Start + ", " + l_End + " = " + emitAs(l_Stop, Type::INT) + "; " + l_Item + (*l_Step > 0 ? " < " : " > ") + l_End + "; " + (*l_Step > 0 ? "++" : "--") + l_Item + ")");
+                }
+                else
+                {
+                    // A longer step may overshoot past the end of int64_t, so the values left are counted instead
+                    const std::string l_StepCode = emitConstant(*l_Step, Type::INT, p_Node);
+                    line("int64_t " + l_Item + " = " + l_Start + ";");
+                    line("for (uint64_t " + l_End + " = ::pyc::rangeLength(" + l_Item + ", " + emitAs(l_Stop, Type::INT) + ", " + l_StepCode + "); " + l_End + " != 0; --" + l_End + ", " + l_Item + " = ::pyc::add(" + l_Item + ", " + l_StepCode + "))");
+                }
+                l_Element = Type::INT;
+                // Counting up from zero or more to the length of a list the body neither resizes nor rebinds, the
+                // target indexes it
+                const std::optional<int64_t> l_First = l_Arguments.size() == 1 ? 0 : getInteger(l_Arguments[0]);
+                const Ast::NodeIndex l_Listed = getLength(l_Stop);
+                if (*l_Step > 0 && l_First && *l_First >= 0 && l_Listed != Ast::c_NoNode && getNode(l_Node.first).kind == Ast::NAME && !l_Resizes
+                    && !mayBind(l_For.iterable + 1, p_Node, getReference(l_Listed)) && !mayBind(l_For.iterable + 1, p_Node, getReference(l_Node.first)))
+                {
+                    m_Indexed.push_back({ getReference(l_Listed), getReference(l_Node.first) });
+                }
+            }
+            else if (l_Range)
+            {
+                std::string l_Code;
+                for (const Ast::NodeIndex l_Argument : l_Arguments)
+                {
+                    l_Code += (l_Code.empty() ? "" : ", ") + emitAs(l_Argument, Type::INT);
+                }
+                line("for (" + std::string(isDropped(l_Node.first) ? "[[maybe_unused]] " : "") + "const int64_t " + l_Item + " : ::pyc::range(" + l_Code + "))");
+                l_Element = Type::INT;
+            }
+            else if (l_Type.isList())
+            {
+                // Python's list iterator reads the length before every item, so that items appended are reached
+                const std::string l_List = temporary();
+                line("const auto " + l_List + " = " + emit(l_For.iterable) + ";");
+                if (l_Resizes)
+                {
+                    line("for (int64_t " + l_Item + " = 0; " + l_Item + " < " + l_List + ".size(); ++" + l_Item + ")");
+                }
+                else
+                {
+                    const std::string l_Size = temporary();
+                    line("for (int64_t " + l_Item + " = 0, " + l_Size + " = " + l_List + ".size(); " + l_Item + " < " + l_Size + "; ++" + l_Item + ")");
+                }
+                l_Read = l_List + "[" + l_Item + "]";
+            }
+            else
+            {
+                // Nothing reads the item when the target is left out
+                line("for (" + std::string(isDropped(l_Node.first) ? "[[maybe_unused]] " : "") + "const auto& " + l_Item + " : ::pyc::iterate(" + emit(l_For.iterable) + "))");
+            }
+            line("{");
+            ++m_Indent;
+            store(l_Node.first, l_Read, l_Element);
+            writeBlock(l_For.body);
+            --m_Indent;
+            line("}");
+            m_Indexed.resize(l_Indexed);
+        }
+
+        // The int p_Node folds to, if it does
+        std::optional<int64_t> getInteger(const Ast::NodeIndex p_Node) const
+        {
+            const ConstantFolder::Constant* const l_Constant = getConstant(p_Node);
+            const std::optional<ConstantFolder::Constant> l_Int = l_Constant != nullptr ? ConstantFolder::convert(*l_Constant, Type::INT) : std::nullopt;
+            return l_Int ? std::optional<int64_t>(std::get<int64_t>(*l_Int)) : std::nullopt;
+        }
+
+        // The list variable p_Node takes the length of, if it is len() of one, c_NoNode otherwise
+        Ast::NodeIndex getLength(const Ast::NodeIndex p_Node) const
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            if (l_Node.kind != Ast::CALL || getNode(l_Node.first).kind != Ast::NAME || getReference(l_Node.first).kind != Reference::BUILTIN || getReference(l_Node.first).index != Builtins::LEN)
+            {
+                return Ast::c_NoNode;
+            }
+            const std::span<const Ast::NodeIndex> l_Arguments = getAst().getList(l_Node.second);
+            if (l_Arguments.size() != 1 || getNode(l_Arguments[0]).kind != Ast::NAME || !getType(l_Arguments[0]).isList())
+            {
+                return Ast::c_NoNode;
+            }
+            const Reference::Kind l_Kind = getReference(l_Arguments[0]).kind;
+            return l_Kind == Reference::LOCAL || l_Kind == Reference::GLOBAL ? l_Arguments[0] : Ast::c_NoNode;
+        }
+
+        // Whether running the nodes from p_First to before p_Last can change the length of a list: a list method, +=
+        // on a list or a boxed value, or a call to a function, which may do anything
+        bool mayResize(const Ast::NodeIndex p_First, const Ast::NodeIndex p_Last) const
+        {
+            for (Ast::NodeIndex l_Index = p_First; l_Index < p_Last; ++l_Index)
+            {
+                const Ast::Node& l_Node = getNode(l_Index);
+                if (l_Node.kind == Ast::ASSIGN && l_Node.op == Ast::ADD && (getType(l_Node.first).isList() || getType(l_Node.first).isDynamic()))
+                {
+                    return true;
+                }
+                if (l_Node.kind != Ast::CALL)
+                {
+                    continue;
+                }
+                const Ast::Node& l_Callee = getNode(l_Node.first);
+                if (getReference(l_Node.first).kind == Reference::FUNCTION)
+                {
+                    return true;
+                }
+                if (l_Callee.kind == Ast::ATTRIBUTE && !(getNode(l_Callee.first).kind == Ast::NAME && getReference(l_Callee.first).kind == Reference::MATH))
+                {
+                    const std::optional<Builtins::Method> l_Method = Builtins::findMethod(getAst().getName(l_Node.first));
+                    if (!l_Method || Builtins::getMethod(*l_Method).onList)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        // Whether the nodes from p_First to before p_Last assign to p_Variable
+        bool mayBind(const Ast::NodeIndex p_First, const Ast::NodeIndex p_Last, const Reference& p_Variable) const
+        {
+            for (Ast::NodeIndex l_Index = p_First; l_Index < p_Last; ++l_Index)
+            {
+                const Ast::Node& l_Node = getNode(l_Index);
+                if ((l_Node.kind == Ast::ASSIGN || l_Node.kind == Ast::FOR) && isBoundBy(l_Node.first, p_Variable))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool isBoundBy(const Ast::NodeIndex p_Target, const Reference& p_Variable) const
+        {
+            const Ast::Node& l_Node = getNode(p_Target);
+            switch (l_Node.kind)
+            {
+            case Ast::NAME:
+                return isSame(getReference(p_Target), p_Variable);
+            case Ast::ANNOTATED:
+                return isBoundBy(l_Node.first, p_Variable);
+            case Ast::TUPLE:
+            case Ast::LIST:
+                return std::ranges::any_of(getAst().getList(l_Node.first), [&](const Ast::NodeIndex p_Element) { return isBoundBy(p_Element, p_Variable); });
+            default:
+                return false;
+            }
+        }
+
+        static bool isSame(const Reference& p_Left, const Reference& p_Right)
+        {
+            return p_Left.kind == p_Right.kind && p_Left.module == p_Right.module && p_Left.index == p_Right.index;
+        }
+
+        // Whether p_Subscript is items[i] inside a loop that keeps i within items
+        bool isInBounds(const Ast::NodeIndex p_Subscript) const
+        {
+            const Ast::Node& l_Node = getNode(p_Subscript);
+            if (getNode(l_Node.first).kind != Ast::NAME || getNode(l_Node.second).kind != Ast::NAME)
+            {
+                return false;
+            }
+            return std::ranges::any_of(m_Indexed, [&](const std::array<Reference, 2>& p_Indexed)
+            {
+                return isSame(p_Indexed[0], getReference(l_Node.first)) && isSame(p_Indexed[1], getReference(l_Node.second));
+            });
+        }
+
+        // Type what is stored in p_Target is kept as
+        Type getTargetType(const Ast::NodeIndex p_Target) const
+        {
+            const Ast::Node& l_Node = getNode(p_Target);
+            if (l_Node.kind == Ast::ANNOTATED)
+            {
+                return getTargetType(l_Node.first);
+            }
+            if (l_Node.kind == Ast::SUBSCRIPT)
+            {
+                const Type l_Object = getType(l_Node.first);
+                return l_Object.isList() ? l_Object.getElement() : Type{ Type::DYNAMIC };
+            }
+            return getVariable(p_Target).type;
+        }
+
+        const TypeInference::Variable& getVariable(const Ast::NodeIndex p_Name) const
+        {
+            const Reference& l_Reference = getReference(p_Name);
+            return l_Reference.kind == Reference::LOCAL ? m_Instance->variables[l_Reference.index] : m_Inference.getGlobal(l_Reference);
+        }
+
+        // Whether p_Target is a global left out of the C++, or a constant one its declaration already holds
+        bool isDropped(const Ast::NodeIndex p_Target) const
+        {
+            const Ast::Node& l_Node = getNode(p_Target);
+            if (l_Node.kind == Ast::ANNOTATED)
+            {
+                return isDropped(l_Node.first);
+            }
+            if (l_Node.kind != Ast::NAME || getReference(p_Target).kind != Reference::GLOBAL)
+            {
+                return false;
+            }
+            const TypeInference::Variable& l_Global = m_Inference.getGlobal(getReference(p_Target));
+            return !l_Global.read || l_Global.constant;
+        }
+
+        std::string getVariableName(const Ast::NodeIndex p_Name) const
+        {
+            const Reference& l_Reference = getReference(p_Name);
+            return qualify(l_Reference.kind == Reference::LOCAL ? m_Module : l_Reference.module, mangle(getVariable(p_Name).name));
+        }
+
+        // Stores p_Code, of type p_Type, in p_Target
+        void store(const Ast::NodeIndex p_Target, const std::string& p_Code, const Type p_Type)
+        {
+            const Ast::Node& l_Node = getNode(p_Target);
+            switch (l_Node.kind)
+            {
+            case Ast::ANNOTATED:
+                store(l_Node.first, p_Code, p_Type);
+                break;
+            case Ast::SUBSCRIPT:
+                {
+                    const Type l_Object = getType(l_Node.first);
+                    if (l_Object.isList())
+                    {
+                        line(emit(l_Node.first) + (isInBounds(p_Target) ? ".setUnchecked(" : ".set(") + emitAs(l_Node.second, Type::INT) + ", " + convert(p_Code, p_Type, l_Object.getElement(), p_Target) + ");");
+                    }
+                    else
+                    {
+                        line("::pyc::setItem(" + emitAs(l_Node.first, Type::DYNAMIC) + ", " + emitAs(l_Node.second, Type::DYNAMIC) + ", " + convert(p_Code, p_Type, Type::DYNAMIC, p_Target) + ");");
+                    }
+                    break;
+                }
+            default:
+                if (!isDropped(p_Target))
+                {
+                    line(getVariableName(p_Target) + " = " + convert(p_Code, p_Type, getVariable(p_Target).type, p_Target) + ";");
+                }
+                break;
+            }
+        }
+
+        void writeAssign(const Ast::NodeIndex p_Node)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            if (l_Node.second == Ast::c_NoNode)
+            {
+                return;
+            }
+            const Ast::Node& l_Target = getNode(l_Node.first);
+            if (l_Node.op != Ast::NO_OPERATOR)
+            {
+                writeAugmentedAssign(p_Node);
+                return;
+            }
+            if (l_Target.kind == Ast::TUPLE || l_Target.kind == Ast::LIST)
+            {
+                // Every value before any target
+                const std::span<const Ast::NodeIndex> l_Targets = getAst().getList(l_Target.first);
+                const std::span<const Ast::NodeIndex> l_Values = getAst().getList(getNode(l_Node.second).first);
+                std::vector<std::string> l_Temporaries;
+                for (size_t l_Index = 0; l_Index < l_Targets.size(); ++l_Index)
+                {
+                    const Type l_Type = getTargetType(l_Targets[l_Index]);
+                    if (isDropped(l_Targets[l_Index]))
+                    {
+                        l_Temporaries.emplace_back();
+                        if (hasEffects(l_Values[l_Index]))
+                        {
+                            line(emitDiscarded(l_Values[l_Index]) + ";");
+                        }
+                        continue;
+                    }
+                    l_Temporaries.push_back(temporary());
+                    line("const " + getTypeName(l_Type) + " " + l_Temporaries.back() + " = " + emitAs(l_Values[l_Index], l_Type) + ";");
+                }
+                for (size_t l_Index = 0; l_Index < l_Targets.size(); ++l_Index)
+                {
+                    store(l_Targets[l_Index], l_Temporaries[l_Index], getTargetType(l_Targets[l_Index]));
+                }
+                return;
+            }
+            if (isDropped(l_Node.first))
+            {
+                // What the value does still happens
+                if (hasEffects(l_Node.second))
+                {
+                    line(emitDiscarded(l_Node.second) + ";");
+                }
+                return;
+            }
+            const Type l_Type = getTargetType(l_Node.first);
+            store(l_Node.first, emitAs(l_Node.second, l_Type), l_Type);
+        }
+
+        void writeAugmentedAssign(const Ast::NodeIndex p_Node)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Ast::Node& l_Target = getNode(l_Node.first);
+            // What the target holds now, and what the operation makes of it
+            const Type l_Current = getType(l_Node.first);
+            const Type l_Result = getType(p_Node);
+            std::string l_Read;
+            std::string l_Object;
+            std::string l_Index;
+            if (l_Target.kind == Ast::SUBSCRIPT)
+            {
+                // The list and the index are evaluated once
+                const Type l_ObjectType = getType(l_Target.first);
+                l_Object = temporary();
+                l_Index = temporary();
+                line("const auto " + l_Object + " = " + emit(l_Target.first) + ";");
+                if (l_ObjectType.isList())
+                {
+                    line("const int64_t " + l_Index + " = " + emitAs(l_Target.second, Type::INT) + ";");
+                    l_Read = convert(l_Object + (isInBounds(l_Node.first) ? "[" + l_Index + "]" : ".at(" + l_Index + ")"), l_ObjectType.getElement(), l_Current, l_Node.first);
+                }
+                else
+                {
+                    line("const ::pyc::Value " + l_Index + " = " + emitAs(l_Target.second, Type::DYNAMIC) + ";");
+                    l_Read = convert("::pyc::getItem(" + convert(l_Object, l_ObjectType, Type::DYNAMIC, l_Node.first) + ", " + l_Index + ")", Type::DYNAMIC, l_Current, l_Node.first);
+                }
+            }
+            else
+            {
+                l_Read = emit(l_Node.first);
+            }
+
+            std::string l_Value;
+            if (hasEffects(l_Node.second))
+            {
+                // The target is read before the value is evaluated
+                const std::string l_Target = temporary();
+                line("const " + getTypeName(l_Current) + " " + l_Target + " = " + l_Read + ";");
+                l_Read = l_Target;
+            }
+            if (l_Node.op == Ast::ADD && l_Current.isList())
+            {
+                // Extends the list in place
+                line(l_Read + ".extend(" + emitAs(l_Node.second, l_Current) + ");");
+                return;
+            }
+            if (l_Node.op == Ast::ADD && l_Current.isDynamic())
+            {
+                l_Value = "::pyc::addInPlace(" + l_Read + ", " + emitAs(l_Node.second, Type::DYNAMIC) + ")";
+            }
+            else
+            {
+                l_Value = emitBinary(l_Node.op, l_Read, l_Current, l_Node.second, l_Result, p_Node);
+            }
+
+            if (l_Target.kind != Ast::SUBSCRIPT)
+            {
+                store(l_Node.first, l_Value, l_Result);
+                return;
+            }
+            const Type l_ObjectType = getType(l_Target.first);
+            if (l_ObjectType.isList())
+            {
+                line(l_Object + (isInBounds(l_Node.first) ? ".setUnchecked(" : ".set(") + l_Index + ", " + convert(l_Value, l_Result, l_ObjectType.getElement(), p_Node) + ");");
+            }
+            else
+            {
+                line("::pyc::setItem(" + convert(l_Object, l_ObjectType, Type::DYNAMIC, p_Node) + ", " + l_Index + ", " + convert(l_Value, l_Result, Type::DYNAMIC, p_Node) + ");");
+            }
+        }
+
+        // Expressions
+
+        std::string emitCondition(const Ast::NodeIndex p_Node)
+        {
+            if (const ConstantFolder::Constant* const l_Constant = getConstant(p_Node))
+            {
+                return ConstantFolder::isTruthy(*l_Constant) ? "true" : "false";
+            }
+            const Type l_Type = getType(p_Node);
+            return l_Type == Type::BOOL ? emit(p_Node) : "::pyc::truthy(" + emit(p_Node) + ")";
+        }
+
+        // An expression whose value is not used, where a call to a function returning None is left as it is
+        std::string emitDiscarded(const Ast::NodeIndex p_Node)
+        {
+            if (getNode(p_Node).kind == Ast::CALL)
+            {
+                bool l_Void = false;
+                return emitCall(p_Node, l_Void);
+            }
+            return emit(p_Node);
+        }
+
+        std::string emit(const Ast::NodeIndex p_Node)
+        {
+            return emitAs(p_Node, getType(p_Node));
+        }
+
+        // p_Node converted to p_Type. List displays and conditionals are made as p_Type directly
+        std::string emitAs(const Ast::NodeIndex p_Node, const Type p_Type)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Type l_Type = getType(p_Node);
+            // What folds is written out, but for reads of constant globals, which keep their name
+            const ConstantFolder::Constant* const l_Constant = getConstant(p_Node);
+            if (l_Constant != nullptr && getReference(p_Node).kind != Reference::GLOBAL)
+            {
+                return emitConstant(*l_Constant, p_Type, p_Node);
+            }
+            switch (l_Node.kind)
+            {
+            case Ast::NAME:
+                // A DYNAMIC variable known to hold a scalar is read unboxed
+                return convert(convert(getVariableName(p_Node), getVariable(p_Node).type, l_Type, p_Node), l_Type, p_Type, p_Node);
+            case Ast::UNARY:
+                return convert(emitUnary(p_Node), l_Type, p_Type, p_Node);
+            case Ast::BINARY:
+                {
+                    // Left operands of and and or that fold do not decide, or the whole would
+                    if ((l_Node.op == Ast::AND || l_Node.op == Ast::OR) && getConstant(l_Node.first) != nullptr)
+                    {
+                        return emitAs(l_Node.second, p_Type);
+                    }
+                    if (!isConstant(l_Node.first) && hasEffects(l_Node.second) && l_Node.op != Ast::AND && l_Node.op != Ast::OR)
+                    {
+                        // C++ does not order operands, the left one is evaluated first
+                        const std::string l_Left = temporary();
+                        const std::string l_Code = "const auto " + l_Left + " = " + emit(l_Node.first) + "; return ";
+                        return convert("[&]() -> " + getTypeName(l_Type) + " { " + l_Code + emitBinary(l_Node.op, l_Left, getType(l_Node.first), l_Node.second, l_Type, p_Node) + "; }()", l_Type, p_Type, p_Node);
+                    }
+                    return convert(emitBinary(l_Node.op, emit(l_Node.first), getType(l_Node.first), l_Node.second, l_Type, p_Node), l_Type, p_Type, p_Node);
+                }
+            case Ast::CONDITIONAL:
+                {
+                    const std::span<const Ast::NodeIndex, 2> l_Branches = getAst().getBranches(p_Node);
+                    if (const ConstantFolder::Constant* const l_Condition = getConstant(l_Node.first))
+                    {
+                        return emitAs(l_Branches[ConstantFolder::isTruthy(*l_Condition) ? 0 : 1], p_Type);
+                    }
+                    return "(" + emitCondition(l_Node.first) + " ? " + emitAs(l_Branches[0], p_Type) + " : " + emitAs(l_Branches[1], p_Type) + ")";
+                }
+            case Ast::CALL:
+                {
+                    bool l_Void = false;
+                    const std::string l_Call = emitCall(p_Node, l_Void);
+                    return convert(l_Void ? "(" + l_Call + ", ::pyc::None)" : l_Call, l_Void ? Type{ Type::NONE } : l_Type, p_Type, p_Node);
+                }
+            case Ast::ATTRIBUTE:
+                {
+                    const Reference& l_Reference = getReference(p_Node);
+                    const TypeInference::Variable& l_Global = m_Inference.getGlobal(l_Reference);
+                    return convert(convert(qualify(l_Reference.module, mangle(l_Global.name)), l_Global.type, l_Type, p_Node), l_Type, p_Type, p_Node);
+                }
+            case Ast::SUBSCRIPT:
+                {
+                    const Type l_Object = getType(l_Node.first);
+                    std::string l_Code;
+                    if (l_Object.isList())
+                    {
+                        const std::string l_Index = emitAs(l_Node.second, Type::INT);
+                        l_Code = emit(l_Node.first) + (isInBounds(p_Node) ? "[" + l_Index + "]" : ".at(" + l_Index + ")");
+                    }
+                    else if (l_Object == Type::STRING)
+                    {
+                        l_Code = emitArguments("::pyc::charAt", { emit(l_Node.first), emitAs(l_Node.second, Type::INT) }, { l_Node.first, l_Node.second });
+                    }
+                    else
+                    {
+                        l_Code = emitArguments("::pyc::getItem", { emitAs(l_Node.first, Type::DYNAMIC), emitAs(l_Node.second, Type::DYNAMIC) }, { l_Node.first, l_Node.second });
+                    }
+                    return convert(l_Code, l_Type, p_Type, p_Node);
+                }
+            case Ast::LIST:
+                {
+                    const Type l_List = p_Type.isList() ? p_Type : l_Type;
+                    std::string l_Code = getTypeName(l_List) + "{";
+                    const std::span<const Ast::NodeIndex> l_Items = getAst().getList(l_Node.first);
+                    for (size_t l_Index = 0; l_Index < l_Items.size(); ++l_Index)
+                    {
+                        l_Code += (l_Index == 0 ? " " : ", ") + emitAs(l_Items[l_Index], l_List.getElement());
+                    }
+                    l_Code += l_Items.empty() ? "}" : " }";
+                    return convert(l_Code, l_List, p_Type, p_Node);
+                }
+            default:
+                error(p_Node, "Cannot translate " + std::string(Ast::getKindName(l_Node.kind)));
+                return "::pyc::Value()";
+            }
+        }
+
+        std::string emitConstant(const ConstantFolder::Constant& p_Constant, const Type p_Type, const Ast::NodeIndex p_At)
+        {
+            std::string l_Code = "::pyc::None";
+            if (const int64_t* const l_Int = std::get_if<int64_t>(&p_Constant))
+            {
+                if (p_Type == Type::FLOAT)
+                {
+                    return formatDouble(static_cast<double>(*l_Int));
+                }
+                // The smallest int has no literal, the one it would negate is out of range
+                l_Code = *l_Int == std::numeric_limits<int64_t>::min() ? "(INT64_C(-9223372036854775807) - 1)" : "INT64_C(" + std::to_string(*l_Int) + ")";
+            }
+            else if (const double* const l_Float = std::get_if<double>(&p_Constant))
+            {
+                l_Code = formatDouble(*l_Float);
+            }
+            else if (const bool* const l_Bool = std::get_if<bool>(&p_Constant))
+            {
+                l_Code = *l_Bool ? "true" : "false";
+            }
+            else if (const std::string* const l_String = std::get_if<std::string>(&p_Constant))
+            {
+                l_Code = formatString(*l_String);
+            }
+            return convert(l_Code, ConstantFolder::getType(p_Constant), p_Type, p_At);
+        }
+
+        // p_Code, of type p_From, as a p_To
+        std::string convert(const std::string& p_Code, const Type p_From, const Type p_To, const Ast::NodeIndex p_At)
+        {
+            if (p_From == p_To)
+            {
+                return p_Code;
+            }
+            if (p_To.isDynamic())
+            {
+                return "::pyc::Value(" + p_Code + ")";
+            }
+            if (p_From.isDynamic())
+            {
+                return "::pyc::unbox<" + getTypeName(p_To) + ">(" + p_Code + ")";
+            }
+            if ((p_From == Type::INT || p_From == Type::BOOL) && p_To == Type::FLOAT)
+            {
+                return "static_cast<double>(" + p_Code + ")";
+            }
+            if (p_From == Type::BOOL && p_To == Type::INT)
+            {
+                return "static_cast<int64_t>(" + p_Code + ")";
+            }
+            error(p_At, "Cannot convert " + p_From.getName() + " to " + p_To.getName());
+            return p_Code;
+        }
+
+        std::string emitUnary(const Ast::NodeIndex p_Node)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Type l_Operand = getType(l_Node.first);
+            if (l_Node.op == Ast::NOT)
+            {
+                return "(!" + emitCondition(l_Node.first) + ")";
+            }
+            if (l_Operand.isDynamic())
+            {
+                return std::string(l_Node.op == Ast::NEGATE ? "::pyc::negate(" : l_Node.op == Ast::POSITIVE ? "::pyc::positive(" : "::pyc::invert(") + emit(l_Node.first) + ")";
+            }
+            const Type l_Result = getType(p_Node);
+            const std::string l_Value = emitAs(l_Node.first, l_Result);
+            if (l_Node.op == Ast::POSITIVE)
+            {
+                return l_Value;
+            }
+            // Wrapping on ints, where C++ leaves overflow undefined
+            if (l_Node.op == Ast::NEGATE && l_Result == Type::INT)
+            {
+                return "::pyc::negate(" + l_Value + ")";
+            }
+            return std::string(l_Node.op == Ast::NEGATE ? "(-" : "(~") + l_Value + ")";
+        }
+
+        // p_Left, of type p_LeftType, p_Operator the value of p_Right. p_Result is what inference found it makes
+        std::string emitBinary(const Ast::Operator p_Operator, const std::string& p_Left, const Type p_LeftType, const Ast::NodeIndex p_Right, const Type p_Result, const Ast::NodeIndex p_At)
+        {
+            const Type l_RightType = getType(p_Right);
+            if (p_Operator == Ast::AND || p_Operator == Ast::OR)
+            {
+                if (p_LeftType == Type::BOOL && l_RightType == Type::BOOL)
+                {
+                    return "(" + p_Left + (p_Operator == Ast::AND ? " && " : " || ") + emit(p_Right) + ")";
+                }
+                // The left value is kept, evaluated once, unless it decides for the right one
+                const std::string l_Left = temporary();
+                const std::string l_Kept = convert(l_Left, p_LeftType, p_Result, p_At);
+                const std::string l_Other = emitAs(p_Right, p_Result);
+                return "[&]() -> " + getTypeName(p_Result) + " { const auto " + l_Left + " = " + p_Left + "; return ::pyc::truthy(" + l_Left + ") ? "
+                    + (p_Operator == Ast::AND ? l_Other + " : " + l_Kept : l_Kept + " : " + l_Other) + "; }()";
+            }
+            if (Ast::isComparison(p_Operator))
+            {
+                return emitComparison(p_Operator, p_Left, p_LeftType, p_Right, p_At);
+            }
+            if (p_LeftType.isDynamic() || l_RightType.isDynamic() || p_Result.isDynamic())
+            {
+                return convert("::pyc::" + std::string(c_OperationNames[p_Operator]) + "(" + convert(p_Left, p_LeftType, Type::DYNAMIC, p_At) + ", " + emitAs(p_Right, Type::DYNAMIC) + ")", Type::DYNAMIC, p_Result, p_At);
+            }
+            if (p_LeftType.isNumber() && l_RightType.isNumber())
+            {
+                const Type l_Common = p_LeftType == Type::FLOAT || l_RightType == Type::FLOAT ? Type::FLOAT : Type::INT;
+                const auto l_Call = [&](const Type p_Type)
+                {
+                    return "::pyc::" + std::string(c_OperationNames[p_Operator]) + "(" + convert(p_Left, p_LeftType, p_Type, p_At) + ", " + emitAs(p_Right, p_Type) + ")";
+                };
+                switch (p_Operator)
+                {
+                case Ast::ADD:
+                case Ast::SUBTRACT:
+                case Ast::MULTIPLY:
+                    // Wrapping on ints, where C++ leaves overflow undefined
+                    if (l_Common == Type::INT)
+                    {
+                        return l_Call(Type::INT);
+                    }
+                    return "(" + convert(p_Left, p_LeftType, l_Common, p_At) + " " + std::string(Ast::getOperatorName(p_Operator)) + " " + emitAs(p_Right, l_Common) + ")";
+                case Ast::DIVIDE:
+                    return l_Call(Type::FLOAT);
+                case Ast::POWER:
+                    return l_Call(p_Result);
+                case Ast::BIT_AND:
+                case Ast::BIT_OR:
+                case Ast::BIT_XOR:
+                    if (p_Result == Type::BOOL)
+                    {
+                        return "static_cast<bool>(" + p_Left + " " + std::string(Ast::getOperatorName(p_Operator)) + " " + emit(p_Right) + ")";
+                    }
+                    return "(" + convert(p_Left, p_LeftType, Type::INT, p_At) + " " + std::string(Ast::getOperatorName(p_Operator)) + " " + emitAs(p_Right, Type::INT) + ")";
+                default:
+                    return l_Call(l_Common);
+                }
+            }
+            if (p_Operator == Ast::ADD && p_Result == Type::STRING)
+            {
+                return "(" + p_Left + " + " + emit(p_Right) + ")";
+            }
+            if (p_Operator == Ast::ADD)
+            {
+                return "::pyc::concat(" + convert(p_Left, p_LeftType, p_Result, p_At) + ", " + emitAs(p_Right, p_Result) + ")";
+            }
+            // Repetition, of whichever side is the sequence
+            if (p_LeftType == Type::STRING || p_LeftType.isList())
+            {
+                return "::pyc::repeat(" + p_Left + ", " + emitAs(p_Right, Type::INT) + ")";
+            }
+            return "::pyc::repeat(" + emitAs(p_Right, p_Result) + ", " + convert(p_Left, p_LeftType, Type::INT, p_At) + ")";
+        }
+
+        std::string emitComparison(const Ast::Operator p_Operator, const std::string& p_Left, const Type p_LeftType, const Ast::NodeIndex p_Right, const Ast::NodeIndex p_At)
+        {
+            const Type l_RightType = getType(p_Right);
+            if (p_Operator == Ast::IN || p_Operator == Ast::NOT_IN)
+            {
+                std::string l_Code;
+                if (l_RightType.isList() && !p_LeftType.isDynamic() && p_LeftType != l_RightType.getElement() && !(p_LeftType.isNumber() && l_RightType.getElement().isNumber()) && !l_RightType.getElement().isDynamic())
+                {
+                    // Never equal to any item
+                    l_Code = "((void)" + p_Left + ", (void)" + emit(p_Right) + ", false)";
+                }
+                else if (l_RightType.isList() && !p_LeftType.isDynamic())
+                {
+                    l_Code = "::pyc::contains(" + emit(p_Right) + ", " + convert(p_Left, p_LeftType, l_RightType.getElement(), p_At) + ")";
+                }
+                else if (l_RightType == Type::STRING && p_LeftType == Type::STRING)
+                {
+                    l_Code = "::pyc::contains(" + emit(p_Right) + ", " + p_Left + ")";
+                }
+                else
+                {
+                    l_Code = "::pyc::contains(" + emitAs(p_Right, Type::DYNAMIC) + ", " + convert(p_Left, p_LeftType, Type::DYNAMIC, p_At) + ")";
+                }
+                return p_Operator == Ast::IN ? l_Code : "(!" + l_Code + ")";
+            }
+
+            const std::string l_Operator(Ast::getOperatorName(p_Operator));
+            const bool l_Numbers = p_LeftType.isNumber() && l_RightType.isNumber();
+            if (l_Numbers || (p_LeftType == l_RightType && !p_LeftType.isDynamic()))
+            {
+                return "(" + p_Left + " " + l_Operator + " " + emit(p_Right) + ")";
+            }
+            const bool l_Equality = p_Operator == Ast::EQUAL || p_Operator == Ast::NOT_EQUAL;
+            if (l_Equality && !p_LeftType.isDynamic() && !l_RightType.isDynamic())
+            {
+                // Values of different types are never equal
+                return "((void)" + p_Left + ", (void)" + emit(p_Right) + ", " + (p_Operator == Ast::NOT_EQUAL ? "true" : "false") + ")";
+            }
+            return "(" + convert(p_Left, p_LeftType, Type::DYNAMIC, p_At) + " " + l_Operator + " " + emitAs(p_Right, Type::DYNAMIC) + ")";
+        }
+
+        bool isConstant(const Ast::NodeIndex p_Node) const
+        {
+            return p_Node == Ast::c_NoNode || getConstant(p_Node) != nullptr;
+        }
+
+        // Whether evaluating p_Node can change what other expressions read or print something, which decides
+        // whether the arguments around it have to be evaluated first
+        bool hasEffects(const Ast::NodeIndex p_Node) const
+        {
+            if (isConstant(p_Node))
+            {
+                return false;
+            }
+            const Ast::Node& l_Node = getNode(p_Node);
+            switch (l_Node.kind)
+            {
+            case Ast::CALL:
+                {
+                    const Ast::Node& l_Callee = getNode(l_Node.first);
+                    bool l_Effects = true;
+                    if (l_Callee.kind == Ast::NAME && getReference(l_Node.first).kind == Reference::BUILTIN)
+                    {
+                        l_Effects = getReference(l_Node.first).index == Builtins::PRINT;
+                    }
+                    else if (l_Callee.kind == Ast::ATTRIBUTE && getNode(l_Callee.first).kind == Ast::NAME && getReference(l_Callee.first).kind == Reference::MATH)
+                    {
+                        l_Effects = false;
+                    }
+                    else if (l_Callee.kind == Ast::ATTRIBUTE && getReference(l_Node.first).kind != Reference::FUNCTION)
+                    {
+                        const std::optional<Builtins::Method> l_Method = Builtins::findMethod(getAst().getName(l_Node.first));
+                        l_Effects = !l_Method || Builtins::getMethod(*l_Method).onList || hasEffects(l_Callee.first);
+                    }
+                    return l_Effects || std::ranges::any_of(getAst().getList(l_Node.second), [this](const Ast::NodeIndex p_Argument) { return hasEffects(p_Argument); });
+                }
+            case Ast::UNARY:
+            case Ast::KEYWORD_ARGUMENT:
+            case Ast::ATTRIBUTE:
+                return hasEffects(l_Node.first);
+            case Ast::BINARY:
+            case Ast::SUBSCRIPT:
+                return hasEffects(l_Node.first) || hasEffects(l_Node.second);
+            case Ast::CONDITIONAL:
+                return hasEffects(l_Node.first) || hasEffects(getAst().getBranches(p_Node)[0]) || hasEffects(getAst().getBranches(p_Node)[1]);
+            case Ast::LIST:
+                return std::ranges::any_of(getAst().getList(l_Node.first), [this](const Ast::NodeIndex p_Item) { return hasEffects(p_Item); });
+            default:
+                return false;
+            }
+        }
+
+        // p_Callee applied to p_Arguments. C++ leaves the order arguments are evaluated in open, so when one has
+        // effects the others are evaluated first into temporaries, in Python's order
+        std::string emitArguments(const std::string& p_Callee, const std::vector<std::string>& p_Arguments, const std::vector<Ast::NodeIndex>& p_Nodes)
+        {
+            uint32_t l_Evaluated = 0;
+            bool l_Effects = false;
+            for (const Ast::NodeIndex l_Node : p_Nodes)
+            {
+                l_Evaluated += isConstant(l_Node) ? 0 : 1;
+                l_Effects |= hasEffects(l_Node);
+            }
+            std::string l_Prefix;
+            std::string l_Call = p_Callee + "(";
+            for (size_t l_Index = 0; l_Index < p_Arguments.size(); ++l_Index)
+            {
+                std::string l_Argument = p_Arguments[l_Index];
+                const Ast::NodeIndex l_Node = p_Nodes[l_Index];
+                if (l_Effects && l_Evaluated > 1 && !isConstant(l_Node))
+                {
+                    const std::string l_Temporary = temporary();
+                    l_Prefix += "const auto " + l_Temporary + " = " + l_Argument + "; ";
+                    l_Argument = l_Temporary;
+                }
+                l_Call += (l_Index == 0 ? "" : ", ") + l_Argument;
+            }
+            l_Call += ")";
+            return l_Prefix.empty() ? l_Call : "[&]() { " + l_Prefix + "return " + l_Call + "; }()";
+        }
+
+        // A call, p_Void set if it returns nothing
+        std::string emitCall(const Ast::NodeIndex p_Node, bool& p_Void)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Ast::Node& l_Callee = getNode(l_Node.first);
+            if (l_Callee.kind == Ast::NAME && getReference(l_Node.first).kind == Reference::BUILTIN)
+            {
+                return emitBuiltinCall(p_Node, static_cast<Builtins::Function>(getReference(l_Node.first).index), p_Void);
+            }
+            if (l_Callee.kind == Ast::ATTRIBUTE && getNode(l_Callee.first).kind == Ast::NAME && getReference(l_Callee.first).kind == Reference::MATH)
+            {
+                const Builtins::MathFunction& l_Function = *Builtins::findMathFunction(getAst().getName(l_Node.first));
+                const Type l_Argument = l_Function.result == Type::INT && l_Function.minArguments == 2 ? Type::INT : Type::FLOAT;
+                std::vector<std::string> l_Arguments;
+                std::vector<Ast::NodeIndex> l_Nodes;
+                for (const Ast::NodeIndex l_Node : getAst().getList(getNode(p_Node).second))
+                {
+                    l_Arguments.push_back(emitAs(l_Node, l_Argument));
+                    l_Nodes.push_back(l_Node);
+                }
+                return emitArguments(std::string(l_Function.cppName), l_Arguments, l_Nodes);
+            }
+            const Reference& l_Reference = getReference(l_Node.first);
+            if (l_Reference.kind == Reference::FUNCTION)
+            {
+                return emitFunctionCall(p_Node, l_Reference, p_Void);
+            }
+            return emitMethodCall(p_Node, p_Void);
+        }
+
+        std::string emitFunctionCall(const Ast::NodeIndex p_Node, const Reference& p_Callee, bool& p_Void)
+        {
+            const TypeInference::Function& l_Function = m_Inference.getFunction(p_Callee);
+            const uint32_t l_Index = (m_Instance != nullptr ? m_Instance->callees : getModule().callees).at(p_Node);
+            const TypeInference::Instance& l_Instance = l_Function.instances[l_Index];
+            const std::vector<Ast::NodeIndex> l_Matched = m_Inference.matchArguments(m_Module, p_Node, l_Function);
+            std::vector<std::string> l_Arguments;
+            for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+            {
+                const Type l_Type = l_Instance.variables[l_Parameter].type;
+                if (l_Matched[l_Parameter] != Ast::c_NoNode)
+                {
+                    l_Arguments.push_back(emitAs(l_Matched[l_Parameter], l_Type));
+                    continue;
+                }
+                // The default, a constant of the callee's module
+                const Ast::NodeIndex l_Default = m_Inference.getModule(p_Callee.module).ast->getNode(l_Function.variables[l_Parameter].node).second;
+                l_Arguments.push_back(emitConstant(*m_Inference.getConstant(p_Callee.module, l_Default), l_Type, p_Node));
+            }
+            p_Void = l_Instance.result.type == Type::NONE;
+            return emitArguments(qualify(p_Callee.module, m_InstanceNames[p_Callee.module][p_Callee.index][l_Index]), l_Arguments, l_Matched);
+        }
+
+        std::string emitBuiltinCall(const Ast::NodeIndex p_Node, const Builtins::Function p_Function, bool& p_Void)
+        {
+            const Type l_Result = getType(p_Node);
+            std::vector<Ast::NodeIndex> l_Positional;
+            Ast::NodeIndex l_Separator = Ast::c_NoNode;
+            Ast::NodeIndex l_End = Ast::c_NoNode;
+            for (const Ast::NodeIndex l_Argument : getAst().getList(getNode(p_Node).second))
+            {
+                if (getNode(l_Argument).kind != Ast::KEYWORD_ARGUMENT)
+                {
+                    l_Positional.push_back(l_Argument);
+                }
+                else
+                {
+                    (getAst().getName(l_Argument) == "sep" ? l_Separator : l_End) = getNode(l_Argument).first;
+                }
+            }
+            const Type l_First = l_Positional.empty() ? Type{} : getType(l_Positional[0]);
+            std::vector<std::string> l_Arguments;
+            switch (p_Function)
+            {
+            case Builtins::PRINT:
+                {
+                    p_Void = true;
+                    std::vector<Ast::NodeIndex> l_Nodes;
+                    std::string l_Callee = "::pyc::print";
+                    if (l_Separator != Ast::c_NoNode || l_End != Ast::c_NoNode)
+                    {
+                        l_Callee = "::pyc::printWith";
+                        l_Arguments.push_back(l_Separator == Ast::c_NoNode ? "\" \"" : emitAs(l_Separator, Type::STRING));
+                        l_Arguments.push_back(l_End == Ast::c_NoNode ? "\"\\n\"" : emitAs(l_End, Type::STRING));
+                        l_Nodes = { l_Separator, l_End };
+                    }
+                    for (const Ast::NodeIndex l_Argument : l_Positional)
+                    {
+                        l_Arguments.push_back(emit(l_Argument));
+                        l_Nodes.push_back(l_Argument);
+                    }
+                    return emitArguments(l_Callee, l_Arguments, l_Nodes);
+                }
+            case Builtins::LEN:
+                return "::pyc::len(" + emit(l_Positional[0]) + ")";
+            case Builtins::INT:
+                if (l_Positional.empty())
+                {
+                    return "INT64_C(0)";
+                }
+                return l_First == Type::INT || l_First == Type::BOOL ? emitAs(l_Positional[0], Type::INT) : "::pyc::toInt(" + emit(l_Positional[0]) + ")";
+            case Builtins::FLOAT:
+                if (l_Positional.empty())
+                {
+                    return "0.0";
+                }
+                return l_First.isNumber() ? emitAs(l_Positional[0], Type::FLOAT) : "::pyc::toFloat(" + emit(l_Positional[0]) + ")";
+            case Builtins::STR:
+                return l_Positional.empty() ? "::std::string()" : "::pyc::str(" + emit(l_Positional[0]) + ")";
+            case Builtins::BOOL:
+                return l_Positional.empty() ? "false" : emitCondition(l_Positional[0]);
+            case Builtins::ABS:
+                return "::pyc::abs(" + emitAs(l_Positional[0], l_Result) + ")";
+            case Builtins::MIN:
+            case Builtins::MAX:
+                {
+                    const std::string l_Name = p_Function == Builtins::MIN ? "::pyc::min" : "::pyc::max";
+                    if (l_Positional.size() == 1)
+                    {
+                        return l_Name + "(" + emit(l_Positional[0]) + ")";
+                    }
+                    // Braces evaluate in order
+                    std::string l_Code = l_Name + "<" + getTypeName(l_Result) + ">({ ";
+                    for (size_t l_Index = 0; l_Index < l_Positional.size(); ++l_Index)
+                    {
+                        l_Code += (l_Index == 0 ? "" : ", ") + emitAs(l_Positional[l_Index], l_Result);
+                    }
+                    return l_Code + " })";
+                }
+            case Builtins::SUM:
+                return "::pyc::sum(" + emit(l_Positional[0]) + ")";
+            default:
+                error(p_Node, "Cannot translate this call");
+                return "::pyc::Value()";
+            }
+        }
+
+        std::string emitMethodCall(const Ast::NodeIndex p_Node, bool& p_Void)
+        {
+            const Ast::Node& l_Node = getNode(p_Node);
+            const Ast::NodeIndex l_Object = getNode(l_Node.first).first;
+            const Builtins::Method l_Method = *Builtins::findMethod(getAst().getName(l_Node.first));
+            const Type l_Receiver = getType(l_Object);
+            const std::span<const Ast::NodeIndex> l_Nodes = getAst().getList(l_Node.second);
+            const std::string l_Name(c_MethodNames[l_Method]);
+            std::vector<std::string> l_Arguments;
+            std::vector<Ast::NodeIndex> l_ArgumentNodes;
+
+            if (Builtins::getMethod(l_Method).onList)
+            {
+                p_Void = l_Method != Builtins::POP;
+                if (l_Receiver.isList() && !(l_Method == Builtins::EXTEND && getType(l_Nodes[0]).isDynamic()))
+                {
+                    const Type l_Element = l_Receiver.getElement();
+                    for (size_t l_Index = 0; l_Index < l_Nodes.size(); ++l_Index)
+                    {
+                        // Positions are ints, the rest items, or a list to extend with
+                        const bool l_Position = l_Method == Builtins::POP || (l_Method == Builtins::INSERT && l_Index == 0);
+                        l_Arguments.push_back(emitAs(l_Nodes[l_Index], l_Position ? Type{ Type::INT } : l_Method == Builtins::EXTEND ? l_Receiver : l_Element));
+                        l_ArgumentNodes.push_back(l_Nodes[l_Index]);
+                    }
+                    return emitArguments(emit(l_Object) + "." + l_Name, l_Arguments, l_ArgumentNodes);
+                }
+                l_Arguments.push_back(emitAs(l_Object, Type::DYNAMIC));
+                l_ArgumentNodes.push_back(l_Object);
+                for (size_t l_Index = 0; l_Index < l_Nodes.size(); ++l_Index)
+                {
+                    const bool l_Position = l_Method == Builtins::POP || (l_Method == Builtins::INSERT && l_Index == 0);
+                    l_Arguments.push_back(emitAs(l_Nodes[l_Index], l_Position ? Type::INT : Type::DYNAMIC));
+                    l_ArgumentNodes.push_back(l_Nodes[l_Index]);
+                }
+                return emitArguments("::pyc::" + l_Name, l_Arguments, l_ArgumentNodes);
+            }
+
+            // str methods, on the receiver unboxed if need be
+            l_Arguments.push_back(emitAs(l_Object, Type::STRING));
+            l_ArgumentNodes.push_back(l_Object);
+            for (const Ast::NodeIndex l_Argument : l_Nodes)
+            {
+                const Type l_Type = getType(l_Argument);
+                l_Arguments.push_back(l_Method != Builtins::JOIN ? emitAs(l_Argument, Type::STRING) : l_Type.isDynamic() ? emit(l_Argument) : emitAs(l_Argument, Type::listOf(Type::STRING)));
+                l_ArgumentNodes.push_back(l_Argument);
+            }
+            return emitArguments("::pyc::" + l_Name, l_Arguments, l_ArgumentNodes);
+        }
+
+        const TypeInference& m_Inference;
+        const SymbolTable& m_Symbols;
+        std::string& m_Out;
+        std::vector<std::vector<Tokenizer::Error>>& m_Errors;
+        std::vector<std::string> m_Namespaces;
+        // C++ name of each called instance, by module and function
+        std::vector<std::vector<std::vector<std::string>>> m_InstanceNames;
+        // The list and index variables of the loops being written whose index stays within the list
+        std::vector<std::array<Reference, 2>> m_Indexed;
+
+        // Where the writer stands: the module, the function and its instance, nullptr in the module body, and the
+        // indentation
+        uint32_t m_Module = 0;
+        const TypeInference::Function* m_Function = nullptr;
+        const TypeInference::Instance* m_Instance = nullptr;
+        uint32_t m_Indent = 0;
+        // Temporaries are numbered per function
+        uint32_t m_Temporaries = 0;
+    };
+}
+
+void CppWriter::appendProgram(const TypeInference& p_Inference, std::string& p_Buffer, std::vector<std::vector<Tokenizer::Error>>& p_Errors)
+{
+    ProgramWriter{ p_Inference, p_Buffer, p_Errors }.write();
+}
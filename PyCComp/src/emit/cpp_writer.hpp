@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "../tokenizer/tokenizer.hpp"
+#include "../types/type_inference.hpp"
+
+// C++ translation of a whole program, written by --emit=cpp. It is one translation unit for the header only runtime
+// in PyCComp/runtime: a namespace per module holding its variables and functions with the types inference settled
+// on, and a main that runs the module bodies in import order
+class CppWriter
+{
+public:
+    // Appends the translation unit, for an inference without errors. p_Errors gets what could not be translated, per
+    // module, in which case the translation unit is incomplete
+    static void appendProgram(const TypeInference& p_Inference, std::string& p_Buffer, std::vector<std::vector<Tokenizer::Error>>& p_Errors);
+};
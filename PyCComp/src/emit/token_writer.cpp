@@ -0,0 +1,176 @@
+#include "token_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    struct TypeName
+    {
+        std::string_view name;
+        bool hasValue;
+    };
+
+    constexpr std::array<TypeName, Tokenizer::Token::END + 1> c_TypeNames{ {
+        { "keyword", true },
+        { "identifier", true },
+        { "string", true },
+        { "number", true },
+        { "boolean", true },
+        { "none", false },
+        { "operator", true },
+        { "delimiter", true },
+        { "indent", false },
+        { "dedent", false },
+        { "newline", false },
+        { "comment", true },
+        { "end", false }
+    } };
+
+    // Longest fixed part of a line: "l" + 10 digits + " | c" + 10 digits + " | " + "identifier" + "(" + ")\n"
+    constexpr size_t c_MaxLineOverhead = 1 + 10 + 4 + 10 + 3 + 10 + 1 + 2;
+
+    char* writePadded(char* p_Out, const uint32_t p_Value)
+    {
+        char l_Digits[10];
+        const size_t l_Length = static_cast<size_t>(std::to_chars(l_Digits, l_Digits + sizeof(l_Digits), p_Value).ptr - l_Digits);
+        for (size_t l_Pad = l_Length; l_Pad < 4; ++l_Pad)
+        {
+            *p_Out++ = ' ';
+        }
+        std::memcpy(p_Out, l_Digits, l_Length);
+        return p_Out + l_Length;
+    }
+
+    char* writeText(char* p_Out, const std::string_view p_Text)
+    {
+        std::memcpy(p_Out, p_Text.data(), p_Text.size());
+        return p_Out + p_Text.size();
+    }
+
+    void align(std::string& p_Buffer)
+    {
+        p_Buffer.resize((p_Buffer.size() + 7) & ~size_t{ 7 }, '\0');
+    }
+}
+
+void TokenWriter::appendText(const Tokenizer& p_Tokenizer, std::string& p_Buffer)
+{
+    // Sized for the worst case once, written through a pointer and trimmed at the end
+    size_t l_Bound = p_Tokenizer.getTokens().size() * c_MaxLineOverhead;
+    for (const Tokenizer::Token& l_Token : p_Tokenizer.getTokens())
+    {
+        if (c_TypeNames[l_Token.type].hasValue)
+        {
+            l_Bound += p_Tokenizer.getValue(l_Token).size();
+        }
+    }
+    const size_t l_Start = p_Buffer.size();
+    p_Buffer.resize(l_Start + l_Bound);
+    char* l_Out = p_Buffer.data() + l_Start;
+
+    uint32_t l_LineHint = 0;
+    for (const Tokenizer::Token& l_Token : p_Tokenizer.getTokens())
+    {
+        const Tokenizer::Location l_Location = p_Tokenizer.getLocation(l_Token, l_LineHint);
+        const TypeName& l_Type = c_TypeNames[l_Token.type];
+        *l_Out++ = 'l';
+        l_Out = writePadded(l_Out, l_Location.line);
+        l_Out = writeText(l_Out, " | c");
+        l_Out = writePadded(l_Out, l_Location.column);
+        l_Out = writeText(l_Out, " | ");
+        l_Out = writeText(l_Out, l_Type.name);
+        if (l_Type.hasValue)
+        {
+            *l_Out++ = '(';
+            l_Out = writeText(l_Out, p_Tokenizer.getValue(l_Token));
+            *l_Out++ = ')';
+        }
+        *l_Out++ = '\n';
+    }
+    p_Buffer.resize(static_cast<size_t>(l_Out - p_Buffer.data()));
+}
+
+std::string TokenWriter::writeBinary(const std::span<const Module> p_Modules)
+{
+    // The string table is built first, since the records hold offsets into it
+    std::string l_Strings;
+    std::unordered_map<std::string_view, uint32_t> l_StringOffsets;
+    const auto l_AddString = [&](const std::string_view p_Text)
+    {
+        const auto [l_Found, l_Added] = l_StringOffsets.try_emplace(p_Text, static_cast<uint32_t>(l_Strings.size()));
+        if (l_Added)
+        {
+            l_Strings += p_Text;
+        }
+        return l_Found->second;
+    };
+
+    // Interned tokens are deduplicated by symbol, which saves hashing their text
+    std::vector<uint32_t> l_SymbolOffsets;
+    const auto l_AddValue = [&](const Tokenizer::Token& p_Token, const std::string_view p_Value)
+    {
+        if (p_Token.symbol == SymbolTable::c_NoSymbol)
+        {
+            return l_AddString(p_Value);
+        }
+        if (p_Token.symbol >= l_SymbolOffsets.size())
+        {
+            l_SymbolOffsets.resize(std::max<size_t>(p_Token.symbol + 1, l_SymbolOffsets.size() * 2), UINT32_MAX);
+        }
+        if (l_SymbolOffsets[p_Token.symbol] == UINT32_MAX)
+        {
+            l_SymbolOffsets[p_Token.symbol] = l_AddString(p_Value);
+        }
+        return l_SymbolOffsets[p_Token.symbol];
+    };
+
+    size_t l_TokenCount = 0;
+    for (const Module& l_Module : p_Modules)
+    {
+        l_TokenCount += l_Module.tokenizer->getTokens().size();
+    }
+    std::vector<TokenFile::Module> l_Modules;
+    std::vector<TokenFile::Token> l_Tokens;
+    l_Tokens.reserve(l_TokenCount);
+    for (const Module& l_Module : p_Modules)
+    {
+        l_Modules.push_back({ .nameOffset = l_AddString(l_Module.name), .nameLength = static_cast<uint32_t>(l_Module.name.size()),
+            .firstToken = static_cast<uint32_t>(l_Tokens.size()), .tokenCount = static_cast<uint32_t>(l_Module.tokenizer->getTokens().size()) });
+        uint32_t l_LineHint = 0;
+        for (const Tokenizer::Token& l_Token : l_Module.tokenizer->getTokens())
+        {
+            const Tokenizer::Location l_Location = l_Module.tokenizer->getLocation(l_Token, l_LineHint);
+            TokenFile::Token l_Record{ .type = l_Token.type, .reserved = {}, .line = l_Location.line, .column = l_Location.column, .valueOffset = 0, .valueLength = 0 };
+            if (c_TypeNames[l_Token.type].hasValue)
+            {
+                const std::string_view l_Value = l_Module.tokenizer->getValue(l_Token);
+                l_Record.valueOffset = l_AddValue(l_Token, l_Value);
+                l_Record.valueLength = static_cast<uint32_t>(l_Value.size());
+            }
+            l_Tokens.push_back(l_Record);
+        }
+    }
+
+    TokenFile::Header l_Header{};
+    std::memcpy(l_Header.magic, TokenFile::c_Magic, sizeof(l_Header.magic));
+    l_Header.version = TokenFile::c_Version;
+    l_Header.moduleCount = static_cast<uint32_t>(l_Modules.size());
+    l_Header.tokenCount = static_cast<uint32_t>(l_Tokens.size());
+    l_Header.stringTableSize = static_cast<uint32_t>(l_Strings.size());
+
+    std::string l_File(sizeof(TokenFile::Header), '\0');
+    l_Header.modulesOffset = l_File.size();
+    l_File.append(reinterpret_cast<const char*>(l_Modules.data()), l_Modules.size() * sizeof(TokenFile::Module));
+    align(l_File);
+    l_Header.tokensOffset = l_File.size();
+    l_File.append(reinterpret_cast<const char*>(l_Tokens.data()), l_Tokens.size() * sizeof(TokenFile::Token));
+    align(l_File);
+    l_Header.stringsOffset = l_File.size();
+    l_File += l_Strings;
+    std::memcpy(l_File.data(), &l_Header, sizeof(l_Header));
+    return l_File;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../tokenizer/tokenizer.hpp"
+
+// Binary token stream written by --emit=tokens-binary. Little-endian, with every section 8-byte aligned and found
+// through the header, so a reader can map the file and index the records directly. Strings are slices of the
+// string table, which holds every distinct module name and token value once
+struct TokenFile
+{
+    static constexpr char c_Magic[8] = { 'P', 'Y', 'C', 'T', 'O', 'K', 'S', '\0' };
+    // Bumped on any change to the records below
+    static constexpr uint32_t c_Version = 1;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t moduleCount;
+        uint32_t tokenCount;
+        uint32_t stringTableSize;
+        uint64_t modulesOffset;
+        uint64_t tokensOffset;
+        uint64_t stringsOffset;
+    };
+
+    struct Module
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        // Index of the module's first token in the token records, which hold every module's tokens back to back
+        uint32_t firstToken;
+        uint32_t tokenCount;
+    };
+
+    struct Token
+    {
+        // Tokenizer::Token::Type
+        uint8_t type;
+        uint8_t reserved[3];
+        uint32_t line;
+        uint32_t column;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+};
+static_assert(sizeof(TokenFile::Header) == 48 && sizeof(TokenFile::Module) == 16 && sizeof(TokenFile::Token) == 20);
+
+class TokenWriter
+{
+public:
+    struct Module
+    {
+        std::string_view name;
+        const Tokenizer* tokenizer;
+    };
+
+    // Appends one line per token: l<line> | c<column> | type[(value)], with the line and column right-aligned to at
+    // least 4 characters
+    static void appendText(const Tokenizer& p_Tokenizer, std::string& p_Buffer);
+    // The whole file, ready for a single write
+    [[nodiscard]] static std::string writeBinary(std::span<const Module> p_Modules);
+};
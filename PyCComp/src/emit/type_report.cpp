@@ -0,0 +1,96 @@
+#include "type_report.hpp"
+
+#include <array>
+
+namespace
+{
+    // Why p_Variable ended up boxed, from the first two types that did not join. p_Passed is the type a parameter is
+    // called with
+    std::string getReason(const TypeInference::Variable& p_Variable, const Type p_Passed)
+    {
+        if (p_Variable.type.isList())
+        {
+            return "holds values of different types";
+        }
+        if (p_Passed.isDynamic())
+        {
+            return "called with a dynamic value";
+        }
+        // Either side is UNKNOWN where a dynamic value came in first
+        const std::array<Type, 2>& l_Conflict = p_Variable.conflict;
+        if (l_Conflict[0].isUnknown() && l_Conflict[1].isUnknown())
+        {
+            return "none of its values has a known type";
+        }
+        std::string l_Reason = p_Variable.role == TypeInference::Variable::RESULT ? "returns " : "assigned ";
+        if (l_Conflict[0].isUnknown() || l_Conflict[1].isUnknown())
+        {
+            return l_Reason + (l_Conflict[0].isUnknown() ? l_Conflict[1] : l_Conflict[0]).getName();
+        }
+        return l_Reason + l_Conflict[0].getName() + " and " + l_Conflict[1].getName();
+    }
+}
+
+void TypeReport::appendText(const TypeInference& p_Inference, std::string& p_Buffer)
+{
+    const SymbolTable& l_Symbols = p_Inference.getSymbols();
+    uint32_t l_Total = 0;
+    uint32_t l_Dynamic = 0;
+    // p_Scope is the instance's signature, or empty for the module body
+    const auto l_Report = [&](const TypeInference::Module& p_Module, const TypeInference::Variable& p_Variable, const std::string& p_Scope, const Type p_Passed)
+    {
+        ++l_Total;
+        if (p_Variable.type.getKind() != Type::DYNAMIC)
+        {
+            return;
+        }
+        ++l_Dynamic;
+        const Tokenizer::Location l_Location = p_Module.ast->getLocation(p_Variable.node);
+        p_Buffer += p_Module.file->fileName.string() + ":" + std::to_string(l_Location.line) + ":" + std::to_string(l_Location.column) + ": ";
+        const std::string l_Name(l_Symbols.getName(p_Variable.name));
+        const std::string l_Scope = p_Scope.empty() ? "the module" : p_Scope;
+        switch (p_Variable.role)
+        {
+        case TypeInference::Variable::PARAMETER:
+            p_Buffer += "parameter '" + l_Name + "' of " + l_Scope;
+            break;
+        case TypeInference::Variable::RESULT:
+            p_Buffer += "return value of " + l_Scope;
+            break;
+        default:
+            p_Buffer += "variable '" + l_Name + "' in " + l_Scope;
+            break;
+        }
+        p_Buffer += " is " + p_Variable.type.getName() + ": " + getReason(p_Variable, p_Passed) + "\n";
+    };
+
+    for (uint32_t l_Index = 0; l_Index < p_Inference.getModuleCount(); ++l_Index)
+    {
+        const TypeInference::Module& l_Module = p_Inference.getModule(l_Index);
+        // Globals and instances the C++ leaves out do not count
+        for (const TypeInference::Variable& l_Global : l_Module.globals)
+        {
+            if (l_Global.read)
+            {
+                l_Report(l_Module, l_Global, {}, {});
+            }
+        }
+        for (const TypeInference::Function& l_Function : l_Module.functions)
+        {
+            for (const TypeInference::Instance& l_Instance : l_Function.instances)
+            {
+                if (!l_Instance.used)
+                {
+                    continue;
+                }
+                const std::string l_Scope = p_Inference.getInstanceName(l_Function, l_Instance);
+                for (uint32_t l_Index = 0; l_Index < l_Instance.variables.size(); ++l_Index)
+                {
+                    l_Report(l_Module, l_Instance.variables[l_Index], l_Scope, l_Index < l_Function.parameterCount ? l_Instance.signature[l_Index].resolve() : Type{});
+                }
+                l_Report(l_Module, l_Instance.result, l_Scope, {});
+            }
+        }
+    }
+    p_Buffer += std::to_string(l_Dynamic) + " of " + std::to_string(l_Total) + " values are dynamic\n";
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+#include "../types/type_inference.hpp"
+
+// What --type-report prints: every variable, parameter and return value inference could not give a native type, in
+// the module bodies and each function instance, and why, so that the code that makes a program slow can be found and
+// changed
+class TypeReport
+{
+public:
+    // Appends one line per boxed value, <file>:<line>:<column>: <what> is <type>: <reason>, then a summary
+    static void appendText(const TypeInference& p_Inference, std::string& p_Buffer);
+};
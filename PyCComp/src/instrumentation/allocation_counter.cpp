@@ -0,0 +1,55 @@
+#include "instrumentation.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replacing the global allocation functions is the only way to see every allocation, including the ones made inside
+// the standard library. They cost one branch while instrumentation is off. The nothrow forms and the other delete
+// forms fall back to these. Kept out of instrumentation.cpp, whose own allocations GCC would otherwise flag as
+// mismatched once these are inlined into them
+void* operator new(const std::size_t p_Size)
+{
+    if (Instrumentation::isEnabled())
+    {
+        Instrumentation::count(Instrumentation::ALLOCATIONS);
+        Instrumentation::count(Instrumentation::ALLOCATED_BYTES, p_Size);
+    }
+    while (true)
+    {
+        if (void* l_Memory = std::malloc(p_Size == 0 ? 1 : p_Size))
+        {
+            return l_Memory;
+        }
+        const std::new_handler l_Handler = std::get_new_handler();
+        if (l_Handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        l_Handler();
+    }
+}
+
+void* operator new[](const std::size_t p_Size)
+{
+    return operator new(p_Size);
+}
+
+void operator delete(void* p_Memory) noexcept
+{
+    std::free(p_Memory);
+}
+
+void operator delete[](void* p_Memory) noexcept
+{
+    std::free(p_Memory);
+}
+
+void operator delete(void* p_Memory, std::size_t) noexcept
+{
+    std::free(p_Memory);
+}
+
+void operator delete[](void* p_Memory, std::size_t) noexcept
+{
+    std::free(p_Memory);
+}
@@ -0,0 +1,255 @@
+#include "instrumentation.hpp"
+
+#include "../tokenizer/tokenizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::array<std::string_view, Instrumentation::PHASE_COUNT> c_PhaseNames{
+        "file load", "import scan", "cache", "tokenize", "lex chunk", "parse", "infer", "dump", "emit"
+    };
+
+    constexpr std::array<std::string_view, Instrumentation::COUNTER_COUNT> c_CounterNames{
+        "modules", "bytes read", "tokens", "nodes", "errors", "cache hits", "cache misses", "allocations", "allocated bytes"
+    };
+
+    constexpr std::array<std::string_view, Tokenizer::Token::END + 1> c_TokenTypeNames{
+        "keyword", "identifier", "string", "number", "boolean", "none", "operator", "delimiter", "indent", "dedent", "newline", "comment", "end"
+    };
+
+    struct Span
+    {
+        Instrumentation::Phase phase;
+        std::string detail;
+        int64_t start;
+        int64_t duration;
+    };
+
+    // Logs outlive their threads so workers that already exited still show up in the report
+    struct ThreadLog
+    {
+        uint32_t thread;
+        std::vector<Span> spans;
+    };
+
+    std::chrono::steady_clock::time_point s_Start;
+    std::array<std::atomic<uint64_t>, Tokenizer::Token::END + 1> s_TokenTypes{};
+    std::mutex s_LogMutex;
+    std::vector<std::unique_ptr<ThreadLog>> s_Logs;
+    thread_local ThreadLog* s_Log = nullptr;
+
+    ThreadLog& getThreadLog()
+    {
+        if (s_Log == nullptr)
+        {
+            const std::scoped_lock l_Lock{ s_LogMutex };
+            s_Logs.push_back(std::make_unique<ThreadLog>(ThreadLog{ static_cast<uint32_t>(s_Logs.size()), {} }));
+            s_Log = s_Logs.back().get();
+        }
+        return *s_Log;
+    }
+
+    void appendJsonString(std::string& p_Out, const std::string_view p_Text)
+    {
+        constexpr char c_Hex[] = "0123456789abcdef";
+        p_Out += '"';
+        for (const char l_Char : p_Text)
+        {
+            if (l_Char == '"' || l_Char == '\\')
+            {
+                p_Out += '\\';
+                p_Out += l_Char;
+            }
+            else if (static_cast<unsigned char>(l_Char) < 0x20)
+            {
+                p_Out += "\\u00";
+                p_Out += c_Hex[static_cast<unsigned char>(l_Char) >> 4];
+                p_Out += c_Hex[static_cast<unsigned char>(l_Char) & 0xF];
+            }
+            else
+            {
+                p_Out += l_Char;
+            }
+        }
+        p_Out += '"';
+    }
+
+    // Trace timestamps are in microseconds
+    void appendMicroseconds(std::string& p_Out, const int64_t p_Nanoseconds)
+    {
+        p_Out += std::to_string(p_Nanoseconds / 1000);
+        p_Out += '.';
+        const std::string l_Fraction = std::to_string(p_Nanoseconds % 1000);
+        p_Out.append(3 - l_Fraction.size(), '0');
+        p_Out += l_Fraction;
+    }
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(const Phase p_Phase, const std::string_view p_Detail)
+    : m_Phase(p_Phase), m_Detail(p_Detail), m_Start(s_RecordSpans ? now() : 0)
+{
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(const Phase p_Phase, const std::filesystem::path& p_Detail)
+    : m_Phase(p_Phase), m_Path(&p_Detail), m_Start(s_RecordSpans ? now() : 0)
+{
+}
+
+Instrumentation::ScopedTimer::~ScopedTimer()
+{
+    if (!s_RecordSpans)
+    {
+        return;
+    }
+    const int64_t l_End = now();
+    getThreadLog().spans.push_back({ m_Phase, m_Path != nullptr ? m_Path->generic_string() : std::string(m_Detail), m_Start, l_End - m_Start });
+}
+
+void Instrumentation::enable(const bool p_RecordSpans)
+{
+    s_Start = std::chrono::steady_clock::now();
+    s_Enabled = true;
+    s_RecordSpans = p_RecordSpans;
+    if (s_RecordSpans)
+    {
+        // Claims thread 0 for the thread that enables instrumentation, so the main thread is always first in the trace
+        getThreadLog();
+    }
+}
+
+void Instrumentation::countTokens(const Tokenizer& p_Tokenizer)
+{
+    if (!s_Enabled)
+    {
+        return;
+    }
+    std::array<uint64_t, Tokenizer::Token::END + 1> l_Counts{};
+    for (const Tokenizer::Token::Type l_Type : p_Tokenizer.getTokens().getTypes())
+    {
+        ++l_Counts[l_Type];
+    }
+    for (size_t l_Type = 0; l_Type < l_Counts.size(); ++l_Type)
+    {
+        s_TokenTypes[l_Type].fetch_add(l_Counts[l_Type], std::memory_order_relaxed);
+    }
+    s_Counters[TOKENS].fetch_add(p_Tokenizer.getTokens().size(), std::memory_order_relaxed);
+}
+
+void Instrumentation::printStats(std::ostream& p_Stream)
+{
+    struct PhaseTotal
+    {
+        uint64_t spans = 0;
+        int64_t total = 0;
+        int64_t longest = 0;
+    };
+    std::array<PhaseTotal, PHASE_COUNT> l_Totals{};
+    size_t l_ThreadCount;
+    {
+        const std::scoped_lock l_Lock{ s_LogMutex };
+        l_ThreadCount = s_Logs.size();
+        for (const std::unique_ptr<ThreadLog>& l_Log : s_Logs)
+        {
+            for (const Span& l_Span : l_Log->spans)
+            {
+                PhaseTotal& l_Total = l_Totals[l_Span.phase];
+                ++l_Total.spans;
+                l_Total.total += l_Span.duration;
+                l_Total.longest = std::max(l_Total.longest, l_Span.duration);
+            }
+        }
+    }
+
+    const auto l_Milliseconds = [](const int64_t p_Nanoseconds) { return static_cast<double>(p_Nanoseconds) / 1e6; };
+    const std::ios::fmtflags l_Flags = p_Stream.flags();
+    const std::streamsize l_Precision = p_Stream.precision();
+    p_Stream << std::fixed << std::setprecision(3);
+    p_Stream << "Wall time: " << l_Milliseconds(now()) << " ms on " << l_ThreadCount << " thread(s)\n";
+    // Phases on several threads overlap, so their totals can add up to more than the wall time
+    p_Stream << std::left << std::setw(16) << "Phase" << std::right << std::setw(10) << "Spans" << std::setw(14) << "Total ms" << std::setw(14) << "Longest ms" << '\n';
+    for (size_t l_Phase = 0; l_Phase < PHASE_COUNT; ++l_Phase)
+    {
+        const PhaseTotal& l_Total = l_Totals[l_Phase];
+        p_Stream << std::left << std::setw(16) << c_PhaseNames[l_Phase] << std::right << std::setw(10) << l_Total.spans
+                 << std::setw(14) << l_Milliseconds(l_Total.total) << std::setw(14) << l_Milliseconds(l_Total.longest) << '\n';
+    }
+    p_Stream << '\n' << std::left << std::setw(16) << "Counter" << std::right << std::setw(16) << "Value" << '\n';
+    for (size_t l_Counter = 0; l_Counter < COUNTER_COUNT; ++l_Counter)
+    {
+        p_Stream << std::left << std::setw(16) << c_CounterNames[l_Counter] << std::right << std::setw(16) << s_Counters[l_Counter].load(std::memory_order_relaxed) << '\n';
+        if (l_Counter != TOKENS)
+        {
+            continue;
+        }
+        for (size_t l_Type = 0; l_Type < c_TokenTypeNames.size(); ++l_Type)
+        {
+            p_Stream << "  " << std::left << std::setw(14) << c_TokenTypeNames[l_Type] << std::right << std::setw(16) << s_TokenTypes[l_Type].load(std::memory_order_relaxed) << '\n';
+        }
+    }
+    p_Stream.flags(l_Flags);
+    p_Stream.precision(l_Precision);
+}
+
+bool Instrumentation::writeTrace(const std::filesystem::path& p_Path)
+{
+    const int64_t l_End = now();
+    std::string l_Json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    {
+        const std::scoped_lock l_Lock{ s_LogMutex };
+        for (const std::unique_ptr<ThreadLog>& l_Log : s_Logs)
+        {
+            const std::string l_Thread = std::to_string(l_Log->thread);
+            l_Json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + l_Thread + ",\"args\":{\"name\":";
+            appendJsonString(l_Json, l_Log->thread == 0 ? "main" : "worker " + l_Thread);
+            l_Json += "}},\n";
+            for (const Span& l_Span : l_Log->spans)
+            {
+                l_Json += "{\"name\":";
+                appendJsonString(l_Json, c_PhaseNames[l_Span.phase]);
+                l_Json += ",\"cat\":\"pyccomp\",\"ph\":\"X\",\"pid\":1,\"tid\":" + l_Thread + ",\"ts\":";
+                appendMicroseconds(l_Json, l_Span.start);
+                l_Json += ",\"dur\":";
+                appendMicroseconds(l_Json, l_Span.duration);
+                if (!l_Span.detail.empty())
+                {
+                    l_Json += ",\"args\":{\"module\":";
+                    appendJsonString(l_Json, l_Span.detail);
+                    l_Json += '}';
+                }
+                l_Json += "},\n";
+            }
+        }
+    }
+    // Counters as a single sample at the end of the run, so they show up as tracks next to the threads
+    l_Json += "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":";
+    appendMicroseconds(l_Json, l_End);
+    l_Json += ",\"args\":{";
+    for (size_t l_Counter = 0; l_Counter < COUNTER_COUNT; ++l_Counter)
+    {
+        if (l_Counter != 0)
+        {
+            l_Json += ',';
+        }
+        appendJsonString(l_Json, c_CounterNames[l_Counter]);
+        l_Json += ':' + std::to_string(s_Counters[l_Counter].load(std::memory_order_relaxed));
+    }
+    l_Json += "}}\n]}\n";
+
+    std::ofstream l_File(p_Path, std::ios::binary);
+    l_File.write(l_Json.data(), static_cast<std::streamsize>(l_Json.size()));
+    return static_cast<bool>(l_File);
+}
+
+int64_t Instrumentation::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Start).count();
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string_view>
+
+class Tokenizer;
+
+// Timed spans and counters behind --stats and --trace. Off unless enabled, in which case timers and counters cost a
+// single branch. Spans go to a log owned by the recording thread, so recording never takes a lock, and are only
+// gathered when reporting, after every worker is done
+class Instrumentation
+{
+public:
+    enum Phase: uint8_t
+    {
+        FILE_LOAD,
+        IMPORT_SCAN,
+        CACHE,
+        TOKENIZE,
+        // One chunk of a module lexed on several threads
+        LEX_CHUNK,
+        PARSE,
+        // Type inference over the whole program
+        INFER,
+        DUMP,
+        EMIT,
+        PHASE_COUNT
+    };
+
+    enum Counter: uint8_t
+    {
+        MODULES,
+        BYTES_READ,
+        TOKENS,
+        // Syntax tree nodes
+        NODES,
+        ERRORS,
+        CACHE_HITS,
+        CACHE_MISSES,
+        // Global operator new calls while enabled, from every thread
+        ALLOCATIONS,
+        ALLOCATED_BYTES,
+        COUNTER_COUNT
+    };
+
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Phase p_Phase, std::string_view p_Detail = {});
+        // The path is only converted to text if the span is recorded
+        ScopedTimer(Phase p_Phase, const std::filesystem::path& p_Detail);
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Phase m_Phase;
+        std::string_view m_Detail;
+        const std::filesystem::path* m_Path = nullptr;
+        int64_t m_Start;
+    };
+
+    // Before any other thread starts, and only once. Without spans only the counters are kept, which is what the
+    // benchmarks use so that recording does not show up in the allocation counts
+    static void enable(bool p_RecordSpans = true);
+    [[nodiscard]] static bool isEnabled() { return s_Enabled; }
+
+    static void count(const Counter p_Counter, const uint64_t p_Amount = 1)
+    {
+        if (s_Enabled)
+        {
+            s_Counters[p_Counter].fetch_add(p_Amount, std::memory_order_relaxed);
+        }
+    }
+    // TOKENS and the count of every token type
+    static void countTokens(const Tokenizer& p_Tokenizer);
+    [[nodiscard]] static uint64_t getCount(const Counter p_Counter) { return s_Counters[p_Counter].load(std::memory_order_relaxed); }
+
+    // Per phase totals and every counter, as a table
+    static void printStats(std::ostream& p_Stream);
+    // Chrome trace event JSON, which Perfetto and chrome://tracing open. False if the file could not be written
+    static bool writeTrace(const std::filesystem::path& p_Path);
+
+private:
+    [[nodiscard]] static int64_t now();
+
+    inline static bool s_Enabled = false;
+    inline static bool s_RecordSpans = false;
+    inline static std::atomic<uint64_t> s_Counters[COUNTER_COUNT]{};
+};
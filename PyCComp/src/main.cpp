@@ -1,75 +1,463 @@
+#include <charconv>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
 
+#include "build/build_database.hpp"
+#include "cache/token_cache.hpp"
+#include "driver/compilation_context.hpp"
+#include "driver/compiler_daemon.hpp"
+#include "driver/pipeline.hpp"
+#include "emit/token_writer.hpp"
+#include "instrumentation/instrumentation.hpp"
+#include "parser/ast.hpp"
+#include "types/type_inference.hpp"
+#include "scheduler/task_scheduler.hpp"
 #include "source_file/source_reader.hpp"
 #include "tokenizer/tokenizer.hpp"
 
+namespace
+{
+    enum class Emit: uint8_t
+    {
+        // Token dumps on stdout, what a run without --emit does
+        PRINT,
+        TOKENS,
+        TOKENS_BINARY,
+        // Syntax tree dumps
+        AST,
+        // The whole program as one C++ translation unit
+        CPP
+    };
+
+    // The module's path relative to the working directory under p_OutputDir, with ".." turned into "_" so that
+    // modules outside the working directory stay inside it
+    std::filesystem::path getOutputPath(const SourceReader& p_Reader, const SourceReader::ModuleFile& p_Module, const std::filesystem::path& p_OutputDir, const Emit p_Emit)
+    {
+        const std::filesystem::path l_Relative = std::filesystem::path(p_Reader.getModuleKey(p_Module.fileName)).lexically_relative(p_Reader.getWorkingDir());
+        std::filesystem::path l_Output = p_OutputDir;
+        for (const std::filesystem::path& l_Part : l_Relative)
+        {
+            l_Output /= l_Part == ".." ? "_" : l_Part;
+        }
+        l_Output += p_Emit == Emit::TOKENS_BINARY ? ".tokbin" : p_Emit == Emit::AST ? ".ast" : ".tokens";
+        return l_Output;
+    }
+
+    // Reports the instrumentation on every way out of main. Declared before the scheduler, so its workers are done
+    // by the time it runs
+    class InstrumentationReport
+    {
+    public:
+        InstrumentationReport(const bool p_Stats, std::filesystem::path p_TracePath) : m_Stats(p_Stats), m_TracePath(std::move(p_TracePath)) {}
+        ~InstrumentationReport()
+        {
+            if (m_Stats)
+            {
+                Instrumentation::printStats(std::cerr);
+            }
+            if (!m_TracePath.empty() && !Instrumentation::writeTrace(m_TracePath))
+            {
+                std::cerr << "Could not write the trace to " << m_TracePath.string() << "\n";
+            }
+        }
+        InstrumentationReport(const InstrumentationReport&) = delete;
+        InstrumentationReport& operator=(const InstrumentationReport&) = delete;
+
+    private:
+        bool m_Stats;
+        std::filesystem::path m_TracePath;
+    };
+}
+
 int main(const uint32_t argc, char *argv[]) {
-    // Arguments <output file> <input file> [working dir]
-    if (argc < 3) {
-        std::cerr << "Arguments: <output file> <input file> [working dir]\n";
+    // Arguments [-j <jobs>] [--no-cache] [--cache-dir <dir>] [--purge-cache] [--out-dir <dir>] [--emit=tokens|tokens-binary|ast|cpp]
+    //           [--type-report] [--daemon] [--socket <path>] [--stats] [--trace=<file>] <output file> <input file> [working dir]
+    //        or [--socket <path>] --client | --stop-daemon
+    uint32_t l_Jobs = 1;
+    bool l_UseCache = true;
+    bool l_PurgeCache = false;
+    bool l_Daemon = false;
+    bool l_Stats = false;
+    bool l_TypeReport = false;
+    Emit l_Emit = Emit::PRINT;
+    std::string_view l_ClientCommand;
+    std::filesystem::path l_CacheDir;
+    std::filesystem::path l_OutputDir;
+    std::filesystem::path l_SocketPath = ".pyccomp-daemon.sock";
+    std::filesystem::path l_TracePath;
+    std::vector<std::string> l_Arguments;
+    for (uint32_t l_Arg = 1; l_Arg < argc; ++l_Arg)
+    {
+        const std::string_view l_Value = argv[l_Arg];
+        if (l_Value == "--no-cache")
+        {
+            l_UseCache = false;
+            continue;
+        }
+        if (l_Value.starts_with("--emit="))
+        {
+            const std::string_view l_Format = l_Value.substr(7);
+            if (l_Format != "tokens" && l_Format != "tokens-binary" && l_Format != "ast" && l_Format != "cpp")
+            {
+                std::cerr << "Unknown --emit format: " << l_Format << "\n";
+                return 1;
+            }
+            l_Emit = l_Format == "tokens" ? Emit::TOKENS : l_Format == "ast" ? Emit::AST : l_Format == "cpp" ? Emit::CPP : Emit::TOKENS_BINARY;
+            continue;
+        }
+        if (l_Value == "--type-report")
+        {
+            l_TypeReport = true;
+            continue;
+        }
+        if (l_Value == "--stats")
+        {
+            l_Stats = true;
+            continue;
+        }
+        if (l_Value.starts_with("--trace="))
+        {
+            l_TracePath = l_Value.substr(8);
+            if (l_TracePath.empty())
+            {
+                std::cerr << "Missing path after --trace=\n";
+                return 1;
+            }
+            continue;
+        }
+        if (l_Value == "--daemon")
+        {
+            l_Daemon = true;
+            continue;
+        }
+        if (l_Value == "--client" || l_Value == "--stop-daemon")
+        {
+            l_ClientCommand = l_Value == "--client" ? "compile" : "stop";
+            continue;
+        }
+        if (l_Value == "--purge-cache")
+        {
+            l_PurgeCache = true;
+            continue;
+        }
+        if (l_Value == "--cache-dir" || l_Value == "--out-dir" || l_Value == "--socket")
+        {
+            if (l_Arg + 1 >= argc)
+            {
+                std::cerr << "Missing path after " << l_Value << "\n";
+                return 1;
+            }
+            (l_Value == "--cache-dir" ? l_CacheDir : l_Value == "--out-dir" ? l_OutputDir : l_SocketPath) = argv[++l_Arg];
+            continue;
+        }
+        if (!l_Value.starts_with("-j"))
+        {
+            l_Arguments.emplace_back(l_Value);
+            continue;
+        }
+        // Both "-j 8" and "-j8". 0 uses every hardware thread
+        std::string_view l_Count = l_Value.substr(2);
+        if (l_Count.empty() && l_Arg + 1 < argc)
+        {
+            l_Count = argv[++l_Arg];
+        }
+        const std::from_chars_result l_Parse = std::from_chars(l_Count.data(), l_Count.data() + l_Count.size(), l_Jobs);
+        if (l_Count.empty() || l_Parse.ec != std::errc{} || l_Parse.ptr != l_Count.data() + l_Count.size())
+        {
+            std::cerr << "Invalid job count: " << l_Count << "\n";
+            return 1;
+        }
+        if (l_Jobs == 0)
+        {
+            l_Jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+    // Without --cache-dir the cache goes in the user's cache directory, and is off if there is none
+    if (l_CacheDir.empty())
+    {
+        l_CacheDir = TokenCache::getDefaultDirectory();
+        l_UseCache = l_UseCache && !l_CacheDir.empty();
+    }
+    // Purging alone is a complete run
+    if (l_PurgeCache)
+    {
+        const uint32_t l_Removed = TokenCache{ l_CacheDir }.purge();
+        std::cout << "Removed " << l_Removed << " cache entries from " << l_CacheDir.string() << "\n";
+        if (l_Arguments.empty())
+        {
+            return 0;
+        }
+    }
+    // The client only forwards the request, everything else is the daemon's business
+    if (!l_ClientCommand.empty())
+    {
+        return CompilerDaemon::runClient(l_SocketPath, l_ClientCommand);
+    }
+    if (l_Arguments.size() < 2) {
+        std::cerr << "Arguments: [-j <jobs>] [--no-cache] [--cache-dir <dir>] [--purge-cache] [--out-dir <dir>] [--emit=tokens|tokens-binary|ast|cpp] [--type-report] [--daemon] [--socket <path>] [--stats] [--trace=<file>] <output file> <input file> [working dir]\n";
+        std::cerr << "       or: [--socket <path>] --client | --stop-daemon\n";
+        return 1;
+    }
+    // The daemon only keeps the printed token dump up to date, it has no other outputs
+    if (l_Daemon && (l_Emit != Emit::PRINT || !l_OutputDir.empty()))
+    {
+        std::cerr << "--daemon prints the token dump and cannot be used with --emit or --out-dir\n";
+        return 1;
+    }
+    // The C++ is one translation unit for the whole program, it has no per module outputs
+    if (l_Emit == Emit::CPP && !l_OutputDir.empty())
+    {
+        std::cerr << "--emit=cpp writes a single file and cannot be used with --out-dir\n";
         return 1;
     }
-    const std::string l_OutputFile = argv[1];
-    const std::string l_InputFile = argv[2];
-    const std::string l_WorkingDir = argc > 3 ? argv[3] : "";
+    if (l_TypeReport && l_Emit != Emit::CPP)
+    {
+        std::cerr << "--type-report requires --emit=cpp\n";
+        return 1;
+    }
+    const std::string l_OutputFile = l_Arguments[0];
+    const std::string l_InputFile = l_Arguments[1];
+    const std::string l_WorkingDir = l_Arguments.size() > 2 ? l_Arguments[2] : "";
+
+    // Before any worker starts
+    if (l_Stats || !l_TracePath.empty())
+    {
+        Instrumentation::enable();
+    }
+    const InstrumentationReport l_Report{ l_Stats, l_TracePath };
+
+    std::optional<TaskScheduler> l_Scheduler;
+    if (l_Jobs > 1)
+    {
+        l_Scheduler.emplace(l_Jobs);
+    }
 
-    const SourceReader l_Reader{ l_InputFile, l_WorkingDir };
+    std::optional<TokenCache> l_Cache;
+    if (l_UseCache)
+    {
+        l_Cache.emplace(l_CacheDir);
+    }
+
+    if (l_Daemon)
+    {
+        CompilerDaemon l_Server{ l_InputFile, l_WorkingDir, l_Scheduler ? &*l_Scheduler : nullptr, l_Cache ? &*l_Cache : nullptr };
+        return l_Server.run(l_SocketPath);
+    }
+
+    // Declared before everything that allocates from it
+    CompilationContext l_Context;
+    const SourceReader l_Reader{ l_InputFile, l_WorkingDir, l_Scheduler ? &*l_Scheduler : nullptr, l_Cache ? &*l_Cache : nullptr, l_Context.getResource() };
+    // Shared by every module
+    SymbolTable l_Symbols;
+
+    // With an output directory every module's output goes to its own file, and only the modules whose file is out
+    // of date are processed. Without one, everything is printed
+    std::vector<std::filesystem::path> l_Outputs;
+    std::optional<BuildDatabase> l_Database;
+    std::vector<bool> l_Stale(l_Reader.getModuleCount(), true);
+    if (!l_OutputDir.empty())
+    {
+        for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+        {
+            l_Outputs.push_back(getOutputPath(l_Reader, *l_Reader.getModule(l_Index), l_OutputDir, l_Emit));
+        }
+        l_Database.emplace(l_OutputDir / ".pyccomp-build");
+        l_Stale = l_Database->findStaleModules(l_Reader, l_Outputs);
+    }
+
+    // Modules are tokenized and dumped independently, then printed in module order so the output does not depend
+    // on the job count
+    std::vector<std::optional<Tokenizer>> l_Tokenizers(l_Reader.getModuleCount());
+    // Only parsed when the trees or the C++ are emitted
+    std::vector<std::optional<Ast>> l_Trees(l_Reader.getModuleCount());
+    std::vector<std::string> l_Dumps(l_Reader.getModuleCount());
+    // Per module rather than a vector<bool>, which tasks could not write to concurrently
+    std::vector<uint8_t> l_Written(l_Reader.getModuleCount(), false);
+    const auto l_Tokenize = [&](const uint32_t p_Index)
+    {
+        l_Tokenizers[p_Index] = tokenizeModule(*l_Reader.getModule(p_Index), l_Scheduler ? &*l_Scheduler : nullptr, l_Cache ? &*l_Cache : nullptr, l_Symbols, l_Context.getResource());
+        if (l_Emit == Emit::AST || l_Emit == Emit::CPP)
+        {
+            l_Trees[p_Index] = parseModule(*l_Tokenizers[p_Index], l_Context.getResource());
+            if (l_Emit == Emit::AST)
+            {
+                l_Dumps[p_Index] = dumpAst(*l_Trees[p_Index]);
+            }
+        }
+        // Binary outputs are written per file, so only an output directory needs one per module
+        else if (l_Emit != Emit::TOKENS_BINARY)
+        {
+            l_Dumps[p_Index] = dumpTokens(*l_Tokenizers[p_Index]);
+        }
+        else if (l_Database)
+        {
+            const std::string l_Name = l_Reader.getModule(p_Index)->fileName.string();
+            const TokenWriter::Module l_Module{ .name = l_Name, .tokenizer = &*l_Tokenizers[p_Index] };
+            const Instrumentation::ScopedTimer l_Timer{ Instrumentation::DUMP };
+            l_Dumps[p_Index] = TokenWriter::writeBinary({ &l_Module, 1 });
+        }
+        if (l_Database)
+        {
+            const Instrumentation::ScopedTimer l_Timer{ Instrumentation::EMIT, l_Outputs[p_Index] };
+            std::error_code l_Error;
+            std::filesystem::create_directories(l_Outputs[p_Index].parent_path(), l_Error);
+            std::ofstream l_Stream(l_Outputs[p_Index], std::ios::binary | std::ios::trunc);
+            l_Written[p_Index] = static_cast<bool>(l_Stream.write(l_Dumps[p_Index].data(), static_cast<std::streamsize>(l_Dumps[p_Index].size())));
+        }
+    };
+    for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+    {
+        if (!l_Stale[l_Index])
+        {
+            continue;
+        }
+        if (l_Scheduler)
+        {
+            l_Scheduler->submit([&l_Tokenize, l_Index] { l_Tokenize(l_Index); });
+        }
+        else
+        {
+            l_Tokenize(l_Index);
+        }
+    }
+    if (l_Scheduler)
+    {
+        l_Scheduler->wait();
+    }
+    const auto l_PrintErrors = [&](const uint32_t p_Index)
+    {
+        l_Tokenizers[p_Index]->printErrors();
+        if (l_Trees[p_Index])
+        {
+            l_Trees[p_Index]->printErrors();
+        }
+    };
+
+    if (l_Database)
+    {
+        // Modules with errors are left out of the database so that the next build reports them again
+        std::vector<bool> l_UpToDate(l_Reader.getModuleCount());
+        uint32_t l_Rebuilt = 0;
+        for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+        {
+            if (!l_Stale[l_Index])
+            {
+                l_UpToDate[l_Index] = true;
+                continue;
+            }
+            l_PrintErrors(l_Index);
+            if (!l_Written[l_Index])
+            {
+                std::cerr << "Could not write " << l_Outputs[l_Index].string() << "\n";
+            }
+            l_UpToDate[l_Index] = l_Written[l_Index] && l_Tokenizers[l_Index]->getErrors().empty() && (!l_Trees[l_Index] || l_Trees[l_Index]->getErrors().empty());
+            l_Rebuilt++;
+        }
+        l_Database->update(l_Reader, l_Outputs, l_UpToDate);
+        if (!l_Database->save())
+        {
+            std::cerr << "Could not save the build database in " << l_OutputDir.string() << "\n";
+        }
+        std::cout << "Rebuilt " << l_Rebuilt << " of " << l_Reader.getModuleCount() << " modules\n";
+        return 0;
+    }
+
+    // Emitted outputs are assembled in one buffer and written to the output file at once
+    if (l_Emit != Emit::PRINT)
+    {
+        std::string l_File;
+        if (l_Emit == Emit::CPP)
+        {
+            // Inference needs every module, so nothing is written unless all of them parse
+            bool l_Failed = false;
+            std::vector<const Ast*> l_Asts;
+            for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+            {
+                l_PrintErrors(l_Index);
+                l_Failed |= !l_Tokenizers[l_Index]->getErrors().empty() || !l_Trees[l_Index]->getErrors().empty();
+                l_Asts.push_back(&*l_Trees[l_Index]);
+            }
+            if (l_Failed)
+            {
+                return 1;
+            }
+            const TypeInference l_Inference = inferTypes(l_Reader, l_Asts, l_Symbols, l_Context.getResource());
+            if (l_Inference.hasErrors())
+            {
+                for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+                {
+                    if (!l_Inference.getModule(l_Index).errors.empty())
+                    {
+                        std::cerr << "In " << l_Reader.getModule(l_Index)->fileName.string() << ":\n";
+                        l_Inference.printErrors(l_Index);
+                    }
+                }
+                return 1;
+            }
+            if (l_TypeReport)
+            {
+                std::cout << dumpTypeReport(l_Inference);
+            }
+            std::vector<std::vector<Tokenizer::Error>> l_Errors;
+            l_File = dumpCpp(l_Inference, l_Errors);
+            for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+            {
+                if (!l_Errors[l_Index].empty())
+                {
+                    std::cerr << "In " << l_Reader.getModule(l_Index)->fileName.string() << ":\n";
+                    l_Failed = true;
+                }
+                for (const Tokenizer::Error& l_Error : l_Errors[l_Index])
+                {
+                    std::cerr << "Error at line " << l_Error.line << ", column " << l_Error.column << ": " << l_Error.message << '\n';
+                }
+            }
+            if (l_Failed)
+            {
+                return 1;
+            }
+        }
+        std::vector<std::string> l_Names;
+        std::vector<TokenWriter::Module> l_Modules;
+        for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount() && l_Emit != Emit::CPP; ++l_Index)
+        {
+            l_PrintErrors(l_Index);
+            l_Names.push_back(l_Reader.getModule(l_Index)->fileName.string());
+            if (l_Emit != Emit::TOKENS_BINARY)
+            {
+                l_File += "Module: " + l_Names.back() + "\n***********************************************\n\n";
+                l_File += l_Dumps[l_Index];
+            }
+        }
+        if (l_Emit == Emit::TOKENS_BINARY)
+        {
+            const Instrumentation::ScopedTimer l_Timer{ Instrumentation::DUMP };
+            for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index)
+            {
+                l_Modules.push_back({ .name = l_Names[l_Index], .tokenizer = &*l_Tokenizers[l_Index] });
+            }
+            l_File = TokenWriter::writeBinary(l_Modules);
+        }
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::EMIT, std::string_view{ l_OutputFile } };
+        std::ofstream l_Stream(l_OutputFile, std::ios::binary | std::ios::trunc);
+        if (!l_Stream.write(l_File.data(), static_cast<std::streamsize>(l_File.size())))
+        {
+            std::cerr << "Could not write " << l_OutputFile << "\n";
+            return 1;
+        }
+        return 0;
+    }
 
-    std::vector<Tokenizer> l_Tokenizers;
-    l_Tokenizers.reserve(l_Reader.getModuleCount());
+    const Instrumentation::ScopedTimer l_Timer{ Instrumentation::EMIT };
     for (uint32_t l_Index = 0; l_Index < l_Reader.getModuleCount(); ++l_Index) 
     {
-        l_Tokenizers.emplace_back(l_Reader.getModule(l_Index)->fileContent);
+        l_PrintErrors(l_Index);
         std::cout << "Module: " << l_Reader.getModule(l_Index)->fileName.string() << "\n";
         std::cout << "***********************************************\n\n";
-        std::stringstream l_Stream;
-        for (const Tokenizer::Token& l_Token : l_Tokenizers.back().getTokens())
-        {
-            // Format per line: l<4 spaces line number> | c<4 spaces column number> | type[(value) if there is value)
-            switch (l_Token.type)
-            {
-            case Tokenizer::Token::Type::KEYWORD:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | keyword(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::IDENTIFIER:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | identifier(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::STRING:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | string(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::NUMBER:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | number(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::BOOLEAN:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | boolean(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::NONE:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | none\n";
-                break;
-            case Tokenizer::Token::Type::OPERATOR:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | operator(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::DELIMITER:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | delimiter(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::INDENT:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | indent\n";
-                break;
-            case Tokenizer::Token::Type::DEDENT:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | dedent\n";
-                break;
-            case Tokenizer::Token::Type::NEWLINE:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | newline\n";
-                break;
-            case Tokenizer::Token::Type::COMMENT:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | comment(" << l_Token.value << ")\n";
-                break;
-            case Tokenizer::Token::Type::END:
-                l_Stream << "l" << std::setw(4) << l_Token.line << " | c" << std::setw(4) << l_Token.column << " | end\n";
-                break;
-            }
-        }
-        std::cout << l_Stream.str();
+        std::cout << l_Dumps[l_Index];
     }
 
     return 0;
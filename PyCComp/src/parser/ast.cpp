@@ -0,0 +1,47 @@
+#include "ast.hpp"
+
+#include <array>
+
+namespace
+{
+    constexpr std::array<std::string_view, Ast::KIND_COUNT> c_KindNames{
+        "module", "function", "parameter", "class", "return", "if", "while", "for", "assign", "expression", "pass",
+        "break", "continue", "name", "integer", "float", "imaginary", "string", "boolean", "none", "unary", "binary",
+        "conditional", "call", "keyword_argument", "attribute", "subscript", "list", "tuple", "dict", "annotated"
+    };
+
+    constexpr std::array<std::string_view, Ast::OPERATOR_COUNT> c_OperatorNames{
+        "", "+", "-", "*", "/", "//", "%", "**", "&", "|", "^", "<<", ">>", "==", "!=", "<", "<=", ">", ">=", "in",
+        "not in", "and", "or", "-", "+", "~", "not"
+    };
+}
+
+Ast::Ast(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory)
+    : m_Tokenizer(&p_Tokenizer), m_Nodes(p_Memory), m_Lists(p_Memory), m_Errors(p_Memory)
+{
+}
+
+std::string_view Ast::getString(const NodeIndex p_Node) const
+{
+    // The tokenizer reports every string between one pair of double quotes, triple quoted ones included
+    const std::string_view l_Text = getName(p_Node);
+    return l_Text.substr(1, l_Text.size() - 2);
+}
+
+void Ast::printErrors(std::ostream& p_Stream) const
+{
+    for (const Tokenizer::Error& l_Error : m_Errors)
+    {
+        p_Stream << "Error at line " << l_Error.line << ", column " << l_Error.column << ": " << l_Error.message << '\n';
+    }
+}
+
+std::string_view Ast::getKindName(const Kind p_Kind)
+{
+    return c_KindNames[p_Kind];
+}
+
+std::string_view Ast::getOperatorName(const Operator p_Operator)
+{
+    return c_OperatorNames[p_Operator];
+}
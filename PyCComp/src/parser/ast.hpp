@@ -0,0 +1,225 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../tokenizer/tokenizer.hpp"
+
+// Syntax tree of one module, stored flat. Nodes are 16-byte records in a single array and refer to each other by
+// index, and every list of children (bodies, parameters, arguments, elements) is a run in a second array of indices.
+// A tree is a handful of allocations however many nodes it has, and is released with the memory it came from.
+// Names, strings and locations are read from the tokenizer the tree was parsed from, which has to outlive it
+class Ast
+{
+public:
+    using NodeIndex = uint32_t;
+    static constexpr NodeIndex c_NoNode = UINT32_MAX;
+
+    // What first and second hold for each kind. "list" is an index into the list array where a run's start and
+    // length are stored, read with getList. Fields not mentioned are unused
+    enum Kind: uint8_t
+    {
+        // first: list of statements
+        MODULE,
+        // token: name. first: index of a FunctionData in the list array
+        FUNCTION,
+        // token: name. first: annotation or c_NoNode, second: default value or c_NoNode
+        PARAMETER,
+        // token: name. first: list of bases, second: list of statements
+        CLASS,
+        // first: value or c_NoNode
+        RETURN,
+        // first: condition, second: index of an IfData in the list array. An elif is an else branch holding a
+        // single IF flagged ELIF
+        IF,
+        // first: condition, second: list of statements
+        WHILE,
+        // first: target, second: index of a ForData in the list array
+        FOR,
+        // op: NO_OPERATOR, or the operator of an augmented assignment. first: target, second: value, or c_NoNode
+        // for a declaration like "x: int"
+        ASSIGN,
+        // first: expression
+        EXPRESSION,
+        PASS,
+        BREAK,
+        CONTINUE,
+
+        // token: name
+        NAME,
+        // first and second: low and high halves of the value
+        INTEGER,
+        // first and second: low and high halves of the value's bits
+        FLOAT,
+        // Value read from the token
+        IMAGINARY,
+        // Value read from the token, see getString
+        STRING,
+        // first: 0 or 1
+        BOOLEAN,
+        NONE,
+        // op: one of the unary operators. first: operand
+        UNARY,
+        // op: one of the binary operators. first: left, second: right
+        BINARY,
+        // first: condition, second: index of the value if true followed by the value if false, in the list array
+        CONDITIONAL,
+        // first: callee, second: list of arguments
+        CALL,
+        // token: name. first: value
+        KEYWORD_ARGUMENT,
+        // token: attribute name. first: object
+        ATTRIBUTE,
+        // first: object, second: index
+        SUBSCRIPT,
+        // first: list of elements
+        LIST,
+        TUPLE,
+        // first: list of keys and values, alternating
+        DICT,
+        // A target with a type, as in "x: int = 0". first: target, second: annotation
+        ANNOTATED,
+        KIND_COUNT
+    };
+
+    enum Operator: uint8_t
+    {
+        NO_OPERATOR,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        FLOOR_DIVIDE,
+        MODULO,
+        POWER,
+        BIT_AND,
+        BIT_OR,
+        BIT_XOR,
+        SHIFT_LEFT,
+        SHIFT_RIGHT,
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        IN,
+        NOT_IN,
+        AND,
+        OR,
+        NEGATE,
+        POSITIVE,
+        INVERT,
+        NOT,
+        OPERATOR_COUNT
+    };
+
+    enum Flag: uint16_t
+    {
+        // FUNCTION decorated with @staticmethod
+        STATIC_METHOD = 1 << 0,
+        // IF written as an elif
+        ELIF = 1 << 1,
+        // TUPLE written with parentheses
+        PARENTHESIZED = 1 << 2
+    };
+
+    struct Node
+    {
+        Kind kind;
+        Operator op = NO_OPERATOR;
+        uint16_t flags = 0;
+        // Token the node was parsed from, for its name or value and its location
+        uint32_t token;
+        NodeIndex first = c_NoNode;
+        NodeIndex second = c_NoNode;
+    };
+    static_assert(sizeof(Node) == 16);
+
+    // Fields of a FUNCTION that do not fit in the node, in the list array in this order
+    struct FunctionData
+    {
+        // List of PARAMETER nodes
+        uint32_t parameters;
+        // Annotation after ->, or c_NoNode
+        NodeIndex returns;
+        // List of statements
+        uint32_t body;
+    };
+
+    struct IfData
+    {
+        // Lists of statements, the else branch empty if there is none
+        uint32_t body;
+        uint32_t orElse;
+    };
+
+    struct ForData
+    {
+        NodeIndex iterable;
+        // List of statements
+        uint32_t body;
+    };
+
+    explicit Ast(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+    [[nodiscard]] NodeIndex getRoot() const { return m_Root; }
+    [[nodiscard]] const Node& getNode(const NodeIndex p_Node) const { return m_Nodes[p_Node]; }
+    [[nodiscard]] size_t getNodeCount() const { return m_Nodes.size(); }
+    [[nodiscard]] std::span<const NodeIndex> getList(const uint32_t p_List) const { return { m_Lists.data() + m_Lists[p_List], m_Lists[p_List + 1] }; }
+    [[nodiscard]] FunctionData getFunction(const NodeIndex p_Node) const { return read<FunctionData>(m_Nodes[p_Node].first); }
+    [[nodiscard]] IfData getIf(const NodeIndex p_Node) const { return read<IfData>(m_Nodes[p_Node].second); }
+    [[nodiscard]] ForData getFor(const NodeIndex p_Node) const { return read<ForData>(m_Nodes[p_Node].second); }
+    // The two values of a CONDITIONAL, true first
+    [[nodiscard]] std::span<const NodeIndex, 2> getBranches(const NodeIndex p_Node) const { return std::span<const NodeIndex, 2>{ m_Lists.data() + m_Nodes[p_Node].second, 2 }; }
+
+    [[nodiscard]] const Tokenizer& getTokenizer() const { return *m_Tokenizer; }
+    [[nodiscard]] Tokenizer::Token getToken(const NodeIndex p_Node) const { return m_Tokenizer->getTokens()[m_Nodes[p_Node].token]; }
+    [[nodiscard]] std::string_view getName(const NodeIndex p_Node) const { return m_Tokenizer->getValue(getToken(p_Node)); }
+    // Interned name, or c_NoSymbol if the tokenizer had no symbol table
+    [[nodiscard]] SymbolTable::Symbol getSymbol(const NodeIndex p_Node) const { return m_Tokenizer->getTokens().getSymbols()[m_Nodes[p_Node].token]; }
+    [[nodiscard]] int64_t getInteger(const NodeIndex p_Node) const { return static_cast<int64_t>(getBits(p_Node)); }
+    [[nodiscard]] double getFloat(const NodeIndex p_Node) const
+    {
+        const uint64_t l_Bits = getBits(p_Node);
+        double l_Value;
+        std::memcpy(&l_Value, &l_Bits, sizeof(l_Value));
+        return l_Value;
+    }
+    // Text of a STRING without its quotes
+    [[nodiscard]] std::string_view getString(NodeIndex p_Node) const;
+    [[nodiscard]] Tokenizer::Location getLocation(const NodeIndex p_Node) const { return m_Tokenizer->getLocation(getToken(p_Node)); }
+
+    [[nodiscard]] const std::pmr::vector<Tokenizer::Error>& getErrors() const { return m_Errors; }
+    void printErrors(std::ostream& p_Stream = std::cerr) const;
+
+    [[nodiscard]] static std::string_view getKindName(Kind p_Kind);
+    [[nodiscard]] static std::string_view getOperatorName(Operator p_Operator);
+    [[nodiscard]] static bool isComparison(const Operator p_Operator) { return p_Operator >= EQUAL && p_Operator <= NOT_IN; }
+
+private:
+    [[nodiscard]] uint64_t getBits(const NodeIndex p_Node) const
+    {
+        return static_cast<uint64_t>(m_Nodes[p_Node].first) | static_cast<uint64_t>(m_Nodes[p_Node].second) << 32;
+    }
+    template<typename Data>
+    [[nodiscard]] Data read(const uint32_t p_At) const
+    {
+        Data l_Data;
+        std::memcpy(&l_Data, m_Lists.data() + p_At, sizeof(Data));
+        return l_Data;
+    }
+
+    const Tokenizer* m_Tokenizer;
+    std::pmr::vector<Node> m_Nodes;
+    // Runs of children, and the start and length of every run, in whatever order the parser finished them
+    std::pmr::vector<uint32_t> m_Lists;
+    std::pmr::vector<Tokenizer::Error> m_Errors;
+    NodeIndex m_Root = c_NoNode;
+
+    friend class Parser;
+};
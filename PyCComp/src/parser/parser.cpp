@@ -0,0 +1,1016 @@
+#include "parser.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // Nodes and list entries per token seen at most on the benchmark corpus, with some headroom, so that reserving by
+    // them rarely has either array grow. Literal heavy code is the densest at about 0.6 nodes per token
+    constexpr double c_NodesPerToken = 0.65;
+    constexpr double c_ListEntriesPerToken = 0.65;
+    // Longest token text quoted in an error message
+    constexpr size_t c_MaxQuotedLength = 40;
+
+    // Counts one level of nesting for as long as it lives
+    class DepthGuard
+    {
+    public:
+        explicit DepthGuard(uint32_t& p_Depth) : m_Depth(p_Depth) { ++m_Depth; }
+        ~DepthGuard() { --m_Depth; }
+        DepthGuard(const DepthGuard&) = delete;
+        DepthGuard& operator=(const DepthGuard&) = delete;
+
+    private:
+        uint32_t& m_Depth;
+    };
+}
+
+Ast Parser::parse(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory)
+{
+    Ast l_Ast{ p_Tokenizer, p_Memory };
+    Parser l_Parser{ p_Tokenizer, l_Ast, p_Memory };
+    l_Parser.skipTrivia();
+    const size_t l_Mark = l_Parser.m_Scratch.size();
+    l_Parser.parseStatements(true);
+    l_Ast.m_Root = l_Parser.addNode(Ast::MODULE, 0, l_Parser.finishList(l_Mark));
+    return l_Ast;
+}
+
+Parser::Parser(const Tokenizer& p_Tokenizer, Ast& p_Ast, std::pmr::memory_resource* p_Memory)
+    : m_Tokenizer(p_Tokenizer), m_Tokens(p_Tokenizer.getTokens()), m_Types(m_Tokens.getTypes()), m_Ast(p_Ast), m_Scratch(p_Memory)
+{
+    m_Ast.m_Nodes.reserve(static_cast<size_t>(static_cast<double>(m_Tokens.size()) * c_NodesPerToken) + 1);
+    m_Ast.m_Lists.reserve(static_cast<size_t>(static_cast<double>(m_Tokens.size()) * c_ListEntriesPerToken) + 1);
+    m_Scratch.reserve(256);
+}
+
+void Parser::parseStatements(const bool p_TopLevel)
+{
+    // A block ends at its DEDENT, the module and every block still open at the END
+    while (getType() != Tokenizer::Token::END && (p_TopLevel || getType() != Tokenizer::Token::DEDENT))
+    {
+        if (getType() == Tokenizer::Token::DEDENT)
+        {
+            advance();
+            continue;
+        }
+        const uint32_t l_Start = m_Position;
+        const size_t l_Mark = m_Scratch.size();
+        parseStatement();
+        if (m_Recovering)
+        {
+            // Whatever the broken statement left behind is dropped
+            m_Scratch.resize(l_Mark);
+            synchronize();
+        }
+        if (m_Position == l_Start)
+        {
+            advance();
+        }
+    }
+}
+
+void Parser::parseStatement()
+{
+    NodeIndex l_Statement = Ast::c_NoNode;
+    if (getType() == Tokenizer::Token::INDENT)
+    {
+        error("Unexpected indent");
+        skipBlock();
+        m_Recovering = false;
+        return;
+    }
+    if (getType() == Tokenizer::Token::DELIMITER && isDelimiter('@'))
+    {
+        advance();
+        if (getKeyword() != Keyword::STATICMETHOD)
+        {
+            error("Only @staticmethod is supported as a decorator, found " + describeCurrent());
+            return;
+        }
+        advance();
+        if (getType() != Tokenizer::Token::NEWLINE)
+        {
+            error("Expected a new line after the decorator, found " + describeCurrent());
+            return;
+        }
+        advance();
+        if (getKeyword() != Keyword::DEF)
+        {
+            error("Expected a function after the decorator, found " + describeCurrent());
+            return;
+        }
+        l_Statement = parseFunction(Ast::STATIC_METHOD);
+    }
+    else
+    {
+        switch (getKeyword())
+        {
+        case Keyword::DEF:
+            l_Statement = parseFunction(0);
+            break;
+        case Keyword::CLASS:
+            l_Statement = parseClass();
+            break;
+        case Keyword::IF:
+            l_Statement = parseIf();
+            break;
+        case Keyword::WHILE:
+            l_Statement = parseWhile();
+            break;
+        case Keyword::FOR:
+            l_Statement = parseFor();
+            break;
+        case Keyword::IMPORT:
+        case Keyword::FROM:
+            // The source reader takes the imports from the top of the module, the body starts after the last one
+            error("Imports have to come before any other statement");
+            return;
+        case Keyword::ELSE:
+        case Keyword::ELIF:
+            error("'" + std::string(getText()) + "' without an if before it");
+            return;
+        default:
+            parseSimpleStatements();
+            return;
+        }
+    }
+    if (l_Statement != Ast::c_NoNode)
+    {
+        m_Scratch.push_back(l_Statement);
+    }
+}
+
+void Parser::parseSimpleStatements()
+{
+    while (true)
+    {
+        parseSimpleStatement();
+        if (m_Recovering)
+        {
+            return;
+        }
+        if (!accept(';') || getType() == Tokenizer::Token::NEWLINE || getType() == Tokenizer::Token::END)
+        {
+            break;
+        }
+    }
+    if (getType() == Tokenizer::Token::NEWLINE)
+    {
+        advance();
+    }
+    else if (getType() != Tokenizer::Token::END)
+    {
+        error("Expected the end of the statement, found " + describeCurrent());
+    }
+}
+
+void Parser::parseSimpleStatement()
+{
+    const uint32_t l_Token = m_Position;
+    switch (getKeyword())
+    {
+    case Keyword::RETURN:
+        {
+            advance();
+            const bool l_Bare = getType() == Tokenizer::Token::NEWLINE || getType() == Tokenizer::Token::END || isDelimiter(';');
+            const NodeIndex l_Value = l_Bare ? Ast::c_NoNode : parseExpressionList();
+            if (!m_Recovering)
+            {
+                m_Scratch.push_back(addNode(Ast::RETURN, l_Token, l_Value));
+            }
+            return;
+        }
+    case Keyword::PASS:
+        advance();
+        m_Scratch.push_back(addNode(Ast::PASS, l_Token));
+        return;
+    case Keyword::BREAK:
+        advance();
+        m_Scratch.push_back(addNode(Ast::BREAK, l_Token));
+        return;
+    case Keyword::CONTINUE:
+        advance();
+        m_Scratch.push_back(addNode(Ast::CONTINUE, l_Token));
+        return;
+    case Keyword::NONE:
+        break;
+    default:
+        error("Unexpected " + describeCurrent());
+        return;
+    }
+
+    NodeIndex l_Target = parseExpressionList();
+    if (m_Recovering)
+    {
+        return;
+    }
+    bool l_Annotated = false;
+    if (isDelimiter(':'))
+    {
+        const uint32_t l_Colon = m_Position;
+        advance();
+        const NodeIndex l_Annotation = parseExpression();
+        if (m_Recovering)
+        {
+            return;
+        }
+        l_Target = addNode(Ast::ANNOTATED, l_Colon, l_Target, l_Annotation);
+        l_Annotated = true;
+    }
+    const Ast::Operator l_Operator = getType() == Tokenizer::Token::OPERATOR ? c_Assignments.find(getText()) : Ast::OPERATOR_COUNT;
+    if (l_Operator == Ast::OPERATOR_COUNT)
+    {
+        if (l_Annotated)
+        {
+            if (!isAssignable(l_Target, true))
+            {
+                error("Only names and attributes can be declared with a type");
+                return;
+            }
+            m_Scratch.push_back(addNode(Ast::ASSIGN, m_Ast.m_Nodes[l_Target].token, l_Target));
+            return;
+        }
+        m_Scratch.push_back(addNode(Ast::EXPRESSION, l_Token, l_Target));
+        return;
+    }
+    if (!isAssignable(l_Target, l_Operator == Ast::NO_OPERATOR) || (l_Operator != Ast::NO_OPERATOR && l_Annotated))
+    {
+        error("Cannot assign to this expression with " + describeCurrent());
+        return;
+    }
+    const uint32_t l_OperatorToken = m_Position;
+    advance();
+    const NodeIndex l_Value = parseExpressionList();
+    if (m_Recovering)
+    {
+        return;
+    }
+    if (getType() == Tokenizer::Token::OPERATOR && c_Assignments.find(getText()) != Ast::OPERATOR_COUNT)
+    {
+        error("Chained assignments are not supported");
+        return;
+    }
+    m_Scratch.push_back(addNode(Ast::ASSIGN, l_OperatorToken, l_Target, l_Value, l_Operator));
+}
+
+uint32_t Parser::parseBlock()
+{
+    const size_t l_Mark = m_Scratch.size();
+    if (getType() != Tokenizer::Token::NEWLINE)
+    {
+        parseSimpleStatements();
+        return finishList(l_Mark);
+    }
+    advance();
+    if (getType() != Tokenizer::Token::INDENT)
+    {
+        // The next line is a statement of its own, so there is nothing to skip
+        error("Expected an indented block, found " + describeCurrent());
+        m_Recovering = false;
+        return finishList(l_Mark);
+    }
+    if (m_Depth >= c_MaxDepth)
+    {
+        error("Blocks are nested too deeply");
+        return finishList(l_Mark);
+    }
+    const DepthGuard l_Guard{ m_Depth };
+    advance();
+    parseStatements(false);
+    if (getType() == Tokenizer::Token::DEDENT)
+    {
+        advance();
+    }
+    return finishList(l_Mark);
+}
+
+Parser::NodeIndex Parser::parseFunction(const uint16_t p_Flags)
+{
+    advance();
+    if (getType() != Tokenizer::Token::IDENTIFIER)
+    {
+        error("Expected a function name, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Name = m_Position;
+    advance();
+    if (!isDelimiter('('))
+    {
+        error("Expected '(' after the function name, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    open();
+    const size_t l_Mark = m_Scratch.size();
+    while (!m_Recovering && !isDelimiter(')'))
+    {
+        if (getType() != Tokenizer::Token::IDENTIFIER)
+        {
+            error("Expected a parameter name, found " + describeCurrent());
+            break;
+        }
+        const uint32_t l_Parameter = m_Position;
+        advance();
+        NodeIndex l_Annotation = Ast::c_NoNode;
+        NodeIndex l_Default = Ast::c_NoNode;
+        if (accept(':'))
+        {
+            l_Annotation = parseExpression();
+        }
+        if (!m_Recovering && isOperator("="))
+        {
+            advance();
+            l_Default = parseExpression();
+        }
+        m_Scratch.push_back(addNode(Ast::PARAMETER, l_Parameter, l_Annotation, l_Default));
+        if (!accept(','))
+        {
+            break;
+        }
+    }
+    if (m_Recovering || !close(')'))
+    {
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Parameters = finishList(l_Mark);
+    NodeIndex l_Returns = Ast::c_NoNode;
+    if (isOperator("->"))
+    {
+        advance();
+        l_Returns = parseExpression();
+    }
+    if (m_Recovering || !expect(':'))
+    {
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Body = parseBlock();
+    return addNode(Ast::FUNCTION, l_Name, addData({ l_Parameters, l_Returns, l_Body }), Ast::c_NoNode, Ast::NO_OPERATOR, p_Flags);
+}
+
+Parser::NodeIndex Parser::parseClass()
+{
+    advance();
+    if (getType() != Tokenizer::Token::IDENTIFIER)
+    {
+        error("Expected a class name, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Name = m_Position;
+    advance();
+    uint32_t l_Bases = finishList(m_Scratch.size());
+    if (isDelimiter('('))
+    {
+        open();
+        l_Bases = parseElements(')', false);
+    }
+    if (m_Recovering || !expect(':'))
+    {
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Body = parseBlock();
+    return addNode(Ast::CLASS, l_Name, l_Bases, l_Body);
+}
+
+Parser::NodeIndex Parser::parseIf()
+{
+    // The clauses of an if/elif chain are read in a loop and linked from the last one back, so that long chains
+    // do not recurse. Each one leaves its token, condition and body on the scratch stack
+    const size_t l_Mark = m_Scratch.size();
+    do
+    {
+        const uint32_t l_Token = m_Position;
+        advance();
+        const NodeIndex l_Condition = parseExpression();
+        if (m_Recovering || !expect(':'))
+        {
+            m_Scratch.resize(l_Mark);
+            return Ast::c_NoNode;
+        }
+        const uint32_t l_Body = parseBlock();
+        if (m_Recovering)
+        {
+            m_Scratch.resize(l_Mark);
+            return Ast::c_NoNode;
+        }
+        m_Scratch.insert(m_Scratch.end(), { l_Token, l_Condition, l_Body });
+    }
+    while (getKeyword() == Keyword::ELIF);
+
+    uint32_t l_Else;
+    if (getKeyword() == Keyword::ELSE)
+    {
+        advance();
+        if (!expect(':'))
+        {
+            m_Scratch.resize(l_Mark);
+            return Ast::c_NoNode;
+        }
+        l_Else = parseBlock();
+    }
+    else
+    {
+        l_Else = finishList(m_Scratch.size());
+    }
+    NodeIndex l_If = Ast::c_NoNode;
+    for (size_t l_Clause = m_Scratch.size() - 3; ; l_Clause -= 3)
+    {
+        const uint16_t l_Flags = l_Clause > l_Mark ? Ast::ELIF : 0;
+        l_If = addNode(Ast::IF, m_Scratch[l_Clause], m_Scratch[l_Clause + 1], addData({ m_Scratch[l_Clause + 2], l_Else }), Ast::NO_OPERATOR, l_Flags);
+        if (l_Clause == l_Mark)
+        {
+            break;
+        }
+        m_Scratch.push_back(l_If);
+        l_Else = finishList(m_Scratch.size() - 1);
+    }
+    m_Scratch.resize(l_Mark);
+    return l_If;
+}
+
+Parser::NodeIndex Parser::parseWhile()
+{
+    const uint32_t l_Token = m_Position;
+    advance();
+    const NodeIndex l_Condition = parseExpression();
+    if (m_Recovering || !expect(':'))
+    {
+        return Ast::c_NoNode;
+    }
+    return addNode(Ast::WHILE, l_Token, l_Condition, parseBlock());
+}
+
+Parser::NodeIndex Parser::parseFor()
+{
+    const uint32_t l_Token = m_Position;
+    advance();
+    const NodeIndex l_Target = parseExpressionList(PRECEDENCE_BIT_OR);
+    if (m_Recovering)
+    {
+        return Ast::c_NoNode;
+    }
+    if (!isAssignable(l_Target, true))
+    {
+        error("Cannot assign to the target of the for loop");
+        return Ast::c_NoNode;
+    }
+    if (!isOperator("in"))
+    {
+        error("Expected 'in' after the target of the for loop, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    advance();
+    const NodeIndex l_Iterable = parseExpressionList();
+    if (m_Recovering || !expect(':'))
+    {
+        return Ast::c_NoNode;
+    }
+    const uint32_t l_Body = parseBlock();
+    return addNode(Ast::FOR, l_Token, l_Target, addData({ l_Iterable, l_Body }));
+}
+
+Parser::NodeIndex Parser::parseExpressionList(const Precedence p_Precedence)
+{
+    const uint32_t l_Token = m_Position;
+    const NodeIndex l_First = p_Precedence == PRECEDENCE_NONE ? parseExpression() : parseBinary(p_Precedence);
+    if (m_Recovering || !isDelimiter(','))
+    {
+        return l_First;
+    }
+    const size_t l_Mark = m_Scratch.size();
+    m_Scratch.push_back(l_First);
+    // A trailing comma is allowed, as in "x = 1,"
+    while (!m_Recovering && accept(',') && startsExpression())
+    {
+        m_Scratch.push_back(p_Precedence == PRECEDENCE_NONE ? parseExpression() : parseBinary(p_Precedence));
+    }
+    if (m_Recovering)
+    {
+        return Ast::c_NoNode;
+    }
+    return addNode(Ast::TUPLE, l_Token, finishList(l_Mark));
+}
+
+Parser::NodeIndex Parser::parseExpression()
+{
+    const NodeIndex l_Value = parseBinary(PRECEDENCE_OR);
+    if (m_Recovering || getKeyword() != Keyword::IF)
+    {
+        return l_Value;
+    }
+    const uint32_t l_Token = m_Position;
+    advance();
+    const NodeIndex l_Condition = parseBinary(PRECEDENCE_OR);
+    if (m_Recovering)
+    {
+        return Ast::c_NoNode;
+    }
+    if (getKeyword() != Keyword::ELSE)
+    {
+        error("Expected 'else' in the conditional expression, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    advance();
+    const NodeIndex l_Otherwise = parseExpression();
+    return addNode(Ast::CONDITIONAL, l_Token, l_Condition, addData({ l_Value, l_Otherwise }));
+}
+
+Parser::NodeIndex Parser::parseBinary(const Precedence p_Precedence)
+{
+    if (m_Depth >= c_MaxDepth)
+    {
+        error("Expression nested too deeply");
+        return Ast::c_NoNode;
+    }
+    const DepthGuard l_Guard{ m_Depth };
+    NodeIndex l_Left = parseUnary(p_Precedence);
+    bool l_Compared = false;
+    while (!m_Recovering)
+    {
+        const BinaryOperator l_Operator = findBinaryOperator();
+        if (l_Operator.op == Ast::NO_OPERATOR || l_Operator.precedence < p_Precedence)
+        {
+            break;
+        }
+        const bool l_Comparison = Ast::isComparison(l_Operator.op);
+        if (l_Comparison && l_Compared)
+        {
+            error("Chained comparisons are not supported, use 'and'");
+            break;
+        }
+        l_Compared = l_Comparison;
+        const uint32_t l_Token = m_Position;
+        advance();
+        if (l_Operator.op == Ast::NOT_IN)
+        {
+            advance();
+        }
+        // ** groups to the right and takes a prefix operator on its right, as in 2 ** -1
+        const NodeIndex l_Right = parseBinary(l_Operator.op == Ast::POWER ? PRECEDENCE_UNARY : static_cast<Precedence>(l_Operator.precedence + 1));
+        l_Left = addNode(Ast::BINARY, l_Token, l_Left, l_Right, l_Operator.op);
+    }
+    return l_Left;
+}
+
+Parser::NodeIndex Parser::parseUnary(const Precedence p_Precedence)
+{
+    if (getType() != Tokenizer::Token::OPERATOR)
+    {
+        return parsePostfix(parsePrimary());
+    }
+    const std::string_view l_Text = getText();
+    const uint32_t l_Token = m_Position;
+    if (l_Text == "not")
+    {
+        if (p_Precedence > PRECEDENCE_NOT)
+        {
+            error("'not' needs parentheses here");
+            return Ast::c_NoNode;
+        }
+        advance();
+        return addNode(Ast::UNARY, l_Token, parseBinary(PRECEDENCE_NOT), Ast::c_NoNode, Ast::NOT);
+    }
+    const Ast::Operator l_Operator = l_Text == "-" ? Ast::NEGATE : l_Text == "+" ? Ast::POSITIVE : l_Text == "~" ? Ast::INVERT : Ast::NO_OPERATOR;
+    if (l_Operator == Ast::NO_OPERATOR)
+    {
+        error("Expected an expression, found " + describeCurrent());
+        return Ast::c_NoNode;
+    }
+    advance();
+    return addNode(Ast::UNARY, l_Token, parseBinary(PRECEDENCE_UNARY), Ast::c_NoNode, l_Operator);
+}
+
+Parser::NodeIndex Parser::parsePrimary()
+{
+    const uint32_t l_Token = m_Position;
+    switch (getType())
+    {
+    case Tokenizer::Token::IDENTIFIER:
+        advance();
+        return addNode(Ast::NAME, l_Token);
+    case Tokenizer::Token::NUMBER:
+        {
+            const NumberLiteral& l_Literal = m_Tokenizer.getNumber(m_Tokens[m_Position]);
+            advance();
+            if (l_Literal.kind == NumberLiteral::IMAGINARY)
+            {
+                return addNode(Ast::IMAGINARY, l_Token);
+            }
+            uint64_t l_Bits;
+            if (l_Literal.kind == NumberLiteral::INTEGER)
+            {
+                l_Bits = static_cast<uint64_t>(l_Literal.integer);
+            }
+            else
+            {
+                std::memcpy(&l_Bits, &l_Literal.real, sizeof(l_Bits));
+            }
+            return addNode(l_Literal.kind == NumberLiteral::INTEGER ? Ast::INTEGER : Ast::FLOAT, l_Token, static_cast<uint32_t>(l_Bits), static_cast<uint32_t>(l_Bits >> 32));
+        }
+    case Tokenizer::Token::STRING:
+        advance();
+        return addNode(Ast::STRING, l_Token);
+    case Tokenizer::Token::BOOLEAN:
+        {
+            const bool l_Value = getText() == "True";
+            advance();
+            return addNode(Ast::BOOLEAN, l_Token, l_Value ? 1 : 0);
+        }
+    case Tokenizer::Token::NONE:
+        advance();
+        return addNode(Ast::NONE, l_Token);
+    case Tokenizer::Token::DELIMITER:
+        if (isDelimiter('['))
+        {
+            open();
+            return addNode(Ast::LIST, l_Token, parseElements(']', false));
+        }
+        if (isDelimiter('{'))
+        {
+            open();
+            return addNode(Ast::DICT, l_Token, parseElements('}', true));
+        }
+        if (isDelimiter('('))
+        {
+            open();
+            if (isDelimiter(')'))
+            {
+                close(')');
+                return addNode(Ast::TUPLE, l_Token, finishList(m_Scratch.size()), Ast::c_NoNode, Ast::NO_OPERATOR, Ast::PARENTHESIZED);
+            }
+            const NodeIndex l_Inner = parseExpression();
+            if (m_Recovering)
+            {
+                return Ast::c_NoNode;
+            }
+            if (isDelimiter(','))
+            {
+                const size_t l_Mark = m_Scratch.size();
+                m_Scratch.push_back(l_Inner);
+                while (!m_Recovering && accept(',') && !isDelimiter(')'))
+                {
+                    m_Scratch.push_back(parseExpression());
+                }
+                if (m_Recovering || !close(')'))
+                {
+                    return Ast::c_NoNode;
+                }
+                return addNode(Ast::TUPLE, l_Token, finishList(l_Mark), Ast::c_NoNode, Ast::NO_OPERATOR, Ast::PARENTHESIZED);
+            }
+            return close(')') ? l_Inner : Ast::c_NoNode;
+        }
+        break;
+    default:
+        break;
+    }
+    error("Expected an expression, found " + describeCurrent());
+    return Ast::c_NoNode;
+}
+
+Parser::NodeIndex Parser::parsePostfix(NodeIndex p_Node)
+{
+    while (!m_Recovering && getType() == Tokenizer::Token::DELIMITER)
+    {
+        const uint32_t l_Token = m_Position;
+        if (isDelimiter('('))
+        {
+            open();
+            const size_t l_Mark = m_Scratch.size();
+            while (!m_Recovering && !isDelimiter(')'))
+            {
+                const uint32_t l_Next = findNext(m_Position);
+                if (getType() == Tokenizer::Token::IDENTIFIER && m_Types[l_Next] == Tokenizer::Token::OPERATOR && m_Tokenizer.getValue(m_Tokens[l_Next]) == "=")
+                {
+                    const uint32_t l_Name = m_Position;
+                    advance();
+                    advance();
+                    m_Scratch.push_back(addNode(Ast::KEYWORD_ARGUMENT, l_Name, parseExpression()));
+                }
+                else
+                {
+                    m_Scratch.push_back(parseExpression());
+                }
+                if (!accept(','))
+                {
+                    break;
+                }
+            }
+            if (m_Recovering || !close(')'))
+            {
+                return Ast::c_NoNode;
+            }
+            p_Node = addNode(Ast::CALL, l_Token, p_Node, finishList(l_Mark));
+        }
+        else if (isDelimiter('.'))
+        {
+            advance();
+            if (getType() != Tokenizer::Token::IDENTIFIER)
+            {
+                error("Expected an attribute name after '.', found " + describeCurrent());
+                return Ast::c_NoNode;
+            }
+            p_Node = addNode(Ast::ATTRIBUTE, m_Position, p_Node);
+            advance();
+        }
+        else if (isDelimiter('['))
+        {
+            open();
+            const NodeIndex l_Index = parseExpressionList();
+            if (!m_Recovering && isDelimiter(':'))
+            {
+                error("Slices are not supported");
+            }
+            if (m_Recovering || !close(']'))
+            {
+                return Ast::c_NoNode;
+            }
+            p_Node = addNode(Ast::SUBSCRIPT, l_Token, p_Node, l_Index);
+        }
+        else
+        {
+            break;
+        }
+    }
+    return p_Node;
+}
+
+uint32_t Parser::parseElements(const char p_Close, const bool p_Pairs)
+{
+    const size_t l_Mark = m_Scratch.size();
+    while (!m_Recovering && !isDelimiter(p_Close))
+    {
+        m_Scratch.push_back(parseExpression());
+        if (p_Pairs && !m_Recovering && expect(':'))
+        {
+            m_Scratch.push_back(parseExpression());
+        }
+        if (!accept(','))
+        {
+            break;
+        }
+    }
+    if (m_Recovering || !close(p_Close))
+    {
+        m_Scratch.resize(l_Mark);
+    }
+    return finishList(l_Mark);
+}
+
+Parser::BinaryOperator Parser::findBinaryOperator() const
+{
+    if (getType() != Tokenizer::Token::OPERATOR)
+    {
+        return c_NoBinaryOperator;
+    }
+    const std::string_view l_Text = getText();
+    if (l_Text == "not")
+    {
+        const uint32_t l_Next = findNext(m_Position);
+        if (m_Types[l_Next] == Tokenizer::Token::OPERATOR && m_Tokenizer.getValue(m_Tokens[l_Next]) == "in")
+        {
+            return { Ast::NOT_IN, PRECEDENCE_COMPARISON };
+        }
+        return c_NoBinaryOperator;
+    }
+    return c_BinaryOperators.find(l_Text);
+}
+
+bool Parser::isAssignable(const NodeIndex p_Node, const bool p_Unpacking) const
+{
+    const Ast::Node& l_Node = m_Ast.m_Nodes[p_Node];
+    switch (l_Node.kind)
+    {
+    case Ast::NAME:
+    case Ast::ATTRIBUTE:
+    case Ast::SUBSCRIPT:
+        return true;
+    case Ast::ANNOTATED:
+        return p_Unpacking && (m_Ast.m_Nodes[l_Node.first].kind == Ast::NAME || m_Ast.m_Nodes[l_Node.first].kind == Ast::ATTRIBUTE);
+    case Ast::TUPLE:
+    case Ast::LIST:
+        return p_Unpacking && std::ranges::all_of(m_Ast.getList(l_Node.first), [this](const NodeIndex p_Element)
+        {
+            return m_Ast.m_Nodes[p_Element].kind != Ast::ANNOTATED && isAssignable(p_Element, true);
+        });
+    default:
+        return false;
+    }
+}
+
+Parser::Keyword Parser::getKeyword() const
+{
+    return getType() == Tokenizer::Token::KEYWORD ? c_Keywords.find(getText()) : Keyword::NONE;
+}
+
+bool Parser::isDelimiter(const char p_Delimiter) const
+{
+    return getType() == Tokenizer::Token::DELIMITER && getText()[0] == p_Delimiter;
+}
+
+bool Parser::isOperator(const std::string_view p_Operator) const
+{
+    return getType() == Tokenizer::Token::OPERATOR && getText() == p_Operator;
+}
+
+bool Parser::startsExpression() const
+{
+    switch (getType())
+    {
+    case Tokenizer::Token::IDENTIFIER:
+    case Tokenizer::Token::NUMBER:
+    case Tokenizer::Token::STRING:
+    case Tokenizer::Token::BOOLEAN:
+    case Tokenizer::Token::NONE:
+        return true;
+    case Tokenizer::Token::DELIMITER:
+        return isDelimiter('(') || isDelimiter('[') || isDelimiter('{');
+    case Tokenizer::Token::OPERATOR:
+        return isOperator("-") || isOperator("+") || isOperator("~") || isOperator("not");
+    default:
+        return false;
+    }
+}
+
+uint32_t Parser::findNext(uint32_t p_Position) const
+{
+    while (m_Types[p_Position] != Tokenizer::Token::END)
+    {
+        const Tokenizer::Token::Type l_Type = m_Types[++p_Position];
+        const bool l_Layout = l_Type == Tokenizer::Token::INDENT || l_Type == Tokenizer::Token::DEDENT || l_Type == Tokenizer::Token::NEWLINE;
+        if (l_Type != Tokenizer::Token::COMMENT && !(l_Layout && m_Nesting > 0))
+        {
+            break;
+        }
+    }
+    return p_Position;
+}
+
+void Parser::advance()
+{
+    if (getType() != Tokenizer::Token::END)
+    {
+        ++m_Position;
+        skipTrivia();
+    }
+}
+
+void Parser::skipTrivia()
+{
+    // Comments never matter. Inside brackets the tokenizer emits no NEWLINE, but a continuation line indented less
+    // than its statement still gets INDENT and DEDENT tokens, which mean nothing there
+    while (true)
+    {
+        const Tokenizer::Token::Type l_Type = getType();
+        const bool l_Layout = l_Type == Tokenizer::Token::INDENT || l_Type == Tokenizer::Token::DEDENT || l_Type == Tokenizer::Token::NEWLINE;
+        if (l_Type != Tokenizer::Token::COMMENT && !(l_Layout && m_Nesting > 0))
+        {
+            return;
+        }
+        ++m_Position;
+    }
+}
+
+bool Parser::accept(const char p_Delimiter)
+{
+    if (!isDelimiter(p_Delimiter))
+    {
+        return false;
+    }
+    advance();
+    return true;
+}
+
+bool Parser::expect(const char p_Delimiter)
+{
+    if (accept(p_Delimiter))
+    {
+        return true;
+    }
+    error(std::string("Expected '") + p_Delimiter + "', found " + describeCurrent());
+    return false;
+}
+
+void Parser::open()
+{
+    ++m_Nesting;
+    advance();
+}
+
+bool Parser::close(const char p_Delimiter)
+{
+    if (!isDelimiter(p_Delimiter))
+    {
+        error(std::string("Expected '") + p_Delimiter + "', found " + describeCurrent());
+        return false;
+    }
+    --m_Nesting;
+    advance();
+    return true;
+}
+
+void Parser::error(std::string p_Message)
+{
+    if (m_Recovering)
+    {
+        return;
+    }
+    m_Recovering = true;
+    const Tokenizer::Location l_Location = m_Tokenizer.getLocation(m_Tokens[m_Position]);
+    m_Ast.m_Errors.push_back({ .message = std::move(p_Message), .line = l_Location.line, .column = l_Location.column });
+}
+
+std::string Parser::describeCurrent() const
+{
+    switch (getType())
+    {
+    case Tokenizer::Token::NEWLINE:
+        return "the end of the line";
+    case Tokenizer::Token::INDENT:
+        return "an indent";
+    case Tokenizer::Token::DEDENT:
+        return "the end of the block";
+    case Tokenizer::Token::END:
+        return "the end of the file";
+    case Tokenizer::Token::NONE:
+        return "'None'";
+    default:
+        {
+            // Strings can be long
+            const std::string_view l_Text = getText();
+            std::string l_Quoted;
+            l_Quoted.reserve(c_MaxQuotedLength + 5);
+            l_Quoted += '\'';
+            l_Quoted += l_Text.substr(0, c_MaxQuotedLength);
+            l_Quoted += l_Text.size() > c_MaxQuotedLength ? "...'" : "'";
+            return l_Quoted;
+        }
+    }
+}
+
+void Parser::synchronize()
+{
+    m_Recovering = false;
+    m_Nesting = 0;
+    // An error found at the start of a line leaves the position on the DEDENT closing the block, which is not
+    // the broken statement's to skip
+    if (getType() == Tokenizer::Token::DEDENT)
+    {
+        return;
+    }
+    while (true)
+    {
+        while (getType() != Tokenizer::Token::NEWLINE && getType() != Tokenizer::Token::END)
+        {
+            ++m_Position;
+        }
+        advance();
+        if (getType() == Tokenizer::Token::INDENT)
+        {
+            skipBlock();
+        }
+        const Keyword l_Keyword = getKeyword();
+        if (l_Keyword != Keyword::ELSE && l_Keyword != Keyword::ELIF)
+        {
+            return;
+        }
+    }
+}
+
+void Parser::skipBlock()
+{
+    uint32_t l_Level = 0;
+    do
+    {
+        if (getType() == Tokenizer::Token::INDENT)
+        {
+            ++l_Level;
+        }
+        else if (getType() == Tokenizer::Token::DEDENT)
+        {
+            --l_Level;
+        }
+        advance();
+    }
+    while (l_Level > 0 && getType() != Tokenizer::Token::END);
+}
+
+Parser::NodeIndex Parser::addNode(const Ast::Kind p_Kind, const uint32_t p_Token, const NodeIndex p_First, const NodeIndex p_Second, const Ast::Operator p_Operator, const uint16_t p_Flags)
+{
+    m_Ast.m_Nodes.push_back({ .kind = p_Kind, .op = p_Operator, .flags = p_Flags, .token = p_Token, .first = p_First, .second = p_Second });
+    return static_cast<NodeIndex>(m_Ast.m_Nodes.size() - 1);
+}
+
+uint32_t Parser::finishList(const size_t p_Mark)
+{
+    const uint32_t l_Start = static_cast<uint32_t>(m_Ast.m_Lists.size());
+    const uint32_t l_Count = static_cast<uint32_t>(m_Scratch.size() - p_Mark);
+    m_Ast.m_Lists.insert(m_Ast.m_Lists.end(), m_Scratch.begin() + static_cast<std::ptrdiff_t>(p_Mark), m_Scratch.end());
+    m_Scratch.resize(p_Mark);
+    return addData({ l_Start, l_Count });
+}
+
+uint32_t Parser::addData(const std::initializer_list<uint32_t> p_Words)
+{
+    const uint32_t l_Index = static_cast<uint32_t>(m_Ast.m_Lists.size());
+    m_Ast.m_Lists.insert(m_Ast.m_Lists.end(), p_Words);
+    return l_Index;
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.hpp"
+#include "../tokenizer/perfect_hash.hpp"
+
+// Recursive descent over statements and precedence climbing over expressions, reading the tokens in order with at
+// most one token of lookahead. Errors are collected in the tree rather than thrown. After one, the rest of the
+// statement is skipped, along with the block it opens, so a module with mistakes still gets a tree for everything else
+class Parser
+{
+public:
+    // The tree refers to p_Tokenizer, which has to outlive it, and is allocated from p_Memory
+    [[nodiscard]] static Ast parse(const Tokenizer& p_Tokenizer, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+private:
+    using NodeIndex = Ast::NodeIndex;
+
+    // In the order of Tokenizer::c_Keywords, which c_Keywords is built from
+    enum class Keyword: uint8_t
+    {
+        NONE,
+        IF,
+        ELSE,
+        ELIF,
+        WHILE,
+        FOR,
+        DEF,
+        RETURN,
+        CLASS,
+        IMPORT,
+        FROM,
+        AS,
+        PASS,
+        BREAK,
+        CONTINUE,
+        STATICMETHOD
+    };
+
+    // Binding strength of the binary operators and of the prefix ones, weakest first
+    enum Precedence: uint8_t
+    {
+        PRECEDENCE_NONE,
+        PRECEDENCE_OR,
+        PRECEDENCE_AND,
+        PRECEDENCE_NOT,
+        PRECEDENCE_COMPARISON,
+        PRECEDENCE_BIT_OR,
+        PRECEDENCE_BIT_XOR,
+        PRECEDENCE_BIT_AND,
+        PRECEDENCE_SHIFT,
+        PRECEDENCE_ADDITIVE,
+        PRECEDENCE_MULTIPLICATIVE,
+        PRECEDENCE_UNARY,
+        PRECEDENCE_POWER
+    };
+
+    struct BinaryOperator
+    {
+        Ast::Operator op;
+        Precedence precedence;
+    };
+    static constexpr BinaryOperator c_NoBinaryOperator{ Ast::NO_OPERATOR, PRECEDENCE_NONE };
+
+    // Tokenizer::c_Keywords without the operator keywords, which Keyword lists in the same order
+    static constexpr auto c_Keywords = []
+    {
+        using Map = PerfectHashMap<Keyword, Tokenizer::c_Keywords.size()>;
+        std::array<Map::Entry, Tokenizer::c_Keywords.size()> l_Entries{};
+        uint8_t l_Next = static_cast<uint8_t>(Keyword::IF);
+        for (size_t l_Index = 0; l_Index < Tokenizer::c_Keywords.size(); ++l_Index)
+        {
+            if (!Tokenizer::c_OperatorKeywordTable.find(Tokenizer::c_Keywords[l_Index]))
+            {
+                l_Entries[l_Index] = { Tokenizer::c_Keywords[l_Index], static_cast<Keyword>(l_Next++) };
+            }
+        }
+        if (l_Next != static_cast<uint8_t>(Keyword::STATICMETHOD) + 1)
+        {
+            throw "Keyword does not match Tokenizer::c_Keywords";
+        }
+        return Map{ l_Entries, Keyword::NONE };
+    }();
+
+    // "not in" is two tokens and found separately
+    static constexpr PerfectHashMap<BinaryOperator, 21> c_BinaryOperators{ std::array<PerfectHashMap<BinaryOperator, 21>::Entry, 21>{ {
+        { "or", { Ast::OR, PRECEDENCE_OR } }, { "and", { Ast::AND, PRECEDENCE_AND } },
+        { "==", { Ast::EQUAL, PRECEDENCE_COMPARISON } }, { "!=", { Ast::NOT_EQUAL, PRECEDENCE_COMPARISON } },
+        { "<", { Ast::LESS, PRECEDENCE_COMPARISON } }, { "<=", { Ast::LESS_EQUAL, PRECEDENCE_COMPARISON } },
+        { ">", { Ast::GREATER, PRECEDENCE_COMPARISON } }, { ">=", { Ast::GREATER_EQUAL, PRECEDENCE_COMPARISON } },
+        { "in", { Ast::IN, PRECEDENCE_COMPARISON } }, { "|", { Ast::BIT_OR, PRECEDENCE_BIT_OR } },
+        { "^", { Ast::BIT_XOR, PRECEDENCE_BIT_XOR } }, { "&", { Ast::BIT_AND, PRECEDENCE_BIT_AND } },
+        { "<<", { Ast::SHIFT_LEFT, PRECEDENCE_SHIFT } }, { ">>", { Ast::SHIFT_RIGHT, PRECEDENCE_SHIFT } },
+        { "+", { Ast::ADD, PRECEDENCE_ADDITIVE } }, { "-", { Ast::SUBTRACT, PRECEDENCE_ADDITIVE } },
+        { "*", { Ast::MULTIPLY, PRECEDENCE_MULTIPLICATIVE } }, { "/", { Ast::DIVIDE, PRECEDENCE_MULTIPLICATIVE } },
+        { "//", { Ast::FLOOR_DIVIDE, PRECEDENCE_MULTIPLICATIVE } }, { "%", { Ast::MODULO, PRECEDENCE_MULTIPLICATIVE } },
+        { "**", { Ast::POWER, PRECEDENCE_POWER } }
+    } }, c_NoBinaryOperator };
+
+    // NO_OPERATOR for a plain assignment, OPERATOR_COUNT for anything that is not an assignment
+    static constexpr PerfectHashMap<Ast::Operator, 11> c_Assignments{ std::array<PerfectHashMap<Ast::Operator, 11>::Entry, 11>{ {
+        { "=", Ast::NO_OPERATOR }, { "+=", Ast::ADD }, { "-=", Ast::SUBTRACT }, { "*=", Ast::MULTIPLY },
+        { "/=", Ast::DIVIDE }, { "//=", Ast::FLOOR_DIVIDE }, { "%=", Ast::MODULO }, { "**=", Ast::POWER },
+        { "&=", Ast::BIT_AND }, { "|=", Ast::BIT_OR }, { "^=", Ast::BIT_XOR }
+    } }, Ast::OPERATOR_COUNT };
+
+    Parser(const Tokenizer& p_Tokenizer, Ast& p_Ast, std::pmr::memory_resource* p_Memory);
+
+    // Statements, each pushed on the scratch stack
+    void parseStatements(bool p_TopLevel);
+    void parseStatement();
+    void parseSimpleStatements();
+    void parseSimpleStatement();
+    // After the ':', a list of the statements in the indented block or on the rest of the line
+    uint32_t parseBlock();
+    NodeIndex parseFunction(uint16_t p_Flags);
+    NodeIndex parseClass();
+    NodeIndex parseIf();
+    NodeIndex parseWhile();
+    NodeIndex parseFor();
+
+    // Expressions separated by commas, as a TUPLE if there is more than one. Stops before an operator with less
+    // precedence than p_Precedence, which for targets keeps "in" out of them
+    NodeIndex parseExpressionList(Precedence p_Precedence = PRECEDENCE_NONE);
+    // Conditional expressions included
+    NodeIndex parseExpression();
+    NodeIndex parseBinary(Precedence p_Precedence);
+    NodeIndex parseUnary(Precedence p_Precedence);
+    NodeIndex parsePrimary();
+    NodeIndex parsePostfix(NodeIndex p_Node);
+    // After the opening bracket, up to and including p_Close. Dictionaries have key: value pairs
+    uint32_t parseElements(char p_Close, bool p_Pairs);
+    [[nodiscard]] BinaryOperator findBinaryOperator() const;
+    // Names, attributes and subscripts. With p_Unpacking also annotated names and attributes, and tuples and lists
+    // of targets
+    [[nodiscard]] bool isAssignable(NodeIndex p_Node, bool p_Unpacking) const;
+
+    // The current token is never a comment, nor a layout token inside brackets
+    [[nodiscard]] Tokenizer::Token::Type getType() const { return m_Types[m_Position]; }
+    [[nodiscard]] std::string_view getText() const { return m_Tokenizer.getValue(m_Tokens[m_Position]); }
+    [[nodiscard]] Keyword getKeyword() const;
+    [[nodiscard]] bool isDelimiter(char p_Delimiter) const;
+    [[nodiscard]] bool isOperator(std::string_view p_Operator) const;
+    [[nodiscard]] bool startsExpression() const;
+    [[nodiscard]] uint32_t findNext(uint32_t p_Position) const;
+    void advance();
+    void skipTrivia();
+    bool accept(char p_Delimiter);
+    bool expect(char p_Delimiter);
+    // Opening brackets turn off layout tokens until the matching closing one
+    void open();
+    bool close(char p_Delimiter);
+
+    // Records the error unless one is already being recovered from
+    void error(std::string p_Message);
+    [[nodiscard]] std::string describeCurrent() const;
+    // Skips to the next statement after an error, with the block the broken one opened and any else clauses
+    void synchronize();
+    void skipBlock();
+
+    NodeIndex addNode(Ast::Kind p_Kind, uint32_t p_Token, NodeIndex p_First = Ast::c_NoNode, NodeIndex p_Second = Ast::c_NoNode, Ast::Operator p_Operator = Ast::NO_OPERATOR, uint16_t p_Flags = 0);
+    // Moves what was pushed on the scratch stack since p_Mark into a list, and returns the list
+    uint32_t finishList(size_t p_Mark);
+    uint32_t addData(std::initializer_list<uint32_t> p_Words);
+
+    // Nesting of blocks and expressions deeper than this is reported instead of overflowing the stack
+    static constexpr uint32_t c_MaxDepth = 256;
+
+    const Tokenizer& m_Tokenizer;
+    const TokenStream& m_Tokens;
+    std::span<const Tokenizer::Token::Type> m_Types;
+    Ast& m_Ast;
+    uint32_t m_Position = 0;
+    uint32_t m_Nesting = 0;
+    uint32_t m_Depth = 0;
+    bool m_Recovering = false;
+    // Children of the lists being parsed, innermost on top
+    std::pmr::vector<NodeIndex> m_Scratch;
+};
@@ -0,0 +1,152 @@
+#include "task_scheduler.hpp"
+
+namespace
+{
+    // Scheduler and queue index of the worker running on this thread, if any
+    thread_local const TaskScheduler* s_CurrentScheduler = nullptr;
+    thread_local uint32_t s_CurrentWorker = 0;
+}
+
+TaskScheduler::TaskScheduler(const uint32_t p_WorkerCount)
+{
+    const uint32_t l_WorkerCount = p_WorkerCount == 0 ? 1 : p_WorkerCount;
+    m_Workers.reserve(l_WorkerCount);
+    for (uint32_t l_Worker = 0; l_Worker < l_WorkerCount; ++l_Worker)
+    {
+        m_Workers.push_back(std::make_unique<Worker>());
+    }
+    m_Threads.reserve(l_WorkerCount);
+    for (uint32_t l_Worker = 0; l_Worker < l_WorkerCount; ++l_Worker)
+    {
+        m_Threads.emplace_back(&TaskScheduler::run, this, l_Worker);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard l_Lock{ m_SleepMutex };
+        m_Stopping = true;
+    }
+    m_WorkAvailable.notify_all();
+    for (std::thread& l_Thread : m_Threads)
+    {
+        l_Thread.join();
+    }
+}
+
+void TaskScheduler::submit(Task p_Task)
+{
+    m_Unfinished.fetch_add(1);
+    // Work spawned by a task stays with its worker, work from outside is spread round-robin
+    const uint32_t l_Worker = s_CurrentScheduler == this ? s_CurrentWorker : m_NextWorker.fetch_add(1) % getWorkerCount();
+    {
+        std::lock_guard l_Lock{ m_Workers[l_Worker]->mutex };
+        m_Workers[l_Worker]->tasks.push_back(std::move(p_Task));
+    }
+    {
+        // Counted under the sleep mutex so that a worker about to sleep cannot miss it
+        std::lock_guard l_Lock{ m_SleepMutex };
+        m_Queued.fetch_add(1);
+    }
+    m_WorkAvailable.notify_one();
+}
+
+void TaskScheduler::wait()
+{
+    std::unique_lock l_Lock{ m_SleepMutex };
+    m_AllFinished.wait(l_Lock, [this] { return m_Unfinished.load() == 0; });
+}
+
+void TaskScheduler::parallelFor(const uint32_t p_Count, const std::function<void(uint32_t)>& p_Body)
+{
+    if (p_Count == 0)
+    {
+        return;
+    }
+    std::atomic<uint32_t> l_Remaining = p_Count;
+    for (uint32_t l_Index = 1; l_Index < p_Count; ++l_Index)
+    {
+        submit([&p_Body, &l_Remaining, l_Index]
+        {
+            p_Body(l_Index);
+            l_Remaining.fetch_sub(1);
+        });
+    }
+    p_Body(0);
+    l_Remaining.fetch_sub(1);
+
+    const uint32_t l_Worker = s_CurrentScheduler == this ? s_CurrentWorker : 0;
+    Task l_Task;
+    while (l_Remaining.load() != 0)
+    {
+        if (popTask(l_Worker, l_Task))
+        {
+            execute(l_Task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskScheduler::execute(Task& p_Task)
+{
+    p_Task();
+    p_Task = nullptr;
+    if (m_Unfinished.fetch_sub(1) == 1)
+    {
+        std::lock_guard l_Lock{ m_SleepMutex };
+        m_AllFinished.notify_all();
+    }
+}
+
+bool TaskScheduler::popTask(const uint32_t p_Worker, Task& p_Task)
+{
+    {
+        Worker& l_Own = *m_Workers[p_Worker];
+        std::lock_guard l_Lock{ l_Own.mutex };
+        if (!l_Own.tasks.empty())
+        {
+            p_Task = std::move(l_Own.tasks.back());
+            l_Own.tasks.pop_back();
+            m_Queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (uint32_t l_Offset = 1; l_Offset < getWorkerCount(); ++l_Offset)
+    {
+        Worker& l_Victim = *m_Workers[(p_Worker + l_Offset) % getWorkerCount()];
+        std::lock_guard l_Lock{ l_Victim.mutex };
+        if (!l_Victim.tasks.empty())
+        {
+            p_Task = std::move(l_Victim.tasks.front());
+            l_Victim.tasks.pop_front();
+            m_Queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::run(const uint32_t p_Worker)
+{
+    s_CurrentScheduler = this;
+    s_CurrentWorker = p_Worker;
+    Task l_Task;
+    while (true)
+    {
+        if (popTask(p_Worker, l_Task))
+        {
+            execute(l_Task);
+            continue;
+        }
+        std::unique_lock l_Lock{ m_SleepMutex };
+        m_WorkAvailable.wait(l_Lock, [this] { return m_Stopping || m_Queued.load() > 0; });
+        if (m_Stopping && m_Queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads with one task queue each. A worker runs its own queue newest first and, when it runs
+// dry, steals the oldest task of another worker. Tasks may submit more tasks, which go to the submitting worker's queue
+class TaskScheduler
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit TaskScheduler(uint32_t p_WorkerCount);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Tasks must not throw
+    void submit(Task p_Task);
+    // Blocks until every submitted task, including the ones submitted by other tasks, has finished. Must not be
+    // called from a task
+    void wait();
+    // Calls p_Body with every index below p_Count, spread over the workers, and returns once all calls have finished.
+    // The calling thread runs one of them and then helps with queued tasks, so unlike wait() it can be used in a task
+    void parallelFor(uint32_t p_Count, const std::function<void(uint32_t)>& p_Body);
+
+    [[nodiscard]] uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(uint32_t p_Worker);
+    bool popTask(uint32_t p_Worker, Task& p_Task);
+    void execute(Task& p_Task);
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::vector<std::thread> m_Threads;
+
+    // Tasks sitting in a queue, and tasks not finished yet (queued or running)
+    std::atomic<uint32_t> m_Queued = 0;
+    std::atomic<uint32_t> m_Unfinished = 0;
+    std::atomic<uint32_t> m_NextWorker = 0;
+
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_AllFinished;
+    bool m_Stopping = false;
+};
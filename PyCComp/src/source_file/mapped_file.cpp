@@ -0,0 +1,138 @@
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& p_Path)
+{
+#ifdef _WIN32
+    const HANDLE l_File = CreateFileW(p_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (l_File != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER l_Size;
+        if (GetFileSizeEx(l_File, &l_Size) && l_Size.QuadPart > 0)
+        {
+            const HANDLE l_Mapping = CreateFileMappingW(l_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (l_Mapping != nullptr)
+            {
+                m_Data = static_cast<const char*>(MapViewOfFile(l_Mapping, FILE_MAP_READ, 0, 0, 0));
+                // The view keeps the mapping alive
+                CloseHandle(l_Mapping);
+                if (m_Data != nullptr)
+                {
+                    m_Size = static_cast<size_t>(l_Size.QuadPart);
+                    m_Mapped = true;
+                }
+            }
+        }
+        CloseHandle(l_File);
+    }
+#else
+    const int l_File = open(p_Path.c_str(), O_RDONLY);
+    if (l_File >= 0)
+    {
+        struct stat l_Stat{};
+        if (fstat(l_File, &l_Stat) == 0 && S_ISREG(l_Stat.st_mode) && l_Stat.st_size > 0)
+        {
+            void* l_Data = mmap(nullptr, static_cast<size_t>(l_Stat.st_size), PROT_READ, MAP_PRIVATE, l_File, 0);
+            if (l_Data != MAP_FAILED)
+            {
+                madvise(l_Data, static_cast<size_t>(l_Stat.st_size), MADV_SEQUENTIAL);
+                m_Data = static_cast<const char*>(l_Data);
+                m_Size = static_cast<size_t>(l_Stat.st_size);
+                m_Mapped = true;
+            }
+        }
+        close(l_File);
+    }
+#endif
+    if (m_Mapped)
+    {
+        return;
+    }
+
+    // Empty files cannot be mapped, and neither can some special files. Read those in one go
+    std::ifstream l_Stream(p_Path, std::ios::binary | std::ios::ate);
+    if (!l_Stream.is_open())
+    {
+        throw std::runtime_error("Could not open file: " + p_Path.string());
+    }
+    const std::streamoff l_Size = l_Stream.tellg();
+    if (l_Size <= 0)
+    {
+        return;
+    }
+    m_Buffer = std::make_unique<char[]>(static_cast<size_t>(l_Size));
+    l_Stream.seekg(0);
+    l_Stream.read(m_Buffer.get(), l_Size);
+    m_Data = m_Buffer.get();
+    m_Size = static_cast<size_t>(l_Stream.gcount());
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& p_Other) noexcept
+    : m_Data(std::exchange(p_Other.m_Data, nullptr)), m_Size(std::exchange(p_Other.m_Size, 0)), m_Mapped(std::exchange(p_Other.m_Mapped, false)), m_Buffer(std::move(p_Other.m_Buffer))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& p_Other) noexcept
+{
+    if (this != &p_Other)
+    {
+        release();
+        m_Data = std::exchange(p_Other.m_Data, nullptr);
+        m_Size = std::exchange(p_Other.m_Size, 0);
+        m_Mapped = std::exchange(p_Other.m_Mapped, false);
+        m_Buffer = std::move(p_Other.m_Buffer);
+    }
+    return *this;
+}
+
+void MappedFile::ensureTrailingNewline()
+{
+    if (m_Size == 0 || m_Data[m_Size - 1] == '\n')
+    {
+        return;
+    }
+    std::unique_ptr<char[]> l_Buffer = std::make_unique<char[]>(m_Size + 1);
+    std::memcpy(l_Buffer.get(), m_Data, m_Size);
+    l_Buffer[m_Size] = '\n';
+    const size_t l_Size = m_Size + 1;
+    release();
+    m_Buffer = std::move(l_Buffer);
+    m_Data = m_Buffer.get();
+    m_Size = l_Size;
+}
+
+void MappedFile::release()
+{
+    if (m_Mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap(const_cast<char*>(m_Data), m_Size);
+#endif
+    }
+    m_Buffer.reset();
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Mapped = false;
+}
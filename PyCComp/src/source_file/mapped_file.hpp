@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+// Read-only view of a whole file. The file is memory-mapped when possible and read with a single sized read
+// otherwise. The contents stay at the same address when the object is moved
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& p_Path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& p_Other) noexcept;
+    MappedFile& operator=(MappedFile&& p_Other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::string_view getContents() const { return { m_Data, m_Size }; }
+
+    // Non-empty files that do not end in '\n' are copied into an owned buffer with one appended
+    void ensureTrailingNewline();
+
+private:
+    void release();
+
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    bool m_Mapped = false;
+    std::unique_ptr<char[]> m_Buffer;
+};
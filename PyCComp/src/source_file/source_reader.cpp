@@ -1,10 +1,38 @@
 #include "source_reader.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <exception>
 #include <filesystem>
-#include <fstream>
+#include <stdexcept>
 #include <unordered_set>
 
-SourceReader::SourceReader(const std::filesystem::path& p_MainFile, const std::filesystem::path& p_WorkingDir)
+#include "../instrumentation/instrumentation.hpp"
+#include "../scheduler/task_scheduler.hpp"
+
+// Modules found so far by a parallel discovery, in the order they were first imported. Each one is read by its own
+// task, which then requests its imports
+struct SourceReader::Discovery
+{
+    struct PendingModule
+    {
+        std::filesystem::path fileName;
+        LoadedModule loaded;
+        std::vector<uint32_t> imports;
+        std::exception_ptr error;
+        uint32_t index = UINT32_MAX;
+    };
+
+    TaskScheduler& scheduler;
+    std::mutex mutex{};
+    // Grown while tasks hold pointers to its elements, which a deque keeps stable
+    std::pmr::deque<PendingModule> modules;
+    std::unordered_map<std::string, uint32_t> lexicalKeys{};
+    std::unordered_map<std::string, uint32_t> canonicalKeys{};
+};
+
+SourceReader::SourceReader(const std::filesystem::path& p_MainFile, const std::filesystem::path& p_WorkingDir, TaskScheduler* p_Scheduler, const TokenCache* p_Cache, std::pmr::memory_resource* p_Memory)
+    : m_ModuleFiles(p_Memory), m_Cache(p_Cache)
 {
     if (p_WorkingDir.empty())
     {
@@ -15,7 +43,26 @@ SourceReader::SourceReader(const std::filesystem::path& p_MainFile, const std::f
     {
         m_WorkingDir = std::filesystem::absolute(p_WorkingDir);
     }
-    parseModule(p_WorkingDir / p_MainFile);
+    if (p_Scheduler == nullptr)
+    {
+        parseModule(p_WorkingDir / p_MainFile);
+        return;
+    }
+
+    // Everything reachable is loaded first, then modules are numbered by the same depth-first walk the serial path
+    // does, which also rethrows the first error that walk would have hit
+    Discovery l_Discovery{ .scheduler = *p_Scheduler, .modules = std::pmr::deque<Discovery::PendingModule>(p_Memory) };
+    const uint32_t l_Main = requestModule(l_Discovery, p_WorkingDir / p_MainFile);
+    p_Scheduler->wait();
+    placeModule(l_Discovery, l_Main);
+    for (const auto& [l_Key, l_Pending] : l_Discovery.lexicalKeys)
+    {
+        m_ModuleIndices.emplace(l_Key, l_Discovery.modules[l_Pending].index);
+    }
+    for (const auto& [l_Key, l_Pending] : l_Discovery.canonicalKeys)
+    {
+        m_CanonicalIndices.emplace(l_Key, l_Discovery.modules[l_Pending].index);
+    }
 }
 
 const SourceReader::ModuleFile* SourceReader::getModule(const uint32_t p_Index) const
@@ -27,9 +74,9 @@ const SourceReader::ModuleFile* SourceReader::getModule(const uint32_t p_Index)
     return nullptr;
 }
 
-const SourceReader::ModuleFile* SourceReader::getModule(const std::string_view p_FileName) const
+const SourceReader::ModuleFile* SourceReader::getModule(const std::filesystem::path& p_Path) const
 {
-    const uint32_t l_Index = getModuleIndex(p_FileName);
+    const uint32_t l_Index = getModuleIndex(p_Path);
     if (l_Index != UINT32_MAX)
     {
         return &m_ModuleFiles[l_Index];
@@ -37,87 +84,287 @@ const SourceReader::ModuleFile* SourceReader::getModule(const std::string_view p
     return nullptr;
 }
 
-uint32_t SourceReader::getModuleIndex(const std::string_view p_FileName) const
+uint32_t SourceReader::getModuleIndex(const std::filesystem::path& p_Path) const
+{
+    const std::filesystem::path l_Path = m_WorkingDir / p_Path;
+    const auto l_Lexical = m_ModuleIndices.find(getModuleKey(l_Path));
+    if (l_Lexical != m_ModuleIndices.end())
+    {
+        return l_Lexical->second != c_ModuleInProgress ? l_Lexical->second : UINT32_MAX;
+    }
+    std::error_code l_Error;
+    const std::filesystem::path l_Canonical = std::filesystem::weakly_canonical(l_Path, l_Error);
+    const auto l_Found = l_Error ? m_CanonicalIndices.end() : m_CanonicalIndices.find(l_Canonical.string());
+    if (l_Found != m_CanonicalIndices.end() && l_Found->second != c_ModuleInProgress)
+    {
+        return l_Found->second;
+    }
+    return UINT32_MAX;
+}
+
+bool SourceReader::reloadModule(const uint32_t p_Index)
+{
+    ModuleFile& l_Module = m_ModuleFiles[p_Index];
+    LoadedModule l_Loaded = loadModule(l_Module.fileName);
+    if (l_Loaded.module.importNames != l_Module.importNames)
+    {
+        return false;
+    }
+    // Same imports resolve to the same modules
+    l_Loaded.module.dependencies = std::move(l_Module.dependencies);
+    l_Module = std::move(l_Loaded.module);
+    return true;
+}
+
+std::string SourceReader::getModuleKey(const std::filesystem::path& p_Path) const
+{
+    return (m_WorkingDir / p_Path).lexically_normal().string();
+}
+
+bool SourceReader::fileExists(const std::filesystem::path& p_Path)
 {
-    for (uint32_t l_Index = 0; l_Index < m_ModuleFiles.size(); ++l_Index)
+    const std::filesystem::path l_Directory = p_Path.parent_path();
+    std::lock_guard l_Lock{ m_DirectoryMutex };
+    auto l_Listing = m_DirectoryListings.find(l_Directory.string());
+    if (l_Listing == m_DirectoryListings.end())
     {
-        if (m_ModuleFiles[l_Index].fileName.filename() == p_FileName)
+        std::unordered_set<std::string> l_Names;
+        std::error_code l_Error;
+        for (std::filesystem::directory_iterator l_Entry{ l_Directory.empty() ? "." : l_Directory, l_Error }; !l_Error && l_Entry != std::filesystem::directory_iterator{}; l_Entry.increment(l_Error))
         {
-            return l_Index;
+            l_Names.insert(l_Entry->path().filename().string());
         }
+        l_Listing = m_DirectoryListings.emplace(l_Directory.string(), std::move(l_Names)).first;
     }
-    return UINT32_MAX;
+    return l_Listing->second.contains(p_Path.filename().string());
+}
+
+std::filesystem::path SourceReader::resolveDependency(const std::string& p_Dependency, const std::filesystem::path& p_ImporterDir)
+{
+    // Imports are looked up in the working directory first, then next to the importing module
+    std::filesystem::path l_Path = m_WorkingDir / (p_Dependency + ".py");
+    if (!fileExists(l_Path))
+    {
+        l_Path = p_ImporterDir / (p_Dependency + ".py");
+    }
+    return l_Path;
 }
 
 uint32_t SourceReader::parseModule(const std::filesystem::path& p_FileName)
 {
-    uint32_t l_Index = getModuleIndex(p_FileName.filename().string());
-    if (l_Index != UINT32_MAX)
+    const std::string l_Key = getModuleKey(p_FileName);
+    if (const auto l_Known = m_ModuleIndices.find(l_Key); l_Known != m_ModuleIndices.end())
     {
-        return l_Index;
+        if (l_Known->second == c_ModuleInProgress)
+        {
+            throw std::runtime_error("Circular import of module: " + p_FileName.string());
+        }
+        return l_Known->second;
     }
 
-    std::ifstream l_File(p_FileName.c_str());
-    if (!l_File.is_open())
+    std::error_code l_Error;
+    std::string l_CanonicalKey = std::filesystem::weakly_canonical(m_WorkingDir / p_FileName, l_Error).string();
+    if (l_Error)
     {
-        throw std::runtime_error("Could not open file: " + p_FileName.string());
+        l_CanonicalKey = l_Key;
+    }
+    if (const auto l_Known = m_CanonicalIndices.find(l_CanonicalKey); l_Known != m_CanonicalIndices.end())
+    {
+        if (l_Known->second == c_ModuleInProgress)
+        {
+            throw std::runtime_error("Circular import of module: " + p_FileName.string());
+        }
+        m_ModuleIndices.emplace(l_Key, l_Known->second);
+        return l_Known->second;
     }
+    m_ModuleIndices.emplace(l_Key, c_ModuleInProgress);
+    m_CanonicalIndices.emplace(l_CanonicalKey, c_ModuleInProgress);
 
-    ModuleFile l_Module;
-    l_Module.fileName = p_FileName;
+    LoadedModule l_Loaded = loadModule(p_FileName);
+    for (const std::filesystem::path& l_Import : l_Loaded.imports)
+    {
+        l_Loaded.module.dependencies.push_back(parseModule(l_Import));
+    }
 
-    std::unordered_set<std::string> l_Dependencies;
+    const uint32_t l_Index = static_cast<uint32_t>(m_ModuleFiles.size());
+    m_ModuleFiles.push_back(std::move(l_Loaded.module));
+    m_ModuleIndices[l_Key] = l_Index;
+    m_CanonicalIndices[l_CanonicalKey] = l_Index;
+    return l_Index;
+}
 
-    std::string l_Line;
-    bool l_Importing = true;
-    while (std::getline(l_File, l_Line))
+uint32_t SourceReader::requestModule(Discovery& p_Discovery, const std::filesystem::path& p_FileName)
+{
+    const std::string l_Key = getModuleKey(p_FileName);
     {
-        if (l_Line.empty())
+        std::lock_guard l_Lock{ p_Discovery.mutex };
+        if (const auto l_Known = p_Discovery.lexicalKeys.find(l_Key); l_Known != p_Discovery.lexicalKeys.end())
         {
-            continue;
+            return l_Known->second;
         }
+    }
 
+    std::error_code l_Error;
+    std::string l_CanonicalKey = std::filesystem::weakly_canonical(m_WorkingDir / p_FileName, l_Error).string();
+    if (l_Error)
+    {
+        l_CanonicalKey = l_Key;
+    }
+
+    uint32_t l_Id;
+    Discovery::PendingModule* l_Pending;
+    {
+        std::lock_guard l_Lock{ p_Discovery.mutex };
+        // Another task may have requested the same module meanwhile, under either key
+        if (const auto l_Known = p_Discovery.lexicalKeys.find(l_Key); l_Known != p_Discovery.lexicalKeys.end())
+        {
+            return l_Known->second;
+        }
+        if (const auto l_Known = p_Discovery.canonicalKeys.find(l_CanonicalKey); l_Known != p_Discovery.canonicalKeys.end())
+        {
+            p_Discovery.lexicalKeys.emplace(l_Key, l_Known->second);
+            return l_Known->second;
+        }
+        l_Id = static_cast<uint32_t>(p_Discovery.modules.size());
+        l_Pending = &p_Discovery.modules.emplace_back();
+        l_Pending->fileName = p_FileName;
+        p_Discovery.lexicalKeys.emplace(l_Key, l_Id);
+        p_Discovery.canonicalKeys.emplace(l_CanonicalKey, l_Id);
+    }
+
+    p_Discovery.scheduler.submit([this, &p_Discovery, l_Pending]
+    {
+        try
+        {
+            l_Pending->loaded = loadModule(l_Pending->fileName);
+        }
+        catch (...)
+        {
+            l_Pending->error = std::current_exception();
+            return;
+        }
+        for (const std::filesystem::path& l_Import : l_Pending->loaded.imports)
+        {
+            l_Pending->imports.push_back(requestModule(p_Discovery, l_Import));
+        }
+    });
+    return l_Id;
+}
+
+uint32_t SourceReader::placeModule(Discovery& p_Discovery, const uint32_t p_Pending)
+{
+    Discovery::PendingModule& l_Pending = p_Discovery.modules[p_Pending];
+    if (l_Pending.index == c_ModuleInProgress)
+    {
+        throw std::runtime_error("Circular import of module: " + l_Pending.fileName.string());
+    }
+    if (l_Pending.index != UINT32_MAX)
+    {
+        return l_Pending.index;
+    }
+    if (l_Pending.error)
+    {
+        std::rethrow_exception(l_Pending.error);
+    }
+
+    l_Pending.index = c_ModuleInProgress;
+    for (const uint32_t l_Import : l_Pending.imports)
+    {
+        l_Pending.loaded.module.dependencies.push_back(placeModule(p_Discovery, l_Import));
+    }
+    l_Pending.index = static_cast<uint32_t>(m_ModuleFiles.size());
+    m_ModuleFiles.push_back(std::move(l_Pending.loaded.module));
+    return l_Pending.index;
+}
+
+SourceReader::LoadedModule SourceReader::loadModule(const std::filesystem::path& p_FileName)
+{
+    LoadedModule l_Loaded;
+    ModuleFile& l_Module = l_Loaded.module;
+    l_Module.fileName = p_FileName;
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::FILE_LOAD, p_FileName };
+        l_Module.source = MappedFile{ p_FileName };
+        l_Module.source.ensureTrailingNewline();
+        l_Module.contentHash = TokenCache::hashContents(l_Module.source.getContents());
+    }
+    const std::string_view l_Contents = l_Module.source.getContents();
+    Instrumentation::count(Instrumentation::MODULES);
+    Instrumentation::count(Instrumentation::BYTES_READ, l_Contents.size());
+    if (m_Cache != nullptr)
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::CACHE, p_FileName };
+        l_Module.cacheEntry = m_Cache->find(l_Module.contentHash, l_Contents.size());
+    }
+    const Instrumentation::ScopedTimer l_Timer{ Instrumentation::IMPORT_SCAN, p_FileName };
+    if (l_Module.cacheEntry)
+    {
+        // Only modules that passed the checks below were stored
+        l_Module.fileContent = l_Contents.substr(l_Module.cacheEntry->bodyOffset);
+        l_Module.firstLine = l_Module.cacheEntry->firstLine;
+        l_Module.importNames = l_Module.cacheEntry->imports;
+        resolveImports(l_Loaded);
+        return l_Loaded;
+    }
+
+    std::unordered_set<std::string> l_Dependencies;
+
+    // The import header is every line up to the first one that is neither empty nor an import. The body is the rest
+    // of the file, handed out as a view
+    size_t l_BodyStart = l_Contents.size();
+    for (size_t l_LineStart = 0; l_LineStart < l_Contents.size();)
+    {
+        const size_t l_LineEnd = l_Contents.find('\n', l_LineStart);
+        const std::string_view l_Line = l_Contents.substr(l_LineStart, l_LineEnd - l_LineStart);
         if (l_Line.starts_with("import") || l_Line.starts_with("from"))
         {
-            std::string moduleName = l_Line.substr(l_Line.find_first_of(' ') + 1);
+            std::string_view moduleName = l_Line.substr(l_Line.find_first_of(' ') + 1);
             moduleName = moduleName.substr(0, moduleName.find_first_of(' '));
-            std::ranges::replace(moduleName, '.', '/');
-            l_Dependencies.insert(moduleName);
-
-            if (!l_Importing)
-            {
-                throw std::runtime_error("Import statement found outside of import section in file: " + p_FileName.string() + ".\nAll imports in a module must be at the beginning of the file.");
-            }
+            std::string l_Dependency{ moduleName };
+            std::ranges::replace(l_Dependency, '.', '/');
+            l_Dependencies.insert(std::move(l_Dependency));
         }
-        else
+        else if (!l_Line.empty())
         {
-            l_Module.fileContent += l_Line + '\n';
-            l_Importing = false;
+            l_BodyStart = l_LineStart;
+            break;
         }
+        l_LineStart = l_LineEnd + 1;
+        l_Module.firstLine++;
     }
+    l_Module.fileContent = l_Contents.substr(l_BodyStart);
 
-    for (const std::string& l_Dep : l_Dependencies)
+    if (l_Module.fileContent.find("\nimport") != std::string_view::npos || l_Module.fileContent.find("\nfrom") != std::string_view::npos)
     {
-        std::filesystem::path depPath = m_WorkingDir / (l_Dep + ".py");
-        if (s_StdModules.contains(l_Dep))
+        throw std::runtime_error("Import statement found outside of import section in file: " + p_FileName.string() + ".\nAll imports in a module must be at the beginning of the file.");
+    }
+
+    l_Module.importNames.assign(l_Dependencies.begin(), l_Dependencies.end());
+    resolveImports(l_Loaded);
+    return l_Loaded;
+}
+
+const std::string* SourceReader::findStdModule(const std::string& p_Name)
+{
+    const auto l_Found = s_StdModules.find(p_Name);
+    return l_Found == s_StdModules.end() ? nullptr : &l_Found->second;
+}
+
+void SourceReader::resolveImports(LoadedModule& p_Loaded)
+{
+    ModuleFile& l_Module = p_Loaded.module;
+    for (const std::string& l_Dep : l_Module.importNames)
+    {
+        if (const std::string* l_Header = findStdModule(l_Dep))
         {
-            const std::string& l_ModuleName = s_StdModules.at(l_Dep);
-            if (!l_ModuleName.empty())
+            if (!l_Header->empty())
             {
-                l_Module.stdDependencies.push_back(s_StdModules.at(l_Dep));
+                l_Module.stdDependencies.push_back(*l_Header);
             }
         }
         else
         {
-            if (!std::filesystem::exists(depPath))
-            {
-                std::filesystem::path l_LocalDir = p_FileName.parent_path();
-                depPath = l_LocalDir / (l_Dep + ".py");
-            }
-            l_Module.dependencies.push_back(parseModule(depPath));
+            p_Loaded.imports.push_back(resolveDependency(l_Dep, l_Module.fileName.parent_path()));
         }
     }
-
-    m_ModuleFiles.push_back(std::move(l_Module));
-    return m_ModuleFiles.size() - 1;
 }
@@ -1,35 +1,91 @@
 #pragma once
 #include <filesystem>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "mapped_file.hpp"
+#include "../cache/token_cache.hpp"
+
+class TaskScheduler;
+
 class SourceReader
 {
 public:
     struct ModuleFile
     {
         std::filesystem::path fileName;
-        std::string fileContent;
+        MappedFile source;
+        // Module body after the import header, a view into source
+        std::string_view fileContent;
+        // Line number of the first line of fileContent in the file
+        uint32_t firstLine = 1;
         std::vector<uint32_t> dependencies;
         std::vector<std::string> stdDependencies;
+        // Module names in the import header with '.' replaced by '/', in the order they were resolved
+        std::vector<std::string> importNames;
+        // Hash of the whole file, see TokenCache::hashContents
+        uint64_t contentHash = 0;
+        // Only set when reading with a token cache, if it had an entry for the file
+        std::optional<TokenCache::Entry> cacheEntry;
     };
 
-    explicit SourceReader(const std::filesystem::path& p_MainFile, const std::filesystem::path& p_WorkingDir = {});
+    // With a scheduler, modules are read and scanned for imports in parallel. Module indices, dependencies and
+    // errors are the same as without one. With a cache, the import header of modules it has an entry for is taken
+    // from the entry. The module table is allocated from p_Memory, paths and names keep to the global heap
+    explicit SourceReader(const std::filesystem::path& p_MainFile, const std::filesystem::path& p_WorkingDir = {}, TaskScheduler* p_Scheduler = nullptr, const TokenCache* p_Cache = nullptr, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
 
     [[nodiscard]] uint32_t getModuleCount() const { return static_cast<uint32_t>(m_ModuleFiles.size()); }
     [[nodiscard]] const std::filesystem::path& getWorkingDir() const { return m_WorkingDir; }
 
     const ModuleFile* getModule(uint32_t p_Index) const;
-    const ModuleFile* getModule(std::string_view p_FileName) const;
-    [[nodiscard]] uint32_t getModuleIndex(std::string_view p_FileName) const;
+    // Relative paths are taken from the working directory
+    const ModuleFile* getModule(const std::filesystem::path& p_Path) const;
+    [[nodiscard]] uint32_t getModuleIndex(const std::filesystem::path& p_Path) const;
+    // Reads the module's file again. Returns false and keeps the module as it was if its import header changed, since
+    // the module graph then has to be discovered again. Throws like the constructor if the file cannot be read
+    bool reloadModule(uint32_t p_Index);
+
+    // Absolute, lexically normal path, which is how modules are told apart
+    [[nodiscard]] std::string getModuleKey(const std::filesystem::path& p_Path) const;
+    // Header standing in for a standard Python module, empty if it needs none, or nullptr if p_Name is not one
+    [[nodiscard]] static const std::string* findStdModule(const std::string& p_Name);
 
 private:
+    // A module read from disk, with its imports resolved to paths but not yet to module indices
+    struct LoadedModule
+    {
+        ModuleFile module;
+        std::vector<std::filesystem::path> imports;
+    };
+    struct Discovery;
+
     uint32_t parseModule(const std::filesystem::path& p_FileName);
+    LoadedModule loadModule(const std::filesystem::path& p_FileName);
+    void resolveImports(LoadedModule& p_Loaded);
+    uint32_t requestModule(Discovery& p_Discovery, const std::filesystem::path& p_FileName);
+    uint32_t placeModule(Discovery& p_Discovery, uint32_t p_Pending);
+    std::filesystem::path resolveDependency(const std::string& p_Dependency, const std::filesystem::path& p_ImporterDir);
+    bool fileExists(const std::filesystem::path& p_Path);
 
-    std::vector<ModuleFile> m_ModuleFiles;
+    std::pmr::vector<ModuleFile> m_ModuleFiles;
     std::filesystem::path m_WorkingDir;
+    const TokenCache* m_Cache;
+
+    // Module indices by absolute, lexically normal path, and by canonical path so that two spellings of the same file
+    // (symlinks, '..') load it once. Canonicalizing touches the file system, so it only happens on a lexical miss
+    std::unordered_map<std::string, uint32_t> m_ModuleIndices;
+    std::unordered_map<std::string, uint32_t> m_CanonicalIndices;
+    static constexpr uint32_t c_ModuleInProgress = UINT32_MAX - 1;
+
+    // Names in every directory probed while resolving imports, listed once per directory
+    std::unordered_map<std::string, std::unordered_set<std::string>> m_DirectoryListings;
+    std::mutex m_DirectoryMutex;
 
     inline static const std::unordered_map<std::string, std::string> s_StdModules = {
         {"__future__", ""},
@@ -0,0 +1,209 @@
+#include "number_scanner.hpp"
+
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    bool isDigit(const char p_Char, const int p_Base)
+    {
+        switch (p_Base)
+        {
+        case 2: return p_Char == '0' || p_Char == '1';
+        case 8: return p_Char >= '0' && p_Char <= '7';
+        case 16: return (p_Char >= '0' && p_Char <= '9') || (p_Char >= 'a' && p_Char <= 'f') || (p_Char >= 'A' && p_Char <= 'F');
+        default: return p_Char >= '0' && p_Char <= '9';
+        }
+    }
+
+    // digit (["_"] digit)*, returns the position after the last digit. A trailing '_' is not part of the literal
+    uint32_t scanDigits(const std::string_view p_Text, uint32_t p_Position, const int p_Base)
+    {
+        while (p_Position < p_Text.size())
+        {
+            if (isDigit(p_Text[p_Position], p_Base))
+            {
+                p_Position++;
+            }
+            else if (p_Text[p_Position] == '_' && p_Position + 1 < p_Text.size() && isDigit(p_Text[p_Position + 1], p_Base))
+            {
+                p_Position += 2;
+            }
+            else
+            {
+                break;
+            }
+        }
+        return p_Position;
+    }
+
+    // Copies the literal without its '_' separators, which neither from_chars nor strtod accept
+    class DigitBuffer
+    {
+    public:
+        explicit DigitBuffer(const std::string_view p_Text)
+            : m_Heap(p_Text.size() < sizeof(m_Inline) ? 0 : p_Text.size() + 1, '\0')
+        {
+            char* l_Out = m_Heap.empty() ? m_Inline : m_Heap.data();
+            m_Begin = l_Out;
+            for (const char l_Char : p_Text)
+            {
+                if (l_Char != '_')
+                {
+                    *l_Out++ = l_Char;
+                }
+            }
+            *l_Out = '\0';
+            m_End = l_Out;
+        }
+
+        [[nodiscard]] const char* begin() const { return m_Begin; }
+        [[nodiscard]] const char* end() const { return m_End; }
+
+    private:
+        char m_Inline[64];
+        std::string m_Heap;
+        const char* m_Begin;
+        const char* m_End;
+    };
+
+    // The longest literal at the start of p_Text
+    NumberScanner::Result scanLiteral(const std::string_view p_Text)
+    {
+        NumberScanner::Result l_Result{ .status = NumberScanner::VALID, .length = 0, .literal = {} };
+
+        // 0x / 0o / 0b integers
+        if (p_Text.size() > 1 && p_Text[0] == '0')
+        {
+            int l_Base = 0;
+            switch (p_Text[1])
+            {
+            case 'x': case 'X': l_Base = 16; break;
+            case 'o': case 'O': l_Base = 8; break;
+            case 'b': case 'B': l_Base = 2; break;
+            default: break;
+            }
+            if (l_Base != 0)
+            {
+                // The separator may also follow the prefix: 0x_FF
+                uint32_t l_Start = 2;
+                if (l_Start + 1 < p_Text.size() && p_Text[l_Start] == '_' && isDigit(p_Text[l_Start + 1], l_Base))
+                {
+                    l_Start++;
+                }
+                if (l_Start >= p_Text.size() || !isDigit(p_Text[l_Start], l_Base))
+                {
+                    l_Result.status = NumberScanner::MALFORMED;
+                    l_Result.length = 2;
+                    return l_Result;
+                }
+                l_Result.length = scanDigits(p_Text, l_Start, l_Base);
+                const DigitBuffer l_Digits{ p_Text.substr(l_Start, l_Result.length - l_Start) };
+                const std::from_chars_result l_Parse = std::from_chars(l_Digits.begin(), l_Digits.end(), l_Result.literal.integer, l_Base);
+                if (l_Parse.ec != std::errc{})
+                {
+                    l_Result.status = NumberScanner::OUT_OF_RANGE;
+                }
+                return l_Result;
+            }
+        }
+
+        // Decimal integer part, fraction, exponent and imaginary suffix
+        uint32_t l_Position = 0;
+        bool l_Float = false;
+        if (p_Text[0] != '.')
+        {
+            l_Position = scanDigits(p_Text, 0, 10);
+        }
+        if (l_Position < p_Text.size() && p_Text[l_Position] == '.')
+        {
+            l_Float = true;
+            l_Position++;
+            if (l_Position < p_Text.size() && isDigit(p_Text[l_Position], 10))
+            {
+                l_Position = scanDigits(p_Text, l_Position, 10);
+            }
+        }
+        if (l_Position < p_Text.size() && (p_Text[l_Position] == 'e' || p_Text[l_Position] == 'E'))
+        {
+            // Only part of the literal if digits follow, otherwise the 'e' starts whatever comes next
+            uint32_t l_Exponent = l_Position + 1;
+            if (l_Exponent < p_Text.size() && (p_Text[l_Exponent] == '+' || p_Text[l_Exponent] == '-'))
+            {
+                l_Exponent++;
+            }
+            if (l_Exponent < p_Text.size() && isDigit(p_Text[l_Exponent], 10))
+            {
+                l_Float = true;
+                l_Position = scanDigits(p_Text, l_Exponent, 10);
+            }
+        }
+        const uint32_t l_NumberEnd = l_Position;
+        if (l_Position < p_Text.size() && (p_Text[l_Position] == 'j' || p_Text[l_Position] == 'J'))
+        {
+            l_Result.literal.kind = NumberLiteral::IMAGINARY;
+            l_Position++;
+        }
+        else
+        {
+            l_Result.literal.kind = l_Float ? NumberLiteral::FLOAT : NumberLiteral::INTEGER;
+        }
+        l_Result.length = l_Position;
+
+        const DigitBuffer l_Digits{ p_Text.substr(0, l_NumberEnd) };
+        if (l_Result.literal.kind == NumberLiteral::INTEGER)
+        {
+            // Python rejects leading zeros on non-zero decimal integers (they used to mean octal)
+            if (p_Text[0] == '0' && std::string_view(l_Digits.begin(), l_Digits.end()).find_first_not_of('0') != std::string_view::npos)
+            {
+                l_Result.status = NumberScanner::MALFORMED;
+                return l_Result;
+            }
+            const std::from_chars_result l_Parse = std::from_chars(l_Digits.begin(), l_Digits.end(), l_Result.literal.integer);
+            if (l_Parse.ec != std::errc{})
+            {
+                l_Result.status = NumberScanner::OUT_OF_RANGE;
+            }
+            return l_Result;
+        }
+
+        const std::from_chars_result l_Parse = std::from_chars(l_Digits.begin(), l_Digits.end(), l_Result.literal.real);
+        if (l_Parse.ec == std::errc::result_out_of_range)
+        {
+            // Python rounds to inf or 0 instead of rejecting the literal, which is what strtod does
+            l_Result.literal.real = std::strtod(l_Digits.begin(), nullptr);
+        }
+        else if (l_Parse.ec != std::errc{} || l_Parse.ptr != l_Digits.end())
+        {
+            l_Result.status = NumberScanner::MALFORMED;
+        }
+        return l_Result;
+    }
+}
+
+bool NumberScanner::startsNumber(const std::string_view p_Text)
+{
+    if (p_Text.empty())
+    {
+        return false;
+    }
+    if (p_Text[0] == '.')
+    {
+        return p_Text.size() > 1 && isDigit(p_Text[1], 10);
+    }
+    return isDigit(p_Text[0], 10);
+}
+
+NumberScanner::Result NumberScanner::scan(const std::string_view p_Text)
+{
+    Result l_Result = scanLiteral(p_Text);
+    // A fraction glued to a complete literal (1.2.3, 0x1.5) does not start another number, the whole run is malformed
+    // like 12abc is
+    while (l_Result.length + 1 < p_Text.size() && p_Text[l_Result.length] == '.' && isDigit(p_Text[l_Result.length + 1], 10))
+    {
+        l_Result.status = MALFORMED;
+        l_Result.length += scanLiteral(p_Text.substr(l_Result.length)).length;
+    }
+    return l_Result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+struct NumberLiteral
+{
+    enum Kind: uint8_t
+    {
+        INTEGER,
+        FLOAT,
+        IMAGINARY
+    };
+
+    Kind kind = INTEGER;
+    int64_t integer = 0;
+    // Value of a FLOAT literal, or the imaginary part of an IMAGINARY one
+    double real = 0.0;
+};
+
+// Scanner for Python numeric literals: decimal, hexadecimal, octal and binary integers, floats with fraction and/or
+// exponent, '_' digit separators and the 'j' imaginary suffix. Never throws, malformed literals are reported in the result
+class NumberScanner
+{
+public:
+    enum Status: uint8_t
+    {
+        VALID,
+        MALFORMED,
+        OUT_OF_RANGE
+    };
+
+    struct Result
+    {
+        Status status;
+        uint32_t length;
+        NumberLiteral literal;
+    };
+
+    // p_Text must start with a digit, or with '.' followed by a digit. Scans the longest literal at its start,
+    // and reports it MALFORMED along with any '.' and digits glued to its end
+    [[nodiscard]] static Result scan(std::string_view p_Text);
+
+    [[nodiscard]] static bool startsNumber(std::string_view p_Text);
+};
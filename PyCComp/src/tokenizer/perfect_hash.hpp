@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+// Fixed string -> value map whose layout is computed at compile time. The constructor searches for a hash seed
+// that sends every key to its own slot, so a lookup is one hash, one slot load and one string compare
+template<typename T, size_t N>
+class PerfectHashMap
+{
+public:
+    struct Entry
+    {
+        std::string_view key;
+        T value;
+    };
+
+    constexpr PerfectHashMap(const std::array<Entry, N>& p_Entries, const T p_Missing)
+    {
+        for (uint32_t l_Seed = 1; l_Seed < c_MaxSeedAttempts; ++l_Seed)
+        {
+            if (tryBuild(p_Entries, p_Missing, l_Seed))
+            {
+                m_Seed = l_Seed;
+                return;
+            }
+        }
+        throw "No perfect hash seed found for the given keys";
+    }
+
+    [[nodiscard]] constexpr T find(const std::string_view p_Key) const
+    {
+        const Entry& l_Slot = m_Slots[hash(p_Key, m_Seed) & (c_SlotCount - 1)];
+        return l_Slot.key == p_Key ? l_Slot.value : m_Missing;
+    }
+
+private:
+    static constexpr size_t c_SlotCount = std::bit_ceil(N * 4 + 1);
+    static constexpr uint32_t c_MaxSeedAttempts = 1 << 16;
+
+    [[nodiscard]] static constexpr uint32_t hash(const std::string_view p_Key, const uint32_t p_Seed)
+    {
+        // Seeded FNV-1a, the keys are a handful of characters long
+        uint32_t l_Hash = 2166136261u ^ p_Seed;
+        for (const char l_Char : p_Key)
+        {
+            l_Hash = (l_Hash ^ static_cast<uint8_t>(l_Char)) * 16777619u;
+        }
+        return l_Hash ^ (l_Hash >> 15);
+    }
+
+    constexpr bool tryBuild(const std::array<Entry, N>& p_Entries, const T p_Missing, const uint32_t p_Seed)
+    {
+        m_Missing = p_Missing;
+        for (Entry& l_Slot : m_Slots)
+        {
+            l_Slot = { {}, p_Missing };
+        }
+        for (const Entry& l_Entry : p_Entries)
+        {
+            if (l_Entry.key.empty())
+            {
+                continue;
+            }
+            Entry& l_Slot = m_Slots[hash(l_Entry.key, p_Seed) & (c_SlotCount - 1)];
+            if (!l_Slot.key.empty())
+            {
+                return false;
+            }
+            l_Slot = l_Entry;
+        }
+        return true;
+    }
+
+    std::array<Entry, c_SlotCount> m_Slots{};
+    uint32_t m_Seed = 0;
+    T m_Missing{};
+};
+
+template<typename T, size_t S1, size_t S2>
+constexpr PerfectHashMap<T, S1 + S2> makePerfectHashMap(const std::array<const char*, S1>& p_First, const T p_FirstValue, const std::array<const char*, S2>& p_Second, const T p_SecondValue, const T p_Missing)
+{
+    // Lists may be declared larger than their initializer, the trailing null entries are left out
+    std::array<typename PerfectHashMap<T, S1 + S2>::Entry, S1 + S2> l_Entries{};
+    for (size_t l_Index = 0; l_Index < S1; ++l_Index)
+    {
+        if (p_First[l_Index] != nullptr)
+        {
+            l_Entries[l_Index] = { p_First[l_Index], p_FirstValue };
+        }
+    }
+    for (size_t l_Index = 0; l_Index < S2; ++l_Index)
+    {
+        if (p_Second[l_Index] != nullptr)
+        {
+            l_Entries[S1 + l_Index] = { p_Second[l_Index], p_SecondValue };
+        }
+    }
+    return PerfectHashMap<T, S1 + S2>{ l_Entries, p_Missing };
+}
+
+template<typename T, size_t S>
+constexpr PerfectHashMap<T, S> makePerfectHashMap(const std::array<const char*, S>& p_Keys, const T p_Value, const T p_Missing)
+{
+    return makePerfectHashMap(p_Keys, p_Value, std::array<const char*, 0>{}, p_Value, p_Missing);
+}
@@ -0,0 +1,279 @@
+#include "run_scanner.hpp"
+
+#include <bit>
+#include <cstdint>
+
+#include "tokenizer.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PYCCOMP_RUN_SCANNER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PYCCOMP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PYCCOMP_TARGET_AVX2
+#endif
+
+namespace
+{
+    struct Kernels
+    {
+        const char* (*skipWord)(const char*, const char*);
+        const char* (*skipSpaces)(const char*, const char*);
+        const char* (*findByte)(const char*, const char*, char);
+        const char* (*findEither)(const char*, const char*, char, char);
+        const char* name;
+    };
+
+    const char* skipWordScalar(const char* p_Begin, const char* p_End)
+    {
+        while (p_Begin != p_End && (Tokenizer::getCharClass(*p_Begin) & Tokenizer::CHAR_WORD))
+        {
+            ++p_Begin;
+        }
+        return p_Begin;
+    }
+
+    const char* skipSpacesScalar(const char* p_Begin, const char* p_End)
+    {
+        while (p_Begin != p_End && *p_Begin == ' ')
+        {
+            ++p_Begin;
+        }
+        return p_Begin;
+    }
+
+    const char* findByteScalar(const char* p_Begin, const char* p_End, const char p_Byte)
+    {
+        while (p_Begin != p_End && *p_Begin != p_Byte)
+        {
+            ++p_Begin;
+        }
+        return p_Begin;
+    }
+
+    const char* findEitherScalar(const char* p_Begin, const char* p_End, const char p_First, const char p_Second)
+    {
+        while (p_Begin != p_End && *p_Begin != p_First && *p_Begin != p_Second)
+        {
+            ++p_Begin;
+        }
+        return p_Begin;
+    }
+
+#ifdef PYCCOMP_RUN_SCANNER_X86
+    // Each kernel computes a bitmask of the bytes that end the run, one block at a time, and finishes the last
+    // partial block with the scalar version so no load reads past p_End
+
+    __m128i wordMaskSse2(const __m128i p_Bytes)
+    {
+        const __m128i l_Zero = _mm_setzero_si128();
+        const __m128i l_Lower = _mm_or_si128(p_Bytes, _mm_set1_epi8(0x20));
+        const __m128i l_Letter = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(l_Lower, _mm_set1_epi8('a')), _mm_set1_epi8(25)), l_Zero);
+        const __m128i l_Digit = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(p_Bytes, _mm_set1_epi8('0')), _mm_set1_epi8(9)), l_Zero);
+        const __m128i l_Underscore = _mm_cmpeq_epi8(p_Bytes, _mm_set1_epi8('_'));
+        return _mm_or_si128(_mm_or_si128(l_Letter, l_Digit), l_Underscore);
+    }
+
+    const char* skipWordSse2(const char* p_Begin, const char* p_End)
+    {
+        for (; p_End - p_Begin >= 16; p_Begin += 16)
+        {
+            const __m128i l_Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_Begin));
+            const uint32_t l_Mask = ~static_cast<uint32_t>(_mm_movemask_epi8(wordMaskSse2(l_Bytes))) & 0xFFFF;
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return skipWordScalar(p_Begin, p_End);
+    }
+
+    const char* skipSpacesSse2(const char* p_Begin, const char* p_End)
+    {
+        const __m128i l_Space = _mm_set1_epi8(' ');
+        for (; p_End - p_Begin >= 16; p_Begin += 16)
+        {
+            const __m128i l_Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_Begin));
+            const uint32_t l_Mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l_Bytes, l_Space))) & 0xFFFF;
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return skipSpacesScalar(p_Begin, p_End);
+    }
+
+    const char* findByteSse2(const char* p_Begin, const char* p_End, const char p_Byte)
+    {
+        const __m128i l_Needle = _mm_set1_epi8(p_Byte);
+        for (; p_End - p_Begin >= 16; p_Begin += 16)
+        {
+            const __m128i l_Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_Begin));
+            const uint32_t l_Mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l_Bytes, l_Needle)));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return findByteScalar(p_Begin, p_End, p_Byte);
+    }
+
+    const char* findEitherSse2(const char* p_Begin, const char* p_End, const char p_First, const char p_Second)
+    {
+        const __m128i l_First = _mm_set1_epi8(p_First);
+        const __m128i l_Second = _mm_set1_epi8(p_Second);
+        for (; p_End - p_Begin >= 16; p_Begin += 16)
+        {
+            const __m128i l_Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_Begin));
+            const __m128i l_Match = _mm_or_si128(_mm_cmpeq_epi8(l_Bytes, l_First), _mm_cmpeq_epi8(l_Bytes, l_Second));
+            const uint32_t l_Mask = static_cast<uint32_t>(_mm_movemask_epi8(l_Match));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return findEitherScalar(p_Begin, p_End, p_First, p_Second);
+    }
+
+    PYCCOMP_TARGET_AVX2 __m256i wordMaskAvx2(const __m256i p_Bytes)
+    {
+        const __m256i l_Zero = _mm256_setzero_si256();
+        const __m256i l_Lower = _mm256_or_si256(p_Bytes, _mm256_set1_epi8(0x20));
+        const __m256i l_Letter = _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_sub_epi8(l_Lower, _mm256_set1_epi8('a')), _mm256_set1_epi8(25)), l_Zero);
+        const __m256i l_Digit = _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_sub_epi8(p_Bytes, _mm256_set1_epi8('0')), _mm256_set1_epi8(9)), l_Zero);
+        const __m256i l_Underscore = _mm256_cmpeq_epi8(p_Bytes, _mm256_set1_epi8('_'));
+        return _mm256_or_si256(_mm256_or_si256(l_Letter, l_Digit), l_Underscore);
+    }
+
+    PYCCOMP_TARGET_AVX2 const char* skipWordAvx2(const char* p_Begin, const char* p_End)
+    {
+        for (; p_End - p_Begin >= 32; p_Begin += 32)
+        {
+            const __m256i l_Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_Begin));
+            const uint32_t l_Mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(wordMaskAvx2(l_Bytes)));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return skipWordSse2(p_Begin, p_End);
+    }
+
+    PYCCOMP_TARGET_AVX2 const char* skipSpacesAvx2(const char* p_Begin, const char* p_End)
+    {
+        const __m256i l_Space = _mm256_set1_epi8(' ');
+        for (; p_End - p_Begin >= 32; p_Begin += 32)
+        {
+            const __m256i l_Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_Begin));
+            const uint32_t l_Mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(l_Bytes, l_Space)));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return skipSpacesSse2(p_Begin, p_End);
+    }
+
+    PYCCOMP_TARGET_AVX2 const char* findByteAvx2(const char* p_Begin, const char* p_End, const char p_Byte)
+    {
+        const __m256i l_Needle = _mm256_set1_epi8(p_Byte);
+        for (; p_End - p_Begin >= 32; p_Begin += 32)
+        {
+            const __m256i l_Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_Begin));
+            const uint32_t l_Mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(l_Bytes, l_Needle)));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return findByteSse2(p_Begin, p_End, p_Byte);
+    }
+
+    PYCCOMP_TARGET_AVX2 const char* findEitherAvx2(const char* p_Begin, const char* p_End, const char p_First, const char p_Second)
+    {
+        const __m256i l_First = _mm256_set1_epi8(p_First);
+        const __m256i l_Second = _mm256_set1_epi8(p_Second);
+        for (; p_End - p_Begin >= 32; p_Begin += 32)
+        {
+            const __m256i l_Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_Begin));
+            const __m256i l_Match = _mm256_or_si256(_mm256_cmpeq_epi8(l_Bytes, l_First), _mm256_cmpeq_epi8(l_Bytes, l_Second));
+            const uint32_t l_Mask = static_cast<uint32_t>(_mm256_movemask_epi8(l_Match));
+            if (l_Mask != 0)
+            {
+                return p_Begin + std::countr_zero(l_Mask);
+            }
+        }
+        return findEitherSse2(p_Begin, p_End, p_First, p_Second);
+    }
+
+    bool cpuSupportsAvx2()
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        // The kernels are selected during static initialization, possibly before libgcc has read the CPU features
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+        int l_Info[4];
+        __cpuid(l_Info, 0);
+        if (l_Info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(l_Info, 1);
+        // The OS has to save the YMM registers on context switches
+        const bool l_OsSavesYmm = (l_Info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(l_Info, 7, 0);
+        return l_OsSavesYmm && (l_Info[1] & (1 << 5)) != 0;
+#else
+        return false;
+#endif
+    }
+#endif
+
+    Kernels selectKernels()
+    {
+#ifdef PYCCOMP_RUN_SCANNER_X86
+        if (cpuSupportsAvx2())
+        {
+            return { skipWordAvx2, skipSpacesAvx2, findByteAvx2, findEitherAvx2, "avx2" };
+        }
+        // SSE2 is part of the x86-64 baseline
+        return { skipWordSse2, skipSpacesSse2, findByteSse2, findEitherSse2, "sse2" };
+#else
+        return { skipWordScalar, skipSpacesScalar, findByteScalar, findEitherScalar, "scalar" };
+#endif
+    }
+
+    const Kernels c_Kernels = selectKernels();
+}
+
+const char* RunScanner::skipWord(const char* p_Begin, const char* p_End)
+{
+    return c_Kernels.skipWord(p_Begin, p_End);
+}
+
+const char* RunScanner::skipSpaces(const char* p_Begin, const char* p_End)
+{
+    return c_Kernels.skipSpaces(p_Begin, p_End);
+}
+
+const char* RunScanner::findByte(const char* p_Begin, const char* p_End, const char p_Byte)
+{
+    return c_Kernels.findByte(p_Begin, p_End, p_Byte);
+}
+
+const char* RunScanner::findEither(const char* p_Begin, const char* p_End, const char p_First, const char p_Second)
+{
+    return c_Kernels.findEither(p_Begin, p_End, p_First, p_Second);
+}
+
+const char* RunScanner::getImplementationName()
+{
+    return c_Kernels.name;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Kernels that find the end of a run of bytes the lexer would otherwise consume one at a time. Every function returns
+// a pointer to the first byte in [p_Begin, p_End) that ends the run, or p_End if the run reaches the end.
+// The implementation (AVX2, SSE2 or scalar) is chosen once from the features of the running CPU
+class RunScanner
+{
+public:
+    // Identifier characters, as classified by Tokenizer::CHAR_WORD
+    static const char* skipWord(const char* p_Begin, const char* p_End);
+    static const char* skipSpaces(const char* p_Begin, const char* p_End);
+    static const char* findByte(const char* p_Begin, const char* p_End, char p_Byte);
+    static const char* findEither(const char* p_Begin, const char* p_End, char p_First, char p_Second);
+
+    [[nodiscard]] static const char* getImplementationName();
+};
@@ -0,0 +1,158 @@
+#include "symbol_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+SymbolTable::~SymbolTable()
+{
+    for (std::atomic<std::string_view*>& l_Page : m_Pages)
+    {
+        delete[] l_Page.load();
+    }
+}
+
+uint64_t SymbolTable::hash(const std::string_view p_Name)
+{
+    // Mixed so that both the low bits (slots) and the high bits (shards) are usable
+    return static_cast<uint64_t>(std::hash<std::string_view>{}(p_Name)) * 0x9E3779B97F4A7C15ull;
+}
+
+SymbolTable::Symbol SymbolTable::Index::find(const SymbolTable& p_Table, const std::string_view p_Name, const uint64_t p_Hash) const
+{
+    if (m_Slots.empty())
+    {
+        return c_NoSymbol;
+    }
+    const size_t l_Mask = m_Slots.size() - 1;
+    for (size_t l_Slot = p_Hash & l_Mask;; l_Slot = (l_Slot + 1) & l_Mask)
+    {
+        const Slot& l_Entry = m_Slots[l_Slot];
+        if (l_Entry.symbol == c_NoSymbol)
+        {
+            return c_NoSymbol;
+        }
+        if (l_Entry.hash == p_Hash && p_Table.getName(l_Entry.symbol) == p_Name)
+        {
+            return l_Entry.symbol;
+        }
+    }
+}
+
+void SymbolTable::Index::insert(const Symbol p_Symbol, const uint64_t p_Hash)
+{
+    // Kept at most half full
+    if ((m_Count + 1) * 2 > m_Slots.size())
+    {
+        grow();
+    }
+    const size_t l_Mask = m_Slots.size() - 1;
+    size_t l_Slot = p_Hash & l_Mask;
+    while (m_Slots[l_Slot].symbol != c_NoSymbol)
+    {
+        l_Slot = (l_Slot + 1) & l_Mask;
+    }
+    m_Slots[l_Slot] = { .hash = p_Hash, .symbol = p_Symbol };
+    m_Count++;
+}
+
+void SymbolTable::Index::grow()
+{
+    std::vector<Slot> l_Old = std::move(m_Slots);
+    m_Slots.assign(std::max<size_t>(64, l_Old.size() * 2), Slot{});
+    m_Count = 0;
+    for (const Slot& l_Entry : l_Old)
+    {
+        if (l_Entry.symbol != c_NoSymbol)
+        {
+            insert(l_Entry.symbol, l_Entry.hash);
+        }
+    }
+}
+
+SymbolTable::Symbol SymbolTable::find(const std::string_view p_Name) const
+{
+    const uint64_t l_Hash = hash(p_Name);
+    const Shard& l_Shard = m_Shards[l_Hash >> (64 - c_ShardBits)];
+    std::shared_lock l_Lock{ l_Shard.mutex };
+    return l_Shard.index.find(*this, p_Name, l_Hash);
+}
+
+SymbolTable::Symbol SymbolTable::intern(const std::string_view p_Name, const uint64_t p_Hash)
+{
+    Shard& l_Shard = m_Shards[p_Hash >> (64 - c_ShardBits)];
+    {
+        std::shared_lock l_Lock{ l_Shard.mutex };
+        const Symbol l_Found = l_Shard.index.find(*this, p_Name, p_Hash);
+        if (l_Found != c_NoSymbol)
+        {
+            return l_Found;
+        }
+    }
+
+    std::unique_lock l_Lock{ l_Shard.mutex };
+    const Symbol l_Found = l_Shard.index.find(*this, p_Name, p_Hash);
+    if (l_Found != c_NoSymbol)
+    {
+        return l_Found;
+    }
+    const Symbol l_Symbol = m_NextSymbol.fetch_add(1, std::memory_order_acq_rel);
+    if ((l_Symbol >> c_PageBits) >= c_PageCount)
+    {
+        throw std::runtime_error("Too many distinct symbols");
+    }
+
+    std::atomic<std::string_view*>& l_Page = m_Pages[l_Symbol >> c_PageBits];
+    std::string_view* l_Names = l_Page.load(std::memory_order_acquire);
+    if (l_Names == nullptr)
+    {
+        // Whichever shard gets here first allocates the page
+        std::string_view* l_New = new std::string_view[1 << c_PageBits];
+        if (l_Page.compare_exchange_strong(l_Names, l_New, std::memory_order_acq_rel))
+        {
+            l_Names = l_New;
+        }
+        else
+        {
+            delete[] l_New;
+        }
+    }
+
+    l_Names[l_Symbol & ((1 << c_PageBits) - 1)] = store(l_Shard, p_Name);
+    l_Shard.index.insert(l_Symbol, p_Hash);
+    return l_Symbol;
+}
+
+std::string_view SymbolTable::getName(const Symbol p_Symbol) const
+{
+    const std::string_view* l_Names = m_Pages[p_Symbol >> c_PageBits].load(std::memory_order_acquire);
+    return l_Names[p_Symbol & ((1 << c_PageBits) - 1)];
+}
+
+std::string_view SymbolTable::store(Shard& p_Shard, const std::string_view p_Name)
+{
+    if (p_Shard.blockUsed + p_Name.size() > p_Shard.blockSize)
+    {
+        p_Shard.blockSize = std::max(c_BlockSize, p_Name.size());
+        p_Shard.blocks.push_back(std::make_unique<char[]>(p_Shard.blockSize));
+        p_Shard.blockUsed = 0;
+    }
+    char* l_Copy = p_Shard.blocks.back().get() + p_Shard.blockUsed;
+    std::memcpy(l_Copy, p_Name.data(), p_Name.size());
+    p_Shard.blockUsed += p_Name.size();
+    return { l_Copy, p_Name.size() };
+}
+
+SymbolTable::Symbol SymbolCache::intern(const std::string_view p_Name)
+{
+    const uint64_t l_Hash = SymbolTable::hash(p_Name);
+    SymbolTable::Symbol l_Symbol = m_Index.find(m_Table, p_Name, l_Hash);
+    if (l_Symbol == SymbolTable::c_NoSymbol)
+    {
+        l_Symbol = m_Table.intern(p_Name, l_Hash);
+        m_Index.insert(l_Symbol, l_Hash);
+    }
+    return l_Symbol;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+// Interns the names used across every module of a compilation (identifiers, keywords and string literals) as dense
+// 32-bit ids, so that later stages compare names as integers. Safe to use from several threads at once. Ids are handed
+// out in the order names are first seen, which depends on scheduling when modules are tokenized in parallel
+class SymbolTable
+{
+public:
+    using Symbol = uint32_t;
+    static constexpr Symbol c_NoSymbol = UINT32_MAX;
+
+    SymbolTable() = default;
+    ~SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view p_Name) { return intern(p_Name, hash(p_Name)); }
+    Symbol intern(std::string_view p_Name, uint64_t p_Hash);
+    // c_NoSymbol if the name was never interned
+    [[nodiscard]] Symbol find(std::string_view p_Name) const;
+    // The table's own copy, valid for as long as the table
+    [[nodiscard]] std::string_view getName(Symbol p_Symbol) const;
+    [[nodiscard]] uint32_t getSymbolCount() const { return m_NextSymbol.load(std::memory_order_acquire); }
+
+    [[nodiscard]] static uint64_t hash(std::string_view p_Name);
+
+    // Open-addressing set of symbols, compared by hash first and by name only on a hash match
+    class Index
+    {
+    public:
+        [[nodiscard]] Symbol find(const SymbolTable& p_Table, std::string_view p_Name, uint64_t p_Hash) const;
+        void insert(Symbol p_Symbol, uint64_t p_Hash);
+
+    private:
+        struct Slot
+        {
+            uint64_t hash;
+            Symbol symbol = c_NoSymbol;
+        };
+
+        void grow();
+
+        std::vector<Slot> m_Slots;
+        uint32_t m_Count = 0;
+    };
+
+private:
+    // Names are spread over shards by hash so that threads interning different names rarely wait on each other
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        Index index;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t blockUsed = 0;
+        size_t blockSize = 0;
+    };
+
+    std::string_view store(Shard& p_Shard, std::string_view p_Name);
+
+    static constexpr uint32_t c_ShardBits = 6;
+    static constexpr size_t c_BlockSize = 64 * 1024;
+    // Names by id, in pages that never move once allocated, so readers need no lock
+    static constexpr uint32_t c_PageBits = 16;
+    static constexpr uint32_t c_PageCount = 1 << 12;
+
+    std::array<Shard, 1 << c_ShardBits> m_Shards;
+    std::array<std::atomic<std::string_view*>, c_PageCount> m_Pages{};
+    std::atomic<Symbol> m_NextSymbol = 0;
+};
+
+// Front for a SymbolTable used by a single thread. Names repeat a lot within a module, so the shared table and its locks
+// are only reached once per distinct name
+class SymbolCache
+{
+public:
+    explicit SymbolCache(SymbolTable& p_Table) : m_Table(p_Table) {}
+
+    SymbolTable::Symbol intern(std::string_view p_Name);
+
+private:
+    SymbolTable& m_Table;
+    SymbolTable::Index m_Index;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+#include "symbol_table.hpp"
+
+// One lexed token, also known as Tokenizer::Token. Tokenizers keep their tokens in a TokenStream, which stores these
+// fields as separate arrays
+struct Token
+{
+    enum Type: uint8_t
+    {
+        KEYWORD,
+        IDENTIFIER,
+        STRING,
+        NUMBER,
+        BOOLEAN,
+        NONE,
+        OPERATOR,
+        DELIMITER,
+        INDENT,
+        DEDENT,
+        NEWLINE,
+        COMMENT,
+        END
+    };
+    
+    // Where the token text lives: a slice of the source buffer, a length-prefixed entry in the
+    // tokenizer's text pool for text that does not appear verbatim in the source, or for numbers an
+    // entry in the tokenizer's number table, which holds the source slice and the parsed value
+    enum Storage: uint8_t
+    {
+        SOURCE,
+        POOL,
+        NUMBER_TABLE
+    };
+
+    Type type;
+    Storage storage = SOURCE;
+    uint16_t length = 0;
+    uint32_t offset = 0;
+    // Byte offset of the character the lexer was reading when it emitted the token, or the source size for the
+    // tokens emitted at its end. Resolved to a line and column with getLocation
+    uint32_t position;
+    // Interned text of IDENTIFIER, KEYWORD and STRING tokens when the tokenizer was given a symbol table
+    SymbolTable::Symbol symbol = SymbolTable::c_NoSymbol;
+};
+static_assert(sizeof(Token) <= 16);
@@ -0,0 +1,141 @@
+#pragma once
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "token.hpp"
+
+// Tokens stored as parallel arrays rather than as Token records, so that passes looking at one field, like the types
+// when matching brackets or checking indentation, stream through that field alone. Indexing and iterating yield whole
+// Token values, which keeps loops written against a vector of tokens working, but there is no Token to write through
+class TokenStream
+{
+public:
+    // The fields of a token that say where its text lives
+    struct Text
+    {
+        uint32_t offset;
+        uint16_t length;
+        Token::Storage storage;
+    };
+    static_assert(sizeof(Text) == 8);
+
+    class Iterator
+    {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        // Dereferencing yields values, which random access iterators may only do since C++20
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using reference = Token;
+
+        Iterator() = default;
+        Iterator(const TokenStream* p_Stream, const size_t p_Index) : m_Stream(p_Stream), m_Index(p_Index) {}
+
+        Token operator*() const { return (*m_Stream)[m_Index]; }
+        Token operator[](const difference_type p_Offset) const { return (*m_Stream)[m_Index + p_Offset]; }
+
+        Iterator& operator++()
+        {
+            ++m_Index;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            const Iterator l_Previous = *this;
+            ++m_Index;
+            return l_Previous;
+        }
+        Iterator& operator--()
+        {
+            --m_Index;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            const Iterator l_Previous = *this;
+            --m_Index;
+            return l_Previous;
+        }
+        Iterator& operator+=(const difference_type p_Offset)
+        {
+            m_Index += p_Offset;
+            return *this;
+        }
+        Iterator& operator-=(const difference_type p_Offset)
+        {
+            m_Index -= p_Offset;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator p_Iterator, const difference_type p_Offset) { return p_Iterator += p_Offset; }
+        friend Iterator operator+(const difference_type p_Offset, Iterator p_Iterator) { return p_Iterator += p_Offset; }
+        friend Iterator operator-(Iterator p_Iterator, const difference_type p_Offset) { return p_Iterator -= p_Offset; }
+        friend difference_type operator-(const Iterator& p_Left, const Iterator& p_Right) { return static_cast<difference_type>(p_Left.m_Index - p_Right.m_Index); }
+        friend bool operator==(const Iterator& p_Left, const Iterator& p_Right) { return p_Left.m_Index == p_Right.m_Index; }
+        friend std::strong_ordering operator<=>(const Iterator& p_Left, const Iterator& p_Right) { return p_Left.m_Index <=> p_Right.m_Index; }
+
+    private:
+        const TokenStream* m_Stream = nullptr;
+        size_t m_Index = 0;
+    };
+
+    explicit TokenStream(std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource())
+        : m_Types(p_Memory), m_Texts(p_Memory), m_Positions(p_Memory), m_Symbols(p_Memory)
+    {
+    }
+
+    [[nodiscard]] size_t size() const { return m_Types.size(); }
+    [[nodiscard]] bool empty() const { return m_Types.empty(); }
+    [[nodiscard]] Token operator[](const size_t p_Index) const
+    {
+        const Text& l_Text = m_Texts[p_Index];
+        return { .type = m_Types[p_Index], .storage = l_Text.storage, .length = l_Text.length, .offset = l_Text.offset, .position = m_Positions[p_Index], .symbol = m_Symbols[p_Index] };
+    }
+    [[nodiscard]] Token front() const { return (*this)[0]; }
+    [[nodiscard]] Token back() const { return (*this)[size() - 1]; }
+    [[nodiscard]] Iterator begin() const { return { this, 0 }; }
+    [[nodiscard]] Iterator end() const { return { this, size() }; }
+
+    void push_back(const Token& p_Token)
+    {
+        m_Types.push_back(p_Token.type);
+        m_Texts.push_back({ .offset = p_Token.offset, .length = p_Token.length, .storage = p_Token.storage });
+        m_Positions.push_back(p_Token.position);
+        m_Symbols.push_back(p_Token.symbol);
+    }
+    void reserve(const size_t p_Count)
+    {
+        m_Types.reserve(p_Count);
+        m_Texts.reserve(p_Count);
+        m_Positions.reserve(p_Count);
+        m_Symbols.reserve(p_Count);
+    }
+    void eraseFront(const size_t p_Count)
+    {
+        m_Types.erase(m_Types.begin(), m_Types.begin() + static_cast<std::ptrdiff_t>(p_Count));
+        m_Texts.erase(m_Texts.begin(), m_Texts.begin() + static_cast<std::ptrdiff_t>(p_Count));
+        m_Positions.erase(m_Positions.begin(), m_Positions.begin() + static_cast<std::ptrdiff_t>(p_Count));
+        m_Symbols.erase(m_Symbols.begin(), m_Symbols.begin() + static_cast<std::ptrdiff_t>(p_Count));
+    }
+
+    // One field of every token, in token order
+    [[nodiscard]] std::span<const Token::Type> getTypes() const { return m_Types; }
+    [[nodiscard]] std::span<const Text> getTexts() const { return m_Texts; }
+    [[nodiscard]] std::span<const uint32_t> getPositions() const { return m_Positions; }
+    [[nodiscard]] std::span<const SymbolTable::Symbol> getSymbols() const { return m_Symbols; }
+    // For the tokenizer, which rebases text offsets and fills in symbols once tokens are lexed
+    [[nodiscard]] std::span<Text> getTexts() { return m_Texts; }
+    [[nodiscard]] std::span<SymbolTable::Symbol> getSymbols() { return m_Symbols; }
+
+private:
+    std::pmr::vector<Token::Type> m_Types;
+    std::pmr::vector<Text> m_Texts;
+    std::pmr::vector<uint32_t> m_Positions;
+    std::pmr::vector<SymbolTable::Symbol> m_Symbols;
+};
+static_assert(std::random_access_iterator<TokenStream::Iterator>);
@@ -1,15 +1,36 @@
 #include "tokenizer.hpp"
+#include "run_scanner.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
-#include <stdexcept>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "../instrumentation/instrumentation.hpp"
+#include "../scheduler/task_scheduler.hpp"
 
 struct TokenizerTool
 {
-    uint32_t column = 0;
     uint32_t line = 1;
+    // Offset of the first byte of the current line. Newlines inside strings do not start a new line
+    uint32_t lineOffset = 0;
+    uint32_t position = 0;
+
+    // The current token is tracked as a slice of the source. Only when a token stops being contiguous
+    // (characters dropped from its middle) is it copied into the reusable spill buffer
+    uint32_t tokenOffset = 0;
+    uint32_t tokenLength = 0;
+    bool tokenSpilled = false;
+    std::string spill{};
 
-    std::string currentToken{};
-    enum : uint8_t {WORD, OPERATOR, SINGLE_STRING, MULTI_STRING, COMMENT, NONE} currentTokenType = NONE;
+    // Set while the current word is a number literal, with the scan of the literal it started with
+    bool pendingNumber = false;
+    NumberScanner::Result numberScan{};
+    enum PendingType : uint8_t {WORD, OPERATOR, SINGLE_STRING, MULTI_STRING, COMMENT, NONE, PENDING_TYPE_COUNT} currentTokenType = NONE;
     uint32_t delimiterLevel = 0;
     uint32_t currentScope = 0;
     uint32_t spaceStack = 0;
@@ -19,25 +40,130 @@ struct TokenizerTool
     char strTokenStart = '\0';
     Tokenizer& tokenizer;
 
-    struct Error
+    std::pmr::vector<Tokenizer::Error> errors;
+    // Set once an error message spells out its line, which cannot be shifted afterwards like the line fields
+    bool lineInMessage = false;
+
+    explicit TokenizerTool(Tokenizer& p_Tokenizer) : tokenizer(p_Tokenizer), errors(p_Tokenizer.m_Errors.get_allocator()) { }
+
+    // Column of the character being read, the same rule as Tokenizer::getLocation. Only needed for errors, tokens just
+    // record the position
+    [[nodiscard]] uint32_t currentColumn() const
     {
-        std::string message;
-        uint32_t line;
-        uint32_t column;
-    };
-    std::vector<Error> errors;
+        return position - lineOffset + (position < tokenizer.m_Source.size() ? 1 : 0);
+    }
+
+    [[nodiscard]] std::string_view currentToken() const
+    {
+        if (tokenSpilled)
+        {
+            return spill;
+        }
+        return std::string_view(tokenizer.m_Source).substr(tokenOffset, tokenLength);
+    }
+
+    void appendCurrentChar()
+    {
+        if (tokenLength == 0)
+        {
+            tokenOffset = position;
+        }
+        else if (!tokenSpilled && tokenOffset + tokenLength != position)
+        {
+            spill.assign(currentToken());
+            tokenSpilled = true;
+        }
+        if (tokenSpilled)
+        {
+            spill += tokenizer.m_Source[position];
+        }
+        tokenLength++;
+    }
+
+    void appendCurrentRun(const uint32_t p_Length)
+    {
+        if (tokenSpilled)
+        {
+            spill.append(std::string_view(tokenizer.m_Source).substr(position + 1, p_Length));
+        }
+        tokenLength += p_Length;
+    }
+
+    void clearCurrentToken()
+    {
+        tokenLength = 0;
+        tokenSpilled = false;
+        pendingNumber = false;
+        spill.clear();
+    }
+
+    void pushToken(const Tokenizer::Token::Type p_Type)
+    {
+        tokenizer.m_Tokens.push_back({ .type = p_Type, .position = position });
+    }
+
+    void pushSourceToken(const Tokenizer::Token::Type p_Type, const uint32_t p_Offset, const uint32_t p_Length)
+    {
+        if (p_Length > UINT16_MAX)
+        {
+            pushPooledToken(p_Type, { std::string_view(tokenizer.m_Source).substr(p_Offset, p_Length) });
+            return;
+        }
+        tokenizer.m_Tokens.push_back({ .type = p_Type, .storage = Tokenizer::Token::SOURCE, .length = static_cast<uint16_t>(p_Length), .offset = p_Offset, .position = position });
+    }
+
+    void pushPooledToken(const Tokenizer::Token::Type p_Type, const std::initializer_list<std::string_view> p_Parts)
+    {
+        uint32_t l_Length = 0;
+        for (const std::string_view l_Part : p_Parts)
+        {
+            l_Length += static_cast<uint32_t>(l_Part.size());
+        }
+        const uint32_t l_Offset = static_cast<uint32_t>(tokenizer.m_Pool.size());
+        tokenizer.m_Pool.append(reinterpret_cast<const char*>(&l_Length), sizeof(l_Length));
+        for (const std::string_view l_Part : p_Parts)
+        {
+            tokenizer.m_Pool.append(l_Part);
+        }
+        tokenizer.m_Tokens.push_back({ .type = p_Type, .storage = Tokenizer::Token::POOL, .offset = l_Offset, .position = position });
+    }
+
+    void pushNumberToken()
+    {
+        const uint32_t l_Index = static_cast<uint32_t>(tokenizer.m_Numbers.size());
+        tokenizer.m_Numbers.push_back({ .offset = tokenOffset, .length = tokenLength, .literal = numberScan.literal });
+        tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::NUMBER, .storage = Tokenizer::Token::NUMBER_TABLE, .offset = l_Index, .position = position });
+    }
 
-    explicit TokenizerTool(Tokenizer& p_Tokenizer) : tokenizer(p_Tokenizer) { }
+    void pushCurrentToken(const Tokenizer::Token::Type p_Type)
+    {
+        if (tokenSpilled)
+        {
+            pushPooledToken(p_Type, { spill });
+            return;
+        }
+        pushSourceToken(p_Type, tokenOffset, tokenLength);
+    }
 
-    void advanceColumnCount()
+    void pushStringToken()
     {
-        column++;
+        // String values are always reported double-quoted. When the source already spells the literal
+        // that way the token can point at it, quotes included
+        const std::string_view l_Source = tokenizer.m_Source;
+        const uint32_t l_End = tokenOffset + tokenLength;
+        if (!tokenSpilled && tokenLength > 0 && tokenOffset > 0 && l_End < l_Source.size() && l_Source[tokenOffset - 1] == '"' && l_Source[l_End] == '"')
+        {
+            pushSourceToken(Tokenizer::Token::Type::STRING, tokenOffset - 1, tokenLength + 2);
+            return;
+        }
+        pushPooledToken(Tokenizer::Token::Type::STRING, { "\"", currentToken(), "\"" });
     }
 
     void advanceLineCount()
     {
         line++;
-        column = 0;
+        lineOffset = position + 1;
+        tokenizer.m_LineStarts.push_back(lineOffset);
         localScope = 0;
         lineStart = true;
     }
@@ -54,7 +180,7 @@ struct TokenizerTool
         }
         if (spaceStack != 0)
         {
-            errors.push_back({ .message = "Inconsistent indent at the beginning of the line", .line = line, .column = column });
+            errors.push_back({ .message = "Inconsistent indent at the beginning of the line", .line = line, .column = currentColumn() });
         }
         if (localScope != currentScope)
         {
@@ -62,17 +188,17 @@ struct TokenizerTool
             {
                 if (localScope - currentScope > 1)
                 {
-                    errors.push_back({ .message = "Invalid indentation level", .line = line, .column = column });
+                    errors.push_back({ .message = "Invalid indentation level", .line = line, .column = currentColumn() });
                     return;
                 }
-                tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::INDENT, .line = line, .column = column });
+                pushToken(Tokenizer::Token::Type::INDENT);
                 currentScope = localScope;
             }
             else
             {
                 while (currentScope > localScope)
                 {
-                    tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::DEDENT, .line = line, .column = column });
+                    pushToken(Tokenizer::Token::Type::DEDENT);
                     currentScope--;
                 }
             }
@@ -84,7 +210,7 @@ struct TokenizerTool
         finishToken();
         if (delimiterLevel == 0 && !lineStart)
         {
-            tokenizer.m_Tokens.push_back({.type = Tokenizer::Token::Type::NEWLINE, .line = line, .column = column });
+            pushToken(Tokenizer::Token::Type::NEWLINE);
         }
         advanceLineCount();
     }
@@ -101,81 +227,111 @@ struct TokenizerTool
         }
         else if (currentTokenType == OPERATOR)
         {
-            const Tokenizer::FoundStatus l_Status = Tokenizer::isOperator(currentToken);
+            const Tokenizer::FoundStatus l_Status = Tokenizer::isOperator(currentToken());
             if (l_Status == Tokenizer::UNUSED)
             {
-                errors.push_back({ .message = "Operator " + currentToken + " is not implemented", .line = line, .column = column });
+                errors.push_back({ .message = "Operator " + std::string(currentToken()) + " is not implemented", .line = line, .column = currentColumn() });
             }
             else if (l_Status == Tokenizer::NOT_FOUND)
             {
-                errors.push_back({ .message = "Invalid operator: " + currentToken, .line = line, .column = column });
+                errors.push_back({ .message = "Invalid operator: " + std::string(currentToken()), .line = line, .column = currentColumn() });
             }
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::OPERATOR, .value = currentToken, .line = line, .column = column });
+            pushCurrentToken(Tokenizer::Token::Type::OPERATOR);
         }
         else if (currentTokenType == SINGLE_STRING || currentTokenType == MULTI_STRING)
         {
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::STRING, .value = '"' + currentToken + '"', .line = line, .column = column });
+            pushStringToken();
             strTokenStart = '\0';
             stringBuffer = 0;
         }
         else if (currentTokenType == COMMENT)
         {
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::COMMENT, .value = currentToken, .line = line, .column = column });
+            pushCurrentToken(Tokenizer::Token::Type::COMMENT);
         }
         currentTokenType = NONE;
-        currentToken = "";
+        clearCurrentToken();
     }
 
     void finishAlnumToken()
     {
-        if (currentToken == "None")
+        const std::string_view l_Token = currentToken();
+        if (pendingNumber)
+        {
+            finishNumberToken(l_Token);
+            return;
+        }
+
+        if (l_Token == "None")
         {
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::NONE, .line = line, .column = column });
+            pushToken(Tokenizer::Token::Type::NONE);
             return;
         }
 
-        if (currentToken == "True" || currentToken == "False")
+        if (l_Token == "True" || l_Token == "False")
         {
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::BOOLEAN, .value = currentToken, .line = line, .column = column });
+            pushCurrentToken(Tokenizer::Token::Type::BOOLEAN);
             return;
         }
 
         {
-            const Tokenizer::FoundStatus l_Status = Tokenizer::isKeyword(currentToken);
+            const Tokenizer::FoundStatus l_Status = Tokenizer::isKeyword(l_Token);
             bool l_Operator = false;
             if (l_Status != Tokenizer::NOT_FOUND)
             {
-                l_Operator = Tokenizer::findInLists<0>({}, Tokenizer::c_OperatorKeywords, currentToken);
+                l_Operator = Tokenizer::isOperatorKeyword(l_Token);
             }
             if (l_Status == Tokenizer::FOUND)
             {
                 const Tokenizer::Token::Type l_OperatorType = l_Operator ? Tokenizer::Token::Type::OPERATOR : Tokenizer::Token::Type::KEYWORD;
-                tokenizer.m_Tokens.push_back({ .type = l_OperatorType, .value = currentToken, .line = line, .column = column });
-                currentToken.clear();
+                pushCurrentToken(l_OperatorType);
+                clearCurrentToken();
                 return;
             }
             if (l_Status == Tokenizer::UNUSED)
             {
-                errors.push_back({ .message = (l_Operator ? "keyword " : "operator ") + currentToken + " is not implemented", .line = line, .column = column });
-                currentToken.clear();
+                errors.push_back({ .message = (l_Operator ? "keyword " : "operator ") + std::string(l_Token) + " is not implemented", .line = line, .column = currentColumn() });
+                clearCurrentToken();
                 return;
             }
         }
 
-        try
+        if (!std::isalpha(l_Token[0]) && l_Token[0] != '_')
         {
-            float l_Num = std::stof(currentToken);
-            tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::NUMBER, .value = currentToken, .line = line, .column = column });
+            errors.push_back({ .message = "Invalid identifier: " + std::string(l_Token), .line = line, .column = currentColumn() });
             return;
         }
-        catch (const std::invalid_argument&) {}
+        pushCurrentToken(Tokenizer::Token::Type::IDENTIFIER);
+    }
 
-        if (!std::isalpha(currentToken[0]) && currentToken[0] != '_')
+    void finishNumberToken(const std::string_view p_Token)
+    {
+        // Characters glued to the literal (1abc, 0x, 1_) make the whole word invalid
+        if (tokenSpilled || tokenLength != numberScan.length || numberScan.status == NumberScanner::MALFORMED)
+        {
+            errors.push_back({ .message = "Invalid number literal: " + std::string(p_Token), .line = line, .column = currentColumn() });
+            return;
+        }
+        if (numberScan.status == NumberScanner::OUT_OF_RANGE)
         {
-            errors.push_back({ .message = "Invalid identifier: " + currentToken, .line = line, .column = column });
+            errors.push_back({ .message = "Number literal out of range: " + std::string(p_Token), .line = line, .column = currentColumn() });
             return;
         }
-        tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::IDENTIFIER, .value = currentToken, .line = line, .column = column });
+        pushNumberToken();
+    }
+
+    // Numbers are scanned as a whole when they start, since they can contain characters ('.', '+', '-') that
+    // otherwise end a word. They then stay the current word until the next character finishes it as usual
+    void digestNumber()
+    {
+        finishToken();
+        currentTokenType = WORD;
+        numberScan = NumberScanner::scan(std::string_view(tokenizer.m_Source).substr(position));
+        pendingNumber = true;
+        appendCurrentChar();
+        const uint32_t l_Rest = numberScan.length - 1;
+        appendCurrentRun(l_Rest);
+        position += l_Rest;
+        finishLineStart();
     }
 
     void digestIndent()
@@ -192,12 +348,17 @@ struct TokenizerTool
 
     void digestAlphanumeric(const char p_Char)
     {
+        if (currentTokenType != WORD && std::isdigit(static_cast<unsigned char>(p_Char)))
+        {
+            digestNumber();
+            return;
+        }
         if (currentTokenType != WORD && currentTokenType != NONE)
         {
             finishToken();
         }
         currentTokenType = WORD;
-        currentToken += p_Char;
+        appendCurrentChar();
         finishLineStart();
     }
 
@@ -231,7 +392,8 @@ struct TokenizerTool
             finishToken();
             strTokenStart = p_Char;
         }
-        if (p_Char == strTokenStart)
+        // Outside strings strTokenStart is '\0', which a NUL in the source must not match
+        if (p_Char == strTokenStart && strTokenStart != '\0')
         {
             if (currentTokenType == SINGLE_STRING || (currentTokenType == MULTI_STRING && stringBuffer == 2))
             {
@@ -247,45 +409,63 @@ struct TokenizerTool
         {
             if (p_Char == '\n' && currentTokenType == SINGLE_STRING)
             {
-                errors.push_back({ .message = "Unclosed single-quoted string at line " + std::to_string(line) + ", column " + std::to_string(column), .line = line, .column = column });
-                finishToken();
+                reportUnclosedString();
                 return false;
             }
-            currentToken += p_Char;
+            appendCurrentChar();
             return true;
         }
         if (stringBuffer == 1 || stringBuffer == 3)
         {
-            currentTokenType = stringBuffer == 1 ? SINGLE_STRING : MULTI_STRING;
-            stringBuffer = 0;
-            currentToken += p_Char;
+            openString();
             return true;
         }
         if (stringBuffer == 2 || stringBuffer == 6)
         {
-            currentTokenType = SINGLE_STRING;
-            finishToken();
+            finishEmptyString();
         }
         return false;
     }
 
+    void openString()
+    {
+        currentTokenType = stringBuffer == 1 ? SINGLE_STRING : MULTI_STRING;
+        stringBuffer = 0;
+        appendCurrentChar();
+    }
+
+    void finishEmptyString()
+    {
+        currentTokenType = SINGLE_STRING;
+        finishToken();
+    }
+
+    void reportUnclosedString()
+    {
+        errors.push_back({ .message = "Unclosed single-quoted string at line " + std::to_string(line) + ", column " + std::to_string(currentColumn()), .line = line, .column = currentColumn() });
+        lineInMessage = true;
+        finishToken();
+    }
+
     bool checkOperator(const char p_Char)
     {
-        for (const char l_Operator : Tokenizer::c_OperatorCharacters)
+        if (!(Tokenizer::getCharClass(p_Char) & Tokenizer::CHAR_OPERATOR))
         {
-            if (l_Operator == p_Char)
-            {
-                if (currentTokenType != OPERATOR && currentTokenType != NONE)
-                {
-                    finishToken();
-                }
-                currentToken += p_Char;
-                currentTokenType = OPERATOR;
-                finishLineStart();
-                return true;
-            }
+            return false;
         }
-        return false;
+        digestOperator();
+        return true;
+    }
+
+    void digestOperator()
+    {
+        if (currentTokenType != OPERATOR && currentTokenType != NONE)
+        {
+            finishToken();
+        }
+        appendCurrentChar();
+        currentTokenType = OPERATOR;
+        finishLineStart();
     }
 
     bool checkComment(const char p_Char)
@@ -296,56 +476,60 @@ struct TokenizerTool
             {
                 return false;
             }
-            currentToken += p_Char;
+            appendCurrentChar();
             return true;
         }
         if (p_Char == '#')
         {
-            if (currentTokenType != NONE)
-            {
-                finishToken();
-            }
-            currentTokenType = COMMENT;
-            currentToken += p_Char;
+            startComment();
             return true;
         }
         return false;
     }
 
+    void startComment()
+    {
+        if (currentTokenType != NONE)
+        {
+            finishToken();
+        }
+        currentTokenType = COMMENT;
+        appendCurrentChar();
+    }
+
+    void reportInvalidCharacter(const char p_Char)
+    {
+        errors.push_back({ .message = "Invalid character: " + std::string(1, p_Char), .line = line, .column = currentColumn() });
+    }
+
     bool checkDelimiter(const char l_Char)
     {
-        const Tokenizer::FoundStatus l_Status = Tokenizer::isDelimiter(std::string_view(&l_Char, 1));
-        if (l_Status == Tokenizer::NOT_FOUND)
+        const uint8_t l_Class = Tokenizer::getCharClass(l_Char);
+        if (!(l_Class & (Tokenizer::CHAR_DELIMITER | Tokenizer::CHAR_UNUSED_DELIMITER)))
         {
             return false;
         }
-        if (l_Status == Tokenizer::UNUSED)
+        if (!(l_Class & Tokenizer::CHAR_DELIMITER))
         {
-            errors.push_back({ .message = "Delimiter " + std::string(1, l_Char) + " is not implemented", .line = line, .column = column });
+            errors.push_back({ .message = "Delimiter " + std::string(1, l_Char) + " is not implemented", .line = line, .column = currentColumn() });
         }
-        if (currentTokenType == WORD && l_Char == '.')
+        if (l_Char == '.' && NumberScanner::startsNumber(std::string_view(tokenizer.m_Source).substr(position)))
         {
-            try
-            {
-                int elem = std::stoi(currentToken);
-                currentToken += l_Char;
-                finishLineStart();
-                return true;
-            }
-            catch (const std::invalid_argument&) {}
+            digestNumber();
+            return true;
         }
         finishToken();
         finishLineStart();
-        tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::DELIMITER, .value = std::string(1, l_Char), .line = line, .column = column });
-        if (Tokenizer::isOpeningDelimiter(std::string_view(&l_Char, 1)))
+        pushSourceToken(Tokenizer::Token::Type::DELIMITER, position, 1);
+        if (l_Class & Tokenizer::CHAR_OPENING_DELIMITER)
         {
             delimiterLevel++;
         }
-        else if (Tokenizer::isClosingDelimiter(std::string_view(&l_Char, 1)))
+        else if (l_Class & Tokenizer::CHAR_CLOSING_DELIMITER)
         {
             if (delimiterLevel == 0)
             {
-                errors.push_back({ .message = "Unmatched closing delimiter: " + std::string(1, l_Char), .line = line, .column = column });
+                errors.push_back({ .message = "Unmatched closing delimiter: " + std::string(1, l_Char), .line = line, .column = currentColumn() });
             }
             else
             {
@@ -359,117 +543,788 @@ struct TokenizerTool
     {
         if (currentTokenType == SINGLE_STRING || currentTokenType == MULTI_STRING)
         {
-            errors.push_back({ .message = "Unclosed string at EOF", .line = line, .column = column });
+            errors.push_back({ .message = "Unclosed string at EOF", .line = line, .column = currentColumn() });
         }
         if (delimiterLevel > 0)
         {
-            errors.push_back({ .message = "Unclosed delimiter at EOF", .line = line, .column = column });
+            errors.push_back({ .message = "Unclosed delimiter at EOF", .line = line, .column = currentColumn() });
         }
         if (currentTokenType != NONE)
         {
             finishAlnumToken();
         }
-        tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::END, .line = line, .column = column });
+        pushToken(Tokenizer::Token::Type::END);
     }
+
+    // A chunk can start right after this point if the lexer is at the beginning of a line with nothing pending: no
+    // open token, string, bracket or partial indentation. Only the indentation level carries over
+    [[nodiscard]] bool isAtSeam(const uint32_t p_Position) const
+    {
+        return position == p_Position && currentTokenType == NONE && strTokenStart == '\0' && stringBuffer == 0 && delimiterLevel == 0 && spaceStack == 0 && lineStart && localScope == 0;
+    }
+
+    // Both lex [p_Begin, p_End) of the source, finish() has to follow after the last range
+    void lexCascade(uint32_t p_Begin, uint32_t p_End);
+    void lexTable(uint32_t p_Begin, uint32_t p_End);
+    // The table-driven core, or the original check cascade in builds with the PYCCOMP_LEGACY_LEXER CMake option,
+    // which keep it as the reference the core is tested against
+    void lex(const uint32_t p_Begin, const uint32_t p_End)
+    {
+#ifdef PYCCOMP_LEGACY_LEXER
+        lexCascade(p_Begin, p_End);
+#else
+        lexTable(p_Begin, p_End);
+#endif
+    }
+    uint32_t skipRun(uint8_t p_Action);
+
+    static bool lexParallel(Tokenizer& p_Tokenizer, uint32_t p_FirstLine, TaskScheduler& p_Scheduler);
 };
 
-Tokenizer::Tokenizer(const std::string_view p_Contents)
-    : m_Source(p_Contents)
+void TokenizerTool::lexCascade(const uint32_t p_Begin, const uint32_t p_End)
 {
-    TokenizerTool l_Tool{*this};
-    for (const char l_Char : m_Source)
+    const std::string_view l_Source = tokenizer.m_Source;
+    for (position = p_Begin; position < p_End; ++position)
     {
-        l_Tool.advanceColumnCount();
-        if (l_Tool.checkStringDelimiter(l_Char))
+        const char l_Char = l_Source[position];
+        if (checkStringDelimiter(l_Char))
         {
             continue;
         }
-        if (l_Tool.checkComment(l_Char))
+        if (checkComment(l_Char))
         {
             continue;
         }
-        if (l_Tool.checkOperator(l_Char))
+        if (checkOperator(l_Char))
         {
             continue;
         }
         if (l_Char == '\n')
         {
-            l_Tool.pushNewline();
+            pushNewline();
             continue;
         }
         if (l_Char == '\t')
         {
-            l_Tool.digestIndent();
+            digestIndent();
             continue;
         }
-        if (std::isalnum(l_Char) || l_Char == '_')
+        if (Tokenizer::getCharClass(l_Char) & Tokenizer::CHAR_WORD)
         {
-            l_Tool.digestAlphanumeric(l_Char);
+            digestAlphanumeric(l_Char);
             continue;
         }
         if (l_Char == ' ')
         {
-            l_Tool.digestSpace();
+            digestSpace();
             continue;
         }
-        if (l_Tool.checkDelimiter(l_Char))
+        if (checkDelimiter(l_Char))
         {
             continue;
         }
-        l_Tool.errors.push_back({ .message = "Invalid character: " + std::string(1, l_Char), .line = l_Tool.line, .column = l_Tool.column });
+        reportInvalidCharacter(l_Char);
     }
-    l_Tool.finish();
+}
+
+// Table-driven lexer core. The dispatch the cascade above performs with a chain of checks is precomputed for every
+// combination of lexer state and character class. The state is the pending token type, the quote that opened the
+// current string (if any) and the length of the current run of quotes, capped where longer runs stop mattering
+namespace
+{
+    enum LexClass : uint8_t
+    {
+        LEX_DOUBLE_QUOTE,
+        LEX_SINGLE_QUOTE,
+        LEX_HASH,
+        LEX_OPERATOR,
+        LEX_NEWLINE,
+        LEX_TAB,
+        LEX_WORD,
+        LEX_SPACE,
+        LEX_DELIMITER,
+        LEX_OTHER,
+        LEX_CLASS_COUNT
+    };
 
-    // Print errors if any
-    for (const auto& error : l_Tool.errors)
+    // Low nibble is the action for the character, high nibble an optional step that runs first
+    enum LexAction : uint8_t
     {
-        std::cerr << "Error at line "  << error.line << ", column "  << error.column << ": " << error.message << '\n';
+        ACT_START_STRING,
+        ACT_CLOSE_STRING,
+        ACT_COUNT_QUOTE,
+        ACT_APPEND,
+        ACT_OPEN_STRING,
+        ACT_START_COMMENT,
+        ACT_OPERATOR,
+        ACT_NEWLINE,
+        ACT_TAB,
+        ACT_WORD,
+        ACT_SPACE,
+        ACT_DELIMITER,
+        ACT_INVALID,
+
+        ACT_MASK = 0x0F,
+        PRE_NONE = 0x00,
+        PRE_EMPTY_STRING = 0x10,
+        PRE_UNCLOSED_STRING = 0x20,
+        PRE_MASK = 0xF0
+    };
+
+    constexpr uint32_t c_QuoteKinds = 3;
+    constexpr uint32_t c_QuoteRuns = 8;
+    constexpr uint32_t c_LexStateCount = TokenizerTool::PENDING_TYPE_COUNT * c_QuoteKinds * c_QuoteRuns;
+
+    constexpr uint32_t lexState(const uint32_t p_Type, const uint32_t p_Quote, const uint32_t p_Run)
+    {
+        return (p_Type * c_QuoteKinds + p_Quote) * c_QuoteRuns + p_Run;
     }
+
+    constexpr std::array<uint8_t, 256> c_LexClasses = []
+    {
+        std::array<uint8_t, 256> l_Classes{};
+        for (uint32_t l_Char = 0; l_Char < 256; ++l_Char)
+        {
+            const uint8_t l_Class = Tokenizer::getCharClass(static_cast<char>(l_Char));
+            // Same precedence as the checks in lexCascade
+            if (l_Char == '"') l_Classes[l_Char] = LEX_DOUBLE_QUOTE;
+            else if (l_Char == '\'') l_Classes[l_Char] = LEX_SINGLE_QUOTE;
+            else if (l_Char == '#') l_Classes[l_Char] = LEX_HASH;
+            else if (l_Class & Tokenizer::CHAR_OPERATOR) l_Classes[l_Char] = LEX_OPERATOR;
+            else if (l_Char == '\n') l_Classes[l_Char] = LEX_NEWLINE;
+            else if (l_Char == '\t') l_Classes[l_Char] = LEX_TAB;
+            else if (l_Class & Tokenizer::CHAR_WORD) l_Classes[l_Char] = LEX_WORD;
+            else if (l_Char == ' ') l_Classes[l_Char] = LEX_SPACE;
+            else if (l_Class & (Tokenizer::CHAR_DELIMITER | Tokenizer::CHAR_UNUSED_DELIMITER)) l_Classes[l_Char] = LEX_DELIMITER;
+            else l_Classes[l_Char] = LEX_OTHER;
+        }
+        return l_Classes;
+    }();
+
+    constexpr std::array<uint8_t, 256> c_QuoteKind = []
+    {
+        std::array<uint8_t, 256> l_Kinds{};
+        l_Kinds['"'] = 1;
+        l_Kinds['\''] = 2;
+        return l_Kinds;
+    }();
+
+    // Everything after checkStringDelimiter in lexCascade
+    constexpr uint8_t decideOutsideString(const uint32_t p_Type, const uint32_t p_Class)
+    {
+        if (p_Type == TokenizerTool::COMMENT && p_Class != LEX_NEWLINE)
+        {
+            return ACT_APPEND;
+        }
+        switch (p_Class)
+        {
+        case LEX_HASH: return p_Type == TokenizerTool::COMMENT ? ACT_APPEND : ACT_START_COMMENT;
+        case LEX_OPERATOR: return ACT_OPERATOR;
+        case LEX_NEWLINE: return ACT_NEWLINE;
+        case LEX_TAB: return ACT_TAB;
+        case LEX_WORD: return ACT_WORD;
+        case LEX_SPACE: return ACT_SPACE;
+        case LEX_DELIMITER: return ACT_DELIMITER;
+        default: return ACT_INVALID;
+        }
+    }
+
+    // Mirrors checkStringDelimiter
+    constexpr uint8_t decide(const uint32_t p_Type, const uint32_t p_Quote, const uint32_t p_Run, const uint32_t p_Class)
+    {
+        if (p_Type == TokenizerTool::COMMENT)
+        {
+            return decideOutsideString(p_Type, p_Class);
+        }
+        const uint32_t l_ClassQuote = p_Class == LEX_DOUBLE_QUOTE ? 1 : p_Class == LEX_SINGLE_QUOTE ? 2 : 0;
+        if (l_ClassQuote != 0 && p_Quote == 0)
+        {
+            return ACT_START_STRING;
+        }
+        if (l_ClassQuote != 0 && l_ClassQuote == p_Quote)
+        {
+            if (p_Type == TokenizerTool::SINGLE_STRING || (p_Type == TokenizerTool::MULTI_STRING && p_Run == 2))
+            {
+                return ACT_CLOSE_STRING;
+            }
+            return ACT_COUNT_QUOTE;
+        }
+        if (p_Type == TokenizerTool::SINGLE_STRING || p_Type == TokenizerTool::MULTI_STRING)
+        {
+            if (p_Class == LEX_NEWLINE && p_Type == TokenizerTool::SINGLE_STRING)
+            {
+                return PRE_UNCLOSED_STRING | decideOutsideString(TokenizerTool::NONE, p_Class);
+            }
+            return ACT_APPEND;
+        }
+        if (p_Run == 1 || p_Run == 3)
+        {
+            return ACT_OPEN_STRING;
+        }
+        if (p_Run == 2 || p_Run == 6)
+        {
+            return PRE_EMPTY_STRING | decideOutsideString(TokenizerTool::NONE, p_Class);
+        }
+        return decideOutsideString(p_Type, p_Class);
+    }
+
+    constexpr std::array<std::array<uint8_t, LEX_CLASS_COUNT>, c_LexStateCount> c_LexTable = []
+    {
+        std::array<std::array<uint8_t, LEX_CLASS_COUNT>, c_LexStateCount> l_Table{};
+        for (uint32_t l_Type = 0; l_Type < TokenizerTool::PENDING_TYPE_COUNT; ++l_Type)
+        {
+            for (uint32_t l_Quote = 0; l_Quote < c_QuoteKinds; ++l_Quote)
+            {
+                for (uint32_t l_Run = 0; l_Run < c_QuoteRuns; ++l_Run)
+                {
+                    for (uint32_t l_Class = 0; l_Class < LEX_CLASS_COUNT; ++l_Class)
+                    {
+                        l_Table[lexState(l_Type, l_Quote, l_Run)][l_Class] = decide(l_Type, l_Quote, l_Run, l_Class);
+                    }
+                }
+            }
+        }
+        return l_Table;
+    }();
 }
 
-template<size_t S1, size_t S2>
-Tokenizer::FoundStatus Tokenizer::findInLists(const std::array<const char*, S1>& p_elems, const std::array<const char*, S2>& p_Unused, const std::string_view p_Elem)
+// Once a character has been consumed, the characters after it that would take the same action again are found with
+// RunScanner and consumed at once. Returns how many characters were consumed after the current one
+uint32_t TokenizerTool::skipRun(const uint8_t p_Action)
 {
-    for (const char* elem : p_elems)
+    const std::string_view l_Source = tokenizer.m_Source;
+    const char* l_Begin = l_Source.data() + position + 1;
+    const char* l_End = l_Source.data() + l_Source.size();
+    const uint32_t l_State = lexState(currentTokenType, c_QuoteKind[static_cast<uint8_t>(strTokenStart)], std::min(stringBuffer, c_QuoteRuns - 1));
+
+    const char* l_RunEnd = l_Begin;
+    switch (p_Action)
     {
-        if (p_Elem == elem)
+    case ACT_APPEND:
+    case ACT_OPEN_STRING:
+    case ACT_START_COMMENT:
+        // Comments run to the end of the line, strings to the next quote of their kind, single-quoted ones also stop
+        // at the end of the line. Everything before is appended as is
+        if (currentTokenType == COMMENT)
+        {
+            l_RunEnd = RunScanner::findByte(l_Begin, l_End, '\n');
+        }
+        else if (currentTokenType == SINGLE_STRING)
         {
-            return FOUND;
+            l_RunEnd = RunScanner::findEither(l_Begin, l_End, strTokenStart, '\n');
+        }
+        else if (currentTokenType == MULTI_STRING)
+        {
+            l_RunEnd = RunScanner::findByte(l_Begin, l_End, strTokenStart);
+        }
+        appendCurrentRun(static_cast<uint32_t>(l_RunEnd - l_Begin));
+        break;
+    case ACT_WORD:
+        if (c_LexTable[l_State][LEX_WORD] == ACT_WORD)
+        {
+            l_RunEnd = RunScanner::skipWord(l_Begin, l_End);
+            appendCurrentRun(static_cast<uint32_t>(l_RunEnd - l_Begin));
+        }
+        break;
+    case ACT_SPACE:
+        if (c_LexTable[l_State][LEX_SPACE] == ACT_SPACE)
+        {
+            l_RunEnd = RunScanner::skipSpaces(l_Begin, l_End);
+            // Same as calling digestSpace for each of them. Outside indentation the token is already finished
+            if (lineStart && delimiterLevel == 0)
+            {
+                spaceStack += static_cast<uint32_t>(l_RunEnd - l_Begin);
+                localScope += spaceStack / 4;
+                spaceStack %= 4;
+            }
         }
+        break;
+    default:
+        break;
     }
-    for (const auto& unusedElem : p_Unused)
+
+    return static_cast<uint32_t>(l_RunEnd - l_Begin);
+}
+
+void TokenizerTool::lexTable(const uint32_t p_Begin, const uint32_t p_End)
+{
+    const std::string_view l_Source = tokenizer.m_Source;
+    for (position = p_Begin; position < p_End; ++position)
     {
-        if (p_Elem == unusedElem)
+        const char l_Char = l_Source[position];
+
+        const uint32_t l_State = lexState(currentTokenType, c_QuoteKind[static_cast<uint8_t>(strTokenStart)], std::min(stringBuffer, c_QuoteRuns - 1));
+        const uint8_t l_Action = c_LexTable[l_State][c_LexClasses[static_cast<uint8_t>(l_Char)]];
+        if (l_Action & PRE_MASK)
+        {
+            if ((l_Action & PRE_MASK) == PRE_EMPTY_STRING)
+            {
+                finishEmptyString();
+            }
+            else
+            {
+                reportUnclosedString();
+            }
+        }
+        switch (l_Action & ACT_MASK)
         {
-            return UNUSED;
+        case ACT_START_STRING:
+            finishLineStart();
+            finishToken();
+            strTokenStart = l_Char;
+            stringBuffer += 1;
+            break;
+        case ACT_CLOSE_STRING:
+            finishToken();
+            break;
+        case ACT_COUNT_QUOTE:
+            stringBuffer += 1;
+            break;
+        case ACT_APPEND:
+            appendCurrentChar();
+            position += skipRun(ACT_APPEND);
+            break;
+        case ACT_OPEN_STRING:
+            openString();
+            position += skipRun(ACT_OPEN_STRING);
+            break;
+        case ACT_START_COMMENT:
+            startComment();
+            position += skipRun(ACT_START_COMMENT);
+            break;
+        case ACT_OPERATOR:
+            digestOperator();
+            break;
+        case ACT_NEWLINE:
+            pushNewline();
+            break;
+        case ACT_TAB:
+            digestIndent();
+            break;
+        case ACT_WORD:
+            digestAlphanumeric(l_Char);
+            position += skipRun(ACT_WORD);
+            break;
+        case ACT_SPACE:
+            digestSpace();
+            position += skipRun(ACT_SPACE);
+            break;
+        case ACT_DELIMITER:
+            checkDelimiter(l_Char);
+            break;
+        default:
+            reportInvalidCharacter(l_Char);
+            break;
         }
     }
-    return NOT_FOUND;
+}
+
+namespace
+{
+    void internRange(const Tokenizer& p_Tokenizer, TokenStream& p_Tokens, const size_t p_Begin, const size_t p_End, SymbolCache& p_Cache)
+    {
+        const std::span<const Tokenizer::Token::Type> l_Types = std::as_const(p_Tokens).getTypes();
+        const std::span<SymbolTable::Symbol> l_Symbols = p_Tokens.getSymbols();
+        for (size_t l_Index = p_Begin; l_Index < p_End; ++l_Index)
+        {
+            if (l_Types[l_Index] == Tokenizer::Token::Type::IDENTIFIER || l_Types[l_Index] == Tokenizer::Token::Type::KEYWORD || l_Types[l_Index] == Tokenizer::Token::Type::STRING)
+            {
+                l_Symbols[l_Index] = p_Cache.intern(p_Tokenizer.getValue(p_Tokens[l_Index]));
+            }
+        }
+    }
+}
+
+// Large sources are cut into chunks after newlines followed by a letter or '_', where the lexer is most likely at a
+// seam and, if it is, emits the same tokens for any indentation level except for the DEDENTs of that first line. Every
+// chunk is lexed speculatively from that state at the same time. Tokens only record byte positions, but errors count
+// lines from 0, since newlines inside strings do not count and the real line is only known once the previous chunk is
+// done. The chunks are then checked in order: a chunk whose predecessor really ended at a seam is kept, given the
+// missing DEDENTs and its error lines shifted, any other is thrown away and its range lexed again by the predecessor's
+// lexer
+bool TokenizerTool::lexParallel(Tokenizer& p_Tokenizer, const uint32_t p_FirstLine, TaskScheduler& p_Scheduler)
+{
+    const std::string_view l_Source = p_Tokenizer.m_Source;
+    const uint32_t l_Size = static_cast<uint32_t>(l_Source.size());
+    const uint32_t l_Wanted = std::min(p_Scheduler.getWorkerCount(), l_Size / Tokenizer::c_MinChunkSize);
+    if (l_Wanted < 2)
+    {
+        return false;
+    }
+
+    std::vector<uint32_t> l_Bounds{ 0 };
+    for (uint32_t l_Chunk = 1; l_Chunk < l_Wanted; ++l_Chunk)
+    {
+        size_t l_Newline = l_Source.find('\n', std::max<size_t>(static_cast<uint64_t>(l_Size) * l_Chunk / l_Wanted, l_Bounds.back()));
+        while (l_Newline != std::string_view::npos && l_Newline + 1 < l_Size && !std::isalpha(static_cast<unsigned char>(l_Source[l_Newline + 1])) && l_Source[l_Newline + 1] != '_')
+        {
+            l_Newline = l_Source.find('\n', l_Newline + 1);
+        }
+        if (l_Newline == std::string_view::npos || l_Newline + 1 >= l_Size)
+        {
+            break;
+        }
+        l_Bounds.push_back(static_cast<uint32_t>(l_Newline + 1));
+    }
+    l_Bounds.push_back(l_Size);
+    const uint32_t l_ChunkCount = static_cast<uint32_t>(l_Bounds.size() - 1);
+    if (l_ChunkCount < 2)
+    {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Tokenizer>> l_Parts;
+    std::vector<std::unique_ptr<TokenizerTool>> l_Tools;
+    for (uint32_t l_Chunk = 0; l_Chunk < l_ChunkCount; ++l_Chunk)
+    {
+        l_Parts.emplace_back(new Tokenizer{});
+        l_Parts.back()->m_Source = l_Source;
+        l_Tools.push_back(std::make_unique<TokenizerTool>(*l_Parts.back()));
+        l_Tools.back()->line = l_Chunk == 0 ? p_FirstLine : 0;
+        l_Tools.back()->lineOffset = l_Bounds[l_Chunk];
+    }
+    p_Scheduler.parallelFor(l_ChunkCount, [&](const uint32_t p_Chunk)
+    {
+        const Instrumentation::ScopedTimer l_Timer{ Instrumentation::LEX_CHUNK };
+        l_Tools[p_Chunk]->lex(l_Bounds[p_Chunk], l_Bounds[p_Chunk + 1]);
+    });
+
+    // Number of DEDENTs each kept chunk is missing, or UINT32_MAX for chunks that were lexed again
+    std::vector<uint32_t> l_Dedents(l_ChunkCount, 0);
+    uint32_t l_Current = 0;
+    for (uint32_t l_Chunk = 1; l_Chunk < l_ChunkCount; ++l_Chunk)
+    {
+        TokenizerTool& l_Tool = *l_Tools[l_Current];
+        TokenizerTool& l_Next = *l_Tools[l_Chunk];
+        if (l_Tool.isAtSeam(l_Bounds[l_Chunk]) && !l_Next.lineInMessage)
+        {
+            // Shifted right away, so that the chunk's lexer counts real lines if it has to go on past its chunk
+            const uint32_t l_LineBase = l_Tool.line;
+            for (Tokenizer::Error& l_Error : l_Next.errors)
+            {
+                l_Error.line += l_LineBase;
+            }
+            l_Next.line += l_LineBase;
+            l_Dedents[l_Chunk] = l_Tool.currentScope;
+            l_Current = l_Chunk;
+        }
+        else
+        {
+            l_Dedents[l_Chunk] = UINT32_MAX;
+            l_Tool.lex(l_Tool.position, l_Bounds[l_Chunk + 1]);
+        }
+    }
+    l_Tools[l_Current]->finish();
+
+    for (uint32_t l_Chunk = 0; l_Chunk < l_ChunkCount; ++l_Chunk)
+    {
+        if (l_Dedents[l_Chunk] == UINT32_MAX)
+        {
+            continue;
+        }
+        Tokenizer& l_Part = *l_Parts[l_Chunk];
+        const uint32_t l_PoolBase = static_cast<uint32_t>(p_Tokenizer.m_Pool.size());
+        const uint32_t l_NumberBase = static_cast<uint32_t>(p_Tokenizer.m_Numbers.size());
+        p_Tokenizer.m_Pool += l_Part.m_Pool;
+        p_Tokenizer.m_Numbers.insert(p_Tokenizer.m_Numbers.end(), l_Part.m_Numbers.begin(), l_Part.m_Numbers.end());
+        p_Tokenizer.m_LineStarts.insert(p_Tokenizer.m_LineStarts.end(), l_Part.m_LineStarts.begin(), l_Part.m_LineStarts.end());
+        for (uint32_t l_Dedent = 0; l_Dedent < l_Dedents[l_Chunk]; ++l_Dedent)
+        {
+            p_Tokenizer.m_Tokens.push_back({ .type = Tokenizer::Token::Type::DEDENT, .position = l_Bounds[l_Chunk] });
+        }
+        for (Tokenizer::Token l_Token : l_Part.m_Tokens)
+        {
+            if (l_Token.storage == Tokenizer::Token::POOL)
+            {
+                l_Token.offset += l_PoolBase;
+            }
+            else if (l_Token.storage == Tokenizer::Token::NUMBER_TABLE)
+            {
+                l_Token.offset += l_NumberBase;
+            }
+            p_Tokenizer.m_Tokens.push_back(l_Token);
+        }
+        std::ranges::move(l_Tools[l_Chunk]->errors, std::back_inserter(p_Tokenizer.m_Errors));
+    }
+    return true;
+}
+
+Tokenizer::Tokenizer(const std::string_view p_Contents, const uint32_t p_FirstLine, TaskScheduler* p_Scheduler, SymbolTable* p_Symbols, std::pmr::memory_resource* p_Memory)
+    : m_Source(p_Contents), m_FirstLine(p_FirstLine), m_LineStarts(1, 0, p_Memory), m_Pool(p_Memory), m_Numbers(p_Memory), m_Tokens(p_Memory), m_Errors(p_Memory)
+{
+    m_Tokens.reserve(p_Contents.size() / c_MinBytesPerToken + 1);
+    const bool l_Split = p_Scheduler != nullptr && TokenizerTool::lexParallel(*this, p_FirstLine, *p_Scheduler);
+    if (!l_Split)
+    {
+        TokenizerTool l_Tool{*this};
+        l_Tool.line = p_FirstLine;
+        l_Tool.lex(0, static_cast<uint32_t>(m_Source.size()));
+        l_Tool.finish();
+        m_Errors = std::move(l_Tool.errors);
+    }
+
+    if (p_Symbols != nullptr)
+    {
+        internSymbols(*p_Symbols, l_Split ? p_Scheduler : nullptr);
+    }
+}
+
+Tokenizer::Tokenizer(std::pmr::memory_resource* p_Memory)
+    : m_LineStarts(p_Memory), m_Pool(p_Memory), m_Numbers(p_Memory), m_Tokens(p_Memory), m_Errors(p_Memory)
+{
+}
+
+void Tokenizer::internSymbols(SymbolTable& p_Symbols, TaskScheduler* p_Scheduler)
+{
+    const uint32_t l_Ranges = p_Scheduler != nullptr ? p_Scheduler->getWorkerCount() : 1;
+    const size_t l_RangeSize = (m_Tokens.size() + l_Ranges - 1) / l_Ranges;
+    const auto l_Intern = [&](const uint32_t p_Range)
+    {
+        SymbolCache l_Cache{ p_Symbols };
+        const size_t l_Begin = std::min(m_Tokens.size(), p_Range * l_RangeSize);
+        const size_t l_End = std::min(m_Tokens.size(), l_Begin + l_RangeSize);
+        internRange(*this, m_Tokens, l_Begin, l_End, l_Cache);
+    };
+    if (l_Ranges > 1)
+    {
+        p_Scheduler->parallelFor(l_Ranges, l_Intern);
+    }
+    else
+    {
+        l_Intern(0);
+    }
+}
+
+void Tokenizer::printErrors(std::ostream& p_Stream) const
+{
+    for (const auto& error : m_Errors)
+    {
+        p_Stream << "Error at line "  << error.line << ", column "  << error.column << ": " << error.message << '\n';
+    }
+}
+
+Tokenizer::Location Tokenizer::getLocation(const Token& p_Token) const
+{
+    const auto l_Line = std::ranges::upper_bound(m_LineStarts, p_Token.position) - 1;
+    // Tokens emitted at the end of the source sit after its last character instead of on one
+    const uint32_t l_Column = p_Token.position - *l_Line + (p_Token.position < m_Source.size() ? 1 : 0);
+    return { .line = m_FirstLine + static_cast<uint32_t>(l_Line - m_LineStarts.begin()), .column = l_Column };
+}
+
+Tokenizer::Location Tokenizer::getLocation(const Token& p_Token, uint32_t& p_LineHint) const
+{
+    if (p_LineHint >= m_LineStarts.size() || m_LineStarts[p_LineHint] > p_Token.position)
+    {
+        p_LineHint = static_cast<uint32_t>(std::ranges::upper_bound(m_LineStarts, p_Token.position) - m_LineStarts.begin() - 1);
+    }
+    while (p_LineHint + 1 < m_LineStarts.size() && m_LineStarts[p_LineHint + 1] <= p_Token.position)
+    {
+        p_LineHint++;
+    }
+    const uint32_t l_Column = p_Token.position - m_LineStarts[p_LineHint] + (p_Token.position < m_Source.size() ? 1 : 0);
+    return { .line = m_FirstLine + p_LineHint, .column = l_Column };
+}
+
+std::string_view Tokenizer::getValue(const Token& p_Token) const
+{
+    if (p_Token.storage == Token::SOURCE)
+    {
+        return std::string_view(m_Source).substr(p_Token.offset, p_Token.length);
+    }
+    if (p_Token.storage == Token::NUMBER_TABLE)
+    {
+        const Number& l_Number = m_Numbers[p_Token.offset];
+        return std::string_view(m_Source).substr(l_Number.offset, l_Number.length);
+    }
+    uint32_t l_Length;
+    std::memcpy(&l_Length, m_Pool.data() + p_Token.offset, sizeof(l_Length));
+    return std::string_view(m_Pool).substr(p_Token.offset + sizeof(l_Length), l_Length);
 }
 
 Tokenizer::FoundStatus Tokenizer::isKeyword(const std::string_view p_Identifier)
 {
-    return findInLists(c_Keywords, c_UnusedKeywords, p_Identifier);
+    return c_KeywordTable.find(p_Identifier);
+}
+
+bool Tokenizer::isOperatorKeyword(const std::string_view p_Identifier)
+{
+    return c_OperatorKeywordTable.find(p_Identifier);
 }
 
 Tokenizer::FoundStatus Tokenizer::isOperator(const std::string_view p_Operator)
 {
-    return findInLists(c_Operators, c_UnusedOperators, p_Operator);
+    return c_OperatorTable.find(p_Operator);
 }
 
 Tokenizer::FoundStatus Tokenizer::isDelimiter(const std::string_view p_Delimiter)
 {
-    return findInLists(c_Delimiters, c_UnusedDelimiters, p_Delimiter);
+    return c_DelimiterTable.find(p_Delimiter);
 }
 
 bool Tokenizer::isOpeningDelimiter(const std::string_view p_Delimiter)
 {
-    constexpr std::array<const char*, 0> unused;
-    return findInLists(c_OpeningDelimiters, unused, p_Delimiter) == FOUND;
+    return p_Delimiter.size() == 1 && (getCharClass(p_Delimiter[0]) & CHAR_OPENING_DELIMITER);
 }
 
 bool Tokenizer::isClosingDelimiter(const std::string_view p_Delimiter)
 {
-    constexpr std::array<const char*, 0> unused;
-    return findInLists(c_ClosingDelimiters, unused, p_Delimiter) == FOUND;
+    return p_Delimiter.size() == 1 && (getCharClass(p_Delimiter[0]) & CHAR_CLOSING_DELIMITER);
+}
+
+TokenCursor::TokenCursor(const std::string_view p_Contents, const uint32_t p_FirstLine, SymbolTable* p_Symbols)
+    : m_Buffer(new Tokenizer{})
+{
+    if (p_Symbols != nullptr)
+    {
+        m_SymbolCache = std::make_unique<SymbolCache>(*p_Symbols);
+    }
+    m_Buffer->m_Source = p_Contents;
+    m_Buffer->m_FirstLine = p_FirstLine;
+    m_Buffer->m_LineStarts.push_back(0);
+    m_Tool = std::make_unique<TokenizerTool>(*m_Buffer);
+    m_Tool->line = p_FirstLine;
+}
+
+TokenCursor::~TokenCursor() = default;
+TokenCursor::TokenCursor(TokenCursor&& p_Other) noexcept = default;
+TokenCursor& TokenCursor::operator=(TokenCursor&& p_Other) noexcept = default;
+
+bool TokenCursor::lexMore()
+{
+    if (m_Finished)
+    {
+        return false;
+    }
+    discardConsumed();
+
+    TokenStream& l_Tokens = m_Buffer->m_Tokens;
+    const size_t l_First = l_Tokens.size();
+    const uint32_t l_Size = static_cast<uint32_t>(m_Buffer->m_Source.size());
+    // The lexer keeps all of its state between slices, so a slice may end anywhere, even inside a token
+    if (m_Tool->position < l_Size)
+    {
+        m_Tool->lex(m_Tool->position, std::min(l_Size, m_Tool->position + c_SliceSize));
+    }
+    if (m_Tool->position >= l_Size)
+    {
+        m_Tool->finish();
+        m_Finished = true;
+    }
+    if (m_SymbolCache != nullptr)
+    {
+        internRange(*m_Buffer, l_Tokens, l_First, l_Tokens.size(), *m_SymbolCache);
+    }
+    for (TokenStream::Text& l_Text : l_Tokens.getTexts().subspan(l_First))
+    {
+        if (l_Text.storage == Tokenizer::Token::POOL)
+        {
+            l_Text.offset += m_PoolBase;
+        }
+        else if (l_Text.storage == Tokenizer::Token::NUMBER_TABLE)
+        {
+            l_Text.offset += m_NumberBase;
+        }
+    }
+    return true;
+}
+
+void TokenCursor::discardConsumed()
+{
+    TokenStream& l_Tokens = m_Buffer->m_Tokens;
+    if (m_Head < c_SliceSize || m_Head * 2 < l_Tokens.size())
+    {
+        return;
+    }
+
+    // Pool entries and numbers are added in token order, so everything before the oldest one still reachable goes
+    uint32_t l_PoolKeep = m_PoolBase + static_cast<uint32_t>(m_Buffer->m_Pool.size());
+    uint32_t l_NumberKeep = m_NumberBase + static_cast<uint32_t>(m_Buffer->m_Numbers.size());
+    const auto l_Keep = [&](const Tokenizer::Token& p_Token)
+    {
+        if (p_Token.storage == Tokenizer::Token::POOL)
+        {
+            l_PoolKeep = std::min(l_PoolKeep, p_Token.offset);
+        }
+        else if (p_Token.storage == Tokenizer::Token::NUMBER_TABLE)
+        {
+            l_NumberKeep = std::min(l_NumberKeep, p_Token.offset);
+        }
+    };
+    l_Keep(m_Last);
+    for (size_t l_Index = m_Head; l_Index < l_Tokens.size(); ++l_Index)
+    {
+        l_Keep(l_Tokens[l_Index]);
+    }
+
+    m_Buffer->m_Pool.erase(0, l_PoolKeep - m_PoolBase);
+    m_PoolBase = l_PoolKeep;
+    m_Buffer->m_Numbers.erase(m_Buffer->m_Numbers.begin(), m_Buffer->m_Numbers.begin() + (l_NumberKeep - m_NumberBase));
+    m_NumberBase = l_NumberKeep;
+    l_Tokens.eraseFront(m_Head);
+    m_Head = 0;
+
+    // Lines before the one the last returned token is on go too. Tokens come in source order, so none ahead is
+    // earlier, and the table's first entry stays the start of m_FirstLine
+    std::pmr::vector<uint32_t>& l_LineStarts = m_Buffer->m_LineStarts;
+    const size_t l_Lines = std::ranges::upper_bound(l_LineStarts, m_Last.position) - l_LineStarts.begin() - 1;
+    l_LineStarts.erase(l_LineStarts.begin(), l_LineStarts.begin() + static_cast<ptrdiff_t>(l_Lines));
+    m_Buffer->m_FirstLine += static_cast<uint32_t>(l_Lines);
+}
+
+Tokenizer::Token TokenCursor::next()
+{
+    const Tokenizer::Token l_Token = peek(0);
+    if (m_Head < m_Buffer->m_Tokens.size())
+    {
+        m_Head++;
+    }
+    m_Done = l_Token.type == Tokenizer::Token::Type::END;
+    m_Last = l_Token;
+    return l_Token;
+}
+
+Tokenizer::Token TokenCursor::peek(const uint32_t p_Ahead)
+{
+    while (m_Buffer->m_Tokens.size() - m_Head <= p_Ahead)
+    {
+        if (!lexMore())
+        {
+            // Only END is left to repeat
+            return m_Buffer->m_Tokens.empty() ? m_Last : m_Buffer->m_Tokens.back();
+        }
+    }
+    return m_Buffer->m_Tokens[m_Head + p_Ahead];
+}
+
+Tokenizer::Token TokenCursor::toPhysical(Tokenizer::Token p_Token) const
+{
+    if (p_Token.storage == Tokenizer::Token::POOL)
+    {
+        p_Token.offset -= m_PoolBase;
+    }
+    else if (p_Token.storage == Tokenizer::Token::NUMBER_TABLE)
+    {
+        p_Token.offset -= m_NumberBase;
+    }
+    return p_Token;
+}
+
+std::string_view TokenCursor::getValue(const Tokenizer::Token& p_Token) const
+{
+    return m_Buffer->getValue(toPhysical(p_Token));
+}
+
+const NumberLiteral& TokenCursor::getNumber(const Tokenizer::Token& p_Token) const
+{
+    return m_Buffer->getNumber(toPhysical(p_Token));
+}
+
+Tokenizer::Location TokenCursor::getLocation(const Tokenizer::Token& p_Token) const
+{
+    return m_Buffer->getLocation(p_Token);
+}
+
+const std::pmr::vector<Tokenizer::Error>& TokenCursor::getErrors() const
+{
+    return m_Tool->errors;
 }
@@ -2,69 +2,128 @@
 #include <cstdint>
 #include <string_view>
 #include <array>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
 #include <span>
 #include <string>
 #include <vector>
 
+#include "number_scanner.hpp"
+#include "perfect_hash.hpp"
+#include "symbol_table.hpp"
+#include "token.hpp"
+#include "token_stream.hpp"
+
 class SourceReader;
+class TaskScheduler;
+class TokenCache;
+struct TokenizerTool;
 
 class Tokenizer
 {
 public:
-    struct Token
+    // Defined on its own so that TokenStream can hold it
+    using Token = ::Token;
+
+    struct Location
     {
-        enum Type: uint8_t
-        {
-            KEYWORD,
-            IDENTIFIER,
-            STRING,
-            NUMBER,
-            BOOLEAN,
-            NONE,
-            OPERATOR,
-            DELIMITER,
-            INDENT,
-            DEDENT,
-            NEWLINE,
-            COMMENT,
-            END
-        };
-        
-        Type type;
-        std::string value;
         uint32_t line;
         uint32_t column;
     };
 
-    explicit Tokenizer(std::string_view p_Contents);
+    struct Number
+    {
+        uint32_t offset;
+        uint32_t length;
+        NumberLiteral literal;
+    };
 
-    [[nodiscard]] const std::vector<Token>& getTokens() const { return m_Tokens; }
+    struct Error
+    {
+        std::string message;
+        uint32_t line;
+        uint32_t column;
+    };
 
-private:
-    std::string m_Source;
-    std::vector<Token> m_Tokens;
+    // p_Contents is not copied, it has to outlive the tokenizer. p_FirstLine is the line number of its first line.
+    // With a scheduler, large sources are split and lexed on several threads, with the same result. Tokens, text
+    // and errors are allocated from p_Memory, which has to outlive the tokenizer too
+    explicit Tokenizer(std::string_view p_Contents, uint32_t p_FirstLine = 1, TaskScheduler* p_Scheduler = nullptr, SymbolTable* p_Symbols = nullptr, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+    [[nodiscard]] const TokenStream& getTokens() const { return m_Tokens; }
+    [[nodiscard]] const std::pmr::vector<Error>& getErrors() const { return m_Errors; }
+    // Binary search over the line start table, only meant for diagnostics and dumps
+    [[nodiscard]] Location getLocation(const Token& p_Token) const;
+    // For callers walking the tokens in order: p_LineHint is the line index the previous call ended on, 0 at first,
+    // and the search goes forward from it
+    [[nodiscard]] Location getLocation(const Token& p_Token, uint32_t& p_LineHint) const;
+    // Errors are collected while tokenizing and only printed on request, so that tokenizers running on
+    // several threads do not interleave their reports
+    void printErrors(std::ostream& p_Stream = std::cerr) const;
+    [[nodiscard]] std::string_view getValue(const Token& p_Token) const;
+    // Only valid for NUMBER tokens
+    [[nodiscard]] const NumberLiteral& getNumber(const Token& p_Token) const { return m_Numbers[p_Token.offset].literal; }
+
+    enum CharClass: uint8_t
+    {
+        CHAR_WORD = 1 << 0,
+        CHAR_OPERATOR = 1 << 1,
+        CHAR_DELIMITER = 1 << 2,
+        CHAR_UNUSED_DELIMITER = 1 << 3,
+        CHAR_OPENING_DELIMITER = 1 << 4,
+        CHAR_CLOSING_DELIMITER = 1 << 5
+    };
+
+    static constexpr uint8_t getCharClass(const char p_Char) { return c_CharClasses[static_cast<uint8_t>(p_Char)]; }
 
-    friend class TokenizerTool;
+private:
+    // Chunk of a source lexed on several threads, filled in by TokenizerTool
+    Tokenizer() = default;
+    // Filled in by TokenCache
+    explicit Tokenizer(std::pmr::memory_resource* p_Memory);
+
+    // With a scheduler, the tokens are split into one range per worker
+    void internSymbols(SymbolTable& p_Symbols, TaskScheduler* p_Scheduler);
+
+    // Smallest chunk worth lexing on its own thread
+    static constexpr uint32_t c_MinChunkSize = 1 << 20;
+    // Fewest source bytes per token in ordinary code, so that reserving by it rarely has the token vector grow, which
+    // in an arena would leave the old storage behind
+    static constexpr uint32_t c_MinBytesPerToken = 4;
+
+    std::string_view m_Source;
+    uint32_t m_FirstLine = 1;
+    // Offset of the first byte of every line the lexer counted, in order
+    std::pmr::vector<uint32_t> m_LineStarts;
+    std::pmr::string m_Pool;
+    std::pmr::vector<Number> m_Numbers;
+    TokenStream m_Tokens;
+    // The messages themselves stay on the global heap, errors are few
+    std::pmr::vector<Error> m_Errors;
+
+    friend struct TokenizerTool;
+    friend class TokenCursor;
+    friend class TokenCache;
+    // Derives its keyword table from c_Keywords
+    friend class Parser;
 private:
     enum FoundStatus: uint8_t {NOT_FOUND, FOUND, UNUSED};
 
-    
-    template<size_t S1, size_t S2>
-    static FoundStatus findInLists(const std::array<const char*, S1>& p_elems, const std::array<const char*, S2>& p_Unused, std::string_view p_Elem);
-
     static FoundStatus isKeyword(std::string_view p_Identifier);
+    static bool isOperatorKeyword(std::string_view p_Identifier);
     static FoundStatus isOperator(std::string_view p_Operator);
     static FoundStatus isDelimiter(std::string_view p_Delimiter);
     static bool isOpeningDelimiter(std::string_view p_Delimiter);
     static bool isClosingDelimiter(std::string_view p_Delimiter);
 
-    static constexpr std::array<const char*, 18> c_Keywords{
+    static constexpr std::array<const char*, 19> c_Keywords{
         "if", "else", "elif", "while", "for", "def", "return", "class",
-        "import", "from", "as", "pass", "break", "continue", "staticmethod", "and", "or", "not"
+        "import", "from", "as", "pass", "break", "continue", "staticmethod", "and", "or", "not", "in"
     };
-    static constexpr std::array<const char*, 13> c_UnusedKeywords{
+    static constexpr std::array<const char*, 12> c_UnusedKeywords{
         "try", "except", "finally", "with", "yield", "lambda", "global", "nonlocal",
-        "assert", "raise", "del", "in", "is"
+        "assert", "raise", "del", "is"
     };
 
     static constexpr std::array<const char*, 33> c_Operators{
@@ -79,11 +138,11 @@ private:
         
     };
 
-    static constexpr std::array<const char*, 4> c_OperatorKeywords{
-        "and", "or", "not", "is"
+    static constexpr std::array<const char*, 5> c_OperatorKeywords{
+        "and", "or", "not", "in", "is"
     };
 
-    static constexpr std::array<char, 14> c_OperatorCharacters{
+    static constexpr std::array<char, 13> c_OperatorCharacters{
         '+', '-', '*', '/', '%', '=', '<', '>', '!', '&', '|', '^', '~'
     };
 
@@ -102,5 +161,91 @@ private:
     static constexpr std::array<const char*, 3> c_ClosingDelimiters{
         ")", "]", "}"
     };
+
+    // Lookup tables generated from the lists above, which stay the single source of truth
+    static constexpr auto c_KeywordTable = makePerfectHashMap(c_Keywords, FOUND, c_UnusedKeywords, UNUSED, NOT_FOUND);
+    static constexpr auto c_OperatorKeywordTable = makePerfectHashMap(c_OperatorKeywords, true, false);
+    static constexpr auto c_OperatorTable = makePerfectHashMap(c_Operators, FOUND, c_UnusedOperators, UNUSED, NOT_FOUND);
+    static constexpr auto c_DelimiterTable = makePerfectHashMap(c_Delimiters, FOUND, c_UnusedDelimiters, UNUSED, NOT_FOUND);
+
+    static constexpr std::array<uint8_t, 256> c_CharClasses = []
+    {
+        std::array<uint8_t, 256> l_Classes{};
+        const auto l_Mark = [&l_Classes](const auto& p_Delimiters, const uint8_t p_Class)
+        {
+            for (const char* l_Delimiter : p_Delimiters)
+            {
+                l_Classes[static_cast<uint8_t>(l_Delimiter[0])] |= p_Class;
+            }
+        };
+        for (uint32_t l_Char = 0; l_Char < 256; ++l_Char)
+        {
+            if ((l_Char >= 'a' && l_Char <= 'z') || (l_Char >= 'A' && l_Char <= 'Z') || (l_Char >= '0' && l_Char <= '9') || l_Char == '_')
+            {
+                l_Classes[l_Char] |= CHAR_WORD;
+            }
+        }
+        for (const char l_Char : c_OperatorCharacters)
+        {
+            l_Classes[static_cast<uint8_t>(l_Char)] |= CHAR_OPERATOR;
+        }
+        l_Mark(c_Delimiters, CHAR_DELIMITER);
+        l_Mark(c_UnusedDelimiters, CHAR_UNUSED_DELIMITER);
+        l_Mark(c_OpeningDelimiters, CHAR_OPENING_DELIMITER);
+        l_Mark(c_ClosingDelimiters, CHAR_CLOSING_DELIMITER);
+        return l_Classes;
+    }();
+};
+
+// Pull-based alternative to Tokenizer. Tokens are lexed a slice of the source at a time as they are asked for, and only
+// the ones not consumed yet are kept, with their text and the starts of their lines, so memory stays bounded by the
+// lookahead instead of growing with the source.
+// Yields the same tokens and errors as Tokenizer
+class TokenCursor
+{
+public:
+    // p_Contents is not copied, it has to outlive the cursor
+    explicit TokenCursor(std::string_view p_Contents, uint32_t p_FirstLine = 1, SymbolTable* p_Symbols = nullptr);
+    ~TokenCursor();
+
+    TokenCursor(TokenCursor&& p_Other) noexcept;
+    TokenCursor& operator=(TokenCursor&& p_Other) noexcept;
+    TokenCursor(const TokenCursor&) = delete;
+    TokenCursor& operator=(const TokenCursor&) = delete;
+
+    // Consumes the next token. Once END has been returned, keeps returning it
+    Tokenizer::Token next();
+    // Token p_Ahead positions after the one next() returns, without consuming anything. Past the end this is END
+    Tokenizer::Token peek(uint32_t p_Ahead = 0);
+    [[nodiscard]] bool isDone() const { return m_Done; }
+
+    // These three only for the token last returned by next() and the ones still ahead
+    [[nodiscard]] std::string_view getValue(const Tokenizer::Token& p_Token) const;
+    [[nodiscard]] const NumberLiteral& getNumber(const Tokenizer::Token& p_Token) const;
+    [[nodiscard]] Tokenizer::Location getLocation(const Tokenizer::Token& p_Token) const;
+    // Errors found in the part of the source lexed so far
+    [[nodiscard]] const std::pmr::vector<Tokenizer::Error>& getErrors() const;
+
+private:
+    // Lexes one more slice, returns false once the whole source has been lexed
+    bool lexMore();
+    void discardConsumed();
+    [[nodiscard]] Tokenizer::Token toPhysical(Tokenizer::Token p_Token) const;
+
+    // Bytes lexed per refill
+    static constexpr uint32_t c_SliceSize = 4096;
+
+    // Holds the window: m_Tokens from m_Head on, plus the pool text, numbers and line starts they and the last returned
+    // token use. Its m_FirstLine is the line of the first line start kept
+    std::unique_ptr<Tokenizer> m_Buffer;
+    std::unique_ptr<TokenizerTool> m_Tool;
+    uint32_t m_Head = 0;
+    // Handed-out tokens address the pool and number table as if nothing had ever been discarded from them
+    uint32_t m_PoolBase = 0;
+    uint32_t m_NumberBase = 0;
+    std::unique_ptr<SymbolCache> m_SymbolCache;
+    Tokenizer::Token m_Last{ .type = Tokenizer::Token::Type::END, .position = 0 };
+    bool m_Finished = false;
+    bool m_Done = false;
 };
 
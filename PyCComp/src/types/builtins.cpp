@@ -0,0 +1,113 @@
+#include "builtins.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace
+{
+    constexpr std::array<std::string_view, Builtins::FUNCTION_COUNT> c_FunctionNames{
+        "print", "len", "range", "int", "float", "str", "bool", "abs", "min", "max", "sum"
+    };
+
+    constexpr std::array<Builtins::MethodInfo, Builtins::METHOD_COUNT> c_Methods{ {
+        { "append", true, 1, 1 },
+        { "pop", true, 0, 1 },
+        { "insert", true, 2, 2 },
+        { "extend", true, 1, 1 },
+        { "upper", false, 0, 0 },
+        { "lower", false, 0, 0 },
+        { "strip", false, 0, 0 },
+        { "split", false, 0, 1 },
+        { "join", false, 1, 1 },
+        { "startswith", false, 1, 1 },
+        { "endswith", false, 1, 1 },
+        { "replace", false, 2, 2 },
+        { "find", false, 1, 1 }
+    } };
+
+    // Where Python raises ValueError on a domain error, like sqrt(-1), the <cmath> functions return NaN
+    constexpr std::array<Builtins::MathFunction, 29> c_MathFunctions{ {
+        { "sqrt", "::std::sqrt", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::sqrt(p_Arguments[0]); } },
+        { "exp", "::std::exp", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::exp(p_Arguments[0]); } },
+        { "log", "::pyc::log", 1, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return p_Arguments.size() == 1 ? std::log(p_Arguments[0]) : std::log(p_Arguments[0]) / std::log(p_Arguments[1]); } },
+        { "log2", "::std::log2", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::log2(p_Arguments[0]); } },
+        { "log10", "::std::log10", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::log10(p_Arguments[0]); } },
+        { "pow", "::std::pow", 2, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::pow(p_Arguments[0], p_Arguments[1]); } },
+        { "sin", "::std::sin", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::sin(p_Arguments[0]); } },
+        { "cos", "::std::cos", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::cos(p_Arguments[0]); } },
+        { "tan", "::std::tan", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::tan(p_Arguments[0]); } },
+        { "asin", "::std::asin", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::asin(p_Arguments[0]); } },
+        { "acos", "::std::acos", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::acos(p_Arguments[0]); } },
+        { "atan", "::std::atan", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::atan(p_Arguments[0]); } },
+        { "atan2", "::std::atan2", 2, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::atan2(p_Arguments[0], p_Arguments[1]); } },
+        { "sinh", "::std::sinh", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::sinh(p_Arguments[0]); } },
+        { "cosh", "::std::cosh", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::cosh(p_Arguments[0]); } },
+        { "tanh", "::std::tanh", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::tanh(p_Arguments[0]); } },
+        { "hypot", "::std::hypot", 2, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::hypot(p_Arguments[0], p_Arguments[1]); } },
+        { "fabs", "::std::fabs", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::fabs(p_Arguments[0]); } },
+        { "fmod", "::std::fmod", 2, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::fmod(p_Arguments[0], p_Arguments[1]); } },
+        { "copysign", "::std::copysign", 2, 2, Type::FLOAT, [](const std::span<const double> p_Arguments) { return std::copysign(p_Arguments[0], p_Arguments[1]); } },
+        { "degrees", "::pyc::degrees", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return p_Arguments[0] * (180.0 / std::numbers::pi); } },
+        { "radians", "::pyc::radians", 1, 1, Type::FLOAT, [](const std::span<const double> p_Arguments) { return p_Arguments[0] * (std::numbers::pi / 180.0); } },
+        { "floor", "::pyc::floor", 1, 1, Type::INT, [](const std::span<const double> p_Arguments) { return std::floor(p_Arguments[0]); } },
+        { "ceil", "::pyc::ceil", 1, 1, Type::INT, [](const std::span<const double> p_Arguments) { return std::ceil(p_Arguments[0]); } },
+        { "trunc", "::pyc::trunc", 1, 1, Type::INT, [](const std::span<const double> p_Arguments) { return std::trunc(p_Arguments[0]); } },
+        { "isnan", "::std::isnan", 1, 1, Type::BOOL, [](const std::span<const double> p_Arguments) { return std::isnan(p_Arguments[0]) ? 1.0 : 0.0; } },
+        { "isinf", "::std::isinf", 1, 1, Type::BOOL, [](const std::span<const double> p_Arguments) { return std::isinf(p_Arguments[0]) ? 1.0 : 0.0; } },
+        { "isfinite", "::std::isfinite", 1, 1, Type::BOOL, [](const std::span<const double> p_Arguments) { return std::isfinite(p_Arguments[0]) ? 1.0 : 0.0; } },
+        { "gcd", "::pyc::gcd", 2, 2, Type::INT, nullptr }
+    } };
+
+    constexpr std::array<Builtins::MathConstant, 5> c_MathConstants{ {
+        { "pi", std::numbers::pi },
+        { "e", std::numbers::e },
+        { "tau", 2 * std::numbers::pi },
+        { "inf", std::numeric_limits<double>::infinity() },
+        { "nan", std::numeric_limits<double>::quiet_NaN() }
+    } };
+}
+
+std::optional<Builtins::Function> Builtins::findFunction(const std::string_view p_Name)
+{
+    const auto l_Found = std::ranges::find(c_FunctionNames, p_Name);
+    if (l_Found == c_FunctionNames.end())
+    {
+        return std::nullopt;
+    }
+    return static_cast<Function>(l_Found - c_FunctionNames.begin());
+}
+
+std::string_view Builtins::getFunctionName(const Function p_Function)
+{
+    return c_FunctionNames[p_Function];
+}
+
+std::optional<Builtins::Method> Builtins::findMethod(const std::string_view p_Name)
+{
+    const auto l_Found = std::ranges::find(c_Methods, p_Name, &MethodInfo::name);
+    if (l_Found == c_Methods.end())
+    {
+        return std::nullopt;
+    }
+    return static_cast<Method>(l_Found - c_Methods.begin());
+}
+
+const Builtins::MethodInfo& Builtins::getMethod(const Method p_Method)
+{
+    return c_Methods[p_Method];
+}
+
+const Builtins::MathFunction* Builtins::findMathFunction(const std::string_view p_Name)
+{
+    const auto l_Found = std::ranges::find(c_MathFunctions, p_Name, &MathFunction::name);
+    return l_Found == c_MathFunctions.end() ? nullptr : &*l_Found;
+}
+
+const Builtins::MathConstant* Builtins::findMathConstant(const std::string_view p_Name)
+{
+    const auto l_Found = std::ranges::find(c_MathConstants, p_Name, &MathConstant::name);
+    return l_Found == c_MathConstants.end() ? nullptr : &*l_Found;
+}
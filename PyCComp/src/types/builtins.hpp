@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "type.hpp"
+
+// What the compiled subset provides without a definition: Python's builtin functions, the math module and the methods
+// of str and list. Inference types calls to them and the C++ writer emits them from these tables
+class Builtins
+{
+public:
+    enum Function: uint8_t
+    {
+        PRINT,
+        LEN,
+        // Only as the iterable of a for loop
+        RANGE,
+        INT,
+        FLOAT,
+        STR,
+        BOOL,
+        ABS,
+        MIN,
+        MAX,
+        SUM,
+        FUNCTION_COUNT
+    };
+
+    enum Method: uint8_t
+    {
+        // list
+        APPEND,
+        POP,
+        INSERT,
+        EXTEND,
+        // str
+        UPPER,
+        LOWER,
+        STRIP,
+        SPLIT,
+        JOIN,
+        STARTSWITH,
+        ENDSWITH,
+        REPLACE,
+        FIND,
+        METHOD_COUNT
+    };
+
+    struct MethodInfo
+    {
+        std::string_view name;
+        bool onList;
+        uint8_t minArguments;
+        uint8_t maxArguments;
+    };
+
+    // A function of the math module. Arguments are passed as double
+    struct MathFunction
+    {
+        std::string_view name;
+        std::string_view cppName;
+        uint8_t minArguments;
+        uint8_t maxArguments;
+        // INT for the ones Python rounds to an int, BOOL for the predicates, FLOAT otherwise
+        Type::Kind result;
+        // What the C++ function gives, for calls the compiler folds: the rounded value of the INT ones and 0 or 1
+        // for the predicates. nullptr for gcd, which takes ints
+        double (*evaluate)(std::span<const double> p_Arguments);
+    };
+
+    struct MathConstant
+    {
+        std::string_view name;
+        double value;
+    };
+
+    [[nodiscard]] static std::optional<Function> findFunction(std::string_view p_Name);
+    [[nodiscard]] static std::string_view getFunctionName(Function p_Function);
+    [[nodiscard]] static std::optional<Method> findMethod(std::string_view p_Name);
+    [[nodiscard]] static const MethodInfo& getMethod(Method p_Method);
+    // nullptr if the math module has no such function or constant
+    [[nodiscard]] static const MathFunction* findMathFunction(std::string_view p_Name);
+    [[nodiscard]] static const MathConstant* findMathConstant(std::string_view p_Name);
+};
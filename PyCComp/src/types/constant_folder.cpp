@@ -0,0 +1,663 @@
+#include "constant_folder.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    using Constant = ConstantFolder::Constant;
+
+    constexpr int64_t c_MinInt = std::numeric_limits<int64_t>::min();
+    constexpr int64_t c_MaxInt = std::numeric_limits<int64_t>::max();
+
+    // bool counts as an int, like Python does in arithmetic
+    std::optional<int64_t> getInteger(const Constant& p_Constant)
+    {
+        if (const bool* const l_Bool = std::get_if<bool>(&p_Constant))
+        {
+            return *l_Bool ? 1 : 0;
+        }
+        if (const int64_t* const l_Int = std::get_if<int64_t>(&p_Constant))
+        {
+            return *l_Int;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<double> getNumber(const Constant& p_Constant)
+    {
+        if (const double* const l_Float = std::get_if<double>(&p_Constant))
+        {
+            return *l_Float;
+        }
+        const std::optional<int64_t> l_Int = getInteger(p_Constant);
+        return l_Int ? std::optional<double>(static_cast<double>(*l_Int)) : std::nullopt;
+    }
+
+    // The int a finite double rounds to, if it is one
+    std::optional<int64_t> toInteger(const double p_Value)
+    {
+        // 2^63 is exact as a double, INT64_MAX is not
+        if (!std::isfinite(p_Value) || p_Value < -0x1p63 || p_Value >= 0x1p63)
+        {
+            return std::nullopt;
+        }
+        return static_cast<int64_t>(p_Value);
+    }
+
+    // int arithmetic, nullopt where the result leaves 64 bits
+
+    std::optional<int64_t> add(const int64_t p_Left, const int64_t p_Right)
+    {
+        if ((p_Right > 0 && p_Left > c_MaxInt - p_Right) || (p_Right < 0 && p_Left < c_MinInt - p_Right))
+        {
+            return std::nullopt;
+        }
+        return p_Left + p_Right;
+    }
+
+    std::optional<int64_t> subtract(const int64_t p_Left, const int64_t p_Right)
+    {
+        if ((p_Right < 0 && p_Left > c_MaxInt + p_Right) || (p_Right > 0 && p_Left < c_MinInt + p_Right))
+        {
+            return std::nullopt;
+        }
+        return p_Left - p_Right;
+    }
+
+    std::optional<int64_t> multiply(const int64_t p_Left, const int64_t p_Right)
+    {
+        if (p_Left == 0 || p_Right == 0)
+        {
+            return 0;
+        }
+        const bool l_Overflows = p_Left > 0
+            ? (p_Right > 0 ? p_Left > c_MaxInt / p_Right : p_Right < c_MinInt / p_Left)
+            : (p_Right > 0 ? p_Left < c_MinInt / p_Right : p_Right < c_MaxInt / p_Left);
+        if (l_Overflows)
+        {
+            return std::nullopt;
+        }
+        return p_Left * p_Right;
+    }
+
+    std::optional<int64_t> power(int64_t p_Base, int64_t p_Exponent)
+    {
+        int64_t l_Result = 1;
+        while (p_Exponent > 0)
+        {
+            if (p_Exponent & 1)
+            {
+                const std::optional<int64_t> l_Product = multiply(l_Result, p_Base);
+                if (!l_Product)
+                {
+                    return std::nullopt;
+                }
+                l_Result = *l_Product;
+            }
+            p_Exponent >>= 1;
+            if (p_Exponent > 0)
+            {
+                const std::optional<int64_t> l_Square = multiply(p_Base, p_Base);
+                if (!l_Square)
+                {
+                    return std::nullopt;
+                }
+                p_Base = *l_Square;
+            }
+        }
+        return l_Result;
+    }
+
+    std::optional<Constant> foldIntegers(const Ast::Operator p_Operator, const int64_t p_Left, const int64_t p_Right, const bool p_Bools)
+    {
+        std::optional<int64_t> l_Result;
+        switch (p_Operator)
+        {
+        case Ast::ADD:
+            l_Result = add(p_Left, p_Right);
+            break;
+        case Ast::SUBTRACT:
+            l_Result = subtract(p_Left, p_Right);
+            break;
+        case Ast::MULTIPLY:
+            l_Result = multiply(p_Left, p_Right);
+            break;
+        case Ast::DIVIDE:
+            if (p_Right == 0)
+            {
+                return std::nullopt;
+            }
+            return static_cast<double>(p_Left) / static_cast<double>(p_Right);
+        case Ast::FLOOR_DIVIDE:
+            {
+                if (p_Right == 0 || (p_Right == -1 && p_Left == c_MinInt))
+                {
+                    return std::nullopt;
+                }
+                const int64_t l_Quotient = p_Left / p_Right;
+                l_Result = p_Left % p_Right != 0 && (p_Left < 0) != (p_Right < 0) ? l_Quotient - 1 : l_Quotient;
+                break;
+            }
+        case Ast::MODULO:
+            {
+                if (p_Right == 0)
+                {
+                    return std::nullopt;
+                }
+                if (p_Right == -1)
+                {
+                    return int64_t{ 0 };
+                }
+                const int64_t l_Remainder = p_Left % p_Right;
+                l_Result = l_Remainder != 0 && (l_Remainder < 0) != (p_Right < 0) ? l_Remainder + p_Right : l_Remainder;
+                break;
+            }
+        case Ast::POWER:
+            if (p_Right >= 0)
+            {
+                l_Result = power(p_Left, p_Right);
+                break;
+            }
+            // A negative exponent makes a float
+            if (p_Left == 0)
+            {
+                return std::nullopt;
+            }
+            return std::pow(static_cast<double>(p_Left), static_cast<double>(p_Right));
+        case Ast::BIT_AND:
+        case Ast::BIT_OR:
+        case Ast::BIT_XOR:
+            {
+                const int64_t l_Value = p_Operator == Ast::BIT_AND ? p_Left & p_Right : p_Operator == Ast::BIT_OR ? p_Left | p_Right : p_Left ^ p_Right;
+                if (p_Bools)
+                {
+                    return l_Value != 0;
+                }
+                l_Result = l_Value;
+                break;
+            }
+        case Ast::SHIFT_LEFT:
+            {
+                if (p_Right < 0 || (p_Right >= 64 && p_Left != 0))
+                {
+                    return std::nullopt;
+                }
+                if (p_Left == 0)
+                {
+                    return int64_t{ 0 };
+                }
+                const int64_t l_Shifted = static_cast<int64_t>(static_cast<uint64_t>(p_Left) << p_Right);
+                if (l_Shifted >> p_Right != p_Left)
+                {
+                    return std::nullopt;
+                }
+                l_Result = l_Shifted;
+                break;
+            }
+        case Ast::SHIFT_RIGHT:
+            if (p_Right < 0)
+            {
+                return std::nullopt;
+            }
+            l_Result = p_Right >= 64 ? (p_Left < 0 ? -1 : 0) : p_Left >> p_Right;
+            break;
+        default:
+            return std::nullopt;
+        }
+        if (!l_Result)
+        {
+            return std::nullopt;
+        }
+        return *l_Result;
+    }
+
+    std::optional<Constant> foldFloats(const Ast::Operator p_Operator, const double p_Left, const double p_Right)
+    {
+        switch (p_Operator)
+        {
+        case Ast::ADD:
+            return p_Left + p_Right;
+        case Ast::SUBTRACT:
+            return p_Left - p_Right;
+        case Ast::MULTIPLY:
+            return p_Left * p_Right;
+        case Ast::DIVIDE:
+            if (p_Right == 0.0)
+            {
+                return std::nullopt;
+            }
+            return p_Left / p_Right;
+        case Ast::FLOOR_DIVIDE:
+            if (p_Right == 0.0)
+            {
+                return std::nullopt;
+            }
+            return std::floor(p_Left / p_Right);
+        case Ast::MODULO:
+            {
+                if (p_Right == 0.0)
+                {
+                    return std::nullopt;
+                }
+                double l_Remainder = std::fmod(p_Left, p_Right);
+                if (l_Remainder != 0.0 && (l_Remainder < 0.0) != (p_Right < 0.0))
+                {
+                    l_Remainder += p_Right;
+                }
+                return l_Remainder;
+            }
+        case Ast::POWER:
+            {
+                // Python raises where the result overflows or would be complex
+                const double l_Result = std::pow(p_Left, p_Right);
+                if ((p_Left == 0.0 && p_Right < 0.0) || (!std::isfinite(l_Result) && std::isfinite(p_Left) && std::isfinite(p_Right)))
+                {
+                    return std::nullopt;
+                }
+                return l_Result;
+            }
+        default:
+            return std::nullopt;
+        }
+    }
+
+    // nullopt where Python cannot compare them
+    std::optional<bool> compare(const Ast::Operator p_Operator, const Constant& p_Left, const Constant& p_Right)
+    {
+        const std::optional<double> l_LeftNumber = getNumber(p_Left);
+        const std::optional<double> l_RightNumber = getNumber(p_Right);
+        int l_Order = 0;
+        if (l_LeftNumber && l_RightNumber)
+        {
+            // ints compare as ints, they do not all fit in a double
+            if (std::holds_alternative<double>(p_Left) || std::holds_alternative<double>(p_Right))
+            {
+                if (std::isnan(*l_LeftNumber) || std::isnan(*l_RightNumber))
+                {
+                    return p_Operator == Ast::NOT_EQUAL;
+                }
+                l_Order = *l_LeftNumber < *l_RightNumber ? -1 : *l_LeftNumber > *l_RightNumber ? 1 : 0;
+            }
+            else
+            {
+                const int64_t l_Left = *getInteger(p_Left);
+                const int64_t l_Right = *getInteger(p_Right);
+                l_Order = l_Left < l_Right ? -1 : l_Left > l_Right ? 1 : 0;
+            }
+        }
+        else if (std::holds_alternative<std::string>(p_Left) && std::holds_alternative<std::string>(p_Right))
+        {
+            const int l_Compared = std::get<std::string>(p_Left).compare(std::get<std::string>(p_Right));
+            l_Order = l_Compared < 0 ? -1 : l_Compared > 0 ? 1 : 0;
+        }
+        else if (p_Operator == Ast::EQUAL || p_Operator == Ast::NOT_EQUAL)
+        {
+            // Values of different types are never equal, and None is only equal to itself
+            const bool l_Equal = std::holds_alternative<std::monostate>(p_Left) && std::holds_alternative<std::monostate>(p_Right);
+            return l_Equal == (p_Operator == Ast::EQUAL);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+        switch (p_Operator)
+        {
+        case Ast::EQUAL:
+            return l_Order == 0;
+        case Ast::NOT_EQUAL:
+            return l_Order != 0;
+        case Ast::LESS:
+            return l_Order < 0;
+        case Ast::LESS_EQUAL:
+            return l_Order <= 0;
+        case Ast::GREATER:
+            return l_Order > 0;
+        case Ast::GREATER_EQUAL:
+            return l_Order >= 0;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    std::optional<Constant> repeat(const std::string& p_Text, const int64_t p_Count)
+    {
+        if (p_Count <= 0 || p_Text.empty())
+        {
+            return std::string();
+        }
+        if (static_cast<uint64_t>(p_Count) > ConstantFolder::c_MaxStringSize / p_Text.size())
+        {
+            return std::nullopt;
+        }
+        std::string l_Result;
+        for (int64_t l_Index = 0; l_Index < p_Count; ++l_Index)
+        {
+            l_Result += p_Text;
+        }
+        return l_Result;
+    }
+}
+
+Type ConstantFolder::getType(const Constant& p_Constant)
+{
+    constexpr Type::Kind c_Kinds[] = { Type::NONE, Type::BOOL, Type::INT, Type::FLOAT, Type::STRING };
+    return c_Kinds[p_Constant.index()];
+}
+
+bool ConstantFolder::isTruthy(const Constant& p_Constant)
+{
+    switch (p_Constant.index())
+    {
+    case 0:
+        return false;
+    case 3:
+        return std::get<double>(p_Constant) != 0.0;
+    case 4:
+        return !std::get<std::string>(p_Constant).empty();
+    default:
+        return *getInteger(p_Constant) != 0;
+    }
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::readLiteral(const Ast& p_Ast, const Ast::NodeIndex p_Node)
+{
+    const Ast::Node& l_Node = p_Ast.getNode(p_Node);
+    switch (l_Node.kind)
+    {
+    case Ast::INTEGER:
+        return p_Ast.getInteger(p_Node);
+    case Ast::FLOAT:
+        return p_Ast.getFloat(p_Node);
+    case Ast::STRING:
+        return decodeString(p_Ast.getString(p_Node));
+    case Ast::BOOLEAN:
+        return l_Node.first != 0;
+    case Ast::NONE:
+        return std::monostate{};
+    default:
+        return std::nullopt;
+    }
+}
+
+std::string ConstantFolder::decodeString(const std::string_view p_Raw)
+{
+    std::string l_Value;
+    for (size_t l_Index = 0; l_Index < p_Raw.size(); ++l_Index)
+    {
+        if (p_Raw[l_Index] != '\\' || l_Index + 1 == p_Raw.size())
+        {
+            l_Value += p_Raw[l_Index];
+            continue;
+        }
+        const char l_Escape = p_Raw[++l_Index];
+        switch (l_Escape)
+        {
+        case 'n': l_Value += '\n'; break;
+        case 't': l_Value += '\t'; break;
+        case 'r': l_Value += '\r'; break;
+        case '0': l_Value += '\0'; break;
+        case 'a': l_Value += '\a'; break;
+        case 'b': l_Value += '\b'; break;
+        case 'f': l_Value += '\f'; break;
+        case 'v': l_Value += '\v'; break;
+        case '\\':
+        case '\'':
+        case '"':
+            l_Value += l_Escape;
+            break;
+        // A line continuation
+        case '\n':
+            break;
+        case 'x':
+            {
+                uint8_t l_Byte = 0;
+                const std::from_chars_result l_Result = std::from_chars(p_Raw.data() + l_Index + 1, p_Raw.data() + std::min(l_Index + 3, p_Raw.size()), l_Byte, 16);
+                if (l_Result.ptr == p_Raw.data() + l_Index + 3)
+                {
+                    l_Value += static_cast<char>(l_Byte);
+                    l_Index += 2;
+                    break;
+                }
+                [[fallthrough]];
+            }
+        default:
+            // Python keeps unknown escapes as they are
+            l_Value += '\\';
+            l_Value += l_Escape;
+            break;
+        }
+    }
+    return l_Value;
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::convert(const Constant& p_Constant, const Type p_Type)
+{
+    if (getType(p_Constant) == p_Type)
+    {
+        return p_Constant;
+    }
+    const std::optional<int64_t> l_Int = getInteger(p_Constant);
+    if (l_Int && p_Type == Type::FLOAT)
+    {
+        return static_cast<double>(*l_Int);
+    }
+    if (l_Int && p_Type == Type::INT)
+    {
+        return *l_Int;
+    }
+    return std::nullopt;
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::unary(const Ast::Operator p_Operator, const Constant& p_Operand)
+{
+    if (p_Operator == Ast::NOT)
+    {
+        return !isTruthy(p_Operand);
+    }
+    if (const double* const l_Float = std::get_if<double>(&p_Operand))
+    {
+        if (p_Operator == Ast::INVERT)
+        {
+            return std::nullopt;
+        }
+        return p_Operator == Ast::NEGATE ? -*l_Float : *l_Float;
+    }
+    const std::optional<int64_t> l_Int = getInteger(p_Operand);
+    if (!l_Int || (p_Operator == Ast::NEGATE && *l_Int == c_MinInt))
+    {
+        return std::nullopt;
+    }
+    switch (p_Operator)
+    {
+    case Ast::NEGATE:
+        return -*l_Int;
+    case Ast::POSITIVE:
+        return *l_Int;
+    case Ast::INVERT:
+        return ~*l_Int;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::binary(const Ast::Operator p_Operator, const Constant& p_Left, const Constant& p_Right)
+{
+    if (p_Operator == Ast::AND || p_Operator == Ast::OR)
+    {
+        return isTruthy(p_Left) == (p_Operator == Ast::OR) ? p_Left : p_Right;
+    }
+    if (p_Operator == Ast::IN || p_Operator == Ast::NOT_IN)
+    {
+        const std::string* const l_Part = std::get_if<std::string>(&p_Left);
+        const std::string* const l_Text = std::get_if<std::string>(&p_Right);
+        if (l_Part == nullptr || l_Text == nullptr)
+        {
+            return std::nullopt;
+        }
+        return (l_Text->find(*l_Part) != std::string::npos) == (p_Operator == Ast::IN);
+    }
+    if (Ast::isComparison(p_Operator))
+    {
+        const std::optional<bool> l_Result = compare(p_Operator, p_Left, p_Right);
+        return l_Result ? std::optional<Constant>(*l_Result) : std::nullopt;
+    }
+
+    const std::optional<int64_t> l_LeftInt = getInteger(p_Left);
+    const std::optional<int64_t> l_RightInt = getInteger(p_Right);
+    if (l_LeftInt && l_RightInt)
+    {
+        return foldIntegers(p_Operator, *l_LeftInt, *l_RightInt, std::holds_alternative<bool>(p_Left) && std::holds_alternative<bool>(p_Right));
+    }
+    const std::optional<double> l_LeftNumber = getNumber(p_Left);
+    const std::optional<double> l_RightNumber = getNumber(p_Right);
+    if (l_LeftNumber && l_RightNumber)
+    {
+        return foldFloats(p_Operator, *l_LeftNumber, *l_RightNumber);
+    }
+
+    const std::string* const l_LeftText = std::get_if<std::string>(&p_Left);
+    const std::string* const l_RightText = std::get_if<std::string>(&p_Right);
+    if (p_Operator == Ast::ADD && l_LeftText != nullptr && l_RightText != nullptr)
+    {
+        if (l_LeftText->size() + l_RightText->size() > c_MaxStringSize)
+        {
+            return std::nullopt;
+        }
+        return *l_LeftText + *l_RightText;
+    }
+    if (p_Operator == Ast::MULTIPLY && l_LeftText != nullptr && l_RightInt)
+    {
+        return repeat(*l_LeftText, *l_RightInt);
+    }
+    if (p_Operator == Ast::MULTIPLY && l_RightText != nullptr && l_LeftInt)
+    {
+        return repeat(*l_RightText, *l_LeftInt);
+    }
+    return std::nullopt;
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::callBuiltin(const Builtins::Function p_Function, const std::span<const Constant> p_Arguments)
+{
+    if (p_Arguments.empty())
+    {
+        switch (p_Function)
+        {
+        case Builtins::INT:
+            return int64_t{ 0 };
+        case Builtins::FLOAT:
+            return 0.0;
+        case Builtins::BOOL:
+            return false;
+        default:
+            return std::nullopt;
+        }
+    }
+    const Constant& l_First = p_Arguments[0];
+    if (p_Function == Builtins::MIN || p_Function == Builtins::MAX)
+    {
+        // The first of the smallest or largest, as Python keeps it
+        if (p_Arguments.size() < 2)
+        {
+            return std::nullopt;
+        }
+        size_t l_Result = 0;
+        for (size_t l_Index = 1; l_Index < p_Arguments.size(); ++l_Index)
+        {
+            const std::optional<bool> l_Replaces = p_Function == Builtins::MIN ? compare(Ast::LESS, p_Arguments[l_Index], p_Arguments[l_Result]) : compare(Ast::LESS, p_Arguments[l_Result], p_Arguments[l_Index]);
+            if (!l_Replaces)
+            {
+                return std::nullopt;
+            }
+            l_Result = *l_Replaces ? l_Index : l_Result;
+        }
+        return p_Arguments[l_Result];
+    }
+    if (p_Arguments.size() != 1)
+    {
+        return std::nullopt;
+    }
+    switch (p_Function)
+    {
+    case Builtins::LEN:
+        if (const std::string* const l_Text = std::get_if<std::string>(&l_First))
+        {
+            return static_cast<int64_t>(l_Text->size());
+        }
+        return std::nullopt;
+    case Builtins::INT:
+        if (const double* const l_Float = std::get_if<double>(&l_First))
+        {
+            const std::optional<int64_t> l_Int = toInteger(std::trunc(*l_Float));
+            return l_Int ? std::optional<Constant>(*l_Int) : std::nullopt;
+        }
+        return convert(l_First, Type::INT);
+    case Builtins::FLOAT:
+        return convert(l_First, Type::FLOAT);
+    case Builtins::BOOL:
+        return isTruthy(l_First);
+    case Builtins::ABS:
+        if (const double* const l_Float = std::get_if<double>(&l_First))
+        {
+            return std::fabs(*l_Float);
+        }
+        if (const std::optional<int64_t> l_Int = getInteger(l_First); l_Int && *l_Int != c_MinInt)
+        {
+            return *l_Int < 0 ? -*l_Int : *l_Int;
+        }
+        return std::nullopt;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<ConstantFolder::Constant> ConstantFolder::callMath(const Builtins::MathFunction& p_Function, const std::span<const Constant> p_Arguments)
+{
+    if (p_Arguments.size() < p_Function.minArguments || p_Arguments.size() > p_Function.maxArguments)
+    {
+        return std::nullopt;
+    }
+    if (p_Function.evaluate == nullptr)
+    {
+        const std::optional<int64_t> l_Left = getInteger(p_Arguments[0]);
+        const std::optional<int64_t> l_Right = getInteger(p_Arguments[1]);
+        if (!l_Left || !l_Right || *l_Left == c_MinInt || *l_Right == c_MinInt)
+        {
+            return std::nullopt;
+        }
+        return std::gcd(*l_Left, *l_Right);
+    }
+    double l_Values[2]{};
+    bool l_Finite = true;
+    for (size_t l_Index = 0; l_Index < p_Arguments.size(); ++l_Index)
+    {
+        const std::optional<double> l_Number = getNumber(p_Arguments[l_Index]);
+        if (!l_Number)
+        {
+            return std::nullopt;
+        }
+        l_Values[l_Index] = *l_Number;
+        l_Finite &= std::isfinite(*l_Number);
+    }
+    const double l_Result = p_Function.evaluate({ l_Values, p_Arguments.size() });
+    // Out of the domain, or overflowing, which Python raises for
+    if (!std::isfinite(l_Result) && l_Finite)
+    {
+        return std::nullopt;
+    }
+    switch (p_Function.result)
+    {
+    case Type::INT:
+        {
+            const std::optional<int64_t> l_Int = toInteger(l_Result);
+            return l_Int ? std::optional<Constant>(*l_Int) : std::nullopt;
+        }
+    case Type::BOOL:
+        return l_Result != 0.0;
+    default:
+        return l_Result;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "builtins.hpp"
+#include "type.hpp"
+#include "../parser/ast.hpp"
+
+// Operations the compiler carries out itself, on the values of expressions it knows before the program runs:
+// literals, module level constants, and pure operators, builtins and math functions applied to them. Inference folds
+// such expressions into their value, which types them, decides which branches are reached and is what the C++ writer
+// emits. An operation is only folded where it gives what the runtime would: one that raises, overflows or leaves its
+// domain returns nullopt and is left for the program to run
+class ConstantFolder
+{
+public:
+    // None is std::monostate
+    using Constant = std::variant<std::monostate, bool, int64_t, double, std::string>;
+
+    // Longest string folding makes, longer ones are built at run time rather than written out
+    static constexpr size_t c_MaxStringSize = 4096;
+
+    [[nodiscard]] static Type getType(const Constant& p_Constant);
+    [[nodiscard]] static bool isTruthy(const Constant& p_Constant);
+
+    // The value of an INTEGER, FLOAT, STRING, BOOLEAN or NONE node
+    [[nodiscard]] static std::optional<Constant> readLiteral(const Ast& p_Ast, Ast::NodeIndex p_Node);
+    // What a Python string literal stands for, its escapes decoded
+    [[nodiscard]] static std::string decodeString(std::string_view p_Raw);
+
+    // p_Constant stored where p_Type is expected, converted like an annotation converts it
+    [[nodiscard]] static std::optional<Constant> convert(const Constant& p_Constant, Type p_Type);
+    [[nodiscard]] static std::optional<Constant> unary(Ast::Operator p_Operator, const Constant& p_Operand);
+    // Every operator but and and or, which only evaluate their right operand when the left one does not decide
+    [[nodiscard]] static std::optional<Constant> binary(Ast::Operator p_Operator, const Constant& p_Left, const Constant& p_Right);
+    [[nodiscard]] static std::optional<Constant> callBuiltin(Builtins::Function p_Function, std::span<const Constant> p_Arguments);
+    [[nodiscard]] static std::optional<Constant> callMath(const Builtins::MathFunction& p_Function, std::span<const Constant> p_Arguments);
+};
@@ -0,0 +1,20 @@
+#include "type.hpp"
+
+#include <array>
+
+namespace
+{
+    constexpr std::array<std::string_view, 7> c_KindNames{ "?", "None", "bool", "int", "float", "str", "dynamic" };
+}
+
+std::string Type::getName() const
+{
+    std::string l_Name;
+    for (uint8_t l_Depth = 0; l_Depth < m_ListDepth; ++l_Depth)
+    {
+        l_Name += "list[";
+    }
+    l_Name += c_KindNames[m_Kind];
+    l_Name.append(m_ListDepth, ']');
+    return l_Name;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Static type of a value, as far as inference can tell: a scalar kind inside up to c_MaxListDepth levels of
+// homogeneous list. UNKNOWN is where inference starts, nothing seen yet, and DYNAMIC where it gives up, a value that
+// has to be boxed. A list of UNKNOWN is a list nothing was put in yet, which any list type deep enough refines
+class Type
+{
+public:
+    enum Kind: uint8_t
+    {
+        UNKNOWN,
+        NONE,
+        BOOL,
+        INT,
+        FLOAT,
+        STRING,
+        DYNAMIC
+    };
+
+    static constexpr uint8_t c_MaxListDepth = 4;
+
+    constexpr Type() = default;
+    constexpr Type(const Kind p_Kind, const uint8_t p_ListDepth = 0) : m_Kind(p_Kind), m_ListDepth(p_ListDepth) {}
+
+    [[nodiscard]] constexpr Kind getKind() const { return m_Kind; }
+    [[nodiscard]] constexpr uint8_t getListDepth() const { return m_ListDepth; }
+    [[nodiscard]] constexpr bool isList() const { return m_ListDepth > 0; }
+    [[nodiscard]] constexpr bool isUnknown() const { return m_Kind == UNKNOWN && m_ListDepth == 0; }
+    [[nodiscard]] constexpr bool isDynamic() const { return m_Kind == DYNAMIC && m_ListDepth == 0; }
+    // Known and not a list, the types a boxed value can be unboxed to
+    [[nodiscard]] constexpr bool isScalar() const { return m_ListDepth == 0 && m_Kind != UNKNOWN && m_Kind != DYNAMIC; }
+    // bool counts, as Python does arithmetic on it as on int
+    [[nodiscard]] constexpr bool isNumber() const { return m_ListDepth == 0 && (m_Kind == BOOL || m_Kind == INT || m_Kind == FLOAT); }
+    // Only meaningful for lists
+    [[nodiscard]] constexpr Type getElement() const { return { m_Kind, static_cast<uint8_t>(m_ListDepth - 1) }; }
+
+    // Lists nested deeper than c_MaxListDepth are DYNAMIC, which keeps the lattice finite
+    [[nodiscard]] static constexpr Type listOf(const Type p_Element)
+    {
+        return p_Element.m_ListDepth < c_MaxListDepth ? Type{ p_Element.m_Kind, static_cast<uint8_t>(p_Element.m_ListDepth + 1) } : Type{ DYNAMIC };
+    }
+
+    // Least type that holds values of both. Lists are mutable and shared, so list[int] and list[float] do not make a
+    // list[float], or a list of anything else: they are DYNAMIC
+    [[nodiscard]] static constexpr Type join(const Type p_First, const Type p_Second)
+    {
+        if (p_First == p_Second)
+        {
+            return p_First;
+        }
+        if (p_First.m_Kind == UNKNOWN && p_First.m_ListDepth <= p_Second.m_ListDepth)
+        {
+            return p_Second;
+        }
+        if (p_Second.m_Kind == UNKNOWN && p_Second.m_ListDepth <= p_First.m_ListDepth)
+        {
+            return p_First;
+        }
+        return { DYNAMIC };
+    }
+
+    // What is left once inference is done: UNKNOWN becomes DYNAMIC, in lists too
+    [[nodiscard]] constexpr Type resolve() const { return m_Kind == UNKNOWN ? Type{ DYNAMIC, m_ListDepth } : *this; }
+
+    // Python spelling, like "list[int]". UNKNOWN is "?"
+    [[nodiscard]] std::string getName() const;
+
+    constexpr bool operator==(const Type&) const = default;
+
+private:
+    Kind m_Kind = UNKNOWN;
+    uint8_t m_ListDepth = 0;
+};
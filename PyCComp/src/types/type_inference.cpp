@@ -0,0 +1,2186 @@
+#include "type_inference.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // Every pass that is not the last moves some type up a lattice a few steps high, so this is never reached by a
+    // correct analysis. It turns a bug into an error rather than a hang
+    constexpr uint32_t c_MaxPasses = 10000;
+
+    bool isIntLike(const Type p_Type)
+    {
+        return p_Type == Type::BOOL || p_Type == Type::INT;
+    }
+
+    // Whether a value of p_From can be stored where p_To is expected, converted if need be. Only annotations ask for
+    // this, everything else takes the join
+    bool isConvertible(const Type p_From, const Type p_To)
+    {
+        if (p_From == p_To || p_To.isDynamic() || p_From.isUnknown())
+        {
+            return true;
+        }
+        if (p_From.isDynamic())
+        {
+            return p_To.isScalar();
+        }
+        if (p_To == Type::FLOAT)
+        {
+            return isIntLike(p_From);
+        }
+        if (p_To == Type::INT)
+        {
+            return p_From == Type::BOOL;
+        }
+        // A list nothing was put in yet
+        return Type::join(p_From, p_To) == p_To;
+    }
+
+    // The type a read gives: the variable's own, unless it is DYNAMIC and flow analysis knows better
+    Type readType(const Type p_Storage, const Type p_Flow)
+    {
+        if (!p_Storage.isDynamic())
+        {
+            return p_Storage;
+        }
+        return p_Flow.isScalar() ? p_Flow : Type{ Type::DYNAMIC };
+    }
+
+    void merge(std::vector<Type>& p_Into, bool& p_IntoReached, const std::vector<Type>& p_From)
+    {
+        if (!p_IntoReached)
+        {
+            p_Into = p_From;
+            p_IntoReached = true;
+            return;
+        }
+        for (size_t l_Index = 0; l_Index < p_Into.size(); ++l_Index)
+        {
+            p_Into[l_Index] = Type::join(p_Into[l_Index], p_From[l_Index]);
+        }
+    }
+
+    // Adds how many times the module body binds each name in p_Target to p_Counts
+    void countBindings(const Ast& p_Ast, const Ast::NodeIndex p_Target, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Counts)
+    {
+        const Ast::Node& l_Node = p_Ast.getNode(p_Target);
+        switch (l_Node.kind)
+        {
+        case Ast::NAME:
+            ++p_Counts[p_Ast.getSymbol(p_Target)];
+            break;
+        case Ast::ANNOTATED:
+            countBindings(p_Ast, l_Node.first, p_Counts);
+            break;
+        case Ast::TUPLE:
+        case Ast::LIST:
+            for (const Ast::NodeIndex l_Element : p_Ast.getList(l_Node.first))
+            {
+                countBindings(p_Ast, l_Element, p_Counts);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void countStatement(const Ast& p_Ast, const Ast::NodeIndex p_Statement, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Counts)
+    {
+        const Ast::Node& l_Node = p_Ast.getNode(p_Statement);
+        const auto l_CountList = [&](const uint32_t p_List)
+        {
+            for (const Ast::NodeIndex l_Statement : p_Ast.getList(p_List))
+            {
+                countStatement(p_Ast, l_Statement, p_Counts);
+            }
+        };
+        switch (l_Node.kind)
+        {
+        case Ast::ASSIGN:
+            // "x: int" declares without binding
+            if (l_Node.second != Ast::c_NoNode)
+            {
+                countBindings(p_Ast, l_Node.first, p_Counts);
+            }
+            break;
+        case Ast::FOR:
+            countBindings(p_Ast, l_Node.first, p_Counts);
+            l_CountList(p_Ast.getFor(p_Statement).body);
+            break;
+        case Ast::IF:
+            l_CountList(p_Ast.getIf(p_Statement).body);
+            l_CountList(p_Ast.getIf(p_Statement).orElse);
+            break;
+        case Ast::WHILE:
+            l_CountList(l_Node.second);
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::string quote(const std::string_view p_Name)
+    {
+        std::string l_Quoted;
+        l_Quoted.reserve(p_Name.size() + 2);
+        l_Quoted += '\'';
+        l_Quoted += p_Name;
+        l_Quoted += '\'';
+        return l_Quoted;
+    }
+}
+
+TypeInference::TypeInference(const SourceReader& p_Reader, const std::span<const Ast* const> p_Trees, const SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory)
+    : m_Reader(p_Reader), m_Symbols(p_Symbols), m_Modules(p_Memory)
+{
+    for (uint8_t l_Function = 0; l_Function < Builtins::FUNCTION_COUNT; ++l_Function)
+    {
+        const SymbolTable::Symbol l_Symbol = p_Symbols.find(Builtins::getFunctionName(static_cast<Builtins::Function>(l_Function)));
+        if (l_Symbol != SymbolTable::c_NoSymbol)
+        {
+            m_Builtins.emplace(l_Symbol, static_cast<Builtins::Function>(l_Function));
+        }
+    }
+    m_Modules.reserve(p_Trees.size());
+    for (uint32_t l_Index = 0; l_Index < p_Trees.size(); ++l_Index)
+    {
+        const size_t l_NodeCount = p_Trees[l_Index]->getNodeCount();
+        m_Modules.push_back(Module{
+            .ast = p_Trees[l_Index],
+            .file = p_Reader.getModule(l_Index),
+            .types = std::pmr::vector<Type>(l_NodeCount, p_Memory),
+            .references = std::pmr::vector<Reference>(l_NodeCount, p_Memory),
+            .reached = std::pmr::vector<uint8_t>(l_NodeCount, 0, p_Memory),
+            .errors = std::pmr::vector<Tokenizer::Error>(p_Memory)
+        });
+    }
+    for (uint32_t l_Index = 0; l_Index < m_Modules.size(); ++l_Index)
+    {
+        declareModule(l_Index);
+    }
+    // Modules come after the ones they import, whose constants they read
+    for (uint32_t l_Index = 0; l_Index < m_Modules.size(); ++l_Index)
+    {
+        foldModule(l_Index);
+    }
+
+    do
+    {
+        solve();
+    }
+    while (resolveUnknown());
+    // One more pass over the settled types, to report what they do not allow
+    m_Reporting = true;
+    analyzeProgram();
+    m_Reporting = false;
+}
+
+std::vector<Ast::NodeIndex> TypeInference::matchArguments(const uint32_t p_Module, const Ast::NodeIndex p_Call, const Function& p_Function, std::string* p_Error) const
+{
+    const Ast& l_Ast = *m_Modules[p_Module].ast;
+    const std::string l_Name = std::string(m_Symbols.getName(p_Function.result.name)) + "()";
+    const auto l_Fail = [&](std::string p_Message)
+    {
+        if (p_Error != nullptr)
+        {
+            *p_Error = std::move(p_Message);
+        }
+        return std::vector<Ast::NodeIndex>{};
+    };
+
+    std::vector<Ast::NodeIndex> l_Arguments(p_Function.parameterCount, Ast::c_NoNode);
+    uint32_t l_Positional = 0;
+    for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Ast.getNode(p_Call).second))
+    {
+        const Ast::Node& l_Node = l_Ast.getNode(l_Argument);
+        if (l_Node.kind != Ast::KEYWORD_ARGUMENT)
+        {
+            if (l_Positional >= p_Function.parameterCount)
+            {
+                return l_Fail(l_Name + " takes " + std::to_string(p_Function.parameterCount) + " arguments");
+            }
+            l_Arguments[l_Positional++] = l_Argument;
+            continue;
+        }
+        const SymbolTable::Symbol l_Keyword = l_Ast.getSymbol(l_Argument);
+        uint32_t l_Parameter = 0;
+        while (l_Parameter < p_Function.parameterCount && p_Function.variables[l_Parameter].name != l_Keyword)
+        {
+            ++l_Parameter;
+        }
+        if (l_Parameter == p_Function.parameterCount)
+        {
+            return l_Fail(l_Name + " has no parameter " + quote(l_Ast.getName(l_Argument)));
+        }
+        if (l_Arguments[l_Parameter] != Ast::c_NoNode)
+        {
+            return l_Fail(l_Name + " is given " + quote(l_Ast.getName(l_Argument)) + " twice");
+        }
+        l_Arguments[l_Parameter] = l_Node.first;
+    }
+    const Ast& l_Callee = *m_Modules[p_Function.result.module].ast;
+    for (uint32_t l_Parameter = 0; l_Parameter < p_Function.parameterCount; ++l_Parameter)
+    {
+        if (l_Arguments[l_Parameter] == Ast::c_NoNode && l_Callee.getNode(p_Function.variables[l_Parameter].node).second == Ast::c_NoNode)
+        {
+            return l_Fail(l_Name + " is missing argument " + quote(m_Symbols.getName(p_Function.variables[l_Parameter].name)));
+        }
+    }
+    return l_Arguments;
+}
+
+std::string TypeInference::getInstanceName(const Function& p_Function, const Instance& p_Instance) const
+{
+    std::string l_Name = std::string(m_Symbols.getName(p_Function.result.name)) + "(";
+    for (size_t l_Parameter = 0; l_Parameter < p_Instance.signature.size(); ++l_Parameter)
+    {
+        l_Name += (l_Parameter == 0 ? "" : ", ") + p_Instance.signature[l_Parameter].resolve().getName();
+    }
+    return l_Name + ")";
+}
+
+const ConstantFolder::Constant* TypeInference::getConstant(const uint32_t p_Module, const Ast::NodeIndex p_Node) const
+{
+    const auto l_Found = m_Modules[p_Module].constants.find(p_Node);
+    return l_Found == m_Modules[p_Module].constants.end() ? nullptr : &l_Found->second;
+}
+
+bool TypeInference::hasErrors() const
+{
+    for (const Module& l_Module : m_Modules)
+    {
+        if (!l_Module.errors.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TypeInference::printErrors(const uint32_t p_Module, std::ostream& p_Stream) const
+{
+    for (const Tokenizer::Error& l_Error : m_Modules[p_Module].errors)
+    {
+        p_Stream << "Error at line " << l_Error.line << ", column " << l_Error.column << ": " << l_Error.message << '\n';
+    }
+}
+
+std::optional<Type> TypeInference::readAnnotation(const Ast& p_Ast, const Ast::NodeIndex p_Node)
+{
+    const Ast::Node& l_Node = p_Ast.getNode(p_Node);
+    if (l_Node.kind == Ast::NONE)
+    {
+        return Type{ Type::NONE };
+    }
+    if (l_Node.kind == Ast::NAME)
+    {
+        const std::string_view l_Name = p_Ast.getName(p_Node);
+        if (l_Name == "int")
+        {
+            return Type{ Type::INT };
+        }
+        if (l_Name == "float")
+        {
+            return Type{ Type::FLOAT };
+        }
+        if (l_Name == "bool")
+        {
+            return Type{ Type::BOOL };
+        }
+        if (l_Name == "str")
+        {
+            return Type{ Type::STRING };
+        }
+        return std::nullopt;
+    }
+    if (l_Node.kind == Ast::SUBSCRIPT && p_Ast.getNode(l_Node.first).kind == Ast::NAME)
+    {
+        const std::string_view l_Name = p_Ast.getName(l_Node.first);
+        const std::optional<Type> l_Element = readAnnotation(p_Ast, l_Node.second);
+        if ((l_Name == "list" || l_Name == "List") && l_Element && *l_Element != Type::NONE && !Type::listOf(*l_Element).isDynamic())
+        {
+            return Type::listOf(*l_Element);
+        }
+    }
+    return std::nullopt;
+}
+
+void TypeInference::declareModule(const uint32_t p_Module)
+{
+    Module& l_Module = m_Modules[p_Module];
+    const Ast& l_Ast = *l_Module.ast;
+
+    // Non standard imports are the module's dependencies, in the same order
+    uint32_t l_Dependency = 0;
+    for (const std::string& l_Import : l_Module.file->importNames)
+    {
+        const bool l_Standard = SourceReader::findStdModule(l_Import) != nullptr;
+        const SymbolTable::Symbol l_Symbol = l_Import.find('/') == std::string::npos ? m_Symbols.find(l_Import) : SymbolTable::c_NoSymbol;
+        if (l_Symbol != SymbolTable::c_NoSymbol && (!l_Standard || l_Import == "math"))
+        {
+            l_Module.imports[l_Symbol] = l_Standard ? Reference{ .kind = Reference::MATH } : Reference{ .kind = Reference::MODULE, .module = l_Module.file->dependencies[l_Dependency] };
+        }
+        l_Dependency += l_Standard ? 0 : 1;
+    }
+
+    std::unordered_map<SymbolTable::Symbol, uint32_t> l_Globals;
+    // Where the nodes of the next statement start
+    Ast::NodeIndex l_FirstNode = 0;
+    for (const Ast::NodeIndex l_Statement : l_Ast.getList(l_Ast.getNode(l_Ast.getRoot()).first))
+    {
+        const Ast::NodeIndex l_StatementFirst = l_FirstNode;
+        l_FirstNode = l_Statement + 1;
+        if (l_Ast.getNode(l_Statement).kind != Ast::FUNCTION)
+        {
+            declareBlock(l_Statement, p_Module, l_Module.globals, l_Globals);
+            continue;
+        }
+        const SymbolTable::Symbol l_Name = l_Ast.getSymbol(l_Statement);
+        if (l_Module.names.contains(l_Name))
+        {
+            error(p_Module, l_Statement, quote(l_Ast.getName(l_Statement)) + " is defined more than once");
+            continue;
+        }
+        l_Module.names[l_Name] = { .kind = Reference::FUNCTION, .module = p_Module, .index = static_cast<uint32_t>(l_Module.functions.size()) };
+        Function& l_Function = l_Module.functions.emplace_back();
+        l_Function.node = l_Statement;
+        l_Function.firstNode = l_StatementFirst;
+        l_Function.result = { .name = l_Name, .role = Variable::RESULT, .module = p_Module, .node = l_Statement };
+
+        const Ast::FunctionData l_Data = l_Ast.getFunction(l_Statement);
+        std::unordered_map<SymbolTable::Symbol, uint32_t> l_Locals;
+        for (const Ast::NodeIndex l_Parameter : l_Ast.getList(l_Data.parameters))
+        {
+            const SymbolTable::Symbol l_Symbol = l_Ast.getSymbol(l_Parameter);
+            if (!l_Locals.emplace(l_Symbol, static_cast<uint32_t>(l_Function.variables.size())).second)
+            {
+                error(p_Module, l_Parameter, "Duplicate parameter " + quote(l_Ast.getName(l_Parameter)));
+                continue;
+            }
+            Variable& l_Variable = l_Function.variables.emplace_back(Variable{ .name = l_Symbol, .role = Variable::PARAMETER, .module = p_Module, .node = l_Parameter });
+            if (l_Ast.getNode(l_Parameter).first != Ast::c_NoNode)
+            {
+                pin(l_Variable, l_Ast.getNode(l_Parameter).first, p_Module);
+            }
+        }
+        l_Function.parameterCount = static_cast<uint32_t>(l_Function.variables.size());
+        if (l_Data.returns != Ast::c_NoNode)
+        {
+            pin(l_Function.result, l_Data.returns, p_Module);
+        }
+        for (const Ast::NodeIndex l_Body : l_Ast.getList(l_Data.body))
+        {
+            declareBlock(l_Body, p_Module, l_Function.variables, l_Locals);
+        }
+    }
+    for (const auto& [l_Name, l_Index] : l_Globals)
+    {
+        const Variable& l_Global = l_Module.globals[l_Index];
+        if (!l_Module.names.emplace(l_Name, Reference{ .kind = Reference::GLOBAL, .module = p_Module, .index = l_Index }).second)
+        {
+            error(p_Module, l_Global.node, quote(m_Symbols.getName(l_Name)) + " is both a function and a variable");
+        }
+    }
+}
+
+void TypeInference::declareBlock(const Ast::NodeIndex p_Statement, const uint32_t p_Module, std::vector<Variable>& p_Variables, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Indices)
+{
+    const Ast& l_Ast = *m_Modules[p_Module].ast;
+    const Ast::Node& l_Node = l_Ast.getNode(p_Statement);
+    const auto l_DeclareList = [&](const uint32_t p_List)
+    {
+        for (const Ast::NodeIndex l_Statement : l_Ast.getList(p_List))
+        {
+            declareBlock(l_Statement, p_Module, p_Variables, p_Indices);
+        }
+    };
+    switch (l_Node.kind)
+    {
+    case Ast::ASSIGN:
+        declareTargets(l_Node.first, p_Module, p_Variables, p_Indices);
+        break;
+    case Ast::FOR:
+        declareTargets(l_Node.first, p_Module, p_Variables, p_Indices);
+        l_DeclareList(l_Ast.getFor(p_Statement).body);
+        break;
+    case Ast::IF:
+        l_DeclareList(l_Ast.getIf(p_Statement).body);
+        l_DeclareList(l_Ast.getIf(p_Statement).orElse);
+        break;
+    case Ast::WHILE:
+        l_DeclareList(l_Node.second);
+        break;
+    default:
+        break;
+    }
+}
+
+void TypeInference::declareTargets(const Ast::NodeIndex p_Target, const uint32_t p_Module, std::vector<Variable>& p_Variables, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Indices)
+{
+    const Ast& l_Ast = *m_Modules[p_Module].ast;
+    const Ast::Node& l_Node = l_Ast.getNode(p_Target);
+    switch (l_Node.kind)
+    {
+    case Ast::NAME:
+        {
+            const SymbolTable::Symbol l_Symbol = l_Ast.getSymbol(p_Target);
+            if (p_Indices.emplace(l_Symbol, static_cast<uint32_t>(p_Variables.size())).second)
+            {
+                p_Variables.push_back({ .name = l_Symbol, .module = p_Module, .node = p_Target });
+            }
+            break;
+        }
+    case Ast::ANNOTATED:
+        declareTargets(l_Node.first, p_Module, p_Variables, p_Indices);
+        if (l_Ast.getNode(l_Node.first).kind == Ast::NAME)
+        {
+            pin(p_Variables[p_Indices.at(l_Ast.getSymbol(l_Node.first))], l_Node.second, p_Module);
+        }
+        break;
+    case Ast::TUPLE:
+    case Ast::LIST:
+        for (const Ast::NodeIndex l_Element : l_Ast.getList(l_Node.first))
+        {
+            declareTargets(l_Element, p_Module, p_Variables, p_Indices);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TypeInference::pin(Variable& p_Variable, const Ast::NodeIndex p_Annotation, const uint32_t p_Module)
+{
+    const std::optional<Type> l_Type = readAnnotation(*m_Modules[p_Module].ast, p_Annotation);
+    if (!l_Type)
+    {
+        error(p_Module, p_Annotation, "Unsupported annotation, use int, float, bool, str, None or list[...] of them");
+        return;
+    }
+    if (p_Variable.pinned && p_Variable.type != *l_Type)
+    {
+        error(p_Module, p_Annotation, quote(m_Symbols.getName(p_Variable.name)) + " is already annotated " + p_Variable.type.getName());
+        return;
+    }
+    p_Variable.type = *l_Type;
+    p_Variable.pinned = true;
+}
+
+void TypeInference::foldModule(const uint32_t p_Module)
+{
+    Module& l_Module = m_Modules[p_Module];
+    const Ast& l_Ast = *l_Module.ast;
+    const std::span<const Ast::NodeIndex> l_Statements = l_Ast.getList(l_Ast.getNode(l_Ast.getRoot()).first);
+    std::unordered_map<SymbolTable::Symbol, uint32_t> l_Bindings;
+    for (const Ast::NodeIndex l_Statement : l_Statements)
+    {
+        countStatement(l_Ast, l_Statement, l_Bindings);
+    }
+
+    Frame l_Frame{ .module = p_Module, .function = nullptr };
+    for (const Ast::NodeIndex l_Statement : l_Statements)
+    {
+        foldStatement(l_Statement, l_Frame);
+        const Ast::Node& l_Node = l_Ast.getNode(l_Statement);
+        if (l_Node.kind != Ast::ASSIGN || l_Node.op != Ast::NO_OPERATOR || l_Node.second == Ast::c_NoNode)
+        {
+            continue;
+        }
+        const Ast::NodeIndex l_Target = l_Ast.getNode(l_Node.first).kind == Ast::ANNOTATED ? l_Ast.getNode(l_Node.first).first : l_Node.first;
+        if (l_Ast.getNode(l_Target).kind != Ast::NAME || l_Bindings[l_Ast.getSymbol(l_Target)] != 1)
+        {
+            continue;
+        }
+        const ConstantFolder::Constant* const l_Value = getConstant(p_Module, l_Node.second);
+        Variable* const l_Global = findVariable(l_Target, l_Frame);
+        if (l_Value == nullptr || l_Global == nullptr)
+        {
+            continue;
+        }
+        // Stored as its annotation converts it, a value it cannot hold is reported by inference
+        std::optional<ConstantFolder::Constant> l_Stored = l_Global->pinned ? ConstantFolder::convert(*l_Value, l_Global->type) : *l_Value;
+        if (l_Stored)
+        {
+            l_Global->constant = true;
+            l_Module.constants[l_Global->node] = std::move(*l_Stored);
+        }
+    }
+
+    for (Function& l_Function : l_Module.functions)
+    {
+        Frame l_FunctionFrame{ .module = p_Module, .function = &l_Function };
+        foldBlock(l_Ast.getFunction(l_Function.node).body, l_FunctionFrame);
+    }
+}
+
+void TypeInference::foldBlock(const uint32_t p_List, Frame& p_Frame)
+{
+    for (const Ast::NodeIndex l_Statement : getAst(p_Frame).getList(p_List))
+    {
+        foldStatement(l_Statement, p_Frame);
+    }
+}
+
+void TypeInference::foldStatement(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    switch (l_Node.kind)
+    {
+    case Ast::FUNCTION:
+        // Only the defaults are evaluated where the function is defined, its body is folded after the module's
+        if (p_Frame.function == nullptr)
+        {
+            for (const Ast::NodeIndex l_Parameter : l_Ast.getList(l_Ast.getFunction(p_Node).parameters))
+            {
+                if (l_Ast.getNode(l_Parameter).second != Ast::c_NoNode)
+                {
+                    foldExpression(l_Ast.getNode(l_Parameter).second, p_Frame);
+                }
+            }
+        }
+        break;
+    case Ast::RETURN:
+    case Ast::EXPRESSION:
+        if (l_Node.first != Ast::c_NoNode)
+        {
+            foldExpression(l_Node.first, p_Frame);
+        }
+        break;
+    case Ast::IF:
+        foldExpression(l_Node.first, p_Frame);
+        foldBlock(l_Ast.getIf(p_Node).body, p_Frame);
+        foldBlock(l_Ast.getIf(p_Node).orElse, p_Frame);
+        break;
+    case Ast::WHILE:
+        foldExpression(l_Node.first, p_Frame);
+        foldBlock(l_Node.second, p_Frame);
+        break;
+    case Ast::FOR:
+        foldTarget(l_Node.first, p_Frame);
+        foldExpression(l_Ast.getFor(p_Node).iterable, p_Frame);
+        foldBlock(l_Ast.getFor(p_Node).body, p_Frame);
+        break;
+    case Ast::ASSIGN:
+        foldTarget(l_Node.first, p_Frame);
+        if (l_Node.second != Ast::c_NoNode)
+        {
+            foldExpression(l_Node.second, p_Frame);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TypeInference::foldTarget(const Ast::NodeIndex p_Target, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Target);
+    switch (l_Node.kind)
+    {
+    case Ast::ANNOTATED:
+        foldTarget(l_Node.first, p_Frame);
+        break;
+    case Ast::SUBSCRIPT:
+        foldExpression(l_Node.first, p_Frame);
+        foldExpression(l_Node.second, p_Frame);
+        break;
+    case Ast::TUPLE:
+    case Ast::LIST:
+        for (const Ast::NodeIndex l_Element : l_Ast.getList(l_Node.first))
+        {
+            foldTarget(l_Element, p_Frame);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+const ConstantFolder::Constant* TypeInference::foldExpression(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    Module& l_Module = m_Modules[p_Frame.module];
+    const Ast& l_Ast = *l_Module.ast;
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    // The value a global holds, if it is a constant one
+    const auto l_ReadGlobal = [this](const Reference& p_Reference) -> std::optional<ConstantFolder::Constant>
+    {
+        if (p_Reference.kind != Reference::GLOBAL || !m_Modules[p_Reference.module].globals[p_Reference.index].constant)
+        {
+            return std::nullopt;
+        }
+        return m_Modules[p_Reference.module].constants.at(m_Modules[p_Reference.module].globals[p_Reference.index].node);
+    };
+    std::optional<ConstantFolder::Constant> l_Value;
+    switch (l_Node.kind)
+    {
+    case Ast::INTEGER:
+    case Ast::FLOAT:
+    case Ast::STRING:
+    case Ast::BOOLEAN:
+    case Ast::NONE:
+        l_Value = ConstantFolder::readLiteral(l_Ast, p_Node);
+        break;
+    case Ast::NAME:
+        l_Value = l_ReadGlobal(resolve(p_Node, p_Frame));
+        break;
+    case Ast::ATTRIBUTE:
+        {
+            if (l_Ast.getNode(l_Node.first).kind != Ast::NAME)
+            {
+                foldExpression(l_Node.first, p_Frame);
+                break;
+            }
+            const Reference& l_Object = resolve(l_Node.first, p_Frame);
+            if (l_Object.kind == Reference::MATH)
+            {
+                if (const Builtins::MathConstant* const l_Constant = Builtins::findMathConstant(l_Ast.getName(p_Node)))
+                {
+                    l_Value = l_Constant->value;
+                }
+            }
+            else if (l_Object.kind == Reference::MODULE)
+            {
+                const Module& l_Imported = m_Modules[l_Object.module];
+                if (const auto l_Found = l_Imported.names.find(l_Ast.getSymbol(p_Node)); l_Found != l_Imported.names.end())
+                {
+                    l_Module.references[p_Node] = l_Found->second;
+                    l_Value = l_ReadGlobal(l_Found->second);
+                }
+            }
+            break;
+        }
+    case Ast::UNARY:
+        if (const ConstantFolder::Constant* const l_Operand = foldExpression(l_Node.first, p_Frame))
+        {
+            l_Value = ConstantFolder::unary(l_Node.op, *l_Operand);
+        }
+        break;
+    case Ast::BINARY:
+        {
+            const ConstantFolder::Constant* const l_Left = foldExpression(l_Node.first, p_Frame);
+            const ConstantFolder::Constant* const l_Right = foldExpression(l_Node.second, p_Frame);
+            // and and or whose left operand decides never evaluate the right one
+            const bool l_Logical = l_Node.op == Ast::AND || l_Node.op == Ast::OR;
+            if (l_Left != nullptr && l_Logical && ConstantFolder::isTruthy(*l_Left) == (l_Node.op == Ast::OR))
+            {
+                l_Value = *l_Left;
+            }
+            else if (l_Left != nullptr && l_Right != nullptr)
+            {
+                l_Value = ConstantFolder::binary(l_Node.op, *l_Left, *l_Right);
+            }
+            break;
+        }
+    case Ast::CONDITIONAL:
+        {
+            const ConstantFolder::Constant* const l_Condition = foldExpression(l_Node.first, p_Frame);
+            const std::span<const Ast::NodeIndex, 2> l_Branches = l_Ast.getBranches(p_Node);
+            const std::array<const ConstantFolder::Constant*, 2> l_Values{ foldExpression(l_Branches[0], p_Frame), foldExpression(l_Branches[1], p_Frame) };
+            const ConstantFolder::Constant* const l_Chosen = l_Condition == nullptr ? nullptr : l_Values[ConstantFolder::isTruthy(*l_Condition) ? 0 : 1];
+            if (l_Chosen != nullptr)
+            {
+                l_Value = *l_Chosen;
+            }
+            break;
+        }
+    case Ast::CALL:
+        {
+            const Ast::Node& l_Callee = l_Ast.getNode(l_Node.first);
+            Reference l_Target;
+            if (l_Callee.kind == Ast::NAME)
+            {
+                l_Target = resolve(l_Node.first, p_Frame);
+            }
+            else if (l_Callee.kind == Ast::ATTRIBUTE && l_Ast.getNode(l_Callee.first).kind == Ast::NAME)
+            {
+                l_Target = resolve(l_Callee.first, p_Frame);
+                if (l_Target.kind != Reference::MATH && l_Target.kind != Reference::MODULE)
+                {
+                    // A method, on a receiver that may fold
+                    foldExpression(l_Callee.first, p_Frame);
+                    l_Target = {};
+                }
+            }
+            else
+            {
+                foldExpression(l_Node.first, p_Frame);
+            }
+            // Only calls with positional arguments that all fold
+            std::vector<ConstantFolder::Constant> l_Arguments;
+            bool l_Folds = true;
+            for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Node.second))
+            {
+                const bool l_Keyword = l_Ast.getNode(l_Argument).kind == Ast::KEYWORD_ARGUMENT;
+                const ConstantFolder::Constant* const l_Folded = foldExpression(l_Keyword ? l_Ast.getNode(l_Argument).first : l_Argument, p_Frame);
+                l_Folds &= !l_Keyword && l_Folded != nullptr;
+                if (l_Folds)
+                {
+                    l_Arguments.push_back(*l_Folded);
+                }
+            }
+            if (!l_Folds)
+            {
+                break;
+            }
+            if (l_Target.kind == Reference::BUILTIN)
+            {
+                l_Value = ConstantFolder::callBuiltin(static_cast<Builtins::Function>(l_Target.index), l_Arguments);
+            }
+            else if (l_Target.kind == Reference::MATH)
+            {
+                if (const Builtins::MathFunction* const l_Function = Builtins::findMathFunction(l_Ast.getName(l_Node.first)))
+                {
+                    l_Value = ConstantFolder::callMath(*l_Function, l_Arguments);
+                }
+            }
+            break;
+        }
+    case Ast::KEYWORD_ARGUMENT:
+        foldExpression(l_Node.first, p_Frame);
+        break;
+    case Ast::SUBSCRIPT:
+        foldExpression(l_Node.first, p_Frame);
+        foldExpression(l_Node.second, p_Frame);
+        break;
+    case Ast::LIST:
+    case Ast::TUPLE:
+    case Ast::DICT:
+        for (const Ast::NodeIndex l_Item : l_Ast.getList(l_Node.first))
+        {
+            foldExpression(l_Item, p_Frame);
+        }
+        break;
+    default:
+        break;
+    }
+    if (!l_Value)
+    {
+        return nullptr;
+    }
+    return &(l_Module.constants[p_Node] = std::move(*l_Value));
+}
+
+void TypeInference::solve()
+{
+    for (uint32_t l_Pass = 0; l_Pass < c_MaxPasses; ++l_Pass)
+    {
+        m_Changes = 0;
+        analyzeProgram();
+        if (m_Changes == 0)
+        {
+            return;
+        }
+    }
+    throw std::runtime_error("Type inference did not settle");
+}
+
+bool TypeInference::resolveUnknown()
+{
+    bool l_Changed = false;
+    const auto l_Resolve = [&l_Changed](Variable& p_Variable)
+    {
+        const Type l_Resolved = p_Variable.type.resolve();
+        l_Changed |= l_Resolved != p_Variable.type;
+        p_Variable.type = l_Resolved;
+    };
+    for (Module& l_Module : m_Modules)
+    {
+        for (Variable& l_Global : l_Module.globals)
+        {
+            l_Resolve(l_Global);
+        }
+        for (Function& l_Function : l_Module.functions)
+        {
+            for (Instance& l_Instance : l_Function.instances)
+            {
+                for (Variable& l_Variable : l_Instance.variables)
+                {
+                    l_Resolve(l_Variable);
+                }
+                l_Resolve(l_Instance.result);
+            }
+        }
+    }
+    return l_Changed;
+}
+
+void TypeInference::analyzeProgram()
+{
+    for (Module& l_Module : m_Modules)
+    {
+        for (Function& l_Function : l_Module.functions)
+        {
+            for (Instance& l_Instance : l_Function.instances)
+            {
+                l_Instance.called = false;
+                l_Instance.used = false;
+            }
+        }
+        for (Variable& l_Global : l_Module.globals)
+        {
+            l_Global.read = false;
+        }
+    }
+    m_Queue.clear();
+    m_Live = true;
+    for (uint32_t l_Index = 0; l_Index < m_Modules.size(); ++l_Index)
+    {
+        analyzeModule(l_Index);
+    }
+    size_t l_Next = 0;
+    while (true)
+    {
+        for (; l_Next < m_Queue.size(); ++l_Next)
+        {
+            const std::array<uint32_t, 3> l_Entry = m_Queue[l_Next];
+            analyzeFunction(l_Entry[0], l_Entry[1], l_Entry[2]);
+        }
+        if (m_Live)
+        {
+            // The program runs what the module bodies reach, the functions left are only checked
+            for (const std::array<uint32_t, 3>& l_Entry : m_Queue)
+            {
+                m_Modules[l_Entry[0]].functions[l_Entry[1]].instances[l_Entry[2]].used = true;
+            }
+            m_Live = false;
+        }
+        // A function nothing calls is still checked, for any arguments. One at a time, as the calls it
+        // makes may reach the others
+        bool l_Added = false;
+        for (uint32_t l_Index = 0; l_Index < m_Modules.size() && !l_Added; ++l_Index)
+        {
+            for (uint32_t l_Function = 0; l_Function < m_Modules[l_Index].functions.size() && !l_Added; ++l_Function)
+            {
+                const Function& l_Uncalled = m_Modules[l_Index].functions[l_Function];
+                if (std::ranges::any_of(l_Uncalled.instances, [](const Instance& p_Instance) { return p_Instance.called; }))
+                {
+                    continue;
+                }
+                std::vector<Type> l_Signature;
+                for (uint32_t l_Parameter = 0; l_Parameter < l_Uncalled.parameterCount; ++l_Parameter)
+                {
+                    const Variable& l_Variable = l_Uncalled.variables[l_Parameter];
+                    l_Signature.push_back(l_Variable.pinned ? l_Variable.type : Type{ Type::DYNAMIC });
+                }
+                callInstance(l_Index, l_Function, std::move(l_Signature));
+                l_Added = true;
+            }
+        }
+        if (!l_Added)
+        {
+            return;
+        }
+    }
+}
+
+uint32_t TypeInference::callInstance(const uint32_t p_Module, const uint32_t p_Function, std::vector<Type> p_Signature)
+{
+    Function& l_Function = m_Modules[p_Module].functions[p_Function];
+    const auto l_Found = std::ranges::find(l_Function.instances, p_Signature, &Instance::signature);
+    const uint32_t l_Index = static_cast<uint32_t>(l_Found - l_Function.instances.begin());
+    if (l_Found == l_Function.instances.end())
+    {
+        Instance& l_Instance = l_Function.instances.emplace_back();
+        l_Instance.variables = l_Function.variables;
+        l_Instance.result = l_Function.result;
+        for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+        {
+            l_Instance.variables[l_Parameter].type = p_Signature[l_Parameter];
+        }
+        l_Instance.signature = std::move(p_Signature);
+        l_Instance.types.resize(l_Function.node - l_Function.firstNode + 1);
+        l_Instance.reached.resize(l_Function.node - l_Function.firstNode + 1);
+        ++m_Changes;
+    }
+    Instance& l_Instance = l_Function.instances[l_Index];
+    if (!l_Instance.called)
+    {
+        l_Instance.called = true;
+        m_Queue.push_back({ p_Module, p_Function, l_Index });
+    }
+    return l_Index;
+}
+
+void TypeInference::analyzeModule(const uint32_t p_Module)
+{
+    Module& l_Module = m_Modules[p_Module];
+    Frame l_Frame{
+        .module = p_Module,
+        .function = nullptr,
+        .instance = nullptr,
+        .variables = &l_Module.globals,
+        .types = l_Module.types.data(),
+        .reached = l_Module.reached.data(),
+        .firstNode = 0,
+        .callees = &l_Module.callees,
+        .env = std::vector<Type>(l_Module.globals.size())
+    };
+    analyzeBlock(l_Module.ast->getNode(l_Module.ast->getRoot()).first, l_Frame);
+}
+
+void TypeInference::analyzeFunction(const uint32_t p_Module, const uint32_t p_Function, const uint32_t p_Instance)
+{
+    Function& l_Function = m_Modules[p_Module].functions[p_Function];
+    Instance& l_Instance = l_Function.instances[p_Instance];
+    Frame l_Frame{
+        .module = p_Module,
+        .function = &l_Function,
+        .instance = &l_Instance,
+        .variables = &l_Instance.variables,
+        .types = l_Instance.types.data(),
+        .reached = l_Instance.reached.data(),
+        .firstNode = l_Function.firstNode,
+        .callees = &l_Instance.callees,
+        .env = std::vector<Type>(l_Instance.variables.size())
+    };
+    for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+    {
+        l_Frame.env[l_Parameter] = l_Instance.signature[l_Parameter];
+    }
+    analyzeBlock(getAst(l_Frame).getFunction(l_Function.node).body, l_Frame);
+    l_Instance.fallsThrough = l_Frame.reachable;
+    if (!l_Frame.reachable)
+    {
+        return;
+    }
+    if (l_Instance.result.pinned && !isConvertible(Type::NONE, l_Instance.result.type))
+    {
+        error(l_Frame, l_Function.node, quote(m_Symbols.getName(l_Instance.result.name)) + " is annotated to return " + l_Instance.result.type.getName() + " but can end without returning");
+        return;
+    }
+    joinVariable(l_Instance.result, Type::NONE, l_Function.node, l_Frame);
+}
+
+void TypeInference::analyzeBlock(const uint32_t p_List, Frame& p_Frame)
+{
+    for (const Ast::NodeIndex l_Statement : getAst(p_Frame).getList(p_List))
+    {
+        analyzeStatement(l_Statement, p_Frame);
+    }
+}
+
+void TypeInference::analyzeStatement(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    // Unreached code is neither typed nor compiled
+    if (!p_Frame.reachable)
+    {
+        return;
+    }
+    Module& l_Module = m_Modules[p_Frame.module];
+    const Ast& l_Ast = *l_Module.ast;
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    p_Frame.reached[p_Node - p_Frame.firstNode] = 1;
+    switch (l_Node.kind)
+    {
+    case Ast::FUNCTION:
+        {
+            if (p_Frame.function != nullptr)
+            {
+                error(p_Frame, p_Node, "Functions can only be defined at the top level of a module");
+                break;
+            }
+            // Defaults are evaluated where the function is defined
+            const auto l_Name = l_Module.names.find(l_Ast.getSymbol(p_Node));
+            if (l_Name == l_Module.names.end() || l_Name->second.kind != Reference::FUNCTION || l_Module.functions[l_Name->second.index].node != p_Node)
+            {
+                break;
+            }
+            Function& l_Function = l_Module.functions[l_Name->second.index];
+            for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+            {
+                const Ast::NodeIndex l_Default = l_Ast.getNode(l_Function.variables[l_Parameter].node).second;
+                if (l_Default == Ast::c_NoNode)
+                {
+                    continue;
+                }
+                if (getConstant(p_Frame.module, l_Default) == nullptr)
+                {
+                    error(p_Frame, l_Default, "Default values have to be constants");
+                }
+                // Which calls that leave the parameter out pass as its type
+                const Type l_Type = analyzeExpression(l_Default, p_Frame);
+                if (l_Function.variables[l_Parameter].pinned)
+                {
+                    joinVariable(l_Function.variables[l_Parameter], l_Type, l_Default, p_Frame);
+                }
+            }
+            break;
+        }
+    case Ast::CLASS:
+        error(p_Frame, p_Node, "Classes are not supported");
+        break;
+    case Ast::RETURN:
+        {
+            if (p_Frame.function == nullptr)
+            {
+                error(p_Frame, p_Node, "'return' outside of a function");
+                break;
+            }
+            Variable& l_Result = p_Frame.instance->result;
+            if (l_Node.first == Ast::c_NoNode)
+            {
+                joinVariable(l_Result, Type::NONE, p_Node, p_Frame);
+            }
+            else
+            {
+                joinVariable(l_Result, analyzeExpression(l_Node.first, p_Frame), l_Node.first, p_Frame);
+                unifyList(l_Node.first, l_Result.type, p_Frame);
+            }
+            p_Frame.reachable = false;
+            break;
+        }
+    case Ast::IF:
+        analyzeIf(p_Node, p_Frame);
+        break;
+    case Ast::WHILE:
+    case Ast::FOR:
+        analyzeLoop(p_Node, p_Frame);
+        break;
+    case Ast::ASSIGN:
+        analyzeAssign(p_Node, p_Frame);
+        break;
+    case Ast::EXPRESSION:
+        analyzeExpression(l_Node.first, p_Frame);
+        break;
+    case Ast::BREAK:
+    case Ast::CONTINUE:
+        {
+            if (p_Frame.loops.empty())
+            {
+                error(p_Frame, p_Node, l_Node.kind == Ast::BREAK ? "'break' outside of a loop" : "'continue' outside of a loop");
+                break;
+            }
+            Loop& l_Loop = p_Frame.loops.back();
+            if (l_Node.kind == Ast::BREAK)
+            {
+                merge(l_Loop.exit, l_Loop.exitReached, p_Frame.env);
+            }
+            else
+            {
+                merge(l_Loop.next, l_Loop.nextReached, p_Frame.env);
+            }
+            p_Frame.reachable = false;
+            break;
+        }
+    default:
+        break;
+    }
+}
+
+void TypeInference::analyzeIf(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    Module& l_Module = m_Modules[p_Frame.module];
+    const Ast& l_Ast = *l_Module.ast;
+    std::vector<Type> l_Exit;
+    bool l_ExitReached = false;
+    // An elif chain is followed iteratively, like the parser builds it
+    Ast::NodeIndex l_If = p_Node;
+    while (true)
+    {
+        p_Frame.reached[l_If - p_Frame.firstNode] = 1;
+        analyzeExpression(l_Ast.getNode(l_If).first, p_Frame);
+        const Ast::IfData l_Data = l_Ast.getIf(l_If);
+        // A branch whose condition folds to false is never taken, and the ones after a true one never tried
+        const ConstantFolder::Constant* const l_Condition = getConstant(p_Frame.module, l_Ast.getNode(l_If).first);
+        const std::vector<Type> l_Entry = p_Frame.env;
+        if (l_Condition == nullptr || ConstantFolder::isTruthy(*l_Condition))
+        {
+            analyzeBlock(l_Data.body, p_Frame);
+            if (p_Frame.reachable)
+            {
+                merge(l_Exit, l_ExitReached, p_Frame.env);
+            }
+        }
+        p_Frame.env = l_Entry;
+        p_Frame.reachable = true;
+        if (l_Condition != nullptr && ConstantFolder::isTruthy(*l_Condition))
+        {
+            break;
+        }
+        const std::span<const Ast::NodeIndex> l_Else = l_Ast.getList(l_Data.orElse);
+        if (l_Else.size() == 1 && (l_Ast.getNode(l_Else[0]).flags & Ast::ELIF))
+        {
+            l_If = l_Else[0];
+            continue;
+        }
+        analyzeBlock(l_Data.orElse, p_Frame);
+        if (p_Frame.reachable)
+        {
+            merge(l_Exit, l_ExitReached, p_Frame.env);
+        }
+        break;
+    }
+    p_Frame.reachable = l_ExitReached;
+    if (l_ExitReached)
+    {
+        p_Frame.env = std::move(l_Exit);
+    }
+}
+
+void TypeInference::analyzeLoop(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    const bool l_IsFor = l_Node.kind == Ast::FOR;
+    // The iterable is evaluated once, before the first iteration
+    const Type l_Element = l_IsFor ? analyzeIterable(l_Ast.getFor(p_Node).iterable, p_Frame) : Type{};
+    const uint32_t l_Body = l_IsFor ? l_Ast.getFor(p_Node).body : l_Node.second;
+    // "while True" only ends through a break, and a loop whose condition is false never runs
+    const ConstantFolder::Constant* const l_Condition = l_IsFor ? nullptr : getConstant(p_Frame.module, l_Node.first);
+    if (l_Condition != nullptr && !ConstantFolder::isTruthy(*l_Condition))
+    {
+        analyzeExpression(l_Node.first, p_Frame);
+        return;
+    }
+    const bool l_Endless = l_Condition != nullptr;
+
+    const size_t l_Depth = p_Frame.loops.size();
+    p_Frame.loops.emplace_back();
+    // Types at the start of an iteration, joined with what every iteration ends with until they stop changing
+    std::vector<Type> l_Head = p_Frame.env;
+    // Iterations before the last see types that are still too narrow, so only the last one reports errors
+    const bool l_Reporting = m_Reporting;
+    m_Reporting = false;
+    while (true)
+    {
+        p_Frame.env = l_Head;
+        p_Frame.reachable = true;
+        p_Frame.loops[l_Depth].next.clear();
+        p_Frame.loops[l_Depth].nextReached = false;
+        if (l_IsFor)
+        {
+            bindTarget(l_Node.first, l_Element, Ast::c_NoNode, p_Frame);
+        }
+        else
+        {
+            analyzeExpression(l_Node.first, p_Frame);
+        }
+        analyzeBlock(l_Body, p_Frame);
+        std::vector<Type> l_Next = l_Head;
+        bool l_NextReached = true;
+        if (p_Frame.reachable)
+        {
+            merge(l_Next, l_NextReached, p_Frame.env);
+        }
+        if (p_Frame.loops[l_Depth].nextReached)
+        {
+            merge(l_Next, l_NextReached, p_Frame.loops[l_Depth].next);
+        }
+        if (l_Next == l_Head && m_Reporting == l_Reporting)
+        {
+            break;
+        }
+        if (l_Next == l_Head)
+        {
+            // Settled, once more to report
+            m_Reporting = true;
+            p_Frame.loops[l_Depth].exitReached = false;
+            p_Frame.loops[l_Depth].exit.clear();
+            continue;
+        }
+        l_Head = std::move(l_Next);
+    }
+    const Loop l_Loop = std::move(p_Frame.loops.back());
+    p_Frame.loops.pop_back();
+    // Running out of iterations happens at the head
+    p_Frame.env = std::move(l_Head);
+    p_Frame.reachable = !l_Endless;
+    if (l_Loop.exitReached)
+    {
+        merge(p_Frame.env, p_Frame.reachable, l_Loop.exit);
+    }
+}
+
+void TypeInference::analyzeAssign(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    // "x: int" declares without binding
+    if (l_Node.second == Ast::c_NoNode)
+    {
+        return;
+    }
+    const Ast::Node& l_Target = l_Ast.getNode(l_Node.first);
+    if (l_Node.op != Ast::NO_OPERATOR)
+    {
+        const Type l_Value = analyzeExpression(l_Node.second, p_Frame);
+        const Type l_Current = analyzeExpression(l_Node.first, p_Frame);
+        // On a list, += extends it in place
+        if (l_Node.op == Ast::ADD && l_Current.isList())
+        {
+            if (!l_Value.isList())
+            {
+                error(p_Frame, l_Node.second, "Only a list can be added to " + l_Current.getName());
+                return;
+            }
+            storeElement(l_Node.first, l_Current, l_Value.getElement(), p_Node, p_Frame);
+            return;
+        }
+        // The ASSIGN keeps the type of the operation, the target that of what it stores
+        const Type l_Result = analyzeBinary(p_Node, l_Node.op, l_Current, l_Value, l_Node.second, p_Frame);
+        p_Frame.types[p_Node - p_Frame.firstNode] = l_Result;
+        bindTarget(l_Node.first, l_Result, Ast::c_NoNode, p_Frame);
+        return;
+    }
+    if (l_Target.kind != Ast::TUPLE && l_Target.kind != Ast::LIST)
+    {
+        bindTarget(l_Node.first, analyzeExpression(l_Node.second, p_Frame), l_Node.second, p_Frame);
+        return;
+    }
+
+    // Unpacking, only from a tuple or list written out with as many values. They are all evaluated first
+    const Ast::Node& l_Value = l_Ast.getNode(l_Node.second);
+    const std::span<const Ast::NodeIndex> l_Targets = l_Ast.getList(l_Target.first);
+    if ((l_Value.kind != Ast::TUPLE && l_Value.kind != Ast::LIST) || l_Ast.getList(l_Value.first).size() != l_Targets.size())
+    {
+        error(p_Frame, l_Node.second, "Only a tuple or list written out with " + std::to_string(l_Targets.size()) + " values can be unpacked here");
+        return;
+    }
+    const std::span<const Ast::NodeIndex> l_Values = l_Ast.getList(l_Value.first);
+    std::vector<Type> l_Types;
+    for (const Ast::NodeIndex l_Element : l_Values)
+    {
+        l_Types.push_back(analyzeExpression(l_Element, p_Frame));
+    }
+    for (size_t l_Index = 0; l_Index < l_Targets.size(); ++l_Index)
+    {
+        bindTarget(l_Targets[l_Index], l_Types[l_Index], l_Values[l_Index], p_Frame);
+    }
+}
+
+Type TypeInference::analyzeIterable(const Ast::NodeIndex p_Iterable, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Iterable);
+    if (l_Node.kind == Ast::CALL && l_Ast.getNode(l_Node.first).kind == Ast::NAME)
+    {
+        const Reference& l_Callee = resolve(l_Node.first, p_Frame);
+        if (l_Callee.kind == Reference::BUILTIN && l_Callee.index == Builtins::RANGE)
+        {
+            const std::span<const Ast::NodeIndex> l_Arguments = l_Ast.getList(l_Node.second);
+            if (l_Arguments.empty() || l_Arguments.size() > 3)
+            {
+                error(p_Frame, p_Iterable, "range() takes 1 to 3 arguments");
+            }
+            for (const Ast::NodeIndex l_Argument : l_Arguments)
+            {
+                const Type l_Type = analyzeExpression(l_Argument, p_Frame);
+                if (l_Ast.getNode(l_Argument).kind == Ast::KEYWORD_ARGUMENT)
+                {
+                    error(p_Frame, l_Argument, "range() takes no keyword arguments");
+                }
+                else if (!isIntLike(l_Type) && !l_Type.isDynamic() && !l_Type.isUnknown())
+                {
+                    error(p_Frame, l_Argument, "range() takes int arguments, not " + l_Type.getName());
+                }
+            }
+            p_Frame.types[p_Iterable - p_Frame.firstNode] = Type::INT;
+            return Type::INT;
+        }
+    }
+    const Type l_Type = analyzeExpression(p_Iterable, p_Frame);
+    if (l_Type.isList())
+    {
+        return l_Type.getElement();
+    }
+    if (l_Type == Type::STRING || l_Type.isDynamic() || l_Type.isUnknown())
+    {
+        return l_Type;
+    }
+    error(p_Frame, p_Iterable, "Cannot iterate over " + l_Type.getName());
+    return Type::DYNAMIC;
+}
+
+Type TypeInference::analyzeExpression(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    if (const ConstantFolder::Constant* const l_Constant = getConstant(p_Frame.module, p_Node))
+    {
+        // Its value is all there is to it, the C++ writes it out, or the name of a constant global
+        if (l_Node.kind == Ast::NAME || l_Node.kind == Ast::ATTRIBUTE)
+        {
+            markRead(m_Modules[p_Frame.module].references[p_Node]);
+        }
+        const Type l_Type = ConstantFolder::getType(*l_Constant);
+        p_Frame.types[p_Node - p_Frame.firstNode] = l_Type;
+        return l_Type;
+    }
+    Type l_Type;
+    switch (l_Node.kind)
+    {
+    case Ast::NAME:
+        l_Type = analyzeName(p_Node, p_Frame);
+        break;
+    case Ast::INTEGER:
+        l_Type = Type::INT;
+        break;
+    case Ast::FLOAT:
+        l_Type = Type::FLOAT;
+        break;
+    case Ast::STRING:
+        l_Type = Type::STRING;
+        break;
+    case Ast::BOOLEAN:
+        l_Type = Type::BOOL;
+        break;
+    case Ast::NONE:
+        l_Type = Type::NONE;
+        break;
+    case Ast::IMAGINARY:
+        error(p_Frame, p_Node, "Complex numbers are not supported");
+        l_Type = Type::DYNAMIC;
+        break;
+    case Ast::UNARY:
+        {
+            const Type l_Operand = analyzeExpression(l_Node.first, p_Frame);
+            if (l_Node.op == Ast::NOT)
+            {
+                l_Type = Type::BOOL;
+            }
+            else if (l_Operand.isUnknown() || l_Operand.isDynamic())
+            {
+                l_Type = l_Operand;
+            }
+            else if (isIntLike(l_Operand) || (l_Operand == Type::FLOAT && l_Node.op != Ast::INVERT))
+            {
+                l_Type = l_Operand == Type::FLOAT ? Type::FLOAT : Type::INT;
+            }
+            else
+            {
+                error(p_Frame, p_Node, "Bad operand type for unary " + std::string(Ast::getOperatorName(l_Node.op)) + ": " + l_Operand.getName());
+                l_Type = Type::DYNAMIC;
+            }
+            break;
+        }
+    case Ast::BINARY:
+        {
+            const Type l_Left = analyzeExpression(l_Node.first, p_Frame);
+            const Type l_Right = analyzeExpression(l_Node.second, p_Frame);
+            // and and or whose left operand folds give the right one, had the left one decided they would fold
+            const bool l_Logical = l_Node.op == Ast::AND || l_Node.op == Ast::OR;
+            l_Type = l_Logical && getConstant(p_Frame.module, l_Node.first) != nullptr ? l_Right : analyzeBinary(p_Node, l_Node.op, l_Left, l_Right, l_Node.second, p_Frame);
+            break;
+        }
+    case Ast::CONDITIONAL:
+        {
+            analyzeExpression(l_Node.first, p_Frame);
+            const std::span<const Ast::NodeIndex, 2> l_Branches = l_Ast.getBranches(p_Node);
+            // Only the branch a folded condition takes is evaluated
+            if (const ConstantFolder::Constant* const l_Condition = getConstant(p_Frame.module, l_Node.first))
+            {
+                l_Type = analyzeExpression(l_Branches[ConstantFolder::isTruthy(*l_Condition) ? 0 : 1], p_Frame);
+                break;
+            }
+            l_Type = Type::join(analyzeExpression(l_Branches[0], p_Frame), analyzeExpression(l_Branches[1], p_Frame));
+            unifyList(l_Branches[0], l_Type, p_Frame);
+            unifyList(l_Branches[1], l_Type, p_Frame);
+            break;
+        }
+    case Ast::CALL:
+        l_Type = analyzeCall(p_Node, p_Frame);
+        break;
+    case Ast::KEYWORD_ARGUMENT:
+        l_Type = analyzeExpression(l_Node.first, p_Frame);
+        break;
+    case Ast::ATTRIBUTE:
+        l_Type = analyzeAttribute(p_Node, p_Frame);
+        break;
+    case Ast::SUBSCRIPT:
+        {
+            const Type l_Object = analyzeExpression(l_Node.first, p_Frame);
+            const Type l_Index = analyzeExpression(l_Node.second, p_Frame);
+            if (!isIntLike(l_Index) && !l_Index.isDynamic() && !l_Index.isUnknown())
+            {
+                error(p_Frame, l_Node.second, "Indices have to be int, not " + l_Index.getName());
+            }
+            if (l_Object.isList())
+            {
+                l_Type = l_Object.getElement();
+            }
+            else if (l_Object == Type::STRING || l_Object.isDynamic() || l_Object.isUnknown())
+            {
+                l_Type = l_Object;
+            }
+            else
+            {
+                error(p_Frame, p_Node, l_Object.getName() + " cannot be indexed");
+                l_Type = Type::DYNAMIC;
+            }
+            break;
+        }
+    case Ast::LIST:
+        {
+            Type l_Element;
+            for (const Ast::NodeIndex l_Item : l_Ast.getList(l_Node.first))
+            {
+                l_Element = Type::join(l_Element, analyzeExpression(l_Item, p_Frame));
+            }
+            l_Type = Type::listOf(l_Element);
+            break;
+        }
+    case Ast::TUPLE:
+    case Ast::DICT:
+        for (const Ast::NodeIndex l_Item : l_Ast.getList(l_Node.first))
+        {
+            analyzeExpression(l_Item, p_Frame);
+        }
+        error(p_Frame, p_Node, l_Node.kind == Ast::DICT ? "Dicts are not supported" : "Tuples are only supported on both sides of an assignment");
+        l_Type = Type::DYNAMIC;
+        break;
+    default:
+        error(p_Frame, p_Node, "Unexpected " + std::string(Ast::getKindName(l_Node.kind)));
+        l_Type = Type::DYNAMIC;
+        break;
+    }
+    p_Frame.types[p_Node - p_Frame.firstNode] = l_Type;
+    return l_Type;
+}
+
+Type TypeInference::analyzeName(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Reference& l_Reference = resolve(p_Node, p_Frame);
+    const std::string l_Name = quote(getAst(p_Frame).getName(p_Node));
+    switch (l_Reference.kind)
+    {
+    case Reference::LOCAL:
+        return readType((*p_Frame.variables)[l_Reference.index].type, p_Frame.env[l_Reference.index]);
+    case Reference::GLOBAL:
+        {
+            markRead(l_Reference);
+            const Type l_Storage = m_Modules[l_Reference.module].globals[l_Reference.index].type;
+            const bool l_Flows = p_Frame.function == nullptr && l_Reference.module == p_Frame.module;
+            return readType(l_Storage, l_Flows ? p_Frame.env[l_Reference.index] : Type{});
+        }
+    case Reference::FUNCTION:
+    case Reference::BUILTIN:
+        error(p_Frame, p_Node, l_Name + " can only be called");
+        return Type::DYNAMIC;
+    case Reference::MODULE:
+    case Reference::MATH:
+        error(p_Frame, p_Node, "Module " + l_Name + " can only be used to reach what it defines");
+        return Type::DYNAMIC;
+    default:
+        error(p_Frame, p_Node, l_Name + " is not defined");
+        return Type::DYNAMIC;
+    }
+}
+
+Type TypeInference::analyzeAttribute(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    const std::string_view l_Name = l_Ast.getName(p_Node);
+    if (l_Ast.getNode(l_Node.first).kind == Ast::NAME)
+    {
+        const Reference& l_Object = resolve(l_Node.first, p_Frame);
+        if (l_Object.kind == Reference::MATH)
+        {
+            if (Builtins::findMathConstant(l_Name) != nullptr)
+            {
+                return Type::FLOAT;
+            }
+            error(p_Frame, p_Node, Builtins::findMathFunction(l_Name) != nullptr ? "math." + std::string(l_Name) + " can only be called" : "math has no " + quote(l_Name));
+            return Type::DYNAMIC;
+        }
+        if (l_Object.kind == Reference::MODULE)
+        {
+            const Module& l_Imported = m_Modules[l_Object.module];
+            const auto l_Found = l_Imported.names.find(l_Ast.getSymbol(p_Node));
+            if (l_Found == l_Imported.names.end())
+            {
+                error(p_Frame, p_Node, "Module " + quote(l_Ast.getName(l_Node.first)) + " has no " + quote(l_Name));
+                return Type::DYNAMIC;
+            }
+            m_Modules[p_Frame.module].references[p_Node] = l_Found->second;
+            if (l_Found->second.kind == Reference::FUNCTION)
+            {
+                error(p_Frame, p_Node, quote(l_Name) + " can only be called");
+                return Type::DYNAMIC;
+            }
+            markRead(l_Found->second);
+            return readType(l_Imported.globals[l_Found->second.index].type, {});
+        }
+    }
+    analyzeExpression(l_Node.first, p_Frame);
+    error(p_Frame, p_Node, "Attributes are only supported on modules");
+    return Type::DYNAMIC;
+}
+
+Type TypeInference::analyzeCall(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    const Ast::Node& l_Callee = l_Ast.getNode(l_Node.first);
+    if (l_Callee.kind == Ast::NAME)
+    {
+        const Reference& l_Reference = resolve(l_Node.first, p_Frame);
+        if (l_Reference.kind == Reference::FUNCTION)
+        {
+            return analyzeFunctionCall(p_Node, l_Reference, p_Frame);
+        }
+        if (l_Reference.kind == Reference::BUILTIN)
+        {
+            return analyzeBuiltinCall(p_Node, static_cast<Builtins::Function>(l_Reference.index), p_Frame);
+        }
+    }
+    else if (l_Callee.kind == Ast::ATTRIBUTE)
+    {
+        if (l_Ast.getNode(l_Callee.first).kind == Ast::NAME)
+        {
+            const Reference& l_Object = resolve(l_Callee.first, p_Frame);
+            if (l_Object.kind == Reference::MATH)
+            {
+                return analyzeMathCall(p_Node, l_Ast.getName(l_Node.first), p_Frame);
+            }
+            if (l_Object.kind == Reference::MODULE)
+            {
+                const Module& l_Imported = m_Modules[l_Object.module];
+                const auto l_Found = l_Imported.names.find(l_Ast.getSymbol(l_Node.first));
+                if (l_Found != l_Imported.names.end() && l_Found->second.kind == Reference::FUNCTION)
+                {
+                    m_Modules[p_Frame.module].references[l_Node.first] = l_Found->second;
+                    return analyzeFunctionCall(p_Node, l_Found->second, p_Frame);
+                }
+                analyzeAttribute(l_Node.first, p_Frame);
+                return Type::DYNAMIC;
+            }
+        }
+        return analyzeMethodCall(p_Node, p_Frame);
+    }
+
+    // Not something that can be called, which the callee reports
+    analyzeExpression(l_Node.first, p_Frame);
+    for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Node.second))
+    {
+        analyzeExpression(l_Argument, p_Frame);
+    }
+    if (l_Callee.kind != Ast::NAME)
+    {
+        error(p_Frame, p_Node, "Only functions, builtins and methods can be called");
+    }
+    return Type::DYNAMIC;
+}
+
+Type TypeInference::analyzeFunctionCall(const Ast::NodeIndex p_Node, const Reference& p_Callee, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Ast.getNode(p_Node).second))
+    {
+        analyzeExpression(l_Argument, p_Frame);
+    }
+    Function& l_Function = m_Modules[p_Callee.module].functions[p_Callee.index];
+    std::string l_Error;
+    const std::vector<Ast::NodeIndex> l_Arguments = matchArguments(p_Frame.module, p_Node, l_Function, &l_Error);
+    if (!l_Error.empty())
+    {
+        error(p_Frame, p_Node, l_Error);
+        return l_Function.result.type;
+    }
+    // The signature: what each argument is, or the default where there is none, and the annotation where there is
+    // one, which the argument is then converted to
+    std::vector<Type> l_Signature;
+    for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+    {
+        const Variable& l_Variable = l_Function.variables[l_Parameter];
+        const Ast::NodeIndex l_Argument = l_Arguments[l_Parameter];
+        if (l_Argument == Ast::c_NoNode)
+        {
+            const Ast::NodeIndex l_Default = m_Modules[p_Callee.module].ast->getNode(l_Variable.node).second;
+            l_Signature.push_back(l_Variable.pinned ? l_Variable.type : m_Modules[p_Callee.module].types[l_Default]);
+            continue;
+        }
+        const Type l_Type = p_Frame.types[l_Argument - p_Frame.firstNode];
+        if (l_Variable.pinned)
+        {
+            // Only checks the argument against the annotation
+            joinVariable(l_Function.variables[l_Parameter], l_Type, l_Argument, p_Frame);
+            unifyList(l_Argument, l_Variable.type, p_Frame);
+        }
+        l_Signature.push_back(l_Variable.pinned ? l_Variable.type : l_Type);
+    }
+    const uint32_t l_Index = callInstance(p_Callee.module, p_Callee.index, std::move(l_Signature));
+    (*p_Frame.callees)[p_Node] = l_Index;
+    Instance& l_Instance = l_Function.instances[l_Index];
+    // Lists are shared, so an argument takes what the instance found its parameter holds
+    for (uint32_t l_Parameter = 0; l_Parameter < l_Function.parameterCount; ++l_Parameter)
+    {
+        if (l_Arguments[l_Parameter] != Ast::c_NoNode)
+        {
+            unifyList(l_Arguments[l_Parameter], l_Instance.variables[l_Parameter].type, p_Frame);
+        }
+    }
+    return l_Instance.result.type;
+}
+
+Type TypeInference::analyzeBuiltinCall(const Ast::NodeIndex p_Node, const Builtins::Function p_Function, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const std::string l_Name = std::string(Builtins::getFunctionName(p_Function)) + "()";
+    std::vector<Type> l_Types;
+    for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Ast.getNode(p_Node).second))
+    {
+        const Type l_Type = analyzeExpression(l_Argument, p_Frame);
+        if (l_Ast.getNode(l_Argument).kind != Ast::KEYWORD_ARGUMENT)
+        {
+            l_Types.push_back(l_Type);
+            continue;
+        }
+        const std::string_view l_Keyword = l_Ast.getName(l_Argument);
+        if (p_Function != Builtins::PRINT || (l_Keyword != "sep" && l_Keyword != "end"))
+        {
+            error(p_Frame, l_Argument, l_Name + " has no parameter " + quote(l_Keyword));
+        }
+        else if (l_Type != Type::STRING && !l_Type.isDynamic() && !l_Type.isUnknown())
+        {
+            error(p_Frame, l_Argument, quote(l_Keyword) + " has to be a str");
+        }
+    }
+    const auto l_Arity = [&](const size_t p_Min, const size_t p_Max)
+    {
+        if (l_Types.size() >= p_Min && l_Types.size() <= p_Max)
+        {
+            return true;
+        }
+        error(p_Frame, p_Node, l_Name + " takes " + (p_Min == p_Max ? std::to_string(p_Min) : std::to_string(p_Min) + " to " + std::to_string(p_Max)) + " arguments");
+        return false;
+    };
+    const auto l_Reject = [&](const Type p_Type)
+    {
+        error(p_Frame, p_Node, l_Name + " does not take " + p_Type.getName());
+        return Type{ Type::DYNAMIC };
+    };
+
+    switch (p_Function)
+    {
+    case Builtins::PRINT:
+        return Type::NONE;
+    case Builtins::LEN:
+        if (l_Arity(1, 1) && !l_Types[0].isList() && l_Types[0] != Type::STRING && !l_Types[0].isDynamic() && !l_Types[0].isUnknown())
+        {
+            return l_Reject(l_Types[0]);
+        }
+        return Type::INT;
+    case Builtins::RANGE:
+        error(p_Frame, p_Node, "range() is only supported as the iterable of a for loop");
+        return Type::DYNAMIC;
+    case Builtins::INT:
+    case Builtins::FLOAT:
+        if (l_Arity(0, 1) && !l_Types.empty() && !l_Types[0].isNumber() && l_Types[0] != Type::STRING && !l_Types[0].isDynamic() && !l_Types[0].isUnknown())
+        {
+            return l_Reject(l_Types[0]);
+        }
+        return p_Function == Builtins::INT ? Type::INT : Type::FLOAT;
+    case Builtins::STR:
+    case Builtins::BOOL:
+        l_Arity(0, 1);
+        return p_Function == Builtins::STR ? Type::STRING : Type::BOOL;
+    case Builtins::ABS:
+        if (!l_Arity(1, 1) || l_Types[0].isDynamic() || l_Types[0].isUnknown())
+        {
+            return l_Types.empty() ? Type::DYNAMIC : l_Types[0];
+        }
+        if (!l_Types[0].isNumber())
+        {
+            return l_Reject(l_Types[0]);
+        }
+        return l_Types[0] == Type::FLOAT ? Type::FLOAT : Type::INT;
+    case Builtins::MIN:
+    case Builtins::MAX:
+        {
+            if (!l_Arity(1, SIZE_MAX))
+            {
+                return Type::DYNAMIC;
+            }
+            if (l_Types.size() == 1)
+            {
+                if (l_Types[0].isList())
+                {
+                    return l_Types[0].getElement();
+                }
+                return l_Types[0].isDynamic() || l_Types[0].isUnknown() ? l_Types[0] : l_Reject(l_Types[0]);
+            }
+            Type l_Result;
+            for (const Type l_Type : l_Types)
+            {
+                l_Result = Type::join(l_Result, l_Type);
+            }
+            return l_Result;
+        }
+    case Builtins::SUM:
+        if (!l_Arity(1, 1) || l_Types[0].isDynamic() || l_Types[0].isUnknown())
+        {
+            return l_Types.empty() ? Type::DYNAMIC : l_Types[0];
+        }
+        if (!l_Types[0].isList() || (!l_Types[0].getElement().isNumber() && !l_Types[0].getElement().isDynamic() && !l_Types[0].getElement().isUnknown()))
+        {
+            return l_Reject(l_Types[0]);
+        }
+        if (l_Types[0].getElement().isDynamic() || l_Types[0].getElement().isUnknown())
+        {
+            return l_Types[0].getElement();
+        }
+        return l_Types[0].getElement() == Type::FLOAT ? Type::FLOAT : Type::INT;
+    default:
+        return Type::DYNAMIC;
+    }
+}
+
+Type TypeInference::analyzeMethodCall(const Ast::NodeIndex p_Node, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Ast::Node& l_Node = l_Ast.getNode(p_Node);
+    const Ast::NodeIndex l_Object = l_Ast.getNode(l_Node.first).first;
+    const std::string_view l_Name = l_Ast.getName(l_Node.first);
+    const Type l_Receiver = analyzeExpression(l_Object, p_Frame);
+    std::vector<Type> l_Types;
+    for (const Ast::NodeIndex l_Argument : l_Ast.getList(l_Node.second))
+    {
+        l_Types.push_back(analyzeExpression(l_Argument, p_Frame));
+        if (l_Ast.getNode(l_Argument).kind == Ast::KEYWORD_ARGUMENT)
+        {
+            error(p_Frame, l_Argument, quote(l_Name) + " takes no keyword arguments");
+        }
+    }
+    const std::optional<Builtins::Method> l_Method = Builtins::findMethod(l_Name);
+    if (!l_Method)
+    {
+        error(p_Frame, p_Node, "Unsupported method " + quote(l_Name));
+        return Type::DYNAMIC;
+    }
+    const Builtins::MethodInfo& l_Info = Builtins::getMethod(*l_Method);
+    if (l_Types.size() < l_Info.minArguments || l_Types.size() > l_Info.maxArguments)
+    {
+        error(p_Frame, p_Node, std::string(l_Name) + "() takes " + std::to_string(l_Info.minArguments) + (l_Info.minArguments == l_Info.maxArguments ? "" : " to " + std::to_string(l_Info.maxArguments)) + " arguments");
+        return Type::DYNAMIC;
+    }
+    if (l_Receiver.isUnknown())
+    {
+        return Type::UNKNOWN;
+    }
+    const auto l_CheckIndex = [&](const size_t p_Argument)
+    {
+        if (!isIntLike(l_Types[p_Argument]) && !l_Types[p_Argument].isDynamic() && !l_Types[p_Argument].isUnknown())
+        {
+            error(p_Frame, p_Node, "Indices have to be int, not " + l_Types[p_Argument].getName());
+        }
+    };
+
+    if (l_Info.onList)
+    {
+        if (!l_Receiver.isList() && !l_Receiver.isDynamic())
+        {
+            error(p_Frame, p_Node, l_Receiver.getName() + " has no method " + quote(l_Name));
+            return Type::DYNAMIC;
+        }
+        if (*l_Method == Builtins::EXTEND && !l_Types[0].isList() && !l_Types[0].isDynamic() && !l_Types[0].isUnknown())
+        {
+            error(p_Frame, p_Node, "extend() takes a list, not " + l_Types[0].getName());
+            return Type::NONE;
+        }
+        if (*l_Method == Builtins::INSERT || (*l_Method == Builtins::POP && !l_Types.empty()))
+        {
+            l_CheckIndex(0);
+        }
+        if (l_Receiver.isDynamic())
+        {
+            return *l_Method == Builtins::POP ? Type::DYNAMIC : Type::NONE;
+        }
+        switch (*l_Method)
+        {
+        case Builtins::APPEND:
+            storeElement(l_Object, l_Receiver, l_Types[0], p_Node, p_Frame);
+            return Type::NONE;
+        case Builtins::INSERT:
+            storeElement(l_Object, l_Receiver, l_Types[1], p_Node, p_Frame);
+            return Type::NONE;
+        case Builtins::EXTEND:
+            if (l_Types[0].isList())
+            {
+                storeElement(l_Object, l_Receiver, l_Types[0].getElement(), p_Node, p_Frame);
+            }
+            else if (l_Types[0].isDynamic() && !l_Receiver.getElement().isDynamic())
+            {
+                error(p_Frame, p_Node, "Only a list[dynamic] can be extended with a dynamic value");
+            }
+            return Type::NONE;
+        default:
+            return l_Receiver.getElement();
+        }
+    }
+
+    // str methods, which a dynamic receiver is unboxed for
+    if (l_Receiver != Type::STRING && !l_Receiver.isDynamic())
+    {
+        error(p_Frame, p_Node, l_Receiver.getName() + " has no method " + quote(l_Name));
+        return Type::DYNAMIC;
+    }
+    for (size_t l_Argument = 0; l_Argument < l_Types.size(); ++l_Argument)
+    {
+        const Type l_Expected = *l_Method == Builtins::JOIN ? Type::listOf(Type::STRING) : Type{ Type::STRING };
+        if (!isConvertible(l_Types[l_Argument], l_Expected))
+        {
+            error(p_Frame, p_Node, std::string(l_Name) + "() takes " + l_Expected.getName() + ", not " + l_Types[l_Argument].getName());
+        }
+    }
+    switch (*l_Method)
+    {
+    case Builtins::SPLIT:
+        return Type::listOf(Type::STRING);
+    case Builtins::STARTSWITH:
+    case Builtins::ENDSWITH:
+        return Type::BOOL;
+    case Builtins::FIND:
+        return Type::INT;
+    default:
+        return Type::STRING;
+    }
+}
+
+Type TypeInference::analyzeMathCall(const Ast::NodeIndex p_Node, const std::string_view p_Name, Frame& p_Frame)
+{
+    const Ast& l_Ast = getAst(p_Frame);
+    const Builtins::MathFunction* const l_Function = Builtins::findMathFunction(p_Name);
+    const std::span<const Ast::NodeIndex> l_Arguments = l_Ast.getList(l_Ast.getNode(p_Node).second);
+    for (const Ast::NodeIndex l_Argument : l_Arguments)
+    {
+        const Type l_Type = analyzeExpression(l_Argument, p_Frame);
+        if (l_Ast.getNode(l_Argument).kind == Ast::KEYWORD_ARGUMENT)
+        {
+            error(p_Frame, l_Argument, "math functions take no keyword arguments");
+        }
+        else if (l_Function != nullptr && !(l_Function->result == Type::INT && l_Function->minArguments == 2 ? isIntLike(l_Type) : l_Type.isNumber()) && !l_Type.isDynamic() && !l_Type.isUnknown())
+        {
+            error(p_Frame, l_Argument, "math." + std::string(p_Name) + "() does not take " + l_Type.getName());
+        }
+    }
+    if (l_Function == nullptr)
+    {
+        error(p_Frame, p_Node, Builtins::findMathConstant(p_Name) != nullptr ? "math." + std::string(p_Name) + " cannot be called" : "math has no " + quote(p_Name));
+        return Type::DYNAMIC;
+    }
+    if (l_Arguments.size() < l_Function->minArguments || l_Arguments.size() > l_Function->maxArguments)
+    {
+        error(p_Frame, p_Node, "math." + std::string(p_Name) + "() takes " + std::to_string(l_Function->minArguments) + (l_Function->minArguments == l_Function->maxArguments ? "" : " to " + std::to_string(l_Function->maxArguments)) + " arguments");
+    }
+    return l_Function->result;
+}
+
+Type TypeInference::analyzeBinary(const Ast::NodeIndex p_Node, const Ast::Operator p_Operator, const Type p_Left, const Type p_Right, const Ast::NodeIndex p_RightNode, Frame& p_Frame)
+{
+    const std::string l_Operator = quote(Ast::getOperatorName(p_Operator));
+    const auto l_Reject = [&]
+    {
+        error(p_Frame, p_Node, "Unsupported operand types for " + l_Operator + ": " + p_Left.getName() + " and " + p_Right.getName());
+        return Type{ Type::DYNAMIC };
+    };
+    // and and or give one of their operands
+    if (p_Operator == Ast::AND || p_Operator == Ast::OR)
+    {
+        return Type::join(p_Left, p_Right);
+    }
+    if (Ast::isComparison(p_Operator))
+    {
+        if (p_Left.isUnknown() || p_Right.isUnknown() || p_Left.isDynamic() || p_Right.isDynamic() || p_Operator == Ast::EQUAL || p_Operator == Ast::NOT_EQUAL)
+        {
+            return Type::BOOL;
+        }
+        if (p_Operator == Ast::IN || p_Operator == Ast::NOT_IN)
+        {
+            if (!p_Right.isList() && !(p_Right == Type::STRING && p_Left == Type::STRING))
+            {
+                l_Reject();
+            }
+            return Type::BOOL;
+        }
+        if (!(p_Left.isNumber() && p_Right.isNumber()) && !(p_Left == p_Right && (p_Left == Type::STRING || p_Left.isList())))
+        {
+            l_Reject();
+        }
+        return Type::BOOL;
+    }
+    if (p_Left.isUnknown() || p_Right.isUnknown())
+    {
+        return Type::UNKNOWN;
+    }
+    if (p_Left.isDynamic() || p_Right.isDynamic())
+    {
+        return Type::DYNAMIC;
+    }
+
+    if (p_Left.isNumber() && p_Right.isNumber())
+    {
+        const bool l_Float = p_Left == Type::FLOAT || p_Right == Type::FLOAT;
+        switch (p_Operator)
+        {
+        case Ast::DIVIDE:
+            return Type::FLOAT;
+        case Ast::POWER:
+            {
+                // A negative exponent makes an int power a float, so only a literal one keeps it an int
+                const Ast& l_Ast = getAst(p_Frame);
+                if (l_Float)
+                {
+                    return Type::FLOAT;
+                }
+                return l_Ast.getNode(p_RightNode).kind == Ast::INTEGER || l_Ast.getNode(p_RightNode).kind == Ast::BOOLEAN ? Type::INT : Type::DYNAMIC;
+            }
+        case Ast::BIT_AND:
+        case Ast::BIT_OR:
+        case Ast::BIT_XOR:
+            if (l_Float)
+            {
+                return l_Reject();
+            }
+            return p_Left == Type::BOOL && p_Right == Type::BOOL ? Type::BOOL : Type::INT;
+        case Ast::SHIFT_LEFT:
+        case Ast::SHIFT_RIGHT:
+            return l_Float ? l_Reject() : Type{ Type::INT };
+        default:
+            return l_Float ? Type::FLOAT : Type::INT;
+        }
+    }
+    if (p_Operator == Ast::ADD && p_Left == p_Right && (p_Left == Type::STRING || p_Left.isList()))
+    {
+        return p_Left;
+    }
+    if (p_Operator == Ast::ADD && p_Left.isList() && p_Right.isList() && !Type::join(p_Left, p_Right).isDynamic())
+    {
+        return Type::join(p_Left, p_Right);
+    }
+    if (p_Operator == Ast::MULTIPLY && (p_Left == Type::STRING || p_Left.isList()) && isIntLike(p_Right))
+    {
+        return p_Left;
+    }
+    if (p_Operator == Ast::MULTIPLY && (p_Right == Type::STRING || p_Right.isList()) && isIntLike(p_Left))
+    {
+        return p_Right;
+    }
+    return l_Reject();
+}
+
+void TypeInference::bindTarget(const Ast::NodeIndex p_Target, const Type p_Type, const Ast::NodeIndex p_Value, Frame& p_Frame)
+{
+    Module& l_Module = m_Modules[p_Frame.module];
+    const Ast& l_Ast = *l_Module.ast;
+    const Ast::Node& l_Node = l_Ast.getNode(p_Target);
+    switch (l_Node.kind)
+    {
+    case Ast::NAME:
+        {
+            Variable* const l_Variable = findVariable(p_Target, p_Frame);
+            if (l_Variable == nullptr)
+            {
+                error(p_Frame, p_Target, quote(l_Ast.getName(p_Target)) + " cannot be assigned to");
+                return;
+            }
+            joinVariable(*l_Variable, p_Type, p_Value != Ast::c_NoNode ? p_Value : p_Target, p_Frame);
+            if (p_Value != Ast::c_NoNode)
+            {
+                unifyList(p_Value, l_Variable->type, p_Frame);
+            }
+            const Reference& l_Reference = l_Module.references[p_Target];
+            if (l_Reference.kind == Reference::LOCAL || (l_Reference.kind == Reference::GLOBAL && p_Frame.function == nullptr))
+            {
+                p_Frame.env[l_Reference.index] = l_Variable->pinned ? l_Variable->type : p_Type;
+            }
+            break;
+        }
+    case Ast::ANNOTATED:
+        if (l_Ast.getNode(l_Node.first).kind != Ast::NAME)
+        {
+            error(p_Frame, p_Target, "Only names can be annotated");
+            return;
+        }
+        bindTarget(l_Node.first, p_Type, p_Value, p_Frame);
+        break;
+    case Ast::SUBSCRIPT:
+        {
+            const Type l_Object = analyzeExpression(l_Node.first, p_Frame);
+            const Type l_Index = analyzeExpression(l_Node.second, p_Frame);
+            if (!isIntLike(l_Index) && !l_Index.isDynamic() && !l_Index.isUnknown())
+            {
+                error(p_Frame, l_Node.second, "Indices have to be int, not " + l_Index.getName());
+            }
+            if (l_Object.isList())
+            {
+                storeElement(l_Node.first, l_Object, p_Type, p_Target, p_Frame);
+            }
+            else if (!l_Object.isDynamic() && !l_Object.isUnknown())
+            {
+                error(p_Frame, p_Target, l_Object.getName() + " does not support item assignment");
+            }
+            break;
+        }
+    case Ast::TUPLE:
+    case Ast::LIST:
+        error(p_Frame, p_Target, "Nested unpacking is not supported");
+        break;
+    default:
+        error(p_Frame, p_Target, "Only names and list items can be assigned to");
+        break;
+    }
+}
+
+void TypeInference::joinVariable(Variable& p_Variable, const Type p_Type, const Ast::NodeIndex p_At, Frame& p_Frame)
+{
+    if (p_Variable.pinned)
+    {
+        if (!isConvertible(p_Type, p_Variable.type))
+        {
+            const std::string l_Name = quote(m_Symbols.getName(p_Variable.name));
+            error(p_Frame, p_At, p_Variable.role == Variable::RESULT
+                ? l_Name + " is annotated to return " + p_Variable.type.getName() + ", not " + p_Type.getName()
+                : l_Name + " is annotated " + p_Variable.type.getName() + " and cannot hold " + p_Type.getName());
+        }
+        return;
+    }
+    const Type l_Joined = Type::join(p_Variable.type, p_Type);
+    if (l_Joined == p_Variable.type)
+    {
+        return;
+    }
+    if (l_Joined.isDynamic())
+    {
+        p_Variable.conflict = { p_Variable.type, p_Type };
+    }
+    p_Variable.type = l_Joined;
+    ++m_Changes;
+}
+
+void TypeInference::storeElement(const Ast::NodeIndex p_List, const Type p_ListType, const Type p_Element, const Ast::NodeIndex p_At, Frame& p_Frame)
+{
+    const Type l_Current = p_ListType.getElement();
+    const Type l_Joined = Type::join(l_Current, p_Element);
+    if (l_Joined == l_Current)
+    {
+        return;
+    }
+    // A list whose elements are not known yet takes their type, through the variable holding it. A list is never
+    // converted, it keeps the type of its elements from when it was made
+    if (l_Current.getKind() == Type::UNKNOWN)
+    {
+        Ast::NodeIndex l_Holder = p_List;
+        Type l_Type = Type::listOf(l_Joined);
+        const Ast& l_Ast = getAst(p_Frame);
+        while (l_Ast.getNode(l_Holder).kind == Ast::SUBSCRIPT)
+        {
+            l_Holder = l_Ast.getNode(l_Holder).first;
+            l_Type = Type::listOf(l_Type);
+        }
+        Variable* const l_Variable = l_Ast.getNode(l_Holder).kind == Ast::NAME ? findVariable(l_Holder, p_Frame) : nullptr;
+        if (l_Variable != nullptr)
+        {
+            joinVariable(*l_Variable, l_Type, p_At, p_Frame);
+            return;
+        }
+    }
+    error(p_Frame, p_At, "A " + p_ListType.getName() + " cannot hold " + p_Element.getName() + ", lists keep the type of their elements");
+}
+
+void TypeInference::unifyList(const Ast::NodeIndex p_Value, const Type p_Target, Frame& p_Frame)
+{
+    if (!p_Target.isList() || getAst(p_Frame).getNode(p_Value).kind != Ast::NAME)
+    {
+        return;
+    }
+    Variable* const l_Variable = findVariable(p_Value, p_Frame);
+    if (l_Variable != nullptr && l_Variable->type != p_Target && Type::join(l_Variable->type, p_Target) == p_Target)
+    {
+        joinVariable(*l_Variable, p_Target, p_Value, p_Frame);
+    }
+}
+
+TypeInference::Variable* TypeInference::findVariable(const Ast::NodeIndex p_Name, Frame& p_Frame)
+{
+    const Reference& l_Reference = resolve(p_Name, p_Frame);
+    if (l_Reference.kind == Reference::LOCAL)
+    {
+        return &(*p_Frame.variables)[l_Reference.index];
+    }
+    if (l_Reference.kind == Reference::GLOBAL)
+    {
+        return &m_Modules[l_Reference.module].globals[l_Reference.index];
+    }
+    return nullptr;
+}
+
+const TypeInference::Reference& TypeInference::resolve(const Ast::NodeIndex p_Name, Frame& p_Frame)
+{
+    Module& l_Module = m_Modules[p_Frame.module];
+    Reference& l_Reference = l_Module.references[p_Name];
+    if (l_Reference.kind != Reference::UNRESOLVED)
+    {
+        return l_Reference;
+    }
+    // Locals, then the module, what it imports, and the builtins
+    const SymbolTable::Symbol l_Symbol = l_Module.ast->getSymbol(p_Name);
+    if (p_Frame.function != nullptr)
+    {
+        for (uint32_t l_Index = 0; l_Index < p_Frame.function->variables.size(); ++l_Index)
+        {
+            if (p_Frame.function->variables[l_Index].name == l_Symbol)
+            {
+                l_Reference = { .kind = Reference::LOCAL, .module = p_Frame.module, .index = l_Index };
+                return l_Reference;
+            }
+        }
+    }
+    if (const auto l_Found = l_Module.names.find(l_Symbol); l_Found != l_Module.names.end())
+    {
+        l_Reference = l_Found->second;
+        return l_Reference;
+    }
+    if (const auto l_Found = l_Module.imports.find(l_Symbol); l_Found != l_Module.imports.end())
+    {
+        l_Reference = l_Found->second;
+        return l_Reference;
+    }
+    // "from module import name" leaves no trace once the import header is read, so every name a dependency defines
+    // is visible
+    for (const uint32_t l_Dependency : l_Module.file->dependencies)
+    {
+        if (const auto l_Found = m_Modules[l_Dependency].names.find(l_Symbol); l_Found != m_Modules[l_Dependency].names.end())
+        {
+            l_Reference = l_Found->second;
+            return l_Reference;
+        }
+    }
+    if (const auto l_Found = m_Builtins.find(l_Symbol); l_Found != m_Builtins.end())
+    {
+        l_Reference = { .kind = Reference::BUILTIN, .index = l_Found->second };
+    }
+    return l_Reference;
+}
+
+void TypeInference::markRead(const Reference& p_Reference)
+{
+    if (m_Live && p_Reference.kind == Reference::GLOBAL)
+    {
+        m_Modules[p_Reference.module].globals[p_Reference.index].read = true;
+    }
+}
+
+void TypeInference::error(const Frame& p_Frame, const Ast::NodeIndex p_At, std::string p_Message)
+{
+    if (m_Reporting)
+    {
+        error(p_Frame.module, p_At, std::move(p_Message));
+    }
+}
+
+void TypeInference::error(const uint32_t p_Module, const Ast::NodeIndex p_At, std::string p_Message)
+{
+    if (!m_Reported.insert(static_cast<uint64_t>(p_Module) << 32 | p_At).second)
+    {
+        return;
+    }
+    Module& l_Module = m_Modules[p_Module];
+    const Tokenizer::Location l_Location = l_Module.ast->getLocation(p_At);
+    l_Module.errors.push_back({ .message = std::move(p_Message), .line = l_Location.line, .column = l_Location.column });
+}
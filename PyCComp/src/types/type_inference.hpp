@@ -0,0 +1,272 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "builtins.hpp"
+#include "constant_folder.hpp"
+#include "type.hpp"
+#include "../parser/ast.hpp"
+#include "../source_file/source_reader.hpp"
+
+// Whole program type inference over every module a SourceReader found, and the check that the program stays within
+// the subset the C++ writer compiles. Each variable, parameter and return value gets the single type every value it
+// holds fits in, which the C++ writer uses as its storage type. Within a scope the analysis follows control flow, so
+// that where a DYNAMIC variable is known to hold one type a read unboxes it, code after a return or a break is not
+// reached, and a function that can end without returning also returns None. Functions are monomorphized: each
+// signature, the types a call passes its parameters, gets an instance of its own, typed as if the function had been
+// written for those arguments alone. Annotated parameters are part of every signature with their annotated type.
+// Passes over the module bodies and the instances their calls reach repeat until nothing changes. Before them,
+// expressions whose value is known at compile time are folded: their value types them, and decides which branches of
+// an if or a while are reached
+class TypeInference
+{
+public:
+    // What a NAME refers to, or an ATTRIBUTE of a module
+    struct Reference
+    {
+        enum Kind: uint8_t
+        {
+            UNRESOLVED,
+            // index: variable of the enclosing function
+            LOCAL,
+            // module, index: module level variable
+            GLOBAL,
+            // module, index: function
+            FUNCTION,
+            // module: an imported module
+            MODULE,
+            // index: a Builtins::Function
+            BUILTIN,
+            // The math module
+            MATH
+        };
+
+        Kind kind = UNRESOLVED;
+        uint32_t module = 0;
+        uint32_t index = 0;
+    };
+
+    struct Variable
+    {
+        enum Role: uint8_t
+        {
+            VARIABLE,
+            PARAMETER,
+            // Return value of a function, named after it
+            RESULT
+        };
+
+        SymbolTable::Symbol name;
+        Role role = VARIABLE;
+        // Module it belongs to
+        uint32_t module = 0;
+        // Where it is first bound, the PARAMETER of a parameter and the FUNCTION of a return value
+        Ast::NodeIndex node{};
+        Type type{};
+        // Set by an annotation, which values are then converted to or rejected by
+        bool pinned = false;
+        // The first two types whose join made it DYNAMIC, for the report
+        std::array<Type, 2> conflict{};
+        // A module level variable bound once, at the top level, to a constant. Its value is the constant of its node
+        bool constant = false;
+        // Whether code the program runs reads a module level variable. The C++ leaves out those nothing reads
+        bool read = false;
+    };
+
+    // A function typed for one signature
+    struct Instance
+    {
+        // Type of each parameter in the calls that reach this instance
+        std::vector<Type> signature;
+        // The function's variables and return value, typed for this signature
+        std::vector<Variable> variables;
+        Variable result;
+        // Whether the end of the body can be reached, where Python returns None
+        bool fallsThrough = false;
+        // Like Module's, for the nodes of the function from its firstNode on
+        std::vector<Type> types;
+        std::vector<uint8_t> reached;
+        // Instance each call in the body reaches, by CALL node
+        std::unordered_map<Ast::NodeIndex, uint32_t> callees;
+        // Whether a call reached it in the last pass. Instances whose signature the types have since moved past are
+        // left uncalled
+        bool called = false;
+        // Whether the module bodies reach it, rather than only a function nothing calls. Only these are in the C++
+        bool used = false;
+    };
+
+    struct Function
+    {
+        Ast::NodeIndex node;
+        // The parser adds nodes after their children, so the nodes of a definition are the ones from this one to node
+        Ast::NodeIndex firstNode = 0;
+        // Parameters first, in order, then the other locals in the order they are first bound. Only annotations type
+        // them here, each instance has its own copy
+        std::vector<Variable> variables;
+        uint32_t parameterCount = 0;
+        Variable result;
+        // A deque, as analyzing an instance can add others while it refers to its own
+        std::deque<Instance> instances;
+    };
+
+    struct Module
+    {
+        const Ast* ast = nullptr;
+        const SourceReader::ModuleFile* file = nullptr;
+        // Type of every expression of the module body and of the defaults of its functions, and of the operation of
+        // an augmented ASSIGN. UNKNOWN for the other nodes and for unreached code
+        std::pmr::vector<Type> types{};
+        // Set for NAME nodes, and for ATTRIBUTE nodes naming something in another module
+        std::pmr::vector<Reference> references{};
+        // Statements of the module body control flow can reach. The others are left out of the C++
+        std::pmr::vector<uint8_t> reached{};
+        // Instance each call in the module body reaches, by CALL node
+        std::unordered_map<Ast::NodeIndex, uint32_t> callees{};
+        // Value of every expression of the module that folds, in the body and in functions alike, and of every
+        // constant global by its node
+        std::unordered_map<Ast::NodeIndex, ConstantFolder::Constant> constants{};
+        std::vector<Variable> globals{};
+        std::vector<Function> functions{};
+        // Module level names, as GLOBAL and FUNCTION references
+        std::unordered_map<SymbolTable::Symbol, Reference> names{};
+        // Modules imported by name, as MODULE and MATH references
+        std::unordered_map<SymbolTable::Symbol, Reference> imports{};
+        std::pmr::vector<Tokenizer::Error> errors{};
+    };
+
+    // p_Trees are in module order and were parsed from tokenizers that interned their names in p_Symbols. Both have
+    // to outlive the inference
+    TypeInference(const SourceReader& p_Reader, std::span<const Ast* const> p_Trees, const SymbolTable& p_Symbols, std::pmr::memory_resource* p_Memory = std::pmr::get_default_resource());
+
+    [[nodiscard]] uint32_t getModuleCount() const { return static_cast<uint32_t>(m_Modules.size()); }
+    [[nodiscard]] const Module& getModule(const uint32_t p_Index) const { return m_Modules[p_Index]; }
+    [[nodiscard]] const SourceReader& getReader() const { return m_Reader; }
+    [[nodiscard]] const SymbolTable& getSymbols() const { return m_Symbols; }
+    [[nodiscard]] const Function& getFunction(const Reference& p_Reference) const { return m_Modules[p_Reference.module].functions[p_Reference.index]; }
+    // The signature of p_Instance as Python would write it, like "f(int, str)"
+    [[nodiscard]] std::string getInstanceName(const Function& p_Function, const Instance& p_Instance) const;
+    [[nodiscard]] const Variable& getGlobal(const Reference& p_Reference) const { return m_Modules[p_Reference.module].globals[p_Reference.index]; }
+    // The value of p_Node if it folds, nullptr otherwise
+    [[nodiscard]] const ConstantFolder::Constant* getConstant(uint32_t p_Module, Ast::NodeIndex p_Node) const;
+    // For each parameter of p_Function, the argument p_Call passes it, the value of a KEYWORD_ARGUMENT rather than the
+    // node itself, or c_NoNode where it takes its default. Empty with p_Error set if they do not match
+    [[nodiscard]] std::vector<Ast::NodeIndex> matchArguments(uint32_t p_Module, Ast::NodeIndex p_Call, const Function& p_Function, std::string* p_Error = nullptr) const;
+    [[nodiscard]] bool hasErrors() const;
+    void printErrors(uint32_t p_Module, std::ostream& p_Stream = std::cerr) const;
+
+    // The type an annotation stands for, if it is one of the supported ones
+    [[nodiscard]] static std::optional<Type> readAnnotation(const Ast& p_Ast, Ast::NodeIndex p_Node);
+
+private:
+    // Where control flow stands inside the loop being analyzed: what reaches its exit and its next iteration
+    struct Loop
+    {
+        std::vector<Type> exit;
+        bool exitReached = false;
+        std::vector<Type> next;
+        bool nextReached = false;
+    };
+
+    // State of the scope being analyzed, the module body or a function instance. env is the type each of its
+    // variables holds at the current point, if it is reached
+    struct Frame
+    {
+        uint32_t module = 0;
+        Function* function = nullptr;
+        Instance* instance = nullptr;
+        std::vector<Variable>* variables = nullptr;
+        // Where the types and reached flags of the scope's nodes are kept, from firstNode on
+        Type* types = nullptr;
+        uint8_t* reached = nullptr;
+        Ast::NodeIndex firstNode = 0;
+        std::unordered_map<Ast::NodeIndex, uint32_t>* callees = nullptr;
+        std::vector<Type> env{};
+        bool reachable = true;
+        std::vector<Loop> loops{};
+    };
+
+    void declareModule(uint32_t p_Module);
+    void declareTargets(Ast::NodeIndex p_Target, uint32_t p_Module, std::vector<Variable>& p_Variables, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Indices);
+    void declareBlock(Ast::NodeIndex p_Statement, uint32_t p_Module, std::vector<Variable>& p_Variables, std::unordered_map<SymbolTable::Symbol, uint32_t>& p_Indices);
+    void pin(Variable& p_Variable, Ast::NodeIndex p_Annotation, uint32_t p_Module);
+
+    // Folds the module body, in order, and then its functions, which may read any constant global it binds
+    void foldModule(uint32_t p_Module);
+    void foldBlock(uint32_t p_List, Frame& p_Frame);
+    void foldStatement(Ast::NodeIndex p_Node, Frame& p_Frame);
+    // Only the indices and lists a target stores into are expressions
+    void foldTarget(Ast::NodeIndex p_Target, Frame& p_Frame);
+    // The value p_Node folds to, nullptr if it does not. Its subexpressions are folded either way
+    const ConstantFolder::Constant* foldExpression(Ast::NodeIndex p_Node, Frame& p_Frame);
+
+    void solve();
+    // Once nothing changes any more, whatever is still UNKNOWN becomes DYNAMIC. Returns whether anything did
+    bool resolveUnknown();
+    // One pass: every module body, then the instances their calls reach, then whatever functions nothing calls, as
+    // an instance with DYNAMIC parameters
+    void analyzeProgram();
+    void analyzeModule(uint32_t p_Module);
+    void analyzeFunction(uint32_t p_Module, uint32_t p_Function, uint32_t p_Instance);
+    // The instance of p_Function for p_Signature, made if there is none yet. Queued for analysis the first time a
+    // pass calls it
+    uint32_t callInstance(uint32_t p_Module, uint32_t p_Function, std::vector<Type> p_Signature);
+
+    void analyzeBlock(uint32_t p_List, Frame& p_Frame);
+    void analyzeStatement(Ast::NodeIndex p_Node, Frame& p_Frame);
+    void analyzeIf(Ast::NodeIndex p_Node, Frame& p_Frame);
+    void analyzeLoop(Ast::NodeIndex p_Node, Frame& p_Frame);
+    void analyzeAssign(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeExpression(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeName(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeAttribute(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeCall(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeFunctionCall(Ast::NodeIndex p_Node, const Reference& p_Callee, Frame& p_Frame);
+    Type analyzeBuiltinCall(Ast::NodeIndex p_Node, Builtins::Function p_Function, Frame& p_Frame);
+    Type analyzeMethodCall(Ast::NodeIndex p_Node, Frame& p_Frame);
+    Type analyzeMathCall(Ast::NodeIndex p_Node, std::string_view p_Name, Frame& p_Frame);
+    Type analyzeBinary(Ast::NodeIndex p_Node, Ast::Operator p_Operator, Type p_Left, Type p_Right, Ast::NodeIndex p_RightNode, Frame& p_Frame);
+    // The element type a for loop over p_Iterable binds its target to
+    Type analyzeIterable(Ast::NodeIndex p_Iterable, Frame& p_Frame);
+
+    void bindTarget(Ast::NodeIndex p_Target, Type p_Type, Ast::NodeIndex p_Value, Frame& p_Frame);
+    // Joins p_Type into p_Variable, or checks it against the annotation of a pinned one
+    void joinVariable(Variable& p_Variable, Type p_Type, Ast::NodeIndex p_At, Frame& p_Frame);
+    // Puts a value in a list: a list nothing was put in yet takes its type, any other has to hold it already
+    void storeElement(Ast::NodeIndex p_List, Type p_ListType, Type p_Element, Ast::NodeIndex p_At, Frame& p_Frame);
+    // Lists are shared, so when one held by a variable flows somewhere with a more precise list type, the variable
+    // takes that type too
+    void unifyList(Ast::NodeIndex p_Value, Type p_Target, Frame& p_Frame);
+    Variable* findVariable(Ast::NodeIndex p_Name, Frame& p_Frame);
+    const Reference& resolve(Ast::NodeIndex p_Name, Frame& p_Frame);
+
+    // Marks a module level variable read, if the code reading it runs
+    void markRead(const Reference& p_Reference);
+
+    void error(const Frame& p_Frame, Ast::NodeIndex p_At, std::string p_Message);
+    void error(uint32_t p_Module, Ast::NodeIndex p_At, std::string p_Message);
+    [[nodiscard]] const Ast& getAst(const Frame& p_Frame) const { return *m_Modules[p_Frame.module].ast; }
+
+    const SourceReader& m_Reader;
+    const SymbolTable& m_Symbols;
+    std::pmr::vector<Module> m_Modules;
+    std::unordered_map<SymbolTable::Symbol, Builtins::Function> m_Builtins;
+    // Module, function and instance of every instance called in the current pass, in the order they were first
+    // called
+    std::vector<std::array<uint32_t, 3>> m_Queue;
+    // Types that changed during the current pass
+    uint32_t m_Changes = 0;
+    // Set while the pass analyzes the module bodies and what they call, the code the program runs
+    bool m_Live = false;
+    // Errors are only recorded during the last pass, which sees the final types, and once per node
+    bool m_Reporting = false;
+    std::unordered_set<uint64_t> m_Reported;
+};
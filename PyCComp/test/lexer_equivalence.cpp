@@ -0,0 +1,305 @@
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../benchmark/corpus_generator.hpp"
+
+// Runs two pyccomp builds on the same seeded inputs and checks that they print the same token dumps, errors and exit
+// codes. Registered with ctest to compare the table-driven lexer with the legacy cascade, and serial runs with -j N.
+// The inputs are the benchmark corpus shapes and an import graph, plus random snippets of valid and malformed code.
+// The large inputs are big enough for -j N to split them into chunks
+namespace
+{
+    struct Options
+    {
+        uint64_t seed = 1;
+        uint32_t count = 200;
+        std::string reference;
+        std::string candidate;
+        uint32_t referenceJobs = 1;
+        uint32_t candidateJobs = 1;
+        std::filesystem::path workDir;
+    };
+
+    // What one run printed
+    struct Outcome
+    {
+        int status = 0;
+        std::string dump = {};
+        std::string out = {};
+        std::string err = {};
+    };
+
+    // Whole lines, valid and not, that the snippets are made of. None starts with import, which would end the
+    // import header of the module and fail the whole run before anything is lexed
+    constexpr std::array<std::string_view, 40> c_Fragments = {
+        "x = 1\n",
+        "def f(a, b=2, *args, **kwargs):\n    return a + b\n",
+        "if x:\n\tpass\n",
+        "class A:\n    def m(self):\n        pass\n",
+        "while True:\n        break\n",
+        "else:\n",
+        "  bad_indent = 3\n",
+        "\t\t\n",
+        "# comment\n",
+        "s = 'abc'\n",
+        "s = 'unterminated\n",
+        "t = \"\"\"multi\nline\"\"\"\n",
+        "t = \"\"\"never closed\n",
+        "w = 'esc\\'aped' + \"dq\\\"x\"\n",
+        "q = f'{x}' + r'\\d' + b'raw'\n",
+        "u = '\xc3\xa9\xe2\x82\xac'\n",
+        "n = 1.2.3\n",
+        "h = 0x1F + 0b101 + 0o17 + 1e5 + 1_000 + .5j + 7.\n",
+        "b = 0x + 0b2 + 0o9\n",
+        "c = 1e + 1e+ + 2E-3\n",
+        "d = 1__0 + 1_ + 00012 + 0_0\n",
+        "a = 123abc + 1.5e3x\n",
+        "big = 99999999999999999999999999 + 1.7976931348623157e309\n",
+        "y = (1,\n 2,\n\n 3)\n",
+        "lst = [1, 2, 3][0]\n",
+        "z = a @ b ** c // d % e << f >> g & h | i ^ ~j\n",
+        "x += 1; y -= 2; z **= 3; w //= 4\n",
+        "cmp = a <= b >= c != d == e < f > g\n",
+        "x = not y and z or w is None in v\n",
+        "v = x\\\n + 1\n",
+        "\\\n",
+        "r = $ ? !\n",
+        "e = a -> b : c . d , e\n",
+        "\r\n",
+        "m = 1\r\n",
+        "lam = lambda k: k if k else -k\n",
+        "try:\n    raise E\nexcept E as e:\n    del e\nfinally:\n    pass\n",
+        "for i in range(10):\n    continue\n",
+        "from_x = global_y\n",
+        "_private = __dunder__\n",
+    };
+
+    // Seeded like CorpusGenerator, from the raw output of mt19937_64 only, so a seed names the same inputs everywhere
+    class SnippetGenerator
+    {
+    public:
+        explicit SnippetGenerator(const uint64_t p_Seed)
+            : m_Random(p_Seed)
+        {
+        }
+
+        // Random fragments at random indentation, with the odd stray byte, until p_Size bytes are reached
+        [[nodiscard]] std::string generate(const size_t p_Size)
+        {
+            std::string l_Source;
+            while (l_Source.size() < p_Size)
+            {
+                const uint32_t l_Indent = below(4) == 0 ? below(13) : 0;
+                l_Source.append(l_Indent, below(5) == 0 ? '\t' : ' ');
+                if (below(20) == 0)
+                {
+                    l_Source += static_cast<char>(below(256));
+                }
+                l_Source += c_Fragments[below(static_cast<uint32_t>(c_Fragments.size()))];
+            }
+            return l_Source;
+        }
+
+        [[nodiscard]] uint32_t below(const uint32_t p_Bound)
+        {
+            return static_cast<uint32_t>(m_Random() % p_Bound);
+        }
+
+    private:
+        std::mt19937_64 m_Random;
+    };
+
+    // Single quoted for /bin/sh
+    std::string quote(const std::string_view p_Text)
+    {
+        std::string l_Quoted = "'";
+        for (const char l_Char : p_Text)
+        {
+            l_Quoted += l_Char == '\'' ? std::string("'\\''") : std::string(1, l_Char);
+        }
+        return l_Quoted + "'";
+    }
+
+    std::string readFile(const std::filesystem::path& p_Path)
+    {
+        std::ifstream l_File(p_Path, std::ios::binary);
+        std::ostringstream l_Contents;
+        l_Contents << l_File.rdbuf();
+        return l_Contents.str();
+    }
+
+    bool writeFile(const std::filesystem::path& p_Path, const std::string_view p_Contents)
+    {
+        std::ofstream l_File(p_Path, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(l_File.write(p_Contents.data(), static_cast<std::streamsize>(p_Contents.size())));
+    }
+
+    Outcome runCompiler(const std::string& p_Compiler, const uint32_t p_Jobs, const std::filesystem::path& p_Input, const std::filesystem::path& p_Base)
+    {
+        const std::filesystem::path l_Dump = p_Base.string() + ".tokens";
+        const std::filesystem::path l_Out = p_Base.string() + ".out";
+        const std::filesystem::path l_Err = p_Base.string() + ".err";
+        std::filesystem::remove(l_Dump);
+        const std::string l_Command = quote(p_Compiler) + " --no-cache -j " + std::to_string(p_Jobs) + " --emit=tokens " + quote(l_Dump.string()) + " " +
+            quote(p_Input.string()) + " > " + quote(l_Out.string()) + " 2> " + quote(l_Err.string());
+        Outcome l_Outcome;
+        l_Outcome.status = std::system(l_Command.c_str());
+        l_Outcome.dump = readFile(l_Dump);
+        l_Outcome.out = readFile(l_Out);
+        l_Outcome.err = readFile(l_Err);
+        std::filesystem::remove(l_Dump);
+        std::filesystem::remove(l_Out);
+        std::filesystem::remove(l_Err);
+        return l_Outcome;
+    }
+
+    // Prints what differs, if anything
+    bool compare(const Options& p_Options, const std::filesystem::path& p_Input)
+    {
+        const std::filesystem::path l_Base = p_Options.workDir / p_Input.stem();
+        const Outcome l_Reference = runCompiler(p_Options.reference, p_Options.referenceJobs, p_Input, l_Base.string() + ".reference");
+        const Outcome l_Candidate = runCompiler(p_Options.candidate, p_Options.candidateJobs, p_Input, l_Base.string() + ".candidate");
+        std::string_view l_Difference;
+        if (l_Reference.status != l_Candidate.status)
+        {
+            l_Difference = "exit status";
+        }
+        else if (l_Reference.dump != l_Candidate.dump)
+        {
+            l_Difference = "token dump";
+        }
+        else if (l_Reference.out != l_Candidate.out)
+        {
+            l_Difference = "stdout";
+        }
+        else if (l_Reference.err != l_Candidate.err)
+        {
+            l_Difference = "stderr";
+        }
+        if (l_Difference.empty())
+        {
+            return true;
+        }
+        std::cerr << p_Input.string() << ": the " << l_Difference << " differs\n";
+        return false;
+    }
+
+    bool parseCount(const std::string_view p_Text, uint64_t& p_Value)
+    {
+        const std::from_chars_result l_Parse = std::from_chars(p_Text.data(), p_Text.data() + p_Text.size(), p_Value);
+        return !p_Text.empty() && l_Parse.ec == std::errc{} && l_Parse.ptr == p_Text.data() + p_Text.size();
+    }
+
+    constexpr std::string_view c_Usage =
+        "Arguments: --reference <pyccomp> --candidate <pyccomp> [--reference-jobs <n>] [--candidate-jobs <n>] [--seed <n>]\n"
+        "           [--count <snippets>] [--work-dir <dir>]\n";
+
+    // Per corpus shape, four chunks at -j 4 and up
+    constexpr size_t c_ShapeSize = 4u << 20;
+    constexpr size_t c_LargeSnippetSize = 3u << 20;
+    constexpr uint32_t c_LargeSnippetCount = 2;
+}
+
+int main(const int argc, char* argv[])
+{
+    Options l_Options;
+    for (int l_Arg = 1; l_Arg < argc; ++l_Arg)
+    {
+        const std::string_view l_Name = argv[l_Arg];
+        if (l_Arg + 1 >= argc)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        const std::string_view l_Value = argv[++l_Arg];
+        if (l_Name == "--reference" || l_Name == "--candidate")
+        {
+            (l_Name == "--reference" ? l_Options.reference : l_Options.candidate) = l_Value;
+            continue;
+        }
+        if (l_Name == "--work-dir")
+        {
+            l_Options.workDir = l_Value;
+            continue;
+        }
+        uint64_t l_Count = 0;
+        if (!parseCount(l_Value, l_Count))
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        if (l_Name == "--seed")
+        {
+            l_Options.seed = l_Count;
+            continue;
+        }
+        if ((l_Name != "--count" && l_Name != "--reference-jobs" && l_Name != "--candidate-jobs") || l_Count == 0 || l_Count > UINT32_MAX)
+        {
+            std::cerr << c_Usage;
+            return 1;
+        }
+        (l_Name == "--count" ? l_Options.count : l_Name == "--reference-jobs" ? l_Options.referenceJobs : l_Options.candidateJobs) = static_cast<uint32_t>(l_Count);
+    }
+    if (l_Options.reference.empty() || l_Options.candidate.empty())
+    {
+        std::cerr << c_Usage;
+        return 1;
+    }
+    if (l_Options.workDir.empty())
+    {
+        l_Options.workDir = std::filesystem::temp_directory_path() / "pyccomp-lexer-equivalence";
+    }
+
+    std::vector<std::filesystem::path> l_Inputs;
+    try
+    {
+        std::filesystem::remove_all(l_Options.workDir);
+        std::filesystem::create_directories(l_Options.workDir / "graph");
+        CorpusGenerator l_Corpus{ l_Options.seed };
+        for (uint8_t l_Shape = 0; l_Shape < CorpusGenerator::SHAPE_COUNT; ++l_Shape)
+        {
+            const CorpusGenerator::Shape l_Kind = static_cast<CorpusGenerator::Shape>(l_Shape);
+            l_Inputs.push_back(l_Options.workDir / (std::string(CorpusGenerator::getShapeName(l_Kind)) + ".py"));
+            if (!writeFile(l_Inputs.back(), l_Corpus.generateModule(l_Kind, c_ShapeSize)))
+            {
+                std::cerr << "Could not write " << l_Inputs.back().string() << "\n";
+                return 1;
+            }
+        }
+        l_Inputs.push_back(l_Corpus.generateImportGraph(l_Options.workDir / "graph", 24, 3, 16 * 1024));
+
+        SnippetGenerator l_Snippets{ l_Options.seed };
+        for (uint32_t l_Index = 0; l_Index < l_Options.count + c_LargeSnippetCount; ++l_Index)
+        {
+            const bool l_Large = l_Index >= l_Options.count;
+            l_Inputs.push_back(l_Options.workDir / ("snippet_" + std::to_string(l_Index) + ".py"));
+            if (!writeFile(l_Inputs.back(), l_Snippets.generate(l_Large ? c_LargeSnippetSize : 1 + l_Snippets.below(2048))))
+            {
+                std::cerr << "Could not write " << l_Inputs.back().string() << "\n";
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& l_Error)
+    {
+        std::cerr << l_Error.what() << "\n";
+        return 1;
+    }
+
+    uint32_t l_Failures = 0;
+    for (const std::filesystem::path& l_Input : l_Inputs)
+    {
+        l_Failures += compare(l_Options, l_Input) ? 0 : 1;
+    }
+    std::cout << l_Inputs.size() - l_Failures << " of " << l_Inputs.size() << " inputs match\n";
+    return l_Failures == 0 ? 0 : 1;
+}